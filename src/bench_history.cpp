@@ -0,0 +1,229 @@
+// Headless history search benchmark.
+// Fills a scratch history database with synthetic chats (words drawn from a
+// Zipf-like vocabulary, a fifth of the rows tool calls with JSON inputs, and
+// a sprinkling of rare tokens), indexing through the same triggers the app
+// uses, then times Database::searchMessages for rare, common, prefix and
+// multi-word queries against a LIKE scan of the same data. Fails when any
+// query's p99 reaches 100 ms.
+//
+// Usage: bench_history [messages]     (default 1000000; 10M takes a while)
+
+#include "core/Database.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+static constexpr int kVocabulary = 20000;
+static constexpr int kMessagesPerSession = 400;
+static constexpr int kMessagesPerTurn = 8;
+static constexpr int kRareEvery = 100000;
+static constexpr int kRuns = 50;
+static constexpr double kTargetMs = 100.0;
+
+static QStringList makeVocabulary(QRandomGenerator &rng)
+{
+    QStringList words;
+    words.reserve(kVocabulary);
+    while (words.size() < kVocabulary) {
+        QString w;
+        const int len = 3 + rng.bounded(7);
+        for (int i = 0; i < len; ++i)
+            w += QChar('a' + rng.bounded(26));
+        words << w;
+    }
+    return words;
+}
+
+// Word ranks with weight 1/rank, sampled through the cumulative sum
+class ZipfSampler {
+public:
+    explicit ZipfSampler(int n)
+    {
+        double sum = 0;
+        m_cumulative.reserve(n);
+        for (int i = 1; i <= n; ++i)
+            m_cumulative.push_back(sum += 1.0 / i);
+    }
+    int sample(QRandomGenerator &rng) const
+    {
+        const double x = rng.generateDouble() * m_cumulative.back();
+        return int(std::lower_bound(m_cumulative.begin(), m_cumulative.end(), x)
+                   - m_cumulative.begin());
+    }
+
+private:
+    std::vector<double> m_cumulative;
+};
+
+static void populate(const QString &path, int messages, const QStringList &words)
+{
+    QRandomGenerator rng(7);
+    const ZipfSampler zipf(words.size());
+    const int sessions = (messages + kMessagesPerSession - 1) / kMessagesPerSession;
+
+    QElapsedTimer t;
+    t.start();
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench_fill");
+        db.setDatabaseName(path);
+        db.open();
+        QSqlQuery q(db);
+        q.exec("PRAGMA journal_mode=WAL");
+        q.exec("PRAGMA synchronous=OFF");
+
+        db.transaction();
+        q.prepare("INSERT INTO sessions (session_id, title, workspace, created_at, updated_at) "
+                  "VALUES (?, ?, ?, ?, ?)");
+        for (int s = 0; s < sessions; ++s) {
+            q.addBindValue(QStringLiteral("session-%1").arg(s));
+            q.addBindValue(QStringLiteral("Chat %1").arg(s));
+            q.addBindValue(s % 4 == 0 ? QStringLiteral("/work/other") : QStringLiteral("/work/main"));
+            q.addBindValue(1700000000 + s);
+            q.addBindValue(1700000000 + s);
+            q.exec();
+        }
+        db.commit();
+
+        q.prepare("INSERT INTO messages (session_id, role, content, tool_name, tool_input, "
+                  "turn_id, timestamp) VALUES (?, ?, ?, ?, ?, ?, ?)");
+        db.transaction();
+        for (int i = 0; i < messages; ++i) {
+            const int s = i / kMessagesPerSession;
+            const bool tool = rng.bounded(5) == 0;
+            QString content;
+            const int len = tool ? 6 : 20 + rng.bounded(60);
+            for (int w = 0; w < len; ++w) {
+                if (w) content += QLatin1Char(' ');
+                content += words[zipf.sample(rng)];
+            }
+            if (i % kRareEvery == kRareEvery / 2)
+                content += QStringLiteral(" needle%1").arg(i / kRareEvery);
+
+            q.addBindValue(QStringLiteral("session-%1").arg(s));
+            q.addBindValue(tool ? QStringLiteral("tool")
+                                : (i % 2 ? QStringLiteral("assistant") : QStringLiteral("user")));
+            q.addBindValue(content);
+            q.addBindValue(tool ? QStringLiteral("Edit") : QString());
+            q.addBindValue(tool ? QStringLiteral("{\"file_path\":\"/work/main/src/%1.cpp\"}")
+                                      .arg(words[zipf.sample(rng)])
+                                : QString());
+            q.addBindValue((i % kMessagesPerSession) / kMessagesPerTurn + 1);
+            q.addBindValue(1700000000 + i);
+            q.exec();
+            if (i % 50000 == 49999) {
+                db.commit();
+                db.transaction();
+            }
+        }
+        db.commit();
+        q.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("bench_fill");
+    qDebug().noquote() << QStringLiteral("[bench] %1 messages in %2 sessions, indexed in %3 s")
+                              .arg(messages).arg(sessions).arg(t.elapsed() / 1000.0, 0, 'f', 1);
+}
+
+// p99 in milliseconds
+static double timeQuery(Database &db, const QString &name, const QString &text,
+                        const QString &workspace = {})
+{
+    std::vector<qint64> nanos;
+    // One untimed run first: the times are for a warm page cache
+    int hits = int(db.searchMessages(text, workspace).size());
+    for (int run = 0; run < kRuns; ++run) {
+        QElapsedTimer t;
+        t.start();
+        hits = int(db.searchMessages(text, workspace).size());
+        nanos.push_back(t.nsecsElapsed());
+    }
+    std::sort(nanos.begin(), nanos.end());
+    auto percentile = [&nanos](double p) {
+        size_t i = std::min(nanos.size() - 1, static_cast<size_t>(p * static_cast<double>(nanos.size())));
+        return nanos[i] / 1e6;
+    };
+    qDebug().noquote() << QStringLiteral("[bench]   %1 %2: %3 hits, p50 %4 ms, p99 %5 ms")
+                              .arg(name, -10).arg(QLatin1Char('"') + text + QLatin1Char('"'), -24)
+                              .arg(hits)
+                              .arg(percentile(0.50), 0, 'f', 2)
+                              .arg(percentile(0.99), 0, 'f', 2);
+    return percentile(0.99);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int messages = argc > 1 ? QString(argv[1]).toInt() : 1000000;
+    if (messages <= 0) {
+        qWarning() << "usage: bench_history [messages]";
+        return 1;
+    }
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("history.db");
+    QRandomGenerator rng(1);
+    const QStringList words = makeVocabulary(rng);
+
+    Database db;
+    if (!db.open(path) || !db.hasSearch()) {
+        qWarning() << "[bench] history database has no full-text search";
+        return 1;
+    }
+    db.close();
+    populate(path, messages, words);
+    if (!db.open(path)) return 1;
+
+    // A common word typed up to its last letter: past the prefix index
+    QString typing;
+    for (int i = 0; i < 100 && typing.isEmpty(); ++i) {
+        if (words[i].size() >= 7)
+            typing = words[i].chopped(1);
+    }
+
+    qDebug().noquote() << "[bench] searchMessages, limit 50:";
+    const double worst = std::max({
+        timeQuery(db, "rare", QStringLiteral("needle0")),
+        timeQuery(db, "common", words[0]),
+        timeQuery(db, "mid", words[500]),
+        timeQuery(db, "prefix", words[50].left(3)),
+        timeQuery(db, "typing", typing),
+        timeQuery(db, "two words", words[20] + QLatin1Char(' ') + words[300]),
+        timeQuery(db, "tool input", QStringLiteral("src ") + words[10]),
+        timeQuery(db, "workspace", words[500], QStringLiteral("/work/other")),
+    });
+
+    // What search cost before the index: a scan of every message
+    {
+        QSqlDatabase scanDb = QSqlDatabase::addDatabase("QSQLITE", "bench_scan");
+        scanDb.setDatabaseName(path);
+        scanDb.open();
+        QSqlQuery scan(scanDb);
+        QElapsedTimer t;
+        t.start();
+        scan.prepare("SELECT id FROM messages WHERE content LIKE ? OR tool_input LIKE ? LIMIT 50");
+        scan.addBindValue(QStringLiteral("%needle0%"));
+        scan.addBindValue(QStringLiteral("%needle0%"));
+        scan.exec();
+        int rows = 0;
+        while (scan.next()) ++rows;
+        qDebug().noquote() << QStringLiteral("[bench]   LIKE scan  \"needle0\": %1 rows, %2 ms")
+                                  .arg(rows).arg(t.nsecsElapsed() / 1e6, 0, 'f', 2);
+        scan.finish();
+        scanDb.close();
+    }
+    QSqlDatabase::removeDatabase("bench_scan");
+
+    if (worst >= kTargetMs) {
+        qDebug().noquote() << QStringLiteral("[FAIL] search p99 %1 ms, target under %2 ms")
+                                  .arg(worst, 0, 'f', 2).arg(kTargetMs, 0, 'f', 0);
+        return 1;
+    }
+    qDebug().noquote() << QStringLiteral("[PASS] every search p99 under %1 ms").arg(kTargetMs, 0, 'f', 0);
+    return 0;
+}
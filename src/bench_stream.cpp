@@ -0,0 +1,376 @@
+// Headless StreamParser benchmark.
+//  - 1 MB Write: replays a large Write tool call as input_json_delta events
+//    and reports per-delta cost at the start vs. the end of the stream. With
+//    the incremental field scanner the two should be flat (ratio ~1.0).
+//  - Delta throughput: lines/sec and heap allocations per line for a typical
+//    mix of text/thinking/tool deltas, next to a full-DOM parse baseline.
+//  - Capture replay: feeds recorded claude stdout (StreamRecorder format)
+//    through StreamParser and reports lines/sec, MB/sec, signal emissions,
+//    allocations and p50/p99 per-line latency, plus how far delta
+//    coalescing cuts the delta emissions.
+//
+// Usage: bench_stream [--realtime] [capture.jsonl ...]
+// Without files, runs the synthetic benchmarks and every checked-in capture.
+// --realtime paces lines by their recorded timestamps instead of full speed.
+
+#include "core/StreamParser.h"
+#include "core/StreamRecorder.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include <QDebug>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#ifndef CCCPP_BENCH_CAPTURES
+#define CCCPP_BENCH_CAPTURES "bench/captures"
+#endif
+
+// Count heap allocations: every malloc, calloc and realloc call, which
+// covers operator new (std::string, json nodes, std::function...) and Qt's
+// containers alike. glibc lets the executable interpose its allocator entry
+// points; elsewhere nothing is counted and the bench reports n/a.
+static std::atomic<quint64> g_allocations{0};
+
+#if defined(__GLIBC__)
+static constexpr bool kCountsAllocations = true;
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+void *calloc(size_t count, size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+void *realloc(void *p, size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+}
+#else
+static constexpr bool kCountsAllocations = false;
+#endif
+
+static QString allocsPerLine(quint64 allocs, double lines)
+{
+    return kCountsAllocations ? QString::number(allocs / lines, 'f', 2) : QStringLiteral("n/a");
+}
+
+static QByteArray streamEventLine(const nlohmann::json &ev)
+{
+    nlohmann::json line = {{"type", "stream_event"}, {"event", ev}};
+    return QByteArray::fromStdString(line.dump());
+}
+
+static std::string syntheticFileContent(size_t bytes)
+{
+    static const char *kLines[] = {
+        "#include \"core/StreamParser.h\"\n",
+        "    if (x == \"quoted\\path\") {\n",
+        "\treturn QStringLiteral(\"tab\\tseparated\");\n",
+        "// a longer comment line that is mostly plain ASCII text without escapes\n",
+        "}\n",
+    };
+    std::string out;
+    out.reserve(bytes + 128);
+    for (size_t i = 0; out.size() < bytes; ++i)
+        out += kLines[i % 5];
+    return out;
+}
+
+static bool benchLargeWrite()
+{
+    const std::string content = syntheticFileContent(1024 * 1024);
+    const std::string input = nlohmann::json{
+        {"file_path", "/tmp/bench/generated.cpp"},
+        {"content", content}
+    }.dump();
+
+    // Pre-build every line so the timed loop measures only the parser
+    static constexpr size_t kChunk = 48;
+    std::vector<QByteArray> deltas;
+    deltas.reserve(input.size() / kChunk + 1);
+    for (size_t pos = 0; pos < input.size(); pos += kChunk) {
+        deltas.push_back(streamEventLine({
+            {"type", "content_block_delta"},
+            {"index", 1},
+            {"delta", {{"type", "input_json_delta"},
+                       {"partial_json", input.substr(pos, kChunk)}}}
+        }));
+    }
+
+    StreamParser parser;
+    QString streamed;
+    QObject::connect(&parser, &StreamParser::editContentDelta,
+                     [&streamed](int, const QString &text) { streamed += text; });
+
+    parser.feed(streamEventLine({
+        {"type", "content_block_start"},
+        {"index", 1},
+        {"content_block", {{"type", "tool_use"}, {"id", "toolu_bench"},
+                           {"name", "Write"}, {"input", nlohmann::json::object()}}}
+    }));
+
+    std::vector<qint64> nanos;
+    nanos.reserve(deltas.size());
+    QElapsedTimer total;
+    total.start();
+    for (const auto &line : deltas) {
+        QElapsedTimer t;
+        t.start();
+        parser.feed(line);
+        nanos.push_back(t.nsecsElapsed());
+    }
+    qint64 totalNs = total.nsecsElapsed();
+
+    parser.feed(streamEventLine({{"type", "content_block_stop"}, {"index", 1}}));
+
+    const size_t decile = nanos.size() / 10;
+    auto meanOf = [&](size_t from, size_t to) {
+        qint64 sum = 0;
+        for (size_t i = from; i < to; ++i)
+            sum += nanos[i];
+        return static_cast<double>(sum) / static_cast<double>(to - from);
+    };
+    double head = meanOf(0, decile);
+    double tail = meanOf(nanos.size() - decile, nanos.size());
+
+    bool ok = streamed == QString::fromStdString(content);
+    qDebug().noquote() << QStringLiteral("[bench] 1 MB Write: %1 deltas in %2 ms")
+                              .arg(deltas.size()).arg(totalNs / 1e6, 0, 'f', 1);
+    qDebug().noquote() << QStringLiteral("[bench]   per-delta first 10%: %1 us, last 10%: %2 us, ratio %3")
+                              .arg(head / 1e3, 0, 'f', 2).arg(tail / 1e3, 0, 'f', 2)
+                              .arg(tail / head, 0, 'f', 2);
+    qDebug().noquote() << (ok ? "[PASS] streamed content matches input"
+                              : "[FAIL] streamed content differs from input");
+    return ok;
+}
+
+static std::vector<QByteArray> syntheticDeltaMix(int lineCount)
+{
+    std::vector<QByteArray> lines;
+    lines.reserve(static_cast<size_t>(lineCount) + 8);
+    lines.push_back(streamEventLine({{"type", "content_block_start"}, {"index", 0},
+                                     {"content_block", {{"type", "thinking"}, {"thinking", ""}}}}));
+    lines.push_back(streamEventLine({{"type", "content_block_start"}, {"index", 1},
+                                     {"content_block", {{"type", "text"}, {"text", ""}}}}));
+    lines.push_back(streamEventLine({{"type", "content_block_start"}, {"index", 2},
+                                     {"content_block", {{"type", "tool_use"}, {"id", "toolu_grep"},
+                                                        {"name", "Grep"}, {"input", nlohmann::json::object()}}}}));
+    for (int i = 0; i < lineCount; ++i) {
+        int kind = i % 10;
+        nlohmann::json delta;
+        int index = 1;
+        if (kind < 7) {
+            delta = {{"type", "text_delta"}, {"text", "token " + std::to_string(i) + " "}};
+        } else if (kind < 9) {
+            index = 0;
+            delta = {{"type", "thinking_delta"}, {"thinking", "considering the next step "}};
+        } else {
+            index = 2;
+            delta = {{"type", "input_json_delta"}, {"partial_json", "{\"pattern\":\"x\""}};
+        }
+        nlohmann::json line = {
+            {"type", "stream_event"},
+            {"event", {{"type", "content_block_delta"}, {"index", index}, {"delta", delta}}},
+            {"session_id", "6c1f3f0e-8a52-4d5e-9d39-2a2f4c0b7e11"},
+            {"parent_tool_use_id", nullptr},
+            {"uuid", "0b4f6a7e-63a4-4b0e-8d0b-6e9e3c51a9d2"}
+        };
+        lines.push_back(QByteArray::fromStdString(line.dump()));
+    }
+    return lines;
+}
+
+static void benchDeltaThroughput()
+{
+    static constexpr int kLines = 200000;
+    const std::vector<QByteArray> lines = syntheticDeltaMix(kLines);
+    qint64 bytes = 0;
+    for (const auto &l : lines)
+        bytes += l.size();
+
+    StreamParser parser;
+    quint64 emissions = 0;
+    QObject::connect(&parser, &StreamParser::textDelta, [&emissions](const QString &) { ++emissions; });
+    QObject::connect(&parser, &StreamParser::thinkingDelta, [&emissions](const QString &) { ++emissions; });
+
+    quint64 allocBefore = g_allocations.load();
+    QElapsedTimer t;
+    t.start();
+    for (const auto &line : lines)
+        parser.feed(line);
+    qint64 ns = t.nsecsElapsed();
+    quint64 allocs = g_allocations.load() - allocBefore;
+
+    // Baseline: what every line used to cost (full DOM + deep copy)
+    allocBefore = g_allocations.load();
+    QElapsedTimer tb;
+    tb.start();
+    for (const auto &line : lines) {
+        nlohmann::json j = nlohmann::json::parse(line.constData(), line.constData() + line.size());
+        nlohmann::json copy = j;
+        Q_UNUSED(copy);
+    }
+    qint64 baselineNs = tb.nsecsElapsed();
+    quint64 baselineAllocs = g_allocations.load() - allocBefore;
+
+    const double n = static_cast<double>(lines.size());
+    qDebug().noquote() << QStringLiteral("[bench] delta mix: %1 lines, %2 MB, %3 emissions")
+                              .arg(lines.size()).arg(bytes / 1048576.0, 0, 'f', 1).arg(emissions);
+    qDebug().noquote() << QStringLiteral("[bench]   fast path : %1 lines/s, %2 MB/s, %3 allocs/line")
+                              .arg(n / (ns / 1e9), 0, 'f', 0)
+                              .arg((bytes / 1048576.0) / (ns / 1e9), 0, 'f', 1)
+                              .arg(allocsPerLine(allocs, n));
+    qDebug().noquote() << QStringLiteral("[bench]   DOM parse : %1 lines/s, %2 allocs/line (baseline)")
+                              .arg(n / (baselineNs / 1e9), 0, 'f', 0)
+                              .arg(allocsPerLine(baselineAllocs, n));
+}
+
+static void countEmissions(StreamParser &parser, quint64 &n)
+{
+    auto bump = [&n] { ++n; };
+    QObject::connect(&parser, &StreamParser::textDelta, bump);
+    QObject::connect(&parser, &StreamParser::toolUseStarted, bump);
+    QObject::connect(&parser, &StreamParser::toolResultReceived, bump);
+    QObject::connect(&parser, &StreamParser::resultReady, bump);
+    QObject::connect(&parser, &StreamParser::turnCompleted, bump);
+    QObject::connect(&parser, &StreamParser::errorOccurred, bump);
+    QObject::connect(&parser, &StreamParser::eventParsed, bump);
+    QObject::connect(&parser, &StreamParser::checkpointReceived, bump);
+    QObject::connect(&parser, &StreamParser::thinkingStarted, bump);
+    QObject::connect(&parser, &StreamParser::thinkingDelta, bump);
+    QObject::connect(&parser, &StreamParser::thinkingStopped, bump);
+    QObject::connect(&parser, &StreamParser::editStreamStarted, bump);
+    QObject::connect(&parser, &StreamParser::editContentDelta, bump);
+    QObject::connect(&parser, &StreamParser::editStreamFinished, bump);
+}
+
+static bool replayCapture(const QString &path, bool realtime)
+{
+    QString error;
+    const QVector<StreamRecorder::Record> records = StreamRecorder::load(path, &error);
+    const QString name = QFileInfo(path).fileName();
+    if (records.isEmpty()) {
+        qDebug().noquote() << QStringLiteral("[FAIL] %1: %2")
+                                  .arg(name, error.isEmpty() ? QStringLiteral("no records") : error);
+        return false;
+    }
+
+    qint64 bytes = 0;
+    for (const auto &r : records)
+        bytes += r.line.size();
+
+    StreamParser parser;
+    quint64 emissions = 0;
+    int turns = 0;
+    countEmissions(parser, emissions);
+    QObject::connect(&parser, &StreamParser::turnCompleted, [&turns](bool) { ++turns; });
+
+    std::vector<qint64> nanos;
+    nanos.reserve(static_cast<size_t>(records.size()));
+    qint64 parseNs = 0;
+    const qint64 firstUs = records.first().offsetUs;
+    quint64 allocBefore = g_allocations.load();
+    QElapsedTimer wall;
+    wall.start();
+    for (const auto &r : records) {
+        if (realtime) {
+            qint64 dueUs = r.offsetUs - firstUs;
+            qint64 nowUs = wall.nsecsElapsed() / 1000;
+            if (dueUs > nowUs)
+                QThread::usleep(static_cast<unsigned long>(dueUs - nowUs));
+        }
+        QElapsedTimer t;
+        t.start();
+        parser.feed(r.line);
+        qint64 ns = t.nsecsElapsed();
+        nanos.push_back(ns);
+        parseNs += ns;
+    }
+    qint64 wallNs = wall.nsecsElapsed();
+    quint64 allocs = g_allocations.load() - allocBefore;
+
+    std::sort(nanos.begin(), nanos.end());
+    auto percentile = [&nanos](double p) {
+        size_t i = std::min(nanos.size() - 1, static_cast<size_t>(p * static_cast<double>(nanos.size())));
+        return nanos[i] / 1e3;
+    };
+
+    const double n = static_cast<double>(records.size());
+    const double secs = parseNs / 1e9;
+    qDebug().noquote() << QStringLiteral("[bench] %1: %2 lines, %3 MB, %4 turns, %5 emissions")
+                              .arg(name).arg(records.size()).arg(bytes / 1048576.0, 0, 'f', 2)
+                              .arg(turns).arg(emissions);
+    qDebug().noquote() << QStringLiteral("[bench]   %1 lines/s, %2 MB/s, %3 allocs/line, p50 %4 us, p99 %5 us")
+                              .arg(n / secs, 0, 'f', 0)
+                              .arg((bytes / 1048576.0) / secs, 0, 'f', 1)
+                              .arg(allocsPerLine(allocs, n))
+                              .arg(percentile(0.50), 0, 'f', 2)
+                              .arg(percentile(0.99), 0, 'f', 2);
+
+    // Same capture in the I/O-thread configuration: batched and coalescing,
+    // with one batch taken per 16 ms of recorded time
+    StreamParser coalescing;
+    coalescing.setBatched(true);
+    coalescing.setCoalescing(true);
+    int batches = 0;
+    qint64 frameEndUs = firstUs + 16000;
+    for (const auto &r : records) {
+        if (r.offsetUs >= frameEndUs) {
+            if (coalescing.hasBatch()) {
+                coalescing.takeBatch();
+                ++batches;
+            }
+            frameEndUs = r.offsetUs + 16000;
+        }
+        coalescing.feed(r.line);
+    }
+    if (coalescing.hasBatch()) {
+        coalescing.takeBatch();
+        ++batches;
+    }
+    const StreamParser::EmissionStats stats = coalescing.emissionStats();
+    qDebug().noquote() << QStringLiteral("[bench]   coalesced: %1 -> %2 delta emissions (%3x), %4 batches")
+                              .arg(stats.deltasIn).arg(stats.deltasOut)
+                              .arg(stats.reductionRatio(), 0, 'f', 1).arg(batches);
+    if (realtime) {
+        qDebug().noquote() << QStringLiteral("[bench]   real-time replay: %1 s wall, parser busy %2%")
+                                  .arg(wallNs / 1e9, 0, 'f', 1)
+                                  .arg(100.0 * parseNs / qMax<qint64>(wallNs, 1), 0, 'f', 3);
+    }
+    return turns > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList files = app.arguments().mid(1);
+    const bool realtime = files.removeAll(QStringLiteral("--realtime")) > 0;
+
+    bool ok = true;
+    if (files.isEmpty()) {
+        ok = benchLargeWrite();
+        benchDeltaThroughput();
+        QDir dir(QStringLiteral(CCCPP_BENCH_CAPTURES));
+        for (const QString &f : dir.entryList({QStringLiteral("*.jsonl")}, QDir::Files, QDir::Name))
+            files << dir.filePath(f);
+    }
+    for (const QString &path : files)
+        ok = replayCapture(path, realtime) && ok;
+    return ok ? 0 : 1;
+}
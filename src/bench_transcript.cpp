@@ -0,0 +1,119 @@
+// Headless chat column resize benchmark.
+// Puts a transcript of rendered assistant messages (MessageTextView, HTML
+// from MarkdownRenderer) in a widget-resizable scroll area like the chat's,
+// then drags its width down and back up a few pixels at a time. The way down
+// enters width buckets no view has seen, so every document lays out again;
+// the way back only hits cached heights. Runs on the offscreen platform and
+// fails when a resize to widths already seen misses a 16 ms frame.
+//
+// Usage: bench_transcript [messages]     (default 500)
+
+#include "ui/MessageTextView.h"
+#include "util/MarkdownRenderer.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QScrollArea>
+#include <QTextDocument>
+#include <QVBoxLayout>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+static constexpr int kWideWidth = 900;
+static constexpr int kNarrowWidth = 420;
+static constexpr int kDragStep = 3;
+static constexpr double kFrameMs = 16.0;
+
+static QString syntheticMessage(int i)
+{
+    QString out = QStringLiteral(
+        "The **parser** in step %1 calls `feed()` once per line and never re-scans the "
+        "buffer, so a long answer costs the same per byte as a short one. "
+        "See [the notes](https://example.com/notes/%1) for details.\n\n").arg(i);
+    if (i % 3 == 0)
+        out += QStringLiteral("- keep `m_pending` small\n- flush on `content_block_stop`\n"
+                              "- measure before and after\n\n");
+    if (i % 4 == 0)
+        out += QStringLiteral("```cpp\nfor (int i = 0; i < %1; ++i) {\n"
+                              "    if (a < b && c > d)\n"
+                              "        emit textDelta(QStringLiteral(\"step %1\"));\n"
+                              "}\n```\n\n").arg(i);
+    for (int p = 0; p < i % 5; ++p)
+        out += QStringLiteral("Paragraph %1 wraps over a few lines at the usual column "
+                              "widths, which is what makes the height depend on the width "
+                              "in the first place.\n\n").arg(p + 1);
+    return out;
+}
+
+struct Sweep {
+    double meanMs = 0;
+    double maxMs = 0;
+    int resizes = 0;
+};
+
+static Sweep drag(QScrollArea &area, int from, int to)
+{
+    std::vector<double> times;
+    const int step = from < to ? kDragStep : -kDragStep;
+    for (int w = from + step; step > 0 ? w <= to : w >= to; w += step) {
+        QElapsedTimer t;
+        t.start();
+        area.resize(w, area.height());
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::LayoutRequest);
+        times.push_back(t.nsecsElapsed() / 1e6);
+    }
+    Sweep s;
+    s.resizes = int(times.size());
+    for (double ms : times)
+        s.meanMs += ms / times.size();
+    s.maxMs = times.empty() ? 0 : *std::max_element(times.begin(), times.end());
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    const int messages = argc > 1 ? qMax(1, QString::fromLocal8Bit(argv[1]).toInt()) : 500;
+
+    MarkdownRenderer renderer;
+    QScrollArea area;
+    area.setWidgetResizable(true);
+    auto *column = new QWidget;
+    auto *layout = new QVBoxLayout(column);
+    layout->setSpacing(8);
+    for (int i = 0; i < messages; ++i) {
+        auto *view = new MessageTextView(column);
+        view->document()->setHtml(renderer.toHtml(syntheticMessage(i)));
+        layout->addWidget(view);
+    }
+    layout->addStretch();
+    area.setWidget(column);
+    area.resize(kWideWidth, 800);
+    area.show();
+    QCoreApplication::processEvents();
+
+    const Sweep narrowing = drag(area, kWideWidth, kNarrowWidth);
+    const Sweep widening = drag(area, kNarrowWidth, kWideWidth);
+    const Sweep again = drag(area, kWideWidth, kNarrowWidth);
+
+    qDebug().noquote() << QStringLiteral("[bench] %1 messages, %2 px steps").arg(messages).arg(kDragStep);
+    const auto report = [](const char *what, const Sweep &s) {
+        qDebug().noquote() << QStringLiteral("[bench] %1: %2 resizes, mean %3 ms, max %4 ms")
+            .arg(QLatin1String(what)).arg(s.resizes)
+            .arg(s.meanMs, 0, 'f', 2).arg(s.maxMs, 0, 'f', 2);
+    };
+    report("new widths (layout every document)", narrowing);
+    report("seen widths, widening", widening);
+    report("seen widths, narrowing", again);
+
+    const double seenMax = std::max(widening.maxMs, again.maxMs);
+    if (seenMax >= kFrameMs) {
+        qDebug().noquote() << QStringLiteral("[FAIL] resize to a seen width took %1 ms, over the %2 ms frame")
+            .arg(seenMax, 0, 'f', 2).arg(kFrameMs, 0, 'f', 0);
+        return 1;
+    }
+    qDebug().noquote() << "[PASS] resizes to seen widths fit in a frame";
+    return 0;
+}
@@ -1,27 +1,48 @@
 #include "core/ClaudeProcess.h"
+#include "core/ProcessIoWorker.h"
 #include "core/StreamParser.h"
 #include "util/Config.h"
 #include <nlohmann/json.hpp>
-#include <QProcessEnvironment>
+#include <QTimer>
+#include <QThread>
 #include <QDir>
-#include <QFile>
-#include <QStandardPaths>
-#include <QUuid>
+#include <QDateTime>
 #include <QDebug>
 
+static constexpr int kDefaultIdleTimeoutMs = 10 * 60 * 1000;
+
 ClaudeProcess::ClaudeProcess(QObject *parent)
     : QObject(parent)
     , m_parser(new StreamParser(this))
+    , m_idleTimer(new QTimer(this))
 {
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(kDefaultIdleTimeoutMs);
+    connect(m_idleTimer, &QTimer::timeout, this, [this] {
+        qCDebug(lcProcess) << "[cccpp] Persistent claude process idle, shutting down";
+        stopPersistentProcess();
+    });
+    connect(m_parser, &StreamParser::turnCompleted,
+            this, &ClaudeProcess::onTurnCompleted);
+    connect(m_parser, &StreamParser::resultReady, this, [this](const QString &sid, const nlohmann::json &) {
+        if (!sid.isEmpty())
+            m_liveSessionId = sid;
+    });
 }
 
 ClaudeProcess::~ClaudeProcess()
 {
-    if (m_process && m_process->state() != QProcess::NotRunning) {
-        m_process->disconnect(this);
-        m_process->terminate();
-        m_process->waitForFinished(2000);
-    }
+    if (!m_worker)
+        return;
+    ProcessIoWorker *worker = m_worker;
+    m_worker = nullptr;
+    worker->disconnect(this);
+    // Stop the process where it lives, without waiting on it: the worker
+    // deletes itself once the process is gone
+    if (worker->thread()->isRunning())
+        QMetaObject::invokeMethod(worker, [worker] { worker->terminate(); }, Qt::QueuedConnection);
+    else
+        delete worker;
 }
 
 void ClaudeProcess::setWorkingDirectory(const QString &dir)
@@ -57,134 +78,251 @@ void ClaudeProcess::setProfileIds(const QStringList &ids)
 void ClaudeProcess::setAgentName(const QString &name) { m_agentName = name; }
 void ClaudeProcess::setTeamId(const QString &teamId) { m_teamId = teamId; }
 
-QProcessEnvironment ClaudeProcess::buildProcessEnvironment() const
+QMap<QString, QString> ClaudeProcess::buildEnvironmentOverrides() const
 {
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    QString path = env.value("PATH");
-    QStringList extraPaths = {
-        QDir::homePath() + "/.local/bin",
-        "/usr/local/bin",
-        "/opt/homebrew/bin",
-        "/opt/homebrew/sbin",
-    };
-    QDir nvmDir(QDir::homePath() + "/.nvm/versions/node");
-    if (nvmDir.exists()) {
-        QStringList versions = nvmDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-        if (!versions.isEmpty())
-            extraPaths.prepend(nvmDir.absoluteFilePath(versions.last()) + "/bin");
-    }
-    for (const QString &p : extraPaths) {
-        if (!path.contains(p) && QDir(p).exists())
-            path = p + ":" + path;
-    }
-    env.insert("PATH", path);
-    if (env.value("HOME").isEmpty())
-        env.insert("HOME", QDir::homePath());
-    env.insert("CLAUDE_CODE_ENABLE_SDK_FILE_CHECKPOINTING", "1");
-
+    QMap<QString, QString> env;
     // Peer messaging: inject agent identity (inherited by MCP server subprocess)
     if (!m_agentName.isEmpty())
         env.insert("CCCPP_AGENT_NAME", m_agentName);
     if (!m_teamId.isEmpty())
         env.insert("CCCPP_TEAM_ID", m_teamId);
-
     return env;
 }
 
-QString ClaudeProcess::resolveClaudeBinary() const
+ProcessLauncher::LaunchSpec ClaudeProcess::launchSpec() const
 {
-    QString claudeBin = Config::instance().claudeBinary();
-    if (claudeBin == "claude" || claudeBin.isEmpty()) {
-        QStringList searchDirs = {
-            QDir::homePath() + "/.local/bin",
-            "/usr/local/bin",
-            "/opt/homebrew/bin",
-        };
-        for (const QString &dir : searchDirs) {
-            QString candidate = dir + "/claude";
-            if (QFile::exists(candidate))
-                return candidate;
-        }
-    }
-    return claudeBin;
+    return {m_workingDir, buildArguments(), buildEnvironmentOverrides()};
 }
 
-void ClaudeProcess::sendMessage(const QString &message,
-                                const QList<QPair<QByteArray, QString>> &images)
+void ClaudeProcess::setPersistent(bool persistent)
 {
-    if (m_process && m_process->state() != QProcess::NotRunning) {
-        emit errorOccurred("Process already running");
+    if (m_persistent == persistent)
         return;
+    m_persistent = persistent;
+    if (!persistent)
+        stopPersistentProcess();
+}
+
+void ClaudeProcess::setIdleTimeout(int ms)
+{
+    m_idleTimer->setInterval(ms);
+}
+
+QString ClaudeProcess::launchSignature() const
+{
+    // Everything baked into the command line or environment at spawn time.
+    // The session id is tracked separately (see m_liveSessionId).
+    return launchSpec().key() + QChar(0x1f) + ProcessLauncher::instance().claudeBinary();
+}
+
+void ClaudeProcess::prewarm()
+{
+    // Parked on an I/O thread, where a worker can take one over as it is
+    if (m_sessionId.isEmpty())
+        ProcessLauncher::instance().prewarm(launchSpec(), ProcessIoWorker::ioThread());
+}
+
+bool ClaudeProcess::ensureProcess()
+{
+    bool alive = m_worker && m_processAlive;
+    if (alive && m_persistent
+        && m_launchSignature == launchSignature()
+        && (m_sessionId.isEmpty() || m_sessionId == m_liveSessionId)) {
+        m_idleTimer->stop();
+        qCDebug(lcProcess) << "[cccpp] Reusing claude process pid=" << m_pid;
+        return true;
     }
+    if (m_worker)
+        retireProcess();
+    return spawnProcess();
+}
 
-    m_parser->reset();
-    m_stdoutBuffer.clear();
-    m_stderrBuffer.clear();
+bool ClaudeProcess::spawnProcess()
+{
+    m_launchSignature = launchSignature();
+    m_liveSessionId = m_sessionId;
+
+    QString capturePath;
+    const QString captureDir = Config::instance().streamCaptureDir();
+    if (!captureDir.isEmpty()) {
+        capturePath = QDir(captureDir).filePath(QStringLiteral("%1-%2.jsonl").arg(
+            QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz"),
+            m_sessionId.isEmpty() ? QStringLiteral("new") : m_sessionId));
+    }
 
-    m_process = new QProcess(this);
-    if (!m_workingDir.isEmpty())
-        m_process->setWorkingDirectory(m_workingDir);
-
-    m_process->setProcessEnvironment(buildProcessEnvironment());
-
-    connect(m_process, &QProcess::readyReadStandardOutput,
-            this, &ClaudeProcess::onReadyReadStdout);
-    connect(m_process, &QProcess::readyReadStandardError,
-            this, &ClaudeProcess::onReadyReadStderr);
-    connect(m_process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
-            this, &ClaudeProcess::onProcessFinished);
-    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError err) {
-        QString msg;
-        switch (err) {
-        case QProcess::FailedToStart:
-            msg = "Failed to start 'claude'. Is it installed and in your PATH?"; break;
-        case QProcess::Crashed:
-            msg = "Claude process crashed."; break;
-        case QProcess::Timedout:
-            msg = "Claude process timed out."; break;
-        case QProcess::WriteError:
-            msg = "Write error communicating with claude."; break;
-        case QProcess::ReadError:
-            msg = "Read error communicating with claude."; break;
-        default:
-            msg = "Unknown process error."; break;
-        }
-        qWarning() << "QProcess error:" << msg;
-        emit errorOccurred(msg);
+    // Never blocks: the process is adopted or created on the worker's
+    // thread, and may still be starting when the envelope is written, in
+    // which case QProcess buffers it.
+    ProcessLauncher &launcher = ProcessLauncher::instance();
+    QProcess *parked = m_sessionId.isEmpty() ? launcher.takeParked(launchSpec()) : nullptr;
+    const ProcessLauncher::Command command = launcher.command(launchSpec(), m_sessionId);
+    auto *worker = new ProcessIoWorker(capturePath);
+    m_worker = worker;
+    m_pid = 0;
+    m_processAlive = true;
+    connectWorker(worker);
+    worker->moveToThread(parked ? parked->thread() : ProcessIoWorker::ioThread());
+    QMetaObject::invokeMethod(worker, [worker, parked, command] {
+        worker->start(parked, command);
+    }, Qt::QueuedConnection);
+
+    QString info = QStringLiteral("[cccpp] Claude process %1 | model=%2")
+        .arg(parked ? "reused from pool" : "starting",
+             m_model.isEmpty() ? "default" : m_model);
+    if (!m_profileIds.isEmpty())
+        info += QStringLiteral(" | profiles=[%1]").arg(m_profileIds.join(", "));
+    if (m_persistent)
+        info += QStringLiteral(" | persistent");
+    qCDebug(lcProcess).noquote() << info;
+    qCDebug(lcProcess) << "[cccpp] Working dir:" << m_workingDir;
+    return true;
+}
+
+void ClaudeProcess::connectWorker(ProcessIoWorker *worker)
+{
+    // Signals from a retired or cancelled worker may still be queued; only
+    // the current one speaks for this session.
+    connect(worker, &ProcessIoWorker::processStarted, this, [this, worker](qint64 pid) {
+        if (worker == m_worker)
+            m_pid = pid;
+    });
+    connect(worker, &ProcessIoWorker::eventsReady, this,
+            [this, worker](const QVector<StreamEvent> &events) {
+        if (worker == m_worker)
+            m_parser->dispatch(events);
+    });
+    connect(worker, &ProcessIoWorker::turnMetricsReady, this,
+            [this, worker](const TurnMetrics &metrics) {
+        if (worker != m_worker)
+            return;
+        m_lastTurnMetrics = metrics;
+        qCDebug(lcProcess).noquote() << "[cccpp] turn timing:" << metrics.summary();
+        emit turnMetricsReady(metrics);
     });
-    connect(m_process, &QProcess::started, this, [this] {
-        QString info = QStringLiteral("[cccpp] Claude process started | model=%1")
-            .arg(m_model.isEmpty() ? "default" : m_model);
-        if (!m_profileIds.isEmpty())
-            info += QStringLiteral(" | profiles=[%1]").arg(m_profileIds.join(", "));
-        qDebug().noquote() << info;
+    connect(worker, &ProcessIoWorker::processFinished, this,
+            [this, worker](int exitCode, QProcess::ExitStatus status, const QByteArray &err) {
+        if (worker != m_worker)
+            return;
+        qCDebug(lcProcess) << "[cccpp] claude process exited" << exitCode
+                 << (status == QProcess::NormalExit ? "Normal" : "Crash");
+        onProcessFinished(exitCode, err);
     });
+    connect(worker, &ProcessIoWorker::processError, this,
+            [this, worker](QProcess::ProcessError err) {
+        if (worker == m_worker)
+            onProcessError(err);
+    });
+    connect(worker, &ProcessIoWorker::writeFailed, this,
+            [this, worker](const QByteArray &data) {
+        if (worker != m_worker)
+            return;
+        if (m_persistent && !m_writeRetried) {
+            // The kept-alive process went away under us: start over once
+            m_writeRetried = true;
+            qCDebug(lcProcess) << "[cccpp] Write to persistent process failed, respawning";
+            retireProcess();
+            spawnProcess();
+            QMetaObject::invokeMethod(m_worker, [w = m_worker, data, sentAt = m_turnSentAtMs] {
+                w->write(data, false, sentAt);
+            }, Qt::QueuedConnection);
+            return;
+        }
+        emit errorOccurred("Write error communicating with claude.");
+        retireProcess();
+        if (m_turnActive) {
+            m_turnActive = false;
+            emit finished(-1);
+        }
+    });
+}
 
-    QString claudeBin = resolveClaudeBinary();
-    QStringList args = buildArguments(message);
-    qDebug() << "[cccpp] Starting:" << claudeBin;
-    qDebug() << "[cccpp] Working dir:" << m_workingDir;
-
-    // Force line-buffered stdout via stdbuf if available, otherwise run directly
-    QString stdbuf = "/usr/bin/stdbuf";
-    if (!QFile::exists(stdbuf))
-        stdbuf = "/opt/homebrew/bin/stdbuf";
-
-    if (QFile::exists(stdbuf)) {
-        QStringList wrappedArgs;
-        wrappedArgs << "-oL" << claudeBin << args;
-        qDebug() << ">>> Using stdbuf wrapper";
-        m_process->start(stdbuf, wrappedArgs);
-    } else {
-        m_process->start(claudeBin, args);
+void ClaudeProcess::onProcessError(QProcess::ProcessError err)
+{
+    // A persistent process dying between turns is respawned on the next send
+    if (m_persistent && !m_turnActive && err != QProcess::FailedToStart)
+        return;
+    QString msg;
+    switch (err) {
+    case QProcess::FailedToStart:
+        msg = "Failed to start 'claude'. Is it installed and in your PATH?"; break;
+    case QProcess::Crashed:
+        msg = "Claude process crashed."; break;
+    case QProcess::Timedout:
+        msg = "Claude process timed out."; break;
+    case QProcess::WriteError:
+        msg = "Write error communicating with claude."; break;
+    case QProcess::ReadError:
+        msg = "Read error communicating with claude."; break;
+    default:
+        msg = "Unknown process error."; break;
+    }
+    qWarning() << "QProcess error:" << msg;
+    emit errorOccurred(msg);
+
+    // No finished() follows a failed start, so end the turn here
+    if (err == QProcess::FailedToStart) {
+        m_processAlive = false;
+        retireProcess();
+        bool wasActive = m_turnActive;
+        m_turnActive = false;
+        if (wasActive)
+            emit finished(-1);
     }
+}
 
-    if (!m_process->waitForStarted(5000)) {
-        qWarning() << "[cccpp] Process failed to start within 5 seconds";
-        emit errorOccurred(QStringLiteral("Process failed to start: %1").arg(claudeBin));
+void ClaudeProcess::retireProcess()
+{
+    // Let the old process finish on its own once stdin closes; nothing it
+    // prints from here on belongs to a turn we care about.
+    ProcessIoWorker *worker = m_worker;
+    m_worker = nullptr;
+    m_processAlive = false;
+    m_pid = 0;
+    m_idleTimer->stop();
+    worker->disconnect(this);
+    QMetaObject::invokeMethod(worker, [worker] { worker->retire(); }, Qt::QueuedConnection);
+}
+
+void ClaudeProcess::stopPersistentProcess()
+{
+    if (!m_worker || m_turnActive)
+        return;
+    qCDebug(lcProcess) << "[cccpp] Closing idle claude process pid=" << m_pid;
+    retireProcess();
+}
+
+void ClaudeProcess::writeEnvelope(const QByteArray &jsonLine)
+{
+    // The write happens on the I/O thread; a failure comes back as
+    // writeFailed() and is handled in spawnProcess()'s connection.
+    ProcessIoWorker *worker = m_worker;
+    const bool closeAfter = !m_persistent;
+    m_writeRetried = false;
+    // onTurnCompleted() logs the deltas of this turn, not the session's
+    m_parser->resetEmissionStats();
+    m_turnSentAtMs = m_turnRequestedAtMs > 0 ? m_turnRequestedAtMs : TurnTimer::clockMs();
+    m_turnRequestedAtMs = 0;
+    QMetaObject::invokeMethod(worker, [worker, jsonLine, closeAfter, sentAt = m_turnSentAtMs] {
+        worker->write(jsonLine, closeAfter, sentAt);
+    }, Qt::QueuedConnection);
+}
+
+void ClaudeProcess::markTurnRequested()
+{
+    m_turnRequestedAtMs = TurnTimer::clockMs();
+}
+
+void ClaudeProcess::sendMessage(const QString &message,
+                                const QList<QPair<QByteArray, QString>> &images)
+{
+    if (isRunning()) {
+        emit errorOccurred("Process already running");
         return;
     }
 
+    if (!ensureProcess())
+        return;
+
     nlohmann::json contentArray = nlohmann::json::array();
     for (const auto &img : images) {
         contentArray.push_back({
@@ -209,64 +347,21 @@ void ClaudeProcess::sendMessage(const QString &message,
         }}
     };
     QByteArray jsonMsg = QByteArray::fromStdString(envelope.dump()) + "\n";
-    m_process->write(jsonMsg);
-    m_process->closeWriteChannel();
-
+    m_turnActive = true;
     emit started();
+    writeEnvelope(jsonMsg);
 }
 
 void ClaudeProcess::sendToolResult(const QString &toolUseId, const QString &content)
 {
-    if (m_process && m_process->state() != QProcess::NotRunning) {
+    if (isRunning()) {
         emit errorOccurred("Process already running");
         return;
     }
 
-    m_parser->reset();
-    m_stdoutBuffer.clear();
-    m_stderrBuffer.clear();
-
-    m_process = new QProcess(this);
-    if (!m_workingDir.isEmpty())
-        m_process->setWorkingDirectory(m_workingDir);
-
-    m_process->setProcessEnvironment(buildProcessEnvironment());
-
-    connect(m_process, &QProcess::readyReadStandardOutput,
-            this, &ClaudeProcess::onReadyReadStdout);
-    connect(m_process, &QProcess::readyReadStandardError,
-            this, &ClaudeProcess::onReadyReadStderr);
-    connect(m_process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
-            this, &ClaudeProcess::onProcessFinished);
-    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError err) {
-        QString msg;
-        switch (err) {
-        case QProcess::FailedToStart: msg = "Failed to start 'claude'. Is it installed and in your PATH?"; break;
-        case QProcess::Crashed:       msg = "Claude process crashed."; break;
-        default:                      msg = "Process error."; break;
-        }
-        emit errorOccurred(msg);
-    });
-
-    QString claudeBin = resolveClaudeBinary();
-    // Use an empty placeholder message for buildArguments (only session/model flags matter)
-    QStringList args = buildArguments(QString());
-    qDebug() << "[cccpp] sendToolResult: starting" << claudeBin;
-
-    QString stdbuf = "/usr/bin/stdbuf";
-    if (!QFile::exists(stdbuf))
-        stdbuf = "/opt/homebrew/bin/stdbuf";
-
-    if (QFile::exists(stdbuf)) {
-        m_process->start(stdbuf, QStringList() << "-oL" << claudeBin << args);
-    } else {
-        m_process->start(claudeBin, args);
-    }
-
-    if (!m_process->waitForStarted(5000)) {
-        emit errorOccurred(QStringLiteral("Process failed to start: %1").arg(claudeBin));
+    qCDebug(lcProcess) << "[cccpp] sendToolResult:" << toolUseId;
+    if (!ensureProcess())
         return;
-    }
 
     nlohmann::json envelope = {
         {"type", "user"},
@@ -282,44 +377,43 @@ void ClaudeProcess::sendToolResult(const QString &toolUseId, const QString &cont
         }}
     };
     QByteArray jsonMsg = QByteArray::fromStdString(envelope.dump()) + "\n";
-    m_process->write(jsonMsg);
-    m_process->closeWriteChannel();
-
+    m_turnActive = true;
     emit started();
+    writeEnvelope(jsonMsg);
 }
 
 void ClaudeProcess::cancel()
 {
-    QProcess *proc = m_process;
-    if (!proc || proc->state() == QProcess::NotRunning) {
-        qDebug() << "[cccpp] cancel() called but process not running";
+    if (!isRunning()) {
+        qCDebug(lcProcess) << "[cccpp] cancel() called but process not running";
         return;
     }
 
-    qDebug() << "[cccpp] cancel() terminating process pid=" << proc->processId();
-
-    // Disconnect all signals from proc to prevent onProcessFinished from
-    // running inside waitForFinished's nested event loop, which would
-    // deleteLater the QProcess while it's still on the call stack.
-    proc->disconnect(this);
-    m_process = nullptr;
-
-    proc->terminate();
-    if (!proc->waitForFinished(2000)) {
-        qDebug() << "[cccpp] cancel() terminate timeout, killing";
-        proc->kill();
-        proc->waitForFinished(1000);
-    }
-
-    int code = proc->exitCode();
-    proc->deleteLater();
-    qDebug() << "[cccpp] cancel() done, emitting finished(" << code << ")";
-    emit finished(code);
+    qCDebug(lcProcess) << "[cccpp] cancel() terminating process pid=" << m_pid;
+
+    // Detach first so nothing the dying process still reports reaches the
+    // session. A persistent process is killed too; the next send resumes it.
+    ProcessIoWorker *worker = m_worker;
+    m_worker = nullptr;
+    m_processAlive = false;
+    m_pid = 0;
+    m_turnActive = false;
+    worker->disconnect(this);
+
+    // finished() follows once the process is gone; nothing waits for it here
+    connect(worker, &ProcessIoWorker::processFinished, this, [this](int exitCode) {
+        // A turn started since is not the one that was cancelled
+        if (!m_turnActive)
+            emit finished(exitCode);
+    });
+    QMetaObject::invokeMethod(worker, [worker] { worker->terminate(); }, Qt::QueuedConnection);
 }
 
 bool ClaudeProcess::isRunning() const
 {
-    return m_process && m_process->state() != QProcess::NotRunning;
+    if (!m_worker || !m_processAlive)
+        return false;
+    return !m_persistent || m_turnActive;
 }
 
 void ClaudeProcess::rewindFiles(const QString &checkpointUuid)
@@ -329,25 +423,28 @@ void ClaudeProcess::rewindFiles(const QString &checkpointUuid)
         return;
     }
 
+    // Don't leave a kept-alive process holding the session while it's rewound
+    stopPersistentProcess();
+
     auto *proc = new QProcess(this);
     if (!m_workingDir.isEmpty())
         proc->setWorkingDirectory(m_workingDir);
 
-    proc->setProcessEnvironment(buildProcessEnvironment());
+    proc->setProcessEnvironment(ProcessLauncher::instance().environment(buildEnvironmentOverrides()));
 
-    QString claudeBin = resolveClaudeBinary();
+    QString claudeBin = ProcessLauncher::instance().claudeBinary();
     QStringList args;
     args << "--resume" << m_sessionId
          << "--rewind-files" << checkpointUuid;
 
-    qDebug() << "[cccpp] Rewinding:" << claudeBin << args;
+    qCDebug(lcProcess) << "[cccpp] Rewinding:" << claudeBin << args;
 
     connect(proc, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
             this, [this, proc](int exitCode, QProcess::ExitStatus) {
         QString out = QString::fromUtf8(proc->readAllStandardOutput()).trimmed();
         QString err = QString::fromUtf8(proc->readAllStandardError()).trimmed();
         bool ok = (exitCode == 0);
-        qDebug() << "[cccpp] Rewind exit:" << exitCode
+        qCDebug(lcProcess) << "[cccpp] Rewind exit:" << exitCode
                  << "stdout:" << out << "stderr:" << err;
         proc->deleteLater();
         emit rewindCompleted(ok);
@@ -357,7 +454,7 @@ void ClaudeProcess::rewindFiles(const QString &checkpointUuid)
     proc->closeWriteChannel();
 }
 
-QStringList ClaudeProcess::buildArguments(const QString &message) const
+QStringList ClaudeProcess::buildArguments() const
 {
     QStringList args;
     args << "-p";
@@ -370,12 +467,7 @@ QStringList ClaudeProcess::buildArguments(const QString &message) const
     if (!m_model.isEmpty())
         args << "--model" << m_model;
 
-    if (!m_sessionId.isEmpty()) {
-        args << "--resume" << m_sessionId;
-    } else {
-        // Force a fresh session to prevent auto-resuming old sessions from other projects
-        args << "--session-id" << QUuid::createUuid().toString(QUuid::WithoutBraces);
-    }
+    // --resume / --session-id are added by ProcessLauncher
 
     if (!m_systemPrompt.isEmpty())
         args << "--append-system-prompt" << m_systemPrompt;
@@ -408,44 +500,48 @@ QStringList ClaudeProcess::buildArguments(const QString &message) const
     return args;
 }
 
-void ClaudeProcess::onReadyReadStdout()
+void ClaudeProcess::onProcessFinished(int exitCode, const QByteArray &stderrOutput)
 {
-    m_stdoutBuffer.append(m_process->readAllStandardOutput());
-
-    while (true) {
-        int idx = m_stdoutBuffer.indexOf('\n');
-        if (idx < 0)
-            break;
-        QByteArray line = m_stdoutBuffer.left(idx);
-        m_stdoutBuffer.remove(0, idx + 1);
-        if (!line.trimmed().isEmpty())
-            m_parser->feed(line);
+    // Any events parsed before the exit were dispatched already (same
+    // sender, same thread, emitted first). The remainder may have carried
+    // the turn's result event, which already reported the turn as finished.
+    ProcessIoWorker *worker = m_worker;
+    m_worker = nullptr;
+    m_processAlive = false;
+    m_pid = 0;
+    worker->disconnect(this);
+    worker->deleteLater();
+    m_idleTimer->stop();
+
+    const QByteArray err = stderrOutput.trimmed();
+    if (m_persistent && !m_turnActive) {
+        // Idle exit between turns: nobody is waiting on it
+        if (exitCode != 0)
+            qWarning() << "[cccpp] Idle claude process exited:" << exitCode << err;
+        return;
     }
-}
+    m_turnActive = false;
 
-void ClaudeProcess::onReadyReadStderr()
-{
-    m_stderrBuffer.append(m_process->readAllStandardError());
+    if (exitCode != 0 && !err.isEmpty()) {
+        qWarning() << "[cccpp] stderr:" << err;
+        emit errorOccurred(QString::fromUtf8(err));
+    }
+
+    qCDebug(lcProcess) << "[cccpp] emitting finished(" << exitCode << ")";
+    emit finished(exitCode);
 }
 
-void ClaudeProcess::onProcessFinished(int exitCode, QProcess::ExitStatus status)
+void ClaudeProcess::onTurnCompleted(bool isError)
 {
-    qDebug() << "[cccpp] onProcessFinished  exit=" << exitCode
-             << (status == QProcess::NormalExit ? "Normal" : "Crash")
-             << "bufferRemaining=" << m_stdoutBuffer.size() << "bytes";
-
-    if (!m_stdoutBuffer.trimmed().isEmpty())
-        m_parser->feed(m_stdoutBuffer);
-    m_stdoutBuffer.clear();
+    // One-shot processes report turn end via process exit
+    if (!m_persistent || !m_turnActive)
+        return;
 
-    if (exitCode != 0 && !m_stderrBuffer.trimmed().isEmpty()) {
-        qWarning() << "[cccpp] stderr:" << m_stderrBuffer.trimmed();
-        emit errorOccurred(QString::fromUtf8(m_stderrBuffer.trimmed()));
-    }
-    m_stderrBuffer.clear();
+    m_turnActive = false;
+    m_idleTimer->start();
 
-    m_process->deleteLater();
-    m_process = nullptr;
-    qDebug() << "[cccpp] emitting finished(" << exitCode << ")";
-    emit finished(exitCode);
+    const StreamParser::EmissionStats stats = m_parser->emissionStats();
+    qCDebug(lcProcess) << "[cccpp] turn completed, turn deltas" << stats.deltasIn << "->" << stats.deltasOut
+             << "emissions, emitting finished(" << (isError ? 1 : 0) << ")";
+    emit finished(isError ? 1 : 0);
 }
@@ -6,9 +6,18 @@
 #include <QStringList>
 #include <QList>
 #include <QPair>
+#include <QMap>
+#include "core/ProcessLauncher.h"
+#include "core/TurnMetrics.h"
 
 class StreamParser;
+class ProcessIoWorker;
+class QTimer;
 
+// GUI-thread facade over one claude CLI process. The process itself, stdout
+// framing and stream-json parsing live in a ProcessIoWorker on a shared I/O
+// thread; parsed events arrive here in per-frame batches and are re-emitted
+// through streamParser(), so consumers connect to it exactly as before.
 class ClaudeProcess : public QObject {
     Q_OBJECT
 public:
@@ -24,33 +33,65 @@ public:
     void setAgentName(const QString &name);
     void setTeamId(const QString &teamId);
 
+    // Persistent mode keeps one claude process alive across turns and writes
+    // each new message into its open stdin. Turns end on the "result" event
+    // instead of process exit; an idle process is reaped after idleTimeoutMs
+    // and respawned (with --resume) on the next send.
+    void setPersistent(bool persistent);
+    bool isPersistent() const { return m_persistent; }
+    void setIdleTimeout(int ms);
+    // Closes an idle persistent process (e.g. when its tab goes away)
+    void stopPersistentProcess();
+    // Parks a process with the current settings so the first send doesn't
+    // wait for CLI startup. Only useful for fresh sessions.
+    void prewarm();
+
+    // Starts the latency clock for the next send (default: the send itself)
+    void markTurnRequested();
+    TurnMetrics lastTurnMetrics() const { return m_lastTurnMetrics; }
+
     void sendMessage(const QString &message,
                      const QList<QPair<QByteArray, QString>> &images = {});
     void sendToolResult(const QString &toolUseId, const QString &content);
     void rewindFiles(const QString &checkpointUuid);
+    // Ends the turn without waiting for the process: finished() follows once
+    // it has exited, unless another turn was started by then
     void cancel();
-    bool isRunning() const;
+    bool isRunning() const; // a turn is in progress
+    qint64 processId() const { return m_processAlive ? m_pid : 0; }
 
     StreamParser *streamParser() const { return m_parser; }
     QString sessionId() const { return m_sessionId; }
+    QString mode() const { return m_mode; }
+    QString model() const { return m_model; }
 
 signals:
     void started();
     void finished(int exitCode);
     void errorOccurred(const QString &error);
     void rewindCompleted(bool success);
+    // Emitted before the finished() of the turn it describes
+    void turnMetricsReady(const TurnMetrics &metrics);
 
 private slots:
-    void onReadyReadStdout();
-    void onReadyReadStderr();
-    void onProcessFinished(int exitCode, QProcess::ExitStatus status);
+    void onProcessFinished(int exitCode, const QByteArray &stderrOutput);
+    void onProcessError(QProcess::ProcessError error);
+    void onTurnCompleted(bool isError);
 
 private:
-    QStringList buildArguments(const QString &message) const;
-    QProcessEnvironment buildProcessEnvironment() const;
-    QString resolveClaudeBinary() const;
+    QStringList buildArguments() const;
+    QMap<QString, QString> buildEnvironmentOverrides() const;
+    ProcessLauncher::LaunchSpec launchSpec() const;
+    QString launchSignature() const;
+    bool ensureProcess();
+    bool spawnProcess();
+    void connectWorker(ProcessIoWorker *worker);
+    void retireProcess();
+    void writeEnvelope(const QByteArray &jsonLine);
 
-    QProcess *m_process = nullptr;
+    ProcessIoWorker *m_worker = nullptr; // lives on an I/O thread
+    bool m_processAlive = false;
+    qint64 m_pid = 0;
     StreamParser *m_parser = nullptr;
     QString m_workingDir;
     QString m_sessionId;
@@ -60,6 +101,14 @@ private:
     QStringList m_profileIds;
     QString m_agentName;   // peer messaging: this agent's name (e.g. "implementer-2")
     QString m_teamId;      // peer messaging: team UUID for inbox scoping
-    QByteArray m_stdoutBuffer;
-    QByteArray m_stderrBuffer;
+
+    bool m_persistent = false;
+    bool m_turnActive = false;
+    bool m_writeRetried = false; // one respawn per envelope
+    qint64 m_turnRequestedAtMs = 0;
+    qint64 m_turnSentAtMs = 0;
+    TurnMetrics m_lastTurnMetrics;
+    QString m_launchSignature; // flags the live process was started with
+    QString m_liveSessionId;   // session the live process is attached to
+    QTimer *m_idleTimer = nullptr;
 };
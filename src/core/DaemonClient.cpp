@@ -125,14 +125,16 @@ void DaemonClient::onDisconnected()
 
 void DaemonClient::onReadyRead()
 {
-    m_readBuffer.append(m_socket->readAll());
+    m_readFramer.readFrom(m_socket);
 
+    QByteArray line;
     while (true) {
-        int idx = m_readBuffer.indexOf('\n');
-        if (idx < 0) break;
-
-        QByteArray line = m_readBuffer.left(idx);
-        m_readBuffer.remove(0, idx + 1);
+        LineFramer::Result r = m_readFramer.next(line);
+        if (r == LineFramer::NoLine) break;
+        if (r == LineFramer::Overflow) {
+            qWarning() << "[DaemonClient] Dropped oversized IPC message";
+            continue;
+        }
 
         if (!line.isEmpty())
             processMessage(line);
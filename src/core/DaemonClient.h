@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/ChatHandler.h"
+#include "core/LineFramer.h"
 #include <QLocalSocket>
 #include <QTimer>
 
@@ -40,7 +41,7 @@ private:
     void attemptReconnect();
 
     QLocalSocket *m_socket = nullptr;
-    QByteArray m_readBuffer;
+    LineFramer m_readFramer{kMaxIpcLineSize};
     QString m_workspaceName;
     QMap<QString, std::function<void(qint64)>> m_pendingMessageIds;
 
@@ -49,4 +50,5 @@ private:
     bool m_wasConnected = false; // true after first successful connection
     static constexpr int kMaxReconnectAttempts = 15;
     static constexpr int kReconnectIntervalMs = 2000;
+    static constexpr qsizetype kMaxIpcLineSize = 16 * 1024 * 1024;
 };
@@ -5,12 +5,28 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QDateTime>
+#include <QDebug>
+#include <QSet>
+#include <iterator>
+#include <limits>
 
 Database::Database(QObject *parent)
     : QObject(parent)
 {
 }
 
+void Database::sync(unsigned tables)
+{
+    if (!m_writer) return;
+    qint64 ticket = 0;
+    for (int i = 0; i < kTableCount; ++i) {
+        if (tables & (1u << i))
+            ticket = qMax(ticket, m_lastWrite[i]);
+    }
+    if (ticket > 0)
+        m_writer->flush(ticket);
+}
+
 Database::~Database()
 {
     close();
@@ -25,283 +41,972 @@ bool Database::open(const QString &path)
         dbPath = configDir + "/history.db";
     }
 
-    m_db = QSqlDatabase::addDatabase("QSQLITE", "cccpp_main");
+    static int instances = 0;
+    const QString connection = instances++ == 0
+        ? QStringLiteral("cccpp_main") : QStringLiteral("cccpp_main_%1").arg(instances);
+    m_db = QSqlDatabase::addDatabase("QSQLITE", connection);
     m_db.setDatabaseName(dbPath);
 
     if (!m_db.open())
         return false;
 
-    createTables();
+    // WAL lets this connection read while the writer commits
+    QSqlQuery pragma(m_db);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    pragma.exec("PRAGMA busy_timeout=5000");
+
+    if (!migrate()) {
+        m_db.close();
+        return false;
+    }
+    m_writer = std::make_unique<DatabaseWriter>(dbPath, connection + "_writer");
+    if (!m_writer->start())
+        m_writer.reset();  // writes fall back to this connection
+    openSearch();
     return true;
 }
 
 void Database::close()
 {
+    m_writer.reset();
+    for (qint64 &ticket : m_lastWrite)
+        ticket = 0;
+    m_failedWrites = 0;
+    m_reportedFailures = 0;
+    m_hasSearch = false;
     if (m_db.isOpen())
         m_db.close();
 }
 
-void Database::createTables()
+bool Database::flush()
 {
+    if (m_writer) m_writer->flush();
+    const qint64 failed = m_failedWrites + (m_writer ? m_writer->failedGroups() : 0);
+    const bool ok = failed == m_reportedFailures;
+    m_reportedFailures = failed;
+    return ok;
+}
+
+void Database::write(unsigned tables, const QList<DbStatement> &group)
+{
+    if (m_writer) {
+        const qint64 ticket = m_writer->enqueue(group);
+        for (int i = 0; i < kTableCount; ++i) {
+            if (tables & (1u << i))
+                m_lastWrite[i] = ticket;
+        }
+        return;
+    }
+    if (!m_db.transaction()) {
+        qWarning() << "[cccpp] history write failed:" << m_db.lastError().text();
+        ++m_failedWrites;
+        return;
+    }
     QSqlQuery q(m_db);
+    bool ok = true;
+    for (const auto &stmt : group) {
+        ok = q.prepare(stmt.sql);
+        for (int i = 0; ok && i < stmt.values.size(); ++i)
+            q.bindValue(i, stmt.values[i]);
+        ok = ok && q.exec();
+        if (!ok) {
+            qWarning() << "[cccpp] history write failed:" << q.lastError().text() << stmt.sql;
+            break;
+        }
+    }
+    if (ok && m_db.commit())
+        return;
+    if (ok)
+        qWarning() << "[cccpp] history write failed:" << m_db.lastError().text();
+    m_db.rollback();
+    ++m_failedWrites;
+}
+
+// ---------------------------------------------------------------------------
+// Schema migrations
+// ---------------------------------------------------------------------------
 
-    q.exec(
-        "CREATE TABLE IF NOT EXISTS sessions ("
-        "  session_id TEXT PRIMARY KEY,"
-        "  title TEXT,"
-        "  workspace TEXT,"
-        "  mode TEXT,"
-        "  created_at INTEGER,"
-        "  updated_at INTEGER"
-        ")");
-
-    q.exec(
-        "CREATE TABLE IF NOT EXISTS messages ("
-        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  session_id TEXT REFERENCES sessions(session_id),"
-        "  role TEXT,"
-        "  content TEXT,"
-        "  tool_name TEXT,"
-        "  tool_input TEXT,"
-        "  turn_id INTEGER,"
-        "  timestamp INTEGER"
-        ")");
-
-    q.exec(
-        "CREATE TABLE IF NOT EXISTS checkpoints ("
-        "  session_id TEXT NOT NULL REFERENCES sessions(session_id),"
-        "  turn_id INTEGER NOT NULL,"
-        "  uuid TEXT NOT NULL,"
-        "  timestamp INTEGER,"
-        "  PRIMARY KEY (session_id, turn_id)"
-        ")");
-
-    // Drop legacy snapshots table if it exists (replaced by CLI checkpointing)
-    q.exec("DROP TABLE IF EXISTS snapshots");
-
-    // Migrations — add columns introduced after initial schema
-    q.exec("ALTER TABLE sessions ADD COLUMN favorite INTEGER DEFAULT 0");
-
-    // Delegation hierarchy columns
-    q.exec("ALTER TABLE sessions ADD COLUMN parent_session_id TEXT DEFAULT ''");
-    q.exec("ALTER TABLE sessions ADD COLUMN pipeline_id TEXT DEFAULT ''");
-    q.exec("ALTER TABLE sessions ADD COLUMN pipeline_node_id TEXT DEFAULT ''");
-    q.exec("ALTER TABLE sessions ADD COLUMN delegation_task TEXT DEFAULT ''");
-    q.exec("ALTER TABLE sessions ADD COLUMN delegation_status INTEGER DEFAULT 0");
-    q.exec("ALTER TABLE sessions ADD COLUMN delegation_result TEXT DEFAULT ''");
+static bool exec(QSqlQuery &q, const QString &sql)
+{
+    if (q.exec(sql)) return true;
+    qWarning() << "[cccpp] history migration failed:" << q.lastError().text() << sql;
+    return false;
 }
 
-void Database::saveSession(const SessionInfo &info)
+static bool addColumn(QSqlQuery &q, const QString &table, const QString &column,
+                      const QString &decl)
+{
+    q.exec(QStringLiteral("PRAGMA table_info(%1)").arg(table));
+    while (q.next()) {
+        if (q.value(1).toString() == column)
+            return true;
+    }
+    return exec(q, QStringLiteral("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, decl));
+}
+
+// Tables as of the first release, plus every column added before schema
+// versioning existed. Old databases already have some of them
+static bool migrateBaseline(QSqlQuery &q)
+{
+    return exec(q,
+            "CREATE TABLE IF NOT EXISTS sessions ("
+            "  session_id TEXT PRIMARY KEY,"
+            "  title TEXT,"
+            "  workspace TEXT,"
+            "  mode TEXT,"
+            "  created_at INTEGER,"
+            "  updated_at INTEGER"
+            ")")
+        && exec(q,
+            "CREATE TABLE IF NOT EXISTS messages ("
+            "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "  session_id TEXT REFERENCES sessions(session_id),"
+            "  role TEXT,"
+            "  content TEXT,"
+            "  tool_name TEXT,"
+            "  tool_input TEXT,"
+            "  turn_id INTEGER,"
+            "  timestamp INTEGER"
+            ")")
+        && exec(q,
+            "CREATE TABLE IF NOT EXISTS checkpoints ("
+            "  session_id TEXT NOT NULL REFERENCES sessions(session_id),"
+            "  turn_id INTEGER NOT NULL,"
+            "  uuid TEXT NOT NULL,"
+            "  timestamp INTEGER,"
+            "  PRIMARY KEY (session_id, turn_id)"
+            ")")
+        && exec(q,
+            "CREATE TABLE IF NOT EXISTS turn_metrics ("
+            "  session_id TEXT NOT NULL REFERENCES sessions(session_id),"
+            "  turn_id INTEGER NOT NULL,"
+            "  model TEXT,"
+            "  mode TEXT,"
+            "  spawn_ms INTEGER,"
+            "  first_byte_ms INTEGER,"
+            "  ttft_ms INTEGER,"
+            "  tool_ms INTEGER,"
+            "  total_ms INTEGER,"
+            "  tool_count INTEGER,"
+            "  delta_count INTEGER,"
+            "  max_gap_ms INTEGER,"
+            "  gap_histogram TEXT,"
+            "  timestamp INTEGER,"
+            "  PRIMARY KEY (session_id, turn_id)"
+            ")")
+        && exec(q,
+            "CREATE TABLE IF NOT EXISTS render_cache ("
+            "  key TEXT PRIMARY KEY,"
+            "  html TEXT NOT NULL,"
+            "  code_blocks TEXT,"
+            "  bytes INTEGER NOT NULL,"
+            "  last_used INTEGER NOT NULL"
+            ")")
+        && exec(q, "CREATE INDEX IF NOT EXISTS idx_render_cache_last_used ON render_cache(last_used)")
+        // Replaced by CLI checkpointing
+        && exec(q, "DROP TABLE IF EXISTS snapshots")
+        && addColumn(q, "sessions", "favorite", "INTEGER DEFAULT 0")
+        // Delegation hierarchy
+        && addColumn(q, "sessions", "parent_session_id", "TEXT DEFAULT ''")
+        && addColumn(q, "sessions", "pipeline_id", "TEXT DEFAULT ''")
+        && addColumn(q, "sessions", "pipeline_node_id", "TEXT DEFAULT ''")
+        && addColumn(q, "sessions", "delegation_task", "TEXT DEFAULT ''")
+        && addColumn(q, "sessions", "delegation_status", "INTEGER DEFAULT 0")
+        && addColumn(q, "sessions", "delegation_result", "TEXT DEFAULT ''");
+}
+
+// Per-session message lookups and turn counts, and the per-workspace session
+// list newest first. Checkpoints and turn metrics are keyed by their
+// (session_id, turn_id) primary keys already
+static bool migrateIndexes(QSqlQuery &q)
+{
+    return exec(q, "CREATE INDEX IF NOT EXISTS idx_messages_session_turn "
+                   "ON messages(session_id, turn_id)")
+        && exec(q, "CREATE INDEX IF NOT EXISTS idx_sessions_workspace_updated "
+                   "ON sessions(workspace, updated_at)")
+        // Rows from before turn ids were recorded, and sessions that never got
+        // an update time, would sort and count wrong through the indexes
+        && exec(q, "UPDATE messages SET turn_id = 0 WHERE turn_id IS NULL")
+        && exec(q, "UPDATE sessions SET updated_at = COALESCE("
+                   "  (SELECT MAX(timestamp) FROM messages m WHERE m.session_id = sessions.session_id),"
+                   "  created_at, 0) "
+                   "WHERE updated_at IS NULL OR updated_at = 0")
+        && exec(q, "UPDATE sessions SET workspace = '' WHERE workspace IS NULL");
+}
+
+// Tools whose calls count as edits on the fleet cards
+static const char kEditToolsSql[] = "('Edit', 'StrReplace', 'Write', 'MultiEdit')";
+
+static bool isEditTool(const QString &name)
+{
+    return name == QLatin1String("Edit") || name == QLatin1String("StrReplace")
+        || name == QLatin1String("Write") || name == QLatin1String("MultiEdit");
+}
+
+// Per-session aggregates for the fleet, so listing a workspace never touches
+// messages. Backfilled from history; cost and tokens were never stored, so
+// they start at zero
+static bool migrateSessionStats(QSqlQuery &q)
+{
+    return exec(q,
+            "CREATE TABLE IF NOT EXISTS session_stats ("
+            "  session_id TEXT PRIMARY KEY,"
+            "  turn_count INTEGER NOT NULL DEFAULT 0,"
+            "  edit_count INTEGER NOT NULL DEFAULT 0,"
+            "  message_count INTEGER NOT NULL DEFAULT 0,"
+            "  last_activity TEXT,"
+            "  cost_usd REAL NOT NULL DEFAULT 0,"
+            "  input_tokens INTEGER NOT NULL DEFAULT 0,"
+            "  output_tokens INTEGER NOT NULL DEFAULT 0,"
+            "  last_ttft_ms INTEGER NOT NULL DEFAULT -1,"
+            "  last_turn_ms INTEGER NOT NULL DEFAULT -1,"
+            "  last_message_at INTEGER NOT NULL DEFAULT 0"
+            ")")
+        && exec(q, QStringLiteral(
+            "INSERT OR REPLACE INTO session_stats "
+            "(session_id, turn_count, edit_count, message_count, last_activity, last_message_at) "
+            "SELECT session_id, COALESCE(MAX(turn_id), 0),"
+            "  SUM(role = 'tool' AND tool_name IN %1), COUNT(*),"
+            "  (SELECT content FROM messages t WHERE t.session_id = m.session_id AND t.role = 'tool'"
+            "   ORDER BY t.id DESC LIMIT 1),"
+            "  COALESCE(MAX(timestamp), 0) "
+            "FROM messages m GROUP BY session_id").arg(kEditToolsSql))
+        && exec(q,
+            "INSERT OR IGNORE INTO session_stats (session_id) "
+            "SELECT DISTINCT session_id FROM turn_metrics")
+        && exec(q,
+            "UPDATE session_stats SET "
+            "  last_ttft_ms = COALESCE((SELECT ttft_ms FROM turn_metrics t"
+            "    WHERE t.session_id = session_stats.session_id ORDER BY turn_id DESC LIMIT 1), -1),"
+            "  last_turn_ms = COALESCE((SELECT total_ms FROM turn_metrics t"
+            "    WHERE t.session_id = session_stats.session_id ORDER BY turn_id DESC LIMIT 1), -1)");
+}
+
+// Keyset paging by message id: (session_id, rowid) order straight from the
+// index, without sorting
+static bool migrateMessagePaging(QSqlQuery &q)
+{
+    return exec(q, "CREATE INDEX IF NOT EXISTS idx_messages_session ON messages(session_id)");
+}
+
+// SQLite can be built without FTS5 (or load it as an extension)
+static bool hasFts5(QSqlQuery &q)
+{
+    if (!q.exec("CREATE VIRTUAL TABLE temp.fts5_probe USING fts5(x)"))
+        return false;
+    q.exec("DROP TABLE temp.fts5_probe");
+    return true;
+}
+
+// Full-text index over message text and tool inputs. Triggers keep it in
+// step with messages, so the writer's batches index themselves; messages
+// from before the index are added by kSearchBackfillSql, newest first, so
+// the delete and update triggers skip rows it has not reached yet. The
+// prefix index serves three-letter prefixes (see searchMessages); without it
+// every prefix query reads the postings of every word it expands to
+static bool createSearchIndex(QSqlQuery &q)
+{
+    return exec(q,
+            "CREATE VIRTUAL TABLE IF NOT EXISTS messages_fts USING fts5("
+            "content, tool_input, content='messages', content_rowid='id', prefix='3')")
+        && exec(q,
+            "CREATE TRIGGER IF NOT EXISTS messages_fts_insert AFTER INSERT ON messages BEGIN"
+            "  INSERT INTO messages_fts (rowid, content, tool_input)"
+            "  VALUES (new.id, new.content, new.tool_input);"
+            " END")
+        && exec(q,
+            "CREATE TRIGGER IF NOT EXISTS messages_fts_delete AFTER DELETE ON messages "
+            "WHEN EXISTS (SELECT 1 FROM messages_fts_docsize WHERE id = old.id) BEGIN"
+            "  INSERT INTO messages_fts (messages_fts, rowid, content, tool_input)"
+            "  VALUES ('delete', old.id, old.content, old.tool_input);"
+            " END")
+        && exec(q,
+            "CREATE TRIGGER IF NOT EXISTS messages_fts_update "
+            "AFTER UPDATE OF content, tool_input ON messages "
+            "WHEN EXISTS (SELECT 1 FROM messages_fts_docsize WHERE id = old.id) BEGIN"
+            "  INSERT INTO messages_fts (messages_fts, rowid, content, tool_input)"
+            "  VALUES ('delete', old.id, old.content, old.tool_input);"
+            "  INSERT INTO messages_fts (rowid, content, tool_input)"
+            "  VALUES (new.id, new.content, new.tool_input);"
+            " END");
+}
+
+// Without FTS5 the step still counts; open() creates the index on the
+// first start with an SQLite that has it
+static bool migrateSearch(QSqlQuery &q)
+{
+    return !hasFts5(q) || createSearchIndex(q);
+}
+
+// Every message from the lowest indexed id up is in the index (FTS5 keeps a
+// messages_fts_docsize row per indexed message). The writer indexes the
+// next 1000 below it whenever it is idle, until none are left
+static const char kSearchBackfillSql[] =
+    "INSERT INTO messages_fts (rowid, content, tool_input) "
+    "SELECT id, content, tool_input FROM messages "
+    "WHERE id < ifnull((SELECT min(id) FROM messages_fts_docsize), 9223372036854775807) "
+    "ORDER BY id DESC LIMIT 1000";
+
+static bool needsSearchBackfill(QSqlQuery &q)
+{
+    q.exec("SELECT EXISTS (SELECT 1 FROM messages WHERE id < ifnull("
+           "(SELECT min(id) FROM messages_fts_docsize), 9223372036854775807))");
+    return q.next() && q.value(0).toBool();
+}
+
+// A running total of render_cache bytes, so a flush under the limit does
+// not have to add up the table. One row; triggers keep it exact
+static bool migrateRenderCacheSize(QSqlQuery &q)
+{
+    return exec(q,
+            "CREATE TABLE IF NOT EXISTS render_cache_size ("
+            "  id INTEGER PRIMARY KEY CHECK (id = 0),"
+            "  bytes INTEGER NOT NULL"
+            ")")
+        && exec(q,
+            "INSERT OR REPLACE INTO render_cache_size (id, bytes) "
+            "SELECT 0, COALESCE(SUM(bytes), 0) FROM render_cache")
+        && exec(q,
+            "CREATE TRIGGER IF NOT EXISTS render_cache_size_insert "
+            "AFTER INSERT ON render_cache BEGIN"
+            "  UPDATE render_cache_size SET bytes = bytes + new.bytes;"
+            " END")
+        && exec(q,
+            "CREATE TRIGGER IF NOT EXISTS render_cache_size_delete "
+            "AFTER DELETE ON render_cache BEGIN"
+            "  UPDATE render_cache_size SET bytes = bytes - old.bytes;"
+            " END")
+        && exec(q,
+            "CREATE TRIGGER IF NOT EXISTS render_cache_size_update "
+            "AFTER UPDATE OF bytes ON render_cache BEGIN"
+            "  UPDATE render_cache_size SET bytes = bytes - old.bytes + new.bytes;"
+            " END");
+}
+
+using Migration = bool (*)(QSqlQuery &);
+
+// Append only: PRAGMA user_version counts the steps a database has applied
+static const Migration kMigrations[] = {
+    migrateBaseline,
+    migrateIndexes,
+    migrateSessionStats,
+    migrateMessagePaging,
+    migrateSearch,
+    migrateRenderCacheSize,
+};
+
+int Database::schemaVersion() const
+{
+    return int(std::size(kMigrations));
+}
+
+bool Database::migrate()
+{
+    QSqlQuery q(m_db);
+    q.exec("PRAGMA user_version");
+    const int version = q.next() ? q.value(0).toInt() : 0;
+    const int latest = schemaVersion();
+    if (version > latest) {
+        qWarning() << "[cccpp] history database is schema" << version
+                   << "but this build knows" << latest;
+        return true;  // a newer build only ever adds
+    }
+
+    for (int step = version; step < latest; ++step) {
+        m_db.transaction();
+        if (!kMigrations[step](q)
+            || !exec(q, QStringLiteral("PRAGMA user_version = %1").arg(step + 1))) {
+            m_db.rollback();
+            return false;
+        }
+        if (!m_db.commit()) {
+            qWarning() << "[cccpp] history migration commit failed:" << m_db.lastError().text();
+            m_db.rollback();
+            return false;
+        }
+    }
+    return true;
+}
+
+void Database::openSearch()
+{
+    QSqlQuery q(m_db);
+    q.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'messages_fts'");
+    m_hasSearch = q.next();
+    if (!m_hasSearch && hasFts5(q)) {
+        m_db.transaction();
+        m_hasSearch = createSearchIndex(q) && m_db.commit();
+        if (!m_hasSearch)
+            m_db.rollback();
+    }
+    if (!m_hasSearch) {
+        qWarning() << "[cccpp] history search is off (SQLite without FTS5?)";
+        return;
+    }
+    // Without the writer, old messages stay unindexed rather than be indexed
+    // here on the GUI thread
+    if (m_writer && needsSearchBackfill(q))
+        m_writer->setIdleWork({QString::fromLatin1(kSearchBackfillSql), {}});
+}
+
+QStringList Database::queryPlan(const QString &sql, const QVariantList &values)
 {
+    QStringList plan;
     QSqlQuery q(m_db);
-    q.prepare(
+    q.prepare("EXPLAIN QUERY PLAN " + sql);
+    for (int i = 0; i < values.size(); ++i)
+        q.bindValue(i, values[i]);
+    q.exec();
+    while (q.next())
+        plan << q.value(3).toString();
+    return plan;
+}
+
+void Database::saveSession(const SessionInfo &info)
+{
+    write(SessionsTable, {{QStringLiteral(
         "INSERT OR REPLACE INTO sessions "
         "(session_id, title, workspace, mode, created_at, updated_at, favorite, "
         " parent_session_id, pipeline_id, pipeline_node_id, delegation_task, delegation_status, delegation_result) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(info.sessionId);
-    q.addBindValue(info.title);
-    q.addBindValue(info.workspace);
-    q.addBindValue(info.mode);
-    q.addBindValue(info.createdAt);
-    q.addBindValue(info.updatedAt);
-    q.addBindValue(info.favorite ? 1 : 0);
-    q.addBindValue(info.parentSessionId);
-    q.addBindValue(info.pipelineId);
-    q.addBindValue(info.pipelineNodeId);
-    q.addBindValue(info.delegationTask);
-    q.addBindValue(static_cast<int>(info.delegationStatus));
-    q.addBindValue(info.delegationResult);
-    q.exec();
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"),
+        {info.sessionId, info.title, info.workspace, info.mode, info.createdAt,
+         info.updatedAt, info.favorite ? 1 : 0, info.parentSessionId, info.pipelineId,
+         info.pipelineNodeId, info.delegationTask, static_cast<int>(info.delegationStatus),
+         info.delegationResult}}});
+}
+
+static const char kSessionColumns[] =
+    "session_id, title, workspace, mode, created_at, updated_at, favorite, parent_session_id, "
+    "pipeline_id, pipeline_node_id, delegation_task, delegation_status, delegation_result";
+
+static SessionInfo sessionFromQuery(const QSqlQuery &q)
+{
+    SessionInfo info;
+    info.sessionId = q.value(0).toString();
+    info.title = q.value(1).toString();
+    info.workspace = q.value(2).toString();
+    info.mode = q.value(3).toString();
+    info.createdAt = q.value(4).toLongLong();
+    info.updatedAt = q.value(5).toLongLong();
+    info.favorite = q.value(6).toInt() != 0;
+    info.parentSessionId = q.value(7).toString();
+    info.pipelineId = q.value(8).toString();
+    info.pipelineNodeId = q.value(9).toString();
+    info.delegationTask = q.value(10).toString();
+    info.delegationStatus = static_cast<SessionInfo::DelegationStatus>(q.value(11).toInt());
+    info.delegationResult = q.value(12).toString();
+    return info;
 }
 
 QList<SessionInfo> Database::loadSessions()
 {
+    sync(SessionsTable);
     QList<SessionInfo> list;
     QSqlQuery q(m_db);
-    q.exec("SELECT session_id, title, workspace, mode, created_at, updated_at, favorite, "
-           "parent_session_id, pipeline_id, pipeline_node_id, delegation_task, delegation_status, delegation_result "
-           "FROM sessions ORDER BY updated_at DESC");
-    while (q.next()) {
-        SessionInfo info;
-        info.sessionId = q.value(0).toString();
-        info.title = q.value(1).toString();
-        info.workspace = q.value(2).toString();
-        info.mode = q.value(3).toString();
-        info.createdAt = q.value(4).toLongLong();
-        info.updatedAt = q.value(5).toLongLong();
-        info.favorite = q.value(6).toInt() != 0;
-        info.parentSessionId = q.value(7).toString();
-        info.pipelineId = q.value(8).toString();
-        info.pipelineNodeId = q.value(9).toString();
-        info.delegationTask = q.value(10).toString();
-        info.delegationStatus = static_cast<SessionInfo::DelegationStatus>(q.value(11).toInt());
-        info.delegationResult = q.value(12).toString();
-        list.append(info);
-    }
+    q.exec(QStringLiteral("SELECT %1 FROM sessions ORDER BY updated_at DESC").arg(kSessionColumns));
+    while (q.next())
+        list.append(sessionFromQuery(q));
+    return list;
+}
+
+QList<SessionInfo> Database::loadSessions(const QString &workspace)
+{
+    sync(SessionsTable);
+    QList<SessionInfo> list;
+    QSqlQuery q(m_db);
+    q.prepare(QStringLiteral("SELECT %1 FROM sessions WHERE workspace = ? ORDER BY updated_at DESC")
+                  .arg(kSessionColumns));
+    q.addBindValue(workspace);
+    q.exec();
+    while (q.next())
+        list.append(sessionFromQuery(q));
     return list;
 }
 
 SessionInfo Database::loadSession(const QString &sessionId)
 {
+    sync(SessionsTable);
     SessionInfo info;
     QSqlQuery q(m_db);
-    q.prepare("SELECT session_id, title, workspace, mode, created_at, updated_at, favorite, "
-              "parent_session_id, pipeline_id, pipeline_node_id, delegation_task, delegation_status, delegation_result "
-              "FROM sessions WHERE session_id = ? LIMIT 1");
+    q.prepare(QStringLiteral("SELECT %1 FROM sessions WHERE session_id = ? LIMIT 1").arg(kSessionColumns));
     q.addBindValue(sessionId);
     q.exec();
-    if (q.next()) {
-        info.sessionId = q.value(0).toString();
-        info.title = q.value(1).toString();
-        info.workspace = q.value(2).toString();
-        info.mode = q.value(3).toString();
-        info.createdAt = q.value(4).toLongLong();
-        info.updatedAt = q.value(5).toLongLong();
-        info.favorite = q.value(6).toInt() != 0;
-        info.parentSessionId = q.value(7).toString();
-        info.pipelineId = q.value(8).toString();
-        info.pipelineNodeId = q.value(9).toString();
-        info.delegationTask = q.value(10).toString();
-        info.delegationStatus = static_cast<SessionInfo::DelegationStatus>(q.value(11).toInt());
-        info.delegationResult = q.value(12).toString();
-    }
+    if (q.next())
+        info = sessionFromQuery(q);
     return info;
 }
 
-void Database::deleteSession(const QString &sessionId)
+static const char kSessionStatsColumns[] =
+    "COALESCE(st.turn_count, 0), COALESCE(st.edit_count, 0), COALESCE(st.message_count, 0), "
+    "st.last_activity, COALESCE(st.cost_usd, 0), COALESCE(st.input_tokens, 0), "
+    "COALESCE(st.output_tokens, 0), COALESCE(st.last_ttft_ms, -1), "
+    "COALESCE(st.last_turn_ms, -1), COALESCE(st.last_message_at, 0)";
+
+static QString summaryColumns()
+{
+    QStringList columns = QString::fromLatin1(kSessionColumns).split(QLatin1String(", "));
+    for (auto &column : columns)
+        column.prepend(QLatin1String("s."));
+    return columns.join(QLatin1String(", ")) + QLatin1String(", ") + kSessionStatsColumns;
+}
+
+static SessionSummary sessionSummaryFromQuery(const QSqlQuery &q)
 {
+    SessionSummary summary;
+    summary.session = sessionFromQuery(q);
+    summary.turnCount = q.value(13).toInt();
+    summary.editCount = q.value(14).toInt();
+    summary.messageCount = q.value(15).toInt();
+    summary.lastActivity = q.value(16).toString();
+    summary.costUsd = q.value(17).toDouble();
+    summary.inputTokens = q.value(18).toLongLong();
+    summary.outputTokens = q.value(19).toLongLong();
+    summary.lastTtftMs = q.value(20).toLongLong();
+    summary.lastTurnMs = q.value(21).toLongLong();
+    summary.lastMessageAt = q.value(22).toLongLong();
+    return summary;
+}
+
+QList<SessionSummary> Database::loadSessionSummaries(const QString &workspace, int limit,
+                                                     int offset)
+{
+    sync(SessionsTable | SessionStatsTable);
+    QList<SessionSummary> list;
     QSqlQuery q(m_db);
-    q.prepare("DELETE FROM messages WHERE session_id = ?");
-    q.addBindValue(sessionId);
+    q.setForwardOnly(true);
+    q.prepare(QStringLiteral(
+        "SELECT %1 FROM sessions s LEFT JOIN session_stats st ON st.session_id = s.session_id "
+        "WHERE s.workspace = ? ORDER BY s.updated_at DESC LIMIT ? OFFSET ?")
+        .arg(summaryColumns()));
+    q.addBindValue(workspace);
+    q.addBindValue(limit);
+    q.addBindValue(offset);
     q.exec();
+    while (q.next())
+        list.append(sessionSummaryFromQuery(q));
+    return list;
+}
 
-    q.prepare("DELETE FROM checkpoints WHERE session_id = ?");
+SessionSummary Database::loadSessionSummary(const QString &sessionId)
+{
+    sync(SessionsTable | SessionStatsTable);
+    SessionSummary summary;
+    QSqlQuery q(m_db);
+    q.prepare(QStringLiteral(
+        "SELECT %1 FROM sessions s LEFT JOIN session_stats st ON st.session_id = s.session_id "
+        "WHERE s.session_id = ?").arg(summaryColumns()));
     q.addBindValue(sessionId);
     q.exec();
+    if (q.next())
+        summary = sessionSummaryFromQuery(q);
+    return summary;
+}
 
-    q.prepare("DELETE FROM sessions WHERE session_id = ?");
-    q.addBindValue(sessionId);
+int Database::sessionCount(const QString &workspace)
+{
+    sync(SessionsTable);
+    QSqlQuery q(m_db);
+    q.prepare("SELECT COUNT(*) FROM sessions WHERE workspace = ?");
+    q.addBindValue(workspace);
     q.exec();
+    return q.next() ? q.value(0).toInt() : 0;
+}
+
+void Database::addSessionUsage(const QString &sessionId, double costUsd, qint64 inputTokens,
+                               qint64 outputTokens)
+{
+    write(SessionStatsTable, {{QStringLiteral(
+        "INSERT INTO session_stats (session_id, cost_usd, input_tokens, output_tokens) "
+        "VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(session_id) DO UPDATE SET "
+        "  cost_usd = cost_usd + excluded.cost_usd,"
+        "  input_tokens = input_tokens + excluded.input_tokens,"
+        "  output_tokens = output_tokens + excluded.output_tokens"),
+        {sessionId, costUsd, inputTokens, outputTokens}}});
+}
+
+void Database::deleteSession(const QString &sessionId)
+{
+    write(kSessionTables, {
+        {QStringLiteral("DELETE FROM messages WHERE session_id = ?"), {sessionId}},
+        {QStringLiteral("DELETE FROM checkpoints WHERE session_id = ?"), {sessionId}},
+        {QStringLiteral("DELETE FROM turn_metrics WHERE session_id = ?"), {sessionId}},
+        {QStringLiteral("DELETE FROM session_stats WHERE session_id = ?"), {sessionId}},
+        {QStringLiteral("DELETE FROM sessions WHERE session_id = ?"), {sessionId}},
+    });
 }
 
 void Database::deleteStalePendingSessions()
 {
-    QSqlQuery q(m_db);
-    q.exec("DELETE FROM messages WHERE session_id LIKE 'pending-%'");
-    q.exec("DELETE FROM checkpoints WHERE session_id LIKE 'pending-%'");
-    q.exec("DELETE FROM sessions WHERE session_id LIKE 'pending-%'");
+    write(kSessionTables, {
+        {QStringLiteral("DELETE FROM messages WHERE session_id LIKE 'pending-%'"), {}},
+        {QStringLiteral("DELETE FROM checkpoints WHERE session_id LIKE 'pending-%'"), {}},
+        {QStringLiteral("DELETE FROM turn_metrics WHERE session_id LIKE 'pending-%'"), {}},
+        {QStringLiteral("DELETE FROM session_stats WHERE session_id LIKE 'pending-%'"), {}},
+        {QStringLiteral("DELETE FROM sessions WHERE session_id LIKE 'pending-%'"), {}},
+    });
 }
 
 void Database::saveMessage(const MessageRecord &msg)
 {
-    QSqlQuery q(m_db);
-    q.prepare(
+    write(MessagesTable | SessionStatsTable, {
+        {QStringLiteral(
         "INSERT INTO messages (session_id, role, content, tool_name, tool_input, turn_id, timestamp) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?)");
-    q.addBindValue(msg.sessionId);
-    q.addBindValue(msg.role);
-    q.addBindValue(msg.content);
-    q.addBindValue(msg.toolName);
-    q.addBindValue(msg.toolInput);
-    q.addBindValue(msg.turnId);
-    q.addBindValue(msg.timestamp);
-    q.exec();
+        "VALUES (?, ?, ?, ?, ?, ?, ?)"),
+        {msg.sessionId, msg.role, msg.content, msg.toolName, msg.toolInput, msg.turnId,
+         msg.timestamp}},
+        // Same transaction, so the stats never disagree with the rows
+        {QStringLiteral(
+        "INSERT INTO session_stats "
+        "(session_id, turn_count, edit_count, message_count, last_activity, last_message_at) "
+        "VALUES (?, ?, ?, 1, ?, ?) "
+        "ON CONFLICT(session_id) DO UPDATE SET "
+        "  turn_count = MAX(turn_count, excluded.turn_count),"
+        "  edit_count = edit_count + excluded.edit_count,"
+        "  message_count = message_count + 1,"
+        "  last_activity = COALESCE(excluded.last_activity, last_activity),"
+        "  last_message_at = MAX(last_message_at, excluded.last_message_at)"),
+        {msg.sessionId, msg.turnId, (msg.role == "tool" && isEditTool(msg.toolName)) ? 1 : 0,
+         msg.role == "tool" ? QVariant(msg.content) : QVariant(), msg.timestamp}}});
 }
 
 void Database::updateMessageSessionId(const QString &oldSessionId, const QString &newSessionId)
 {
-    QSqlQuery q(m_db);
-    q.prepare("UPDATE messages SET session_id = ? WHERE session_id = ?");
-    q.addBindValue(newSessionId);
-    q.addBindValue(oldSessionId);
-    q.exec();
+    const QVariantList ids{newSessionId, oldSessionId};
+    // The new id may have rows of its own already (a resumed session). Where
+    // both have a session row, or a checkpoint or metrics for the same turn,
+    // the new id's is kept and the old one is left for deleteSession(); one
+    // conflict must not undo the whole move. Their stats add up, and the
+    // side with the newer message supplies the "last" fields.
+    write(kSessionTables, {
+        {QStringLiteral("UPDATE messages SET session_id = ? WHERE session_id = ?"), ids},
+        {QStringLiteral("UPDATE OR IGNORE checkpoints SET session_id = ? WHERE session_id = ?"), ids},
+        {QStringLiteral("UPDATE OR IGNORE turn_metrics SET session_id = ? WHERE session_id = ?"), ids},
+        {QStringLiteral(
+        "INSERT INTO session_stats (session_id, turn_count, edit_count, message_count, "
+        "last_activity, cost_usd, input_tokens, output_tokens, last_ttft_ms, last_turn_ms, "
+        "last_message_at) "
+        "SELECT ?, turn_count, edit_count, message_count, last_activity, cost_usd, input_tokens, "
+        "output_tokens, last_ttft_ms, last_turn_ms, last_message_at "
+        "FROM session_stats WHERE session_id = ? "
+        "ON CONFLICT(session_id) DO UPDATE SET "
+        "  turn_count = MAX(turn_count, excluded.turn_count),"
+        "  edit_count = edit_count + excluded.edit_count,"
+        "  message_count = message_count + excluded.message_count,"
+        "  last_activity = CASE WHEN excluded.last_message_at > last_message_at"
+        "    THEN COALESCE(excluded.last_activity, last_activity)"
+        "    ELSE COALESCE(last_activity, excluded.last_activity) END,"
+        "  cost_usd = cost_usd + excluded.cost_usd,"
+        "  input_tokens = input_tokens + excluded.input_tokens,"
+        "  output_tokens = output_tokens + excluded.output_tokens,"
+        "  last_ttft_ms = CASE WHEN last_ttft_ms < 0 OR (excluded.last_ttft_ms >= 0"
+        "    AND excluded.last_message_at > last_message_at)"
+        "    THEN excluded.last_ttft_ms ELSE last_ttft_ms END,"
+        "  last_turn_ms = CASE WHEN last_turn_ms < 0 OR (excluded.last_turn_ms >= 0"
+        "    AND excluded.last_message_at > last_message_at)"
+        "    THEN excluded.last_turn_ms ELSE last_turn_ms END,"
+        "  last_message_at = MAX(last_message_at, excluded.last_message_at)"), ids},
+        {QStringLiteral("DELETE FROM session_stats WHERE session_id = ?"), {oldSessionId}},
+        {QStringLiteral("UPDATE OR IGNORE sessions SET session_id = ? WHERE session_id = ?"), ids},
+    });
+}
 
-    q.prepare("UPDATE checkpoints SET session_id = ? WHERE session_id = ?");
-    q.addBindValue(newSessionId);
-    q.addBindValue(oldSessionId);
+static const char kMessageColumns[] =
+    "id, session_id, role, content, tool_name, tool_input, turn_id, timestamp";
+
+static MessageRecord messageFromQuery(const QSqlQuery &q)
+{
+    MessageRecord msg;
+    msg.id = q.value(0).toInt();
+    msg.sessionId = q.value(1).toString();
+    msg.role = q.value(2).toString();
+    msg.content = q.value(3).toString();
+    msg.toolName = q.value(4).toString();
+    msg.toolInput = q.value(5).toString();
+    msg.turnId = q.value(6).toInt();
+    msg.timestamp = q.value(7).toLongLong();
+    return msg;
+}
+
+QList<MessageRecord> Database::loadMessages(const QString &sessionId)
+{
+    sync(MessagesTable);
+    QList<MessageRecord> list;
+    QSqlQuery q(m_db);
+    q.prepare(QStringLiteral("SELECT %1 FROM messages WHERE session_id = ? ORDER BY id ASC")
+                  .arg(kMessageColumns));
+    q.addBindValue(sessionId);
     q.exec();
+    while (q.next())
+        list.append(messageFromQuery(q));
+    return list;
+}
 
-    q.prepare("UPDATE sessions SET session_id = ? WHERE session_id = ?");
-    q.addBindValue(newSessionId);
-    q.addBindValue(oldSessionId);
+QList<MessageRecord> Database::loadMessagesBefore(const QString &sessionId, int beforeId,
+                                                  int limit)
+{
+    // Rows older than one already read are committed; only the newest page
+    // can be waiting in the writer
+    if (beforeId <= 0)
+        sync(MessagesTable);
+    QList<MessageRecord> list;
+    QSqlQuery q(m_db);
+    q.prepare(QStringLiteral(
+        "SELECT %1 FROM messages WHERE session_id = ? AND id < ? ORDER BY id DESC LIMIT ?")
+        .arg(kMessageColumns));
+    q.addBindValue(sessionId);
+    q.addBindValue(beforeId > 0 ? beforeId : std::numeric_limits<int>::max());
+    q.addBindValue(limit);
     q.exec();
+    while (q.next())
+        list.prepend(messageFromQuery(q));
+    return list;
 }
 
-QList<MessageRecord> Database::loadMessages(const QString &sessionId)
+QList<MessageRecord> Database::loadTurnRange(const QString &sessionId, int firstTurn,
+                                             int lastTurn)
 {
+    sync(MessagesTable);
     QList<MessageRecord> list;
     QSqlQuery q(m_db);
-    q.prepare("SELECT id, session_id, role, content, tool_name, tool_input, turn_id, timestamp "
-              "FROM messages WHERE session_id = ? ORDER BY id ASC");
+    q.prepare(QStringLiteral(
+        "SELECT %1 FROM messages WHERE session_id = ? AND turn_id BETWEEN ? AND ? "
+        "ORDER BY turn_id, id").arg(kMessageColumns));
     q.addBindValue(sessionId);
+    q.addBindValue(firstTurn);
+    q.addBindValue(lastTurn);
     q.exec();
-    while (q.next()) {
-        MessageRecord msg;
-        msg.id = q.value(0).toInt();
-        msg.sessionId = q.value(1).toString();
-        msg.role = q.value(2).toString();
-        msg.content = q.value(3).toString();
-        msg.toolName = q.value(4).toString();
-        msg.toolInput = q.value(5).toString();
-        msg.turnId = q.value(6).toInt();
-        msg.timestamp = q.value(7).toLongLong();
-        list.append(msg);
-    }
+    while (q.next())
+        list.append(messageFromQuery(q));
     return list;
 }
 
-int Database::turnCountForSession(const QString &sessionId)
+QMap<QString, int> Database::countMessagesByRole(const QString &sessionId)
 {
+    sync(MessagesTable);
+    QMap<QString, int> counts;
     QSqlQuery q(m_db);
-    q.prepare("SELECT COALESCE(MAX(turn_id), 0) FROM messages WHERE session_id = ?");
+    q.prepare("SELECT role, COUNT(*) FROM messages WHERE session_id = ? GROUP BY role");
     q.addBindValue(sessionId);
     q.exec();
-    if (q.next())
-        return q.value(0).toInt();
-    return 0;
+    while (q.next())
+        counts.insert(q.value(0).toString(), q.value(1).toInt());
+    return counts;
+}
+
+QMap<int, qint64> Database::turnStartTimes(const QString &sessionId)
+{
+    sync(MessagesTable);
+    QMap<int, qint64> times;
+    QSqlQuery q(m_db);
+    q.prepare("SELECT turn_id, MIN(timestamp) FROM messages "
+              "WHERE session_id = ? AND turn_id > 0 AND timestamp > 0 GROUP BY turn_id");
+    q.addBindValue(sessionId);
+    q.exec();
+    while (q.next())
+        times.insert(q.value(0).toInt(), q.value(1).toLongLong());
+    return times;
 }
 
-QMap<QString, int> Database::turnCountsForSessions(const QStringList &sessionIds)
+// Prefix length messages_fts indexes (prefix='3')
+static constexpr int kSearchPrefixIndex = 3;
+
+// User text to an FTS5 query: every word has to match, the last one as a
+// prefix since it may still be being typed. Words are quoted, so operators
+// and punctuation in the input are searched for literally. A last word
+// shorter than the prefix index matches whole: one or two letters would
+// expand to a good part of the vocabulary
+static QString ftsQuery(const QString &text)
 {
-    QMap<QString, int> result;
-    if (sessionIds.isEmpty()) return result;
+    QStringList terms;
+    const QStringList words = text.simplified().split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    for (QString word : words) {
+        word.replace(QLatin1Char('"'), QLatin1String("\"\""));
+        terms << QLatin1Char('"') + word + QLatin1Char('"');
+    }
+    if (terms.isEmpty()) return {};
+    // The tokenizer's last token of the last word is what the * applies to
+    qsizetype typed = 0;
+    for (auto it = words.last().crbegin(); it != words.last().crend(); ++it) {
+        if (it->isLetterOrNumber())
+            ++typed;
+        else if (typed > 0)
+            break;
+    }
+    if (typed >= kSearchPrefixIndex)
+        terms.last() += QLatin1Char('*');
+    return terms.join(QLatin1Char(' '));
+}
+
+QList<SearchHit> Database::searchMessages(const QString &text, const QString &workspace,
+                                          int limit)
+{
+    QList<SearchHit> hits;
+    const QString match = ftsQuery(text);
+    if (!m_hasSearch || match.isEmpty() || limit <= 0) return hits;
+
+    // Several messages of one turn can match and the best one stands for
+    // it, so a page of rows can hold fewer turns than asked for. Read on
+    // until there are enough or the matches run out; each page ranks again,
+    // so pages double
+    QSet<QPair<QString, int>> seen;
+    int offset = 0;
+    for (int page = limit * 4; hits.size() < limit; offset += page, page *= 2) {
+        QSqlQuery q(m_db);
+        q.setForwardOnly(true);
+        q.prepare(QStringLiteral(
+            "SELECT m.session_id, m.turn_id, m.timestamp, s.title,"
+            "  snippet(messages_fts, -1, char(2), char(3), ?, 12) "
+            "FROM messages_fts JOIN messages m ON m.id = messages_fts.rowid "
+            "JOIN sessions s ON s.session_id = m.session_id "
+            "WHERE messages_fts MATCH ? %1 ORDER BY messages_fts.rank LIMIT ? OFFSET ?")
+            .arg(workspace.isEmpty() ? QString() : QStringLiteral("AND s.workspace = ?")));
+        q.addBindValue(QStringLiteral("\u2026"));
+        q.addBindValue(match);
+        if (!workspace.isEmpty())
+            q.addBindValue(workspace);
+        q.addBindValue(page);
+        q.addBindValue(offset);
+        if (!q.exec()) {
+            qWarning() << "[cccpp] history search failed:" << q.lastError().text();
+            return hits;
+        }
+
+        int rows = 0;
+        while (hits.size() < limit && q.next()) {
+            ++rows;
+            SearchHit hit;
+            hit.sessionId = q.value(0).toString();
+            hit.turnId = q.value(1).toInt();
+            if (seen.contains({hit.sessionId, hit.turnId})) continue;
+            seen.insert({hit.sessionId, hit.turnId});
+            hit.timestamp = q.value(2).toLongLong();
+            hit.title = q.value(3).toString();
+            hit.snippet = q.value(4).toString();
+            hits.append(hit);
+        }
+        if (rows < page) break;
+    }
+    return hits;
+}
 
-    QStringList placeholders;
-    for (int i = 0; i < sessionIds.size(); ++i)
-        placeholders << "?";
+MessageCursor Database::streamMessages(const QString &sessionId, const QString &role)
+{
+    sync(MessagesTable);
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (role.isEmpty()) {
+        q.prepare(QStringLiteral("SELECT %1 FROM messages WHERE session_id = ? ORDER BY id")
+                      .arg(kMessageColumns));
+        q.addBindValue(sessionId);
+    } else {
+        q.prepare(QStringLiteral(
+            "SELECT %1 FROM messages WHERE session_id = ? AND role = ? ORDER BY id")
+            .arg(kMessageColumns));
+        q.addBindValue(sessionId);
+        q.addBindValue(role);
+    }
+    q.exec();
+    return MessageCursor(std::move(q));
+}
 
+QList<FileEditRecord> Database::loadFileEdits(const QString &sessionId)
+{
+    sync(MessagesTable);
     QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    // Edits count the line difference between old_string and new_string,
+    // writes the lines of their content. Inputs that are not JSON are skipped
     q.prepare(QStringLiteral(
-        "SELECT session_id, COALESCE(MAX(turn_id), 0) "
-        "FROM messages WHERE session_id IN (%1) GROUP BY session_id")
-        .arg(placeholders.join(",")));
+        "SELECT turn_id, tool_name, path,"
+        "  CASE WHEN old_lines IS NULL OR new_lines IS NULL THEN ifnull(content_lines, 0)"
+        "       ELSE max(0, new_lines - old_lines) END,"
+        "  CASE WHEN old_lines IS NULL OR new_lines IS NULL THEN 0"
+        "       ELSE max(0, old_lines - new_lines) END "
+        "FROM (SELECT id, turn_id, tool_name, path,"
+        "        length(old_text) - length(replace(old_text, char(10), '')) + (old_text <> '')"
+        "          AS old_lines,"
+        "        length(new_text) - length(replace(new_text, char(10), '')) + (new_text <> '')"
+        "          AS new_lines,"
+        "        length(content) - length(replace(content, char(10), '')) + 1 AS content_lines"
+        "      FROM (SELECT id, turn_id, tool_name,"
+        "              ifnull(json_extract(input, '$.path'), json_extract(input, '$.file_path'))"
+        "                AS path,"
+        "              json_extract(input, '$.old_string') AS old_text,"
+        "              json_extract(input, '$.new_string') AS new_text,"
+        "              ifnull(json_extract(input, '$.content'), json_extract(input, '$.contents'))"
+        "                AS content"
+        "            FROM (SELECT id, turn_id, tool_name,"
+        "                    CASE WHEN json_valid(tool_input) THEN tool_input END AS input"
+        "                  FROM messages"
+        "                  WHERE session_id = ? AND role = 'tool' AND tool_name IN %1))) "
+        "WHERE path <> '' "
+        "ORDER BY id").arg(kEditToolsSql));
+    q.addBindValue(sessionId);
+    QList<FileEditRecord> edits;
+    if (!q.exec()) {
+        qWarning() << "[cccpp] history file edits failed:" << q.lastError().text();
+        return edits;
+    }
+    while (q.next()) {
+        FileEditRecord edit;
+        edit.turnId = q.value(0).toInt();
+        edit.toolName = q.value(1).toString();
+        edit.filePath = q.value(2).toString();
+        edit.linesAdded = q.value(3).toInt();
+        edit.linesRemoved = q.value(4).toInt();
+        edits.append(edit);
+    }
+    return edits;
+}
 
-    for (const auto &sid : sessionIds)
-        q.addBindValue(sid);
+MessageRecord Database::lastMessage(const QString &sessionId, const QString &role)
+{
+    sync(MessagesTable);
+    QSqlQuery q(m_db);
+    q.prepare(QStringLiteral(
+        "SELECT %1 FROM messages WHERE session_id = ? AND role = ? ORDER BY id DESC LIMIT 1")
+        .arg(kMessageColumns));
+    q.addBindValue(sessionId);
+    q.addBindValue(role);
     q.exec();
+    return q.next() ? messageFromQuery(q) : MessageRecord();
+}
 
-    while (q.next())
-        result[q.value(0).toString()] = q.value(1).toInt();
+bool MessageCursor::next(MessageRecord &out)
+{
+    if (!m_query.next()) {
+        m_query.finish();  // ends the read as soon as the walk does
+        return false;
+    }
+    out = messageFromQuery(m_query);
+    return true;
+}
 
-    return result;
+int Database::turnCountForSession(const QString &sessionId)
+{
+    sync(MessagesTable);
+    QSqlQuery q(m_db);
+    q.prepare("SELECT COALESCE(MAX(turn_id), 0) FROM messages WHERE session_id = ?");
+    q.addBindValue(sessionId);
+    q.exec();
+    if (q.next())
+        return q.value(0).toInt();
+    return 0;
 }
 
 void Database::saveCheckpoint(const CheckpointRecord &cp)
 {
-    QSqlQuery q(m_db);
-    q.prepare(
+    write(CheckpointsTable, {{QStringLiteral(
         "INSERT OR REPLACE INTO checkpoints (session_id, turn_id, uuid, timestamp) "
-        "VALUES (?, ?, ?, ?)");
-    q.addBindValue(cp.sessionId);
-    q.addBindValue(cp.turnId);
-    q.addBindValue(cp.uuid);
-    q.addBindValue(cp.timestamp);
-    q.exec();
+        "VALUES (?, ?, ?, ?)"),
+        {cp.sessionId, cp.turnId, cp.uuid, cp.timestamp}}});
 }
 
 QList<CheckpointRecord> Database::loadCheckpoints(const QString &sessionId)
 {
+    sync(CheckpointsTable);
     QList<CheckpointRecord> list;
     QSqlQuery q(m_db);
     q.prepare("SELECT session_id, turn_id, uuid, timestamp "
@@ -321,6 +1026,7 @@ QList<CheckpointRecord> Database::loadCheckpoints(const QString &sessionId)
 
 QString Database::checkpointUuid(const QString &sessionId, int turnId)
 {
+    sync(CheckpointsTable);
     QSqlQuery q(m_db);
     q.prepare("SELECT uuid FROM checkpoints WHERE session_id = ? AND turn_id = ?");
     q.addBindValue(sessionId);
@@ -330,3 +1036,121 @@ QString Database::checkpointUuid(const QString &sessionId, int turnId)
         return q.value(0).toString();
     return {};
 }
+
+void Database::saveTurnMetrics(const TurnMetricsRecord &rec)
+{
+    const TurnMetrics &m = rec.metrics;
+    write(TurnMetricsTable | SessionStatsTable, {
+        {QStringLiteral(
+        "INSERT OR REPLACE INTO turn_metrics (session_id, turn_id, model, mode, spawn_ms, "
+        "first_byte_ms, ttft_ms, tool_ms, total_ms, tool_count, delta_count, max_gap_ms, "
+        "gap_histogram, timestamp) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"),
+        {rec.sessionId, rec.turnId, rec.model, rec.mode, m.spawnMs, m.firstByteMs, m.ttftMs,
+         m.toolMs, m.totalMs, m.toolCount, m.deltaCount, m.maxGapMs, m.histogramToString(),
+         rec.timestamp}},
+        {QStringLiteral(
+        "INSERT INTO session_stats (session_id, last_ttft_ms, last_turn_ms) VALUES (?, ?, ?) "
+        "ON CONFLICT(session_id) DO UPDATE SET "
+        "  last_ttft_ms = excluded.last_ttft_ms, last_turn_ms = excluded.last_turn_ms"),
+        {rec.sessionId, m.ttftMs, m.totalMs}}});
+}
+
+static const char kTurnMetricsColumns[] =
+    "session_id, turn_id, model, mode, spawn_ms, first_byte_ms, ttft_ms, tool_ms, "
+    "total_ms, tool_count, delta_count, max_gap_ms, gap_histogram, timestamp";
+
+static TurnMetricsRecord turnMetricsFromQuery(const QSqlQuery &q)
+{
+    TurnMetricsRecord rec;
+    rec.sessionId = q.value(0).toString();
+    rec.turnId = q.value(1).toInt();
+    rec.model = q.value(2).toString();
+    rec.mode = q.value(3).toString();
+    rec.metrics.spawnMs = q.value(4).toLongLong();
+    rec.metrics.firstByteMs = q.value(5).toLongLong();
+    rec.metrics.ttftMs = q.value(6).toLongLong();
+    rec.metrics.toolMs = q.value(7).toLongLong();
+    rec.metrics.totalMs = q.value(8).toLongLong();
+    rec.metrics.toolCount = q.value(9).toInt();
+    rec.metrics.deltaCount = q.value(10).toInt();
+    rec.metrics.maxGapMs = q.value(11).toLongLong();
+    rec.metrics.histogramFromString(q.value(12).toString());
+    rec.timestamp = q.value(13).toLongLong();
+    return rec;
+}
+
+QList<TurnMetricsRecord> Database::loadTurnMetrics(const QString &sessionId)
+{
+    sync(TurnMetricsTable);
+    QList<TurnMetricsRecord> list;
+    QSqlQuery q(m_db);
+    q.prepare(QStringLiteral("SELECT %1 FROM turn_metrics WHERE session_id = ? ORDER BY turn_id ASC")
+                  .arg(kTurnMetricsColumns));
+    q.addBindValue(sessionId);
+    q.exec();
+    while (q.next())
+        list.append(turnMetricsFromQuery(q));
+    return list;
+}
+
+bool Database::loadRenderCache(const QString &key, RenderCacheRecord &out)
+{
+    // Never waits for the writer: a miss just renders again
+    QSqlQuery q(m_db);
+    q.prepare("SELECT html, code_blocks, last_used FROM render_cache WHERE key = ?");
+    q.addBindValue(key);
+    if (!q.exec() || !q.next())
+        return false;
+    out.key = key;
+    out.html = q.value(0).toString();
+    out.codeBlocks = q.value(1).toString();
+    out.lastUsed = q.value(2).toLongLong();
+    return true;
+}
+
+void Database::saveRenderCache(const QList<RenderCacheRecord> &records,
+                               const QStringList &touched, qint64 now, qint64 maxBytes)
+{
+    if (records.isEmpty() && touched.isEmpty()) return;
+
+    QList<DbStatement> group;
+    group.reserve(records.size() + touched.size() + 1);
+    // An upsert rather than OR REPLACE, which deletes the old row without
+    // firing delete triggers and would leave it counted in render_cache_size
+    for (const auto &rec : records) {
+        group.append({QStringLiteral(
+            "INSERT INTO render_cache (key, html, code_blocks, bytes, last_used) "
+            "VALUES (?, ?, ?, ?, ?) "
+            "ON CONFLICT(key) DO UPDATE SET html = excluded.html,"
+            "  code_blocks = excluded.code_blocks, bytes = excluded.bytes,"
+            "  last_used = excluded.last_used"),
+            {rec.key, rec.html, rec.codeBlocks,
+             qint64(rec.html.size() + rec.codeBlocks.size()) * 2, rec.lastUsed}});
+    }
+    for (const auto &key : touched) {
+        group.append({QStringLiteral("UPDATE render_cache SET last_used = ? WHERE key = ?"),
+                      {now, key}});
+    }
+
+    // Over maxBytes, the least recently used rows go until the rest fits.
+    // The walk follows idx_render_cache_last_used one row at a time, ties in
+    // rowid order; under the limit the running total ends it before any row
+    // is read
+    group.append({QStringLiteral(
+        "WITH RECURSIVE doomed(id, last_used, freed) AS ("
+        "  SELECT r.rowid, r.last_used, r.bytes FROM render_cache_size s"
+        "  JOIN render_cache r"
+        "    ON r.rowid = (SELECT rowid FROM render_cache ORDER BY last_used, rowid LIMIT 1)"
+        "  WHERE s.bytes > ?"
+        "  UNION ALL"
+        "  SELECT r.rowid, r.last_used, d.freed + r.bytes FROM doomed d"
+        "  JOIN render_cache r ON r.rowid = COALESCE("
+        "    (SELECT rowid FROM render_cache WHERE last_used = d.last_used AND rowid > d.id"
+        "     ORDER BY rowid LIMIT 1),"
+        "    (SELECT rowid FROM render_cache WHERE last_used > d.last_used"
+        "     ORDER BY last_used, rowid LIMIT 1))"
+        "  WHERE d.freed < (SELECT bytes FROM render_cache_size) - ?) "
+        "DELETE FROM render_cache WHERE rowid IN (SELECT id FROM doomed)"),
+        {maxBytes, maxBytes}});
+    write(RenderCacheTable, group);
+}
@@ -5,8 +5,11 @@
 #include <QList>
 #include <QMap>
 #include <QSqlDatabase>
-
-struct SessionInfo;
+#include <QSqlQuery>
+#include <memory>
+#include "core/DatabaseWriter.h"
+#include "core/SessionManager.h"
+#include "core/TurnMetrics.h"
 
 struct MessageRecord {
     int id = 0;
@@ -26,27 +29,140 @@ struct CheckpointRecord {
     qint64 timestamp = 0;
 };
 
+struct TurnMetricsRecord {
+    QString sessionId;
+    int turnId = 0;
+    QString model;
+    QString mode;
+    TurnMetrics metrics;
+    qint64 timestamp = 0;
+};
+
+// A session with its session_stats row, which is kept up to date by the
+// writes that change it (messages, turn metrics, usage)
+struct SessionSummary {
+    SessionInfo session;
+    int turnCount = 0;
+    int editCount = 0;
+    int messageCount = 0;
+    QString lastActivity;   // summary of the latest tool call
+    double costUsd = 0.0;
+    qint64 inputTokens = 0;
+    qint64 outputTokens = 0;
+    qint64 lastTtftMs = -1;
+    qint64 lastTurnMs = -1;
+    qint64 lastMessageAt = 0;
+};
+
+// One call of an edit tool, reduced to the file it touched and the lines it
+// added and removed
+struct FileEditRecord {
+    int turnId = 0;
+    QString toolName;
+    QString filePath;  // as the tool got it, possibly relative
+    int linesAdded = 0;
+    int linesRemoved = 0;
+};
+
+struct RenderCacheRecord {
+    QString key;
+    QString html;
+    QString codeBlocks;  // JSON, opaque to the database
+    qint64 lastUsed = 0;
+};
+
+// One turn matching a history search, best matches first. The snippet is
+// plain text around the match with every matched term between kMatchBegin
+// and kMatchEnd
+struct SearchHit {
+    static constexpr QChar kMatchBegin = u'\x02';
+    static constexpr QChar kMatchEnd = u'\x03';
+
+    QString sessionId;
+    QString title;
+    int turnId = 0;
+    qint64 timestamp = 0;
+    QString snippet;
+};
+
+// Forward-only walk over stored messages, oldest first, holding one row at a
+// time (exports, history scans). Keep it short-lived: the read stays open
+// until next() returns false or the cursor goes away
+class MessageCursor {
+public:
+    bool next(MessageRecord &out);
+
+private:
+    friend class Database;
+    explicit MessageCursor(QSqlQuery &&query) : m_query(std::move(query)) {}
+
+    QSqlQuery m_query;
+};
+
 class Database : public QObject {
     Q_OBJECT
 public:
     explicit Database(QObject *parent = nullptr);
     ~Database();
 
+    // Writes (save*, delete*, update*) are queued to a writer thread and
+    // group-committed; every read first waits for the writes queued before
+    // it, so callers always see their own writes. close() drains the queue.
     bool open(const QString &path = {});
     void close();
+    // Blocks until every queued write is committed or dropped; false if a
+    // write group failed since the previous flush()
+    bool flush();
+    qint64 writeTransactions() const { return m_writer ? m_writer->transactions() : 0; }
+    // Migrations known to this build; PRAGMA user_version of an up to date
+    // database equals this
+    int schemaVersion() const;
+    // EXPLAIN QUERY PLAN details, one per plan row (tests and diagnostics)
+    QStringList queryPlan(const QString &sql, const QVariantList &values = {});
 
     // Sessions
     void saveSession(const SessionInfo &info);
     QList<SessionInfo> loadSessions();
+    QList<SessionInfo> loadSessions(const QString &workspace);  // newest first
     SessionInfo loadSession(const QString &sessionId);
     void deleteSession(const QString &sessionId);
     void deleteStalePendingSessions();
+    // Newest first; limit < 0 returns the rest
+    QList<SessionSummary> loadSessionSummaries(const QString &workspace, int limit = -1,
+                                               int offset = 0);
+    SessionSummary loadSessionSummary(const QString &sessionId);
+    int sessionCount(const QString &workspace);
+    void addSessionUsage(const QString &sessionId, double costUsd, qint64 inputTokens,
+                         qint64 outputTokens);
 
     // Messages
     void saveMessage(const MessageRecord &msg);
     QList<MessageRecord> loadMessages(const QString &sessionId);
+    // Keyset pages, oldest first: the last `limit` messages with an id below
+    // beforeId (beforeId <= 0: the newest), and whole turns by turn id
+    QList<MessageRecord> loadMessagesBefore(const QString &sessionId, int beforeId, int limit);
+    QList<MessageRecord> loadTurnRange(const QString &sessionId, int firstTurn, int lastTurn);
+    QMap<QString, int> countMessagesByRole(const QString &sessionId);
+    // Time of each turn's first message
+    QMap<int, qint64> turnStartTimes(const QString &sessionId);
+    MessageCursor streamMessages(const QString &sessionId, const QString &role = {});
+    // Edit tool calls, oldest first. Inputs are parsed and lines counted in
+    // SQLite, so the tool inputs themselves are never loaded
+    QList<FileEditRecord> loadFileEdits(const QString &sessionId);
+    // The newest message with `role`; id 0 when the session has none
+    MessageRecord lastMessage(const QString &sessionId, const QString &role);
+
+    // Full-text search over message text and tool inputs (FTS5), ranked by
+    // bm25; one hit per turn, up to `limit` of them. An empty workspace
+    // searches all of them.
+    // Does not wait for queued writes, so the newest messages can be
+    // missing for one commit interval
+    bool hasSearch() const { return m_hasSearch; }
+    // Messages from before the index are still being indexed, newest first
+    bool searchIndexing() const { return m_writer && m_writer->hasIdleWork(); }
+    QList<SearchHit> searchMessages(const QString &text, const QString &workspace = {},
+                                    int limit = 50);
     int turnCountForSession(const QString &sessionId);
-    QMap<QString, int> turnCountsForSessions(const QStringList &sessionIds);
     void updateMessageSessionId(const QString &oldSessionId, const QString &newSessionId);
 
     // Checkpoints (CLI-backed, stores only the UUID per turn)
@@ -54,7 +170,43 @@ public:
     QList<CheckpointRecord> loadCheckpoints(const QString &sessionId);
     QString checkpointUuid(const QString &sessionId, int turnId);
 
+    // Per-turn latency (spawn, TTFT, inter-delta gaps, tools, total)
+    void saveTurnMetrics(const TurnMetricsRecord &rec);
+    QList<TurnMetricsRecord> loadTurnMetrics(const QString &sessionId);
+
+    // Rendered markdown by content key (see RenderCache). Saving also
+    // refreshes last_used of `touched` and trims the table to maxBytes of
+    // HTML and code block JSON, least recently used first
+    bool loadRenderCache(const QString &key, RenderCacheRecord &out);
+    void saveRenderCache(const QList<RenderCacheRecord> &records,
+                         const QStringList &touched, qint64 now, qint64 maxBytes);
+
 private:
-    void createTables();
-    QSqlDatabase m_db;
+    // Tables a write group touches. A read waits for the writer only while
+    // a write to one of the tables it reads is still queued
+    enum Table : unsigned {
+        SessionsTable = 1u << 0,
+        MessagesTable = 1u << 1,
+        CheckpointsTable = 1u << 2,
+        TurnMetricsTable = 1u << 3,
+        SessionStatsTable = 1u << 4,
+        RenderCacheTable = 1u << 5,
+    };
+    static constexpr int kTableCount = 6;
+    static constexpr unsigned kSessionTables = SessionsTable | MessagesTable | CheckpointsTable
+                                             | TurnMetricsTable | SessionStatsTable;
+
+    bool migrate();
+    // Creates the search index if an earlier start could not, and has the
+    // writer index the messages it is missing
+    void openSearch();
+    void write(unsigned tables, const QList<DbStatement> &group);
+    void sync(unsigned tables);
+
+    QSqlDatabase m_db;  // reads and schema, GUI thread
+    std::unique_ptr<DatabaseWriter> m_writer;
+    bool m_hasSearch = false;
+    qint64 m_lastWrite[kTableCount] = {};  // writer ticket of each table's newest write
+    qint64 m_failedWrites = 0;  // groups dropped without the writer
+    qint64 m_reportedFailures = 0;
 };
@@ -0,0 +1,296 @@
+#include "core/DatabaseWriter.h"
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QDebug>
+
+// busy_timeout covers most contention; a commit that still meets
+// SQLITE_BUSY (another process holding the file) gets a few more tries
+template <typename Step>
+static bool retryBusy(const QSqlDatabase &db, Step step)
+{
+    for (int attempt = 0;; ++attempt) {
+        if (step())
+            return true;
+        const bool busy = (db.lastError().nativeErrorCode().toInt() & 0xff) == 5;
+        if (!busy || attempt == DatabaseWriter::kBusyRetries)
+            return false;
+        QThread::msleep(20u << attempt);
+    }
+}
+
+DatabaseWriter::DatabaseWriter(const QString &path, const QString &connectionName)
+    : m_path(path)
+    , m_connectionName(connectionName)
+{
+}
+
+DatabaseWriter::~DatabaseWriter()
+{
+    stop();
+}
+
+bool DatabaseWriter::start()
+{
+    if (m_thread) return true;
+    m_thread = QThread::create([this] { run(); });
+    m_thread->setObjectName(QStringLiteral("cccpp-db-writer"));
+    m_thread->start();
+
+    QMutexLocker lock(&m_mutex);
+    while (m_openState == 0)
+        m_done.wait(&m_mutex);
+    if (m_openState > 0)
+        return true;
+    lock.unlock();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    return false;
+}
+
+void DatabaseWriter::stop()
+{
+    if (!m_thread) return;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+qint64 DatabaseWriter::enqueue(const QList<DbStatement> &group)
+{
+    QMutexLocker lock(&m_mutex);
+    if (group.isEmpty()) return m_enqueued;
+    const bool wasIdle = m_queue.isEmpty();
+    m_queue.append(group);
+    m_queuedStatements += group.size();
+    ++m_enqueued;
+    // The writer is either asleep on an empty queue or already timing a batch
+    if (wasIdle || m_queuedStatements >= kMaxBatch)
+        m_wake.wakeAll();
+    return m_enqueued;
+}
+
+qint64 DatabaseWriter::enqueue(const QString &sql, const QVariantList &values)
+{
+    return enqueue(QList<DbStatement>{{sql, values}});
+}
+
+void DatabaseWriter::flush(qint64 ticket)
+{
+    QMutexLocker lock(&m_mutex);
+    const qint64 target = ticket < 0 ? m_enqueued : qMin(ticket, m_enqueued);
+    if (!m_thread || m_processed >= target) return;
+    m_flushTarget = qMax(m_flushTarget, target);
+    m_wake.wakeAll();
+    while (m_processed < target)
+        m_done.wait(&m_mutex);
+}
+
+bool DatabaseWriter::hasPending() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_processed < m_enqueued;
+}
+
+void DatabaseWriter::setIdleWork(const DbStatement &stmt)
+{
+    QMutexLocker lock(&m_mutex);
+    m_idleWork = stmt;
+    m_wake.wakeAll();
+}
+
+bool DatabaseWriter::hasIdleWork() const
+{
+    QMutexLocker lock(&m_mutex);
+    return !m_idleWork.sql.isEmpty();
+}
+
+qint64 DatabaseWriter::transactions() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_transactions;
+}
+
+qint64 DatabaseWriter::failedGroups() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_failed;
+}
+
+qint64 DatabaseWriter::statements() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_statements;
+}
+
+// One chunk of idle work; false once it is done (or failed, which is logged)
+static bool runIdleWork(QSqlDatabase &db, QHash<QString, QSqlQuery> &prepared,
+                        const DbStatement &stmt)
+{
+    if (!retryBusy(db, [&db] { return db.transaction(); })) {
+        qWarning() << "[cccpp] history writer: begin failed" << db.lastError().text();
+        return false;
+    }
+    auto it = prepared.find(stmt.sql);
+    if (it == prepared.end()) {
+        QSqlQuery q(db);
+        if (!q.prepare(stmt.sql)) {
+            qWarning() << "[cccpp] history writer: prepare failed" << q.lastError().text()
+                       << stmt.sql;
+            db.rollback();
+            return false;
+        }
+        it = prepared.insert(stmt.sql, q);
+    }
+    for (int i = 0; i < stmt.values.size(); ++i)
+        it->bindValue(i, stmt.values[i]);
+    if (!it->exec()) {
+        qWarning() << "[cccpp] history writer:" << it->lastError().text() << stmt.sql;
+        db.rollback();
+        return false;
+    }
+    const int changed = it->numRowsAffected();
+    if (!retryBusy(db, [&db] { return db.commit(); })) {
+        qWarning() << "[cccpp] history writer: commit failed" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return changed > 0;
+}
+
+void DatabaseWriter::run()
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(m_path);
+        const bool opened = db.open();
+        if (opened) {
+            QSqlQuery pragma(db);
+            pragma.exec("PRAGMA journal_mode=WAL");
+            pragma.exec("PRAGMA synchronous=NORMAL");
+            pragma.exec("PRAGMA busy_timeout=5000");
+        } else {
+            qWarning() << "[cccpp] history writer failed to open" << m_path
+                       << db.lastError().text();
+        }
+        {
+            QMutexLocker lock(&m_mutex);
+            m_openState = opened ? 1 : -1;
+            m_done.wakeAll();
+        }
+
+        QHash<QString, QSqlQuery> prepared;
+        while (opened) {
+            QList<QList<DbStatement>> batch;
+            DbStatement idle;
+            {
+                QMutexLocker lock(&m_mutex);
+                while (m_queue.isEmpty() && !m_stopping && m_idleWork.sql.isEmpty())
+                    m_wake.wait(&m_mutex);
+                if (m_queue.isEmpty() && m_stopping)
+                    break;  // stopping, and everything is written
+                if (m_queue.isEmpty())
+                    idle = m_idleWork;
+            }
+            if (!idle.sql.isEmpty()) {
+                if (!runIdleWork(db, prepared, idle)) {
+                    QMutexLocker lock(&m_mutex);
+                    if (m_idleWork.sql == idle.sql)
+                        m_idleWork = {};
+                }
+                continue;
+            }
+            {
+                QMutexLocker lock(&m_mutex);
+
+                // Group commit: let more rows arrive unless someone is waiting
+                const QDeadlineTimer due(kCommitIntervalMs);
+                while (m_queuedStatements < kMaxBatch && m_flushTarget <= m_processed
+                       && !m_stopping) {
+                    if (!m_wake.wait(&m_mutex, due))
+                        break;
+                }
+
+                int taken = 0;
+                while (!m_queue.isEmpty() && taken < kMaxBatch) {
+                    taken += m_queue.first().size();
+                    batch.append(m_queue.takeFirst());
+                }
+                m_queuedStatements -= taken;
+            }
+
+            // Each group is all or nothing: a failed statement rolls its group
+            // back to a savepoint and the rest of the batch still commits
+            int executed = 0;
+            int written = 0;
+            const bool began = retryBusy(db, [&db] { return db.transaction(); });
+            if (!began)
+                qWarning() << "[cccpp] history writer: begin failed" << db.lastError().text();
+            QSqlQuery savepoint(db);
+            for (const auto &group : std::as_const(batch)) {
+                if (!began) break;
+                savepoint.exec(QStringLiteral("SAVEPOINT batch_group"));
+                bool ok = true;
+                for (const auto &stmt : group) {
+                    auto it = prepared.find(stmt.sql);
+                    if (it == prepared.end()) {
+                        QSqlQuery q(db);
+                        if (!q.prepare(stmt.sql)) {
+                            qWarning() << "[cccpp] history writer: prepare failed"
+                                       << q.lastError().text() << stmt.sql;
+                            ok = false;
+                            break;
+                        }
+                        it = prepared.insert(stmt.sql, q);
+                    }
+                    for (int i = 0; i < stmt.values.size(); ++i)
+                        it->bindValue(i, stmt.values[i]);
+                    if (!it->exec()) {
+                        qWarning() << "[cccpp] history writer:" << it->lastError().text()
+                                   << stmt.sql;
+                        ok = false;
+                        break;
+                    }
+                }
+                if (ok) {
+                    savepoint.exec(QStringLiteral("RELEASE batch_group"));
+                    executed += group.size();
+                    ++written;
+                } else {
+                    savepoint.exec(QStringLiteral("ROLLBACK TO batch_group"));
+                    savepoint.exec(QStringLiteral("RELEASE batch_group"));
+                }
+            }
+            const bool committed = began && retryBusy(db, [&db] { return db.commit(); });
+            if (began && !committed) {
+                qWarning() << "[cccpp] history writer: commit failed, dropped" << written
+                           << "groups:" << db.lastError().text();
+                db.rollback();
+            }
+            if (!committed)
+                written = 0;
+
+            QMutexLocker lock(&m_mutex);
+            m_processed += batch.size();
+            m_failed += batch.size() - written;
+            if (committed) {
+                ++m_transactions;
+                m_statements += executed;
+            }
+            m_done.wakeAll();
+        }
+
+        prepared.clear();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVariantList>
+#include <QWaitCondition>
+
+class QThread;
+
+struct DbStatement {
+    QString sql;
+    QVariantList values;  // positional bind values
+};
+
+// Writes of the history database, off the GUI thread. Statements are queued
+// in groups (a group always lands in one transaction) and a thread with its
+// own connection commits whatever has accumulated every kCommitIntervalMs,
+// or as soon as kMaxBatch statements are waiting. Statements are prepared
+// once per SQL text and reused. enqueue() returns a ticket that flush() can
+// wait for, so a reader only waits for the writes it depends on.
+//
+// The connection runs in WAL mode with synchronous=NORMAL: a commit is an
+// append to the log, and the GUI connection keeps reading while the writer
+// works. flush() blocks until everything queued before it is committed,
+// which is how readers see their own writes; stop() drains the queue.
+//
+// A group is written whole or not at all (a savepoint per group): one bad
+// statement drops its group, not the batch. Dropped groups, including every
+// group of a batch whose commit failed, are logged and counted in
+// failedGroups(); flush() waits for them like for written ones.
+//
+// Idle work is a statement that runs in a transaction of its own whenever
+// nothing is queued, over and over until it changes no rows: a long job
+// split into chunks (indexing old history), which queued writes never wait
+// behind for more than one chunk. Its chunks are not counted in
+// transactions() or statements().
+class DatabaseWriter {
+public:
+    static constexpr int kCommitIntervalMs = 50;
+    static constexpr int kMaxBatch = 500;
+    static constexpr int kBusyRetries = 4;
+
+    DatabaseWriter(const QString &path, const QString &connectionName);
+    ~DatabaseWriter();
+
+    // Opens the connection on the writer thread; false if it failed
+    bool start();
+    void stop();
+
+    qint64 enqueue(const QList<DbStatement> &group);
+    qint64 enqueue(const QString &sql, const QVariantList &values = {});
+    // Waits until the group with this ticket (default: everything queued)
+    // has been written
+    void flush(qint64 ticket = -1);
+    bool hasPending() const;
+    void setIdleWork(const DbStatement &stmt);
+    bool hasIdleWork() const;
+
+    qint64 transactions() const;  // committed
+    qint64 statements() const;    // committed
+    qint64 failedGroups() const;
+
+private:
+    void run();
+
+    const QString m_path;
+    const QString m_connectionName;
+    QThread *m_thread = nullptr;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;  // writer: work queued, flush requested or stopping
+    QWaitCondition m_done;  // callers: a batch was committed / connection opened
+    QList<QList<DbStatement>> m_queue;
+    DbStatement m_idleWork;    // empty sql: none
+    int m_queuedStatements = 0;
+    qint64 m_enqueued = 0;     // groups ever queued
+    qint64 m_processed = 0;    // groups ever committed or dropped
+    qint64 m_failed = 0;       // groups dropped
+    qint64 m_flushTarget = 0;  // commit without waiting up to this group
+    bool m_stopping = false;
+    int m_openState = 0;       // 0 pending, 1 open, -1 failed
+    qint64 m_transactions = 0;
+    qint64 m_statements = 0;
+};
@@ -0,0 +1,239 @@
+#include "core/JsonFieldScanner.h"
+#include <algorithm>
+
+static bool isJsonSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void JsonFieldScanner::setWatchedFields(std::vector<std::string> fields)
+{
+    m_watched = std::move(fields);
+}
+
+void JsonFieldScanner::reset()
+{
+    m_state = BeforeObject;
+    m_key.clear();
+    m_capture = false;
+    m_chunkOut.clear();
+    m_escape = false;
+    m_hexDigits = -1;
+    m_hexValue = 0;
+    m_highSurrogate = 0;
+    m_nestDepth = 0;
+    m_nestInString = false;
+}
+
+bool JsonFieldScanner::isWatched(const std::string &key) const
+{
+    return std::find(m_watched.begin(), m_watched.end(), key) != m_watched.end();
+}
+
+void JsonFieldScanner::appendCodePoint(unsigned cp, std::string *out)
+{
+    if (!out) return;
+    if (cp < 0x80) {
+        out->push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+bool JsonFieldScanner::consumeStringByte(char c, std::string *out)
+{
+    static constexpr unsigned kReplacement = 0xFFFD;
+
+    // A pending high surrogate must be followed by \uDC00-\uDFFF; anything
+    // else leaves it unpaired.
+    auto flushLoneSurrogate = [&] {
+        if (m_highSurrogate) {
+            appendCodePoint(kReplacement, out);
+            m_highSurrogate = 0;
+        }
+    };
+
+    if (m_hexDigits >= 0) {
+        int v = hexValue(c);
+        if (v < 0) {
+            // Malformed \u escape — drop it and treat c as ordinary content
+            m_hexDigits = -1;
+            flushLoneSurrogate();
+            appendCodePoint(kReplacement, out);
+            if (c == '"')
+                return true;
+            if (out) out->push_back(c);
+            return false;
+        }
+        m_hexValue = (m_hexValue << 4) | static_cast<unsigned>(v);
+        if (++m_hexDigits < 4)
+            return false;
+
+        unsigned cp = m_hexValue;
+        m_hexDigits = -1;
+        m_hexValue = 0;
+        if (cp >= 0xDC00 && cp <= 0xDFFF) {
+            if (m_highSurrogate) {
+                appendCodePoint(0x10000 + ((m_highSurrogate - 0xD800) << 10) + (cp - 0xDC00), out);
+                m_highSurrogate = 0;
+            } else {
+                appendCodePoint(kReplacement, out);
+            }
+        } else {
+            flushLoneSurrogate();
+            if (cp >= 0xD800 && cp <= 0xDBFF)
+                m_highSurrogate = cp;
+            else
+                appendCodePoint(cp, out);
+        }
+        return false;
+    }
+
+    if (m_escape) {
+        m_escape = false;
+        if (c == 'u') {
+            // Keep m_highSurrogate: this may be the low half of a pair
+            m_hexDigits = 0;
+            m_hexValue = 0;
+            return false;
+        }
+        flushLoneSurrogate();
+        if (!out) return false;
+        switch (c) {
+        case 'n': out->push_back('\n'); break;
+        case 't': out->push_back('\t'); break;
+        case 'r': out->push_back('\r'); break;
+        case 'b': out->push_back('\b'); break;
+        case 'f': out->push_back('\f'); break;
+        default:  out->push_back(c);    break; // \" \\ \/ and unknown escapes
+        }
+        return false;
+    }
+
+    if (c == '\\') {
+        m_escape = true;
+        return false;
+    }
+
+    flushLoneSurrogate();
+    if (c == '"')
+        return true;
+    if (out) out->push_back(c);
+    return false;
+}
+
+void JsonFieldScanner::feed(std::string_view chunk, const Sink &sink)
+{
+    m_chunkOut.clear();
+
+    for (char c : chunk) {
+        switch (m_state) {
+        case BeforeObject:
+            if (c == '{')
+                m_state = ExpectKey;
+            else if (!isJsonSpace(c))
+                m_state = Failed;
+            break;
+
+        case ExpectKey:
+            if (c == '"') {
+                m_key.clear();
+                m_state = InKey;
+            } else if (c == '}') {
+                m_state = Done;
+            } else if (!isJsonSpace(c) && c != ',') {
+                m_state = Failed;
+            }
+            break;
+
+        case InKey:
+            if (consumeStringByte(c, &m_key))
+                m_state = ExpectColon;
+            break;
+
+        case ExpectColon:
+            if (c == ':')
+                m_state = ExpectValue;
+            else if (!isJsonSpace(c))
+                m_state = Failed;
+            break;
+
+        case ExpectValue:
+            if (isJsonSpace(c))
+                break;
+            if (c == '"') {
+                m_capture = isWatched(m_key);
+                m_state = InValueString;
+            } else {
+                m_nestDepth = (c == '{' || c == '[') ? 1 : 0;
+                m_nestInString = false;
+                m_state = InNested;
+            }
+            break;
+
+        case InValueString:
+            if (consumeStringByte(c, m_capture ? &m_chunkOut : nullptr)) {
+                if (m_capture && sink)
+                    sink(m_key, m_chunkOut, true);
+                m_chunkOut.clear();
+                m_capture = false;
+                m_state = AfterValue;
+            }
+            break;
+
+        case InNested:
+            if (m_nestInString) {
+                if (consumeStringByte(c, nullptr))
+                    m_nestInString = false;
+            } else if (c == '"') {
+                m_nestInString = true;
+            } else if (c == '{' || c == '[') {
+                ++m_nestDepth;
+            } else if (c == '}' || c == ']') {
+                if (m_nestDepth == 0) {
+                    m_state = Done; // closing brace of the top-level object
+                } else if (--m_nestDepth == 0) {
+                    m_state = AfterValue;
+                }
+            } else if (c == ',' && m_nestDepth == 0) {
+                m_state = ExpectKey;
+            }
+            break;
+
+        case AfterValue:
+            if (c == ',')
+                m_state = ExpectKey;
+            else if (c == '}')
+                m_state = Done;
+            else if (!isJsonSpace(c))
+                m_state = Failed;
+            break;
+
+        case Done:
+        case Failed:
+            return;
+        }
+    }
+
+    if (m_state == InValueString && m_capture && !m_chunkOut.empty() && sink)
+        sink(m_key, m_chunkOut, false);
+    m_chunkOut.clear();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Resumable scanner for a JSON object that arrives in arbitrary chunks
+// (the `partial_json` of input_json_delta events). It walks the top-level
+// object once, remembers where it stopped — including inside escapes,
+// \uXXXX sequences and split surrogate pairs — and decodes the string values
+// of the watched keys as they stream in. Each feed() is O(chunk).
+class JsonFieldScanner {
+public:
+    // Called with decoded UTF-8 for a watched field. `finished` is true once
+    // the closing quote of the value has been consumed.
+    using Sink = std::function<void(const std::string &field,
+                                    std::string_view decoded,
+                                    bool finished)>;
+
+    void setWatchedFields(std::vector<std::string> fields);
+    void feed(std::string_view chunk, const Sink &sink);
+    void reset();
+
+    bool failed() const { return m_state == Failed; }
+
+private:
+    enum State {
+        BeforeObject,
+        ExpectKey,     // inside top-level object, waiting for a key string
+        InKey,
+        ExpectColon,
+        ExpectValue,
+        InValueString,
+        InNested,      // skipping a nested object/array/scalar value
+        AfterValue,
+        Done,
+        Failed
+    };
+
+    bool isWatched(const std::string &key) const;
+    // Consume one byte of string body. Returns true when the closing quote
+    // was reached. Decoded bytes go to `out` when it is non-null.
+    bool consumeStringByte(char c, std::string *out);
+    void appendCodePoint(unsigned cp, std::string *out);
+
+    std::vector<std::string> m_watched;
+    State m_state = BeforeObject;
+    std::string m_key;
+    bool m_capture = false;
+    std::string m_chunkOut;
+
+    // String escape state (persists across chunks)
+    bool m_escape = false;
+    int m_hexDigits = -1;          // -1 = not in \u, otherwise digits read
+    unsigned m_hexValue = 0;
+    unsigned m_highSurrogate = 0;  // pending UTF-16 high surrogate
+
+    // Nested value skipping
+    int m_nestDepth = 0;
+    bool m_nestInString = false;
+};
@@ -0,0 +1,126 @@
+#include "core/LineFramer.h"
+#include <QIODevice>
+#include <cstring>
+
+LineFramer::LineFramer(qsizetype maxLineSize)
+    : m_maxLineSize(maxLineSize)
+{
+}
+
+void LineFramer::compact()
+{
+    if (m_head == 0)
+        return;
+    if (m_head >= m_buf.size()) {
+        m_buf.resize(0); // keeps capacity
+        m_head = m_scan = 0;
+        return;
+    }
+    // Only move the unread tail once the dead prefix dominates the buffer
+    if (m_head * 2 < m_buf.size())
+        return;
+    qsizetype remaining = m_buf.size() - m_head;
+    std::memmove(m_buf.data(), m_buf.constData() + m_head, static_cast<size_t>(remaining));
+    m_buf.resize(remaining);
+    m_scan -= m_head;
+    m_head = 0;
+}
+
+void LineFramer::appendRaw(const char *data, qsizetype len)
+{
+    if (len <= 0)
+        return;
+
+    if (m_discarding) {
+        const void *nl = std::memchr(data, '\n', static_cast<size_t>(len));
+        if (!nl)
+            return;
+        qsizetype skip = static_cast<const char *>(nl) - data + 1;
+        data += skip;
+        len -= skip;
+        m_discarding = false;
+        if (len <= 0)
+            return;
+    }
+
+    compact();
+    m_buf.append(data, len);
+}
+
+void LineFramer::append(const QByteArray &data)
+{
+    appendRaw(data.constData(), data.size());
+}
+
+qint64 LineFramer::readFrom(QIODevice *device)
+{
+    qint64 total = 0;
+    while (true) {
+        qint64 avail = device->bytesAvailable();
+        if (avail <= 0)
+            break;
+
+        if (m_discarding) {
+            // Not worth buffering: pull through a small scratch block
+            char scratch[4096];
+            qint64 n = device->read(scratch, qMin<qint64>(avail, sizeof(scratch)));
+            if (n <= 0)
+                break;
+            appendRaw(scratch, n);
+            total += n;
+            continue;
+        }
+
+        compact();
+        qsizetype oldSize = m_buf.size();
+        m_buf.resize(oldSize + avail);
+        qint64 n = device->read(m_buf.data() + oldSize, avail);
+        m_buf.resize(oldSize + qMax<qint64>(n, 0));
+        if (n <= 0)
+            break;
+        total += n;
+    }
+    return total;
+}
+
+LineFramer::Result LineFramer::next(QByteArray &line)
+{
+    qsizetype idx = m_buf.indexOf('\n', m_scan);
+    if (idx < 0) {
+        m_scan = m_buf.size();
+        if (m_buf.size() - m_head > m_maxLineSize) {
+            // Oversized partial line: drop what we have and skip to its end
+            m_buf.resize(0);
+            m_head = m_scan = 0;
+            m_discarding = true;
+            ++m_overflows;
+            return Overflow;
+        }
+        return NoLine;
+    }
+
+    qsizetype start = m_head;
+    m_head = idx + 1;
+    m_scan = m_head;
+    if (idx - start > m_maxLineSize) {
+        ++m_overflows;
+        return Overflow;
+    }
+    line = QByteArray::fromRawData(m_buf.constData() + start, idx - start);
+    return Line;
+}
+
+QByteArray LineFramer::takeRemainder()
+{
+    QByteArray rest = m_discarding ? QByteArray()
+                                   : m_buf.mid(m_head);
+    clear();
+    return rest;
+}
+
+void LineFramer::clear()
+{
+    m_buf.clear();
+    m_head = m_scan = 0;
+    m_discarding = false;
+}
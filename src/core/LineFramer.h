@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QByteArray>
+
+class QIODevice;
+
+// Splits a byte stream into newline-terminated lines without shifting the
+// buffer once per line. Consumed bytes are only reclaimed when they make up
+// at least half of the buffer, and the newline scan resumes where the last
+// one stopped, so framing is amortized O(1) per byte even for multi-MB lines.
+//
+// Lines are handed out as views (QByteArray::fromRawData) into the internal
+// buffer; a view stays valid until the next append()/readFrom()/clear()/
+// takeRemainder(). Not reentrant: code handling a line must not feed or
+// clear the framer it came from while still using the view (copy the line
+// first if it has to).
+class LineFramer {
+public:
+    enum Result {
+        NoLine,    // no complete line buffered yet
+        Line,      // `line` holds the next line, without the trailing '\n'
+        Overflow   // a line exceeded maxLineSize and was dropped
+    };
+
+    explicit LineFramer(qsizetype maxLineSize = 64 * 1024 * 1024);
+
+    void setMaxLineSize(qsizetype bytes) { m_maxLineSize = bytes; }
+    qsizetype maxLineSize() const { return m_maxLineSize; }
+
+    void append(const QByteArray &data);
+    // Reads everything the device has available straight into the buffer.
+    // Returns the number of bytes read.
+    qint64 readFrom(QIODevice *device);
+
+    Result next(QByteArray &line);
+
+    // Unterminated trailing bytes (e.g. at process exit). Clears the framer.
+    QByteArray takeRemainder();
+    void clear();
+
+    qsizetype bufferedBytes() const { return m_buf.size() - m_head; }
+    int overflowCount() const { return m_overflows; }
+
+private:
+    void compact();
+    void appendRaw(const char *data, qsizetype len);
+
+    QByteArray m_buf;
+    qsizetype m_head = 0;        // first unconsumed byte
+    qsizetype m_scan = 0;        // no '\n' in [m_head, m_scan)
+    qsizetype m_maxLineSize;
+    bool m_discarding = false;   // skipping the tail of an oversized line
+    int m_overflows = 0;
+};
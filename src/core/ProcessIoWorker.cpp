@@ -0,0 +1,254 @@
+#include "core/ProcessIoWorker.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+
+// One frame at 60 Hz: the GUI gets at most one batch per tab per frame
+static constexpr int kBatchIntervalMs = 16;
+// How long terminate() gives the process before killing it
+static constexpr int kKillAfterMs = 2000;
+
+static QVector<QThread *> s_ioThreads;
+static int s_nextIoThread = 0;
+
+static void stopIoThreads()
+{
+    for (QThread *t : s_ioThreads) {
+        t->quit();
+        t->wait();
+        delete t;
+    }
+    s_ioThreads.clear();
+}
+
+QThread *ProcessIoWorker::ioThread()
+{
+    if (s_ioThreads.isEmpty()) {
+        qRegisterMetaType<QVector<StreamEvent>>();
+        qRegisterMetaType<TurnMetrics>();
+        const int count = qBound(1, QThread::idealThreadCount() / 2, 4);
+        for (int i = 0; i < count; ++i) {
+            auto *t = new QThread;
+            t->setObjectName(QStringLiteral("claude-io-%1").arg(i));
+            t->start();
+            s_ioThreads.append(t);
+        }
+        // After main() has destroyed the windows (and with them every
+        // ClaudeProcess), but before QCoreApplication goes away
+        qAddPostRoutine(stopIoThreads);
+    }
+    return s_ioThreads[s_nextIoThread++ % s_ioThreads.size()];
+}
+
+ProcessIoWorker::ProcessIoWorker(const QString &capturePath)
+    : m_parser(this)
+    , m_capturePath(capturePath)
+    , m_frameTimer(new QTimer(this))
+{
+    m_parser.setBatched(true);
+    m_parser.setCoalescing(true);
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setInterval(kBatchIntervalMs);
+    connect(m_frameTimer, &QTimer::timeout, this, &ProcessIoWorker::flushBatch);
+}
+
+ProcessIoWorker::~ProcessIoWorker()
+{
+    m_recorder.close();
+    if (m_process && m_process->state() != QProcess::NotRunning) {
+        m_process->disconnect(this);
+        m_process->terminate();
+        if (!m_process->waitForFinished(2000))
+            m_process->kill();
+    }
+}
+
+void ProcessIoWorker::start(QProcess *parked, const ProcessLauncher::Command &command)
+{
+    if (!m_capturePath.isEmpty())
+        m_recorder.open(m_capturePath);
+
+    if (parked && parked->state() != QProcess::NotRunning) {
+        attach(parked);
+        if (m_process->state() == QProcess::Running) {
+            m_startedAtMs = TurnTimer::clockMs();
+            emit processStarted(m_process->processId());
+        }
+        if (m_process->bytesAvailable() > 0)
+            onReadyReadStdout();
+        return;
+    }
+    // Exited while parked, before the launcher heard of it
+    delete parked;
+    // Wired up before start() so a failed start reported from inside it isn't lost
+    ProcessLauncher::launch(command, this, [this](QProcess *proc) { attach(proc); });
+}
+
+void ProcessIoWorker::attach(QProcess *process)
+{
+    m_process = process;
+    m_process->setParent(this);
+    connect(m_process, &QProcess::readyReadStandardOutput,
+            this, &ProcessIoWorker::onReadyReadStdout);
+    connect(m_process, &QProcess::readyReadStandardError, this, [this] {
+        m_stderr.append(m_process->readAllStandardError());
+    });
+    connect(m_process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
+            this, &ProcessIoWorker::onProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError err) {
+        if (!m_terminating)
+            emit processError(err);
+    });
+    connect(m_process, &QProcess::started, this, [this] {
+        m_startedAtMs = TurnTimer::clockMs();
+        m_turnTimer.processStarted(m_startedAtMs);
+        emit processStarted(m_process->processId());
+    });
+}
+
+void ProcessIoWorker::write(const QByteArray &data, bool closeAfter, qint64 sentAtMs)
+{
+    m_parser.reset();
+    m_stderr.clear();
+    m_turnTimer.begin(sentAtMs, m_startedAtMs);
+    if (m_process->state() == QProcess::NotRunning
+        || m_process->write(data) != data.size()) {
+        emit writeFailed(data);
+        return;
+    }
+    if (closeAfter)
+        m_process->closeWriteChannel();
+}
+
+void ProcessIoWorker::retire()
+{
+    m_retiring = true;
+    m_recorder.close();
+    if (m_process->state() == QProcess::NotRunning) {
+        deleteLater();
+        return;
+    }
+    m_process->closeWriteChannel();
+    QTimer::singleShot(5000, this, [this] {
+        if (m_process->state() != QProcess::NotRunning)
+            m_process->terminate();
+    });
+}
+
+void ProcessIoWorker::terminate()
+{
+    m_terminating = true;
+    m_frameTimer->stop();
+    m_recorder.close();
+    if (m_process->state() == QProcess::NotRunning) {
+        emit processFinished(m_process->exitCode(), m_process->exitStatus(), {});
+        deleteLater();
+        return;
+    }
+    m_process->terminate();
+    QTimer::singleShot(kKillAfterMs, this, [this] {
+        if (m_process->state() != QProcess::NotRunning)
+            m_process->kill();
+    });
+}
+
+void ProcessIoWorker::onReadyReadStdout()
+{
+    m_process->setReadChannel(QProcess::StandardOutput);
+    const qint64 nowMs = TurnTimer::clockMs();
+    if (m_framer.readFrom(m_process) > 0)
+        m_turnTimer.stdoutReceived(nowMs);
+
+    QByteArray line;
+    while (true) {
+        LineFramer::Result r = m_framer.next(line);
+        if (r == LineFramer::NoLine)
+            break;
+        if (r == LineFramer::Overflow) {
+            qWarning() << "[cccpp] Dropped stdout line larger than"
+                       << m_framer.maxLineSize() << "bytes";
+            continue;
+        }
+        // StreamParser::feed() skips blank lines itself
+        if (line.isEmpty())
+            continue;
+        if (m_recorder.isOpen())
+            m_recorder.record(line);
+        feedTimed(line, nowMs);
+    }
+
+    if (m_parser.hasBatch() && !m_frameTimer->isActive())
+        m_frameTimer->start();
+}
+
+void ProcessIoWorker::feedTimed(const QByteArray &line, qint64 nowMs)
+{
+    if (!m_turnTimer.isActive()) {
+        m_parser.feed(line);
+        return;
+    }
+    const quint64 deltasBefore = m_parser.emissionStats().deltasIn;
+    const qsizetype eventsBefore = m_parser.pendingBatch().size();
+    m_parser.feed(line);
+
+    if (m_parser.emissionStats().deltasIn != deltasBefore)
+        m_turnTimer.deltaReceived(nowMs);
+    const QVector<StreamEvent> &batch = m_parser.pendingBatch();
+    for (qsizetype i = eventsBefore; i < batch.size(); ++i) {
+        if (batch[i].type == StreamEvent::TurnCompleted) {
+            m_finishedTurn = m_turnTimer.finish(nowMs);
+            m_hasFinishedTurn = true;
+            break;
+        }
+        m_turnTimer.eventReceived(batch[i], nowMs);
+    }
+}
+
+void ProcessIoWorker::flushBatch()
+{
+    if (m_retiring || m_terminating)
+        return;
+    if (m_hasFinishedTurn) {
+        m_hasFinishedTurn = false;
+        emit turnMetricsReady(m_finishedTurn);
+    }
+    if (m_parser.hasBatch())
+        emit eventsReady(m_parser.takeBatch());
+}
+
+void ProcessIoWorker::onProcessFinished(int exitCode, QProcess::ExitStatus status)
+{
+    qCDebug(lcProcess) << "[cccpp] onProcessFinished  exit=" << exitCode
+             << (status == QProcess::NormalExit ? "Normal" : "Crash")
+             << "bufferRemaining=" << m_framer.bufferedBytes() << "bytes";
+
+    if (m_retiring) {
+        deleteLater();
+        return;
+    }
+    if (m_terminating) {
+        emit processFinished(exitCode, status, m_stderr);
+        deleteLater();
+        return;
+    }
+
+    QByteArray remainder = m_framer.takeRemainder();
+    if (!remainder.trimmed().isEmpty()) {
+        if (m_recorder.isOpen())
+            m_recorder.record(remainder);
+        feedTimed(remainder, TurnTimer::clockMs());
+    }
+    m_recorder.close();
+    if (m_turnTimer.isActive()) {
+        // Exited without a result event
+        m_finishedTurn = m_turnTimer.finish(TurnTimer::clockMs());
+        m_hasFinishedTurn = true;
+    }
+
+    // Everything parsed so far must reach the GUI before the exit does
+    m_frameTimer->stop();
+    flushBatch();
+    emit processFinished(exitCode, status, m_stderr);
+    m_stderr.clear();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QObject>
+#include <QProcess>
+#include <QByteArray>
+#include <QVector>
+#include "core/LineFramer.h"
+#include "core/ProcessLauncher.h"
+#include "core/StreamParser.h"
+#include "core/StreamRecorder.h"
+#include "core/TurnMetrics.h"
+
+class QThread;
+class QTimer;
+
+// Owns one claude QProcess on a shared I/O thread: reads and frames stdout,
+// records it, parses it with a batched StreamParser and hands the parsed
+// events to the GUI as one ordered QVector<StreamEvent> per frame. All
+// signals leave this thread in emission order, so a batch always arrives
+// before the processFinished() that followed it.
+//
+// Created on the GUI thread without a process and moved to an I/O thread
+// before anything runs; the process is created (or a parked one adopted)
+// there by start(). Everything is invoked through queued calls.
+class ProcessIoWorker : public QObject {
+    Q_OBJECT
+public:
+    explicit ProcessIoWorker(const QString &capturePath);
+    ~ProcessIoWorker() override;
+
+    // Round-robin over a small pool of threads shared by all workers
+    static QThread *ioThread();
+
+    // --- Called on the I/O thread ---
+    // Takes over `parked`, a process parked on this thread, unless it has
+    // exited already; otherwise (or without one) starts `command` here.
+    void start(QProcess *parked, const ProcessLauncher::Command &command);
+    // Starts a turn: resets the parser and stderr, writes `data` to stdin.
+    // `sentAtMs` (TurnTimer::clockMs()) is when the user sent the message.
+    void write(const QByteArray &data, bool closeAfter, qint64 sentAtMs);
+    // Lets the process exit after stdin closes, then deletes the worker
+    void retire();
+    // Terminates the process, killing it if it lingers, without waiting for
+    // it: processFinished() follows once it has exited, then the worker
+    // deletes itself. Nothing else is emitted after this call.
+    void terminate();
+
+signals:
+    void processStarted(qint64 pid);
+    void eventsReady(const QVector<StreamEvent> &events);
+    // Precedes the eventsReady() that carries the turn's TurnCompleted
+    void turnMetricsReady(const TurnMetrics &metrics);
+    void processFinished(int exitCode, QProcess::ExitStatus status, const QByteArray &stderrOutput);
+    void processError(QProcess::ProcessError error);
+    void writeFailed(const QByteArray &data);
+
+private:
+    void attach(QProcess *process);
+    void onReadyReadStdout();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus status);
+    void feedTimed(const QByteArray &line, qint64 nowMs);
+    void flushBatch();
+
+    QProcess *m_process = nullptr;
+    StreamParser m_parser;
+    LineFramer m_framer;
+    StreamRecorder m_recorder;
+    QString m_capturePath;
+    QByteArray m_stderr;
+    QTimer *m_frameTimer;
+    bool m_retiring = false;
+    bool m_terminating = false;
+    TurnTimer m_turnTimer;
+    qint64 m_startedAtMs = 0;
+    TurnMetrics m_finishedTurn;
+    bool m_hasFinishedTurn = false;
+};
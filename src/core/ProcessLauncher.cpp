@@ -0,0 +1,364 @@
+#include "core/ProcessLauncher.h"
+#include "util/Config.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+#include <QUuid>
+#include <QDebug>
+
+Q_LOGGING_CATEGORY(lcProcess, "cccpp.process", QtInfoMsg)
+
+static constexpr int kParkedIdleMs = 5 * 60 * 1000;
+
+ProcessLauncher &ProcessLauncher::instance()
+{
+    static ProcessLauncher launcher;
+    return launcher;
+}
+
+ProcessLauncher::ProcessLauncher()
+    : m_idleTimer(new QTimer(this))
+{
+    m_idleTimer->setInterval(kParkedIdleMs / 4);
+    connect(m_idleTimer, &QTimer::timeout, this, &ProcessLauncher::retireIdle);
+
+    connect(&Config::instance(), &Config::changed, this, [this] {
+        if (!m_resolved)
+            return;
+        const Config &cfg = Config::instance();
+        if (cfg.claudeBinary() != m_configuredBinary || cfg.processPoolSize() != m_poolSize)
+            invalidate();
+    });
+    if (auto *app = QCoreApplication::instance())
+        connect(app, &QCoreApplication::aboutToQuit, this, &ProcessLauncher::clearPool);
+}
+
+ProcessLauncher::~ProcessLauncher()
+{
+    clearPool();
+}
+
+QString ProcessLauncher::LaunchSpec::key() const
+{
+    QStringList parts;
+    parts << workingDir << args;
+    for (auto it = env.cbegin(); it != env.cend(); ++it)
+        parts << it.key() + "=" + it.value();
+    return parts.join(QChar(0x1f));
+}
+
+void ProcessLauncher::ensureResolved()
+{
+    if (m_resolved)
+        return;
+
+    const Config &cfg = Config::instance();
+    m_configuredBinary = cfg.claudeBinary();
+    m_poolSize = cfg.processPoolSize();
+
+    m_claudeBin = m_configuredBinary;
+    if (m_claudeBin == "claude" || m_claudeBin.isEmpty()) {
+        QStringList searchDirs = {
+            QDir::homePath() + "/.local/bin",
+            "/usr/local/bin",
+            "/opt/homebrew/bin",
+        };
+        for (const QString &dir : searchDirs) {
+            QString candidate = dir + "/claude";
+            if (QFile::exists(candidate)) {
+                m_claudeBin = candidate;
+                break;
+            }
+        }
+    }
+
+    // Force line-buffered stdout via stdbuf if available, otherwise run directly
+    m_stdbuf.clear();
+    for (const QString &candidate : {QStringLiteral("/usr/bin/stdbuf"),
+                                     QStringLiteral("/opt/homebrew/bin/stdbuf")}) {
+        if (QFile::exists(candidate)) {
+            m_stdbuf = candidate;
+            break;
+        }
+    }
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    QString path = env.value("PATH");
+    QStringList extraPaths = {
+        QDir::homePath() + "/.local/bin",
+        "/usr/local/bin",
+        "/opt/homebrew/bin",
+        "/opt/homebrew/sbin",
+    };
+    QDir nvmDir(QDir::homePath() + "/.nvm/versions/node");
+    if (nvmDir.exists()) {
+        QStringList versions = nvmDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        if (!versions.isEmpty())
+            extraPaths.prepend(nvmDir.absoluteFilePath(versions.last()) + "/bin");
+    }
+    for (const QString &p : extraPaths) {
+        if (!path.contains(p) && QDir(p).exists())
+            path = p + ":" + path;
+    }
+    env.insert("PATH", path);
+    if (env.value("HOME").isEmpty())
+        env.insert("HOME", QDir::homePath());
+    env.insert("CLAUDE_CODE_ENABLE_SDK_FILE_CHECKPOINTING", "1");
+    m_baseEnv = env;
+
+    m_resolved = true;
+    qCDebug(lcProcess) << "[cccpp] Launcher resolved claude=" << m_claudeBin
+             << "stdbuf=" << (m_stdbuf.isEmpty() ? QStringLiteral("none") : m_stdbuf)
+             << "pool=" << m_poolSize;
+}
+
+QString ProcessLauncher::claudeBinary()
+{
+    ensureResolved();
+    return m_claudeBin;
+}
+
+QProcessEnvironment ProcessLauncher::environment(const QMap<QString, QString> &extra)
+{
+    ensureResolved();
+    QProcessEnvironment env = m_baseEnv;
+    for (auto it = extra.cbegin(); it != extra.cend(); ++it)
+        env.insert(it.key(), it.value());
+    return env;
+}
+
+ProcessLauncher::Command ProcessLauncher::command(const LaunchSpec &spec,
+                                                  const QString &resumeSessionId)
+{
+    ensureResolved();
+    QStringList args = spec.args;
+    if (!resumeSessionId.isEmpty()) {
+        args << "--resume" << resumeSessionId;
+    } else {
+        // Force a fresh session to prevent auto-resuming old sessions from other projects
+        args << "--session-id" << QUuid::createUuid().toString(QUuid::WithoutBraces);
+    }
+
+    Command cmd;
+    cmd.workingDir = spec.workingDir;
+    cmd.env = environment(spec.env);
+    if (!m_stdbuf.isEmpty()) {
+        cmd.program = m_stdbuf;
+        cmd.args = QStringList{"-oL", m_claudeBin} + args;
+    } else {
+        cmd.program = m_claudeBin;
+        cmd.args = args;
+    }
+    return cmd;
+}
+
+QProcess *ProcessLauncher::launch(const Command &command, QObject *parent, const Setup &setup)
+{
+    auto *proc = new QProcess(parent);
+    if (!command.workingDir.isEmpty())
+        proc->setWorkingDirectory(command.workingDir);
+    proc->setProcessEnvironment(command.env);
+    if (setup)
+        setup(proc);
+    proc->start(command.program, command.args);
+    return proc;
+}
+
+QProcess *ProcessLauncher::takeParked(const QString &key, QThread *thread)
+{
+    for (int i = 0; i < m_parked.size(); ++i) {
+        const Parked &p = m_parked[i];
+        if (p.key != key || !p.process || (thread && p.process->thread() != thread))
+            continue;
+        QProcess *proc = m_parked.takeAt(i).process;
+        proc->disconnect(this);
+        return proc;
+    }
+    return nullptr;
+}
+
+QProcess *ProcessLauncher::takeParked(const LaunchSpec &spec)
+{
+    QProcess *proc = takeParked(spec.key(), nullptr);
+    if (!proc)
+        return nullptr;
+    qCDebug(lcProcess) << "[cccpp] Using parked claude process";
+    // The spec was worth parking once; keep one ready for the next caller
+    QTimer::singleShot(0, this, [this, spec, thread = proc->thread()] { prewarm(spec, thread); });
+    return proc;
+}
+
+QProcess *ProcessLauncher::start(const LaunchSpec &spec, const QString &resumeSessionId,
+                                 QObject *parent, const Setup &setup)
+{
+    ensureResolved();
+
+    if (resumeSessionId.isEmpty()) {
+        if (QProcess *proc = takeParked(spec.key(), QThread::currentThread())) {
+            proc->setParent(parent);
+            if (setup)
+                setup(proc);
+            qCDebug(lcProcess) << "[cccpp] Using parked claude process pid=" << proc->processId();
+            QTimer::singleShot(0, this, [this, spec] { prewarm(spec); });
+            return proc;
+        }
+    }
+    return launch(command(spec, resumeSessionId), parent, setup);
+}
+
+void ProcessLauncher::prewarm(const LaunchSpec &spec, QThread *thread)
+{
+    ensureResolved();
+    const QString key = spec.key();
+
+    int have = 0;
+    for (const auto &p : m_parked)
+        if (p.key == key)
+            ++have;
+
+    while (have < m_poolSize) {
+        if (m_parked.size() >= m_poolSize) {
+            // Make room by dropping the oldest process parked for another spec
+            int victim = -1;
+            for (int i = 0; i < m_parked.size(); ++i) {
+                if (m_parked[i].key != key) {
+                    victim = i;
+                    break;
+                }
+            }
+            if (victim < 0)
+                break;
+            retire(m_parked.takeAt(victim).process);
+        }
+
+        // Failed inside start(): it is already unparked, and so would the next one be
+        if (!park(key, command(spec, {}), thread ? thread : this->thread()))
+            break;
+        ++have;
+    }
+    if (!m_parked.isEmpty() && !m_idleTimer->isActive())
+        m_idleTimer->start();
+}
+
+bool ProcessLauncher::park(const QString &key, const Command &command, QThread *thread)
+{
+    // The slot is taken now; the process fills it once its thread has started
+    // it. Everything reports back by id, so a process that is retired, taken
+    // or deleted in the meantime is never looked up by a stale pointer.
+    const quint64 id = ++m_lastParkId;
+    m_parked.append({id, key, nullptr, QDeadlineTimer(kParkedIdleMs)});
+
+    auto spawn = [this, id, command] {
+        QProcess *proc = launch(command, nullptr, [this, id](QProcess *proc) {
+            connect(proc, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
+                    this, [this, id] { unpark(id); });
+            connect(proc, &QProcess::errorOccurred, this, [this, id](QProcess::ProcessError err) {
+                if (err == QProcess::FailedToStart)
+                    unpark(id);
+            });
+        });
+        if (proc->state() == QProcess::NotRunning) {
+            delete proc;
+            proc = nullptr;
+        }
+        QMetaObject::invokeMethod(this, [this, id, proc] { parked(id, proc); });
+    };
+
+    if (thread == this->thread()) {
+        spawn();
+        for (const auto &p : m_parked)
+            if (p.id == id)
+                return true;
+        return false;
+    }
+    // Something to queue the spawn on: a plain QObject living on `thread`
+    auto *context = new QObject;
+    context->moveToThread(thread);
+    QMetaObject::invokeMethod(context, [spawn, context] {
+        spawn();
+        context->deleteLater();
+    }, Qt::QueuedConnection);
+    return true;
+}
+
+void ProcessLauncher::parked(quint64 id, QProcess *proc)
+{
+    for (auto &p : m_parked) {
+        if (p.id != id)
+            continue;
+        if (proc)
+            p.process = proc;
+        else
+            unpark(id);
+        return;
+    }
+    // Retired or dropped while its thread was starting it
+    retire(proc);
+}
+
+void ProcessLauncher::unpark(quint64 id)
+{
+    for (int i = 0; i < m_parked.size(); ++i) {
+        if (m_parked[i].id != id)
+            continue;
+        if (QProcess *proc = m_parked.takeAt(i).process)
+            proc->deleteLater();
+        return;
+    }
+}
+
+void ProcessLauncher::setPoolSize(int size)
+{
+    m_poolSize = qMax(0, size);
+    while (m_parked.size() > m_poolSize)
+        retire(m_parked.takeFirst().process);
+}
+
+void ProcessLauncher::retire(QProcess *proc)
+{
+    if (!proc)
+        return;
+    // The CLI exits on EOF; delete it once it has
+    proc->disconnect(this);
+    connect(proc, qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
+            proc, &QObject::deleteLater);
+    QMetaObject::invokeMethod(proc, [proc] { proc->closeWriteChannel(); });
+}
+
+void ProcessLauncher::retireIdle()
+{
+    for (int i = 0; i < m_parked.size(); ++i) {
+        if (!m_parked[i].process || !m_parked[i].idleDeadline.hasExpired())
+            continue;
+        qCDebug(lcProcess) << "[cccpp] Retiring parked claude process nobody took";
+        retire(m_parked.takeAt(i).process);
+        --i;
+    }
+    if (m_parked.isEmpty())
+        m_idleTimer->stop();
+}
+
+void ProcessLauncher::invalidate()
+{
+    qCDebug(lcProcess) << "[cccpp] Launcher cache invalidated, dropping" << m_parked.size() << "parked processes";
+    m_resolved = false;
+    setPoolSize(0);
+}
+
+void ProcessLauncher::clearPool()
+{
+    for (const auto &p : m_parked) {
+        if (!p.process)
+            continue;
+        p.process->disconnect(this);
+        // Right here for this thread's processes, queued for the others
+        QMetaObject::invokeMethod(p.process, [proc = p.process] {
+            proc->kill();
+            proc->waitForFinished(1000);
+            delete proc;
+        });
+    }
+    m_parked.clear();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QObject>
+#include <QDeadlineTimer>
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QList>
+#include <functional>
+
+class QThread;
+class QTimer;
+
+// Process lifecycle and per-turn logging of the claude process layer. Debug
+// output is off unless enabled: QT_LOGGING_RULES="cccpp.process.debug=true"
+Q_DECLARE_LOGGING_CATEGORY(lcProcess)
+
+// Starts claude CLI processes for ClaudeProcess.
+//
+// The claude binary, the stdbuf wrapper and the base environment (PATH
+// extended with ~/.local/bin, nvm, Homebrew) are resolved once and cached
+// until Config changes. Processes are started without waitForStarted(); a
+// write before the process is up is buffered by QProcess, and a failed start
+// arrives as QProcess::errorOccurred(FailedToStart).
+//
+// Fresh sessions (no --resume) can be served from a small pool of processes
+// that were spawned ahead of time with the same launch spec and are parked on
+// stdin. Handing one out schedules a replacement, so a burst of new tabs or
+// delegated children doesn't pay CLI startup one after another. A process
+// nobody takes within a few minutes is retired, so a spec that stopped being
+// asked for doesn't hold a pool slot.
+//
+// Parked processes live on the thread prewarm() was given, so whoever takes
+// one over there (a ProcessIoWorker on an I/O thread) never moves a running
+// QProcess between threads. The pool's bookkeeping stays on this thread.
+class ProcessLauncher : public QObject {
+    Q_OBJECT
+public:
+    static ProcessLauncher &instance();
+
+    struct LaunchSpec {
+        QString workingDir;
+        QStringList args;               // without --resume / --session-id
+        QMap<QString, QString> env;     // on top of the cached base environment
+
+        QString key() const;
+    };
+
+    // Everything needed to start a process, resolved up front so that it
+    // can be started on another thread
+    struct Command {
+        QString program;
+        QStringList args;
+        QString workingDir;
+        QProcessEnvironment env;
+    };
+
+    // Runs on a process before QProcess::start(), or before a parked one is
+    // handed out. Connect errorOccurred here: a failed start can be reported
+    // from inside start() itself.
+    using Setup = std::function<void(QProcess *)>;
+
+    // Returns a started (or starting) process owned by `parent`. With an empty
+    // `resumeSessionId` a process parked on the calling thread is used when
+    // one matches `spec`.
+    QProcess *start(const LaunchSpec &spec, const QString &resumeSessionId, QObject *parent,
+                    const Setup &setup = {});
+    // What start() would run for `spec` when nothing is parked
+    Command command(const LaunchSpec &spec, const QString &resumeSessionId);
+    // Creates and starts a process for `command` on the calling thread.
+    // Touches no launcher state, so any thread may call it.
+    static QProcess *launch(const Command &command, QObject *parent, const Setup &setup = {});
+    // Hands out a process parked for `spec` on any thread, or nullptr. It has
+    // no parent and may have exited already; whoever takes it checks that on
+    // its thread. A replacement is parked on the same thread.
+    QProcess *takeParked(const LaunchSpec &spec);
+    // Parks processes for `spec` until the pool holds poolSize() of them.
+    // They are created on `thread`, this one by default.
+    void prewarm(const LaunchSpec &spec, QThread *thread = nullptr);
+
+    QString claudeBinary();
+    QProcessEnvironment environment(const QMap<QString, QString> &extra = {});
+
+    void setPoolSize(int size);
+    int poolSize() const { return m_poolSize; }
+    // Includes processes still being started on another thread
+    int parkedCount() const { return m_parked.size(); }
+
+    // Drops the cached binary/environment and every parked process
+    void invalidate();
+
+private:
+    ProcessLauncher();
+    ~ProcessLauncher() override;
+
+    struct Parked {
+        quint64 id = 0;
+        QString key;
+        QProcess *process = nullptr;    // null until its thread has started it
+        QDeadlineTimer idleDeadline;
+    };
+
+    void ensureResolved();
+    QProcess *takeParked(const QString &key, QThread *thread);
+    bool park(const QString &key, const Command &command, QThread *thread);
+    void parked(quint64 id, QProcess *proc);
+    void unpark(quint64 id);
+    void retire(QProcess *proc);
+    void retireIdle();
+    void clearPool();
+
+    bool m_resolved = false;
+    QString m_configuredBinary;     // Config::claudeBinary() at resolve time
+    QString m_claudeBin;
+    QString m_stdbuf;               // empty when not available
+    QProcessEnvironment m_baseEnv;
+
+    int m_poolSize = 2;
+    QList<Parked> m_parked;         // oldest first
+    quint64 m_lastParkId = 0;
+    QTimer *m_idleTimer = nullptr;
+};
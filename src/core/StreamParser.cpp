@@ -1,13 +1,193 @@
 #include "core/StreamParser.h"
+#include <QMetaMethod>
 #include <QDebug>
 
+// ---------------------------------------------------------------------------
+// StreamLineSniffer — SAX consumer for the hot "stream_event" lines.
+//
+// A turn produces thousands of tiny content_block_delta lines. Building a
+// json DOM for each of them (and copying it into StreamEvent) dominated the
+// parser profile, so these lines are classified while tokenizing: only the
+// few fields handleInnerEvent needs are captured, and parsing stops as soon
+// as the top-level type turns out to be anything other than stream_event.
+// Buffers are reused across lines.
+// ---------------------------------------------------------------------------
+struct StreamLineSniffer : nlohmann::json_sax<json> {
+    enum Scope : unsigned char { Other, Top, Event, Delta, Block };
+    enum Key : unsigned char { KOther, KType, KEvent, KIndex, KDelta, KContentBlock,
+                               KText, KThinking, KPartialJson, KName, KId };
+
+    // Captured fields
+    std::string type;        // top-level "type"
+    std::string eventType;   // event.type
+    std::string deltaType;   // event.delta.type
+    std::string blockType;   // event.content_block.type
+    std::string blockName;
+    std::string blockId;
+    std::string payload;     // delta text / thinking / partial_json
+    int index = -1;
+    bool notStreamEvent = false;
+    bool malformed = false;
+
+    bool sniff(const QByteArray &line)
+    {
+        type.clear();
+        eventType.clear();
+        deltaType.clear();
+        blockType.clear();
+        blockName.clear();
+        blockId.clear();
+        payload.clear();
+        index = -1;
+        notStreamEvent = false;
+        malformed = false;
+        m_depth = 0;
+        m_key = KOther;
+
+        const char *begin = line.constData();
+        json::sax_parse(begin, begin + line.size(), this);
+        return !malformed && !notStreamEvent && type == "stream_event";
+    }
+
+    // --- json_sax interface ---
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t v) override { captureIndex(static_cast<int>(v)); return true; }
+    bool number_unsigned(number_unsigned_t v) override { captureIndex(static_cast<int>(v)); return true; }
+    bool number_float(number_float_t, const string_t &) override { return true; }
+    bool binary(binary_t &) override { return true; }
+
+    bool string(string_t &val) override
+    {
+        switch (scope()) {
+        case Top:
+            if (m_key == KType) {
+                type = val;
+                if (type != "stream_event") {
+                    notStreamEvent = true;
+                    return false; // rare event: caller falls back to the DOM
+                }
+            }
+            break;
+        case Event:
+            if (m_key == KType) eventType = val;
+            break;
+        case Delta:
+            if (m_key == KType) deltaType = val;
+            else if (m_key == KText || m_key == KThinking || m_key == KPartialJson) payload = val;
+            break;
+        case Block:
+            if (m_key == KType) blockType = val;
+            else if (m_key == KName) blockName = val;
+            else if (m_key == KId) blockId = val;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override
+    {
+        Scope parent = scope();
+        Scope next = Other;
+        if (m_depth == 0)
+            next = Top;
+        else if (parent == Top && m_key == KEvent)
+            next = Event;
+        else if (parent == Event && m_key == KDelta)
+            next = Delta;
+        else if (parent == Event && m_key == KContentBlock)
+            next = Block;
+        push(next);
+        return true;
+    }
+    bool end_object() override { --m_depth; return true; }
+    bool start_array(std::size_t) override { push(Other); return true; }
+    bool end_array() override { --m_depth; return true; }
+
+    bool key(string_t &val) override
+    {
+        m_key = keyFor(val);
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override
+    {
+        malformed = true;
+        return false;
+    }
+
+private:
+    static constexpr int kMaxTrackedDepth = 16;
+
+    Scope scope() const
+    {
+        if (m_depth <= 0 || m_depth > kMaxTrackedDepth) return Other;
+        return m_scopes[m_depth - 1];
+    }
+    void push(Scope s)
+    {
+        if (m_depth < kMaxTrackedDepth)
+            m_scopes[m_depth] = s;
+        ++m_depth;
+    }
+    void captureIndex(int v)
+    {
+        if (scope() == Event && m_key == KIndex)
+            index = v;
+    }
+    static Key keyFor(const std::string &k)
+    {
+        switch (k.size()) {
+        case 2:  return k == "id" ? KId : KOther;
+        case 4:  return k == "type" ? KType : k == "text" ? KText : k == "name" ? KName : KOther;
+        case 5:  return k == "event" ? KEvent : k == "index" ? KIndex : k == "delta" ? KDelta : KOther;
+        case 8:  return k == "thinking" ? KThinking : KOther;
+        case 12: return k == "partial_json" ? KPartialJson : KOther;
+        case 13: return k == "content_block" ? KContentBlock : KOther;
+        default: return KOther;
+        }
+    }
+
+    Scope m_scopes[kMaxTrackedDepth] = {};
+    int m_depth = 0;
+    Key m_key = KOther;
+};
+
+const json &StreamEvent::raw() const
+{
+    if (!m_rawDom) {
+        json parsed = json::parse(rawLine.constData(), rawLine.constData() + rawLine.size(),
+                                  nullptr, false);
+        m_rawDom = std::make_shared<const json>(parsed.is_discarded() ? json() : std::move(parsed));
+    }
+    return *m_rawDom;
+}
+
 StreamParser::StreamParser(QObject *parent)
     : QObject(parent)
+    , m_sniffer(std::make_unique<StreamLineSniffer>())
 {
 }
 
+StreamParser::~StreamParser() = default;
+
+void StreamParser::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&StreamParser::eventParsed))
+        m_eventParsedConnected = true;
+}
+
+void StreamParser::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&StreamParser::eventParsed))
+        m_eventParsedConnected = isSignalConnected(signal);
+}
+
 void StreamParser::reset()
 {
+    endDeltaRun();
     m_accumulatedText.clear();
     m_pendingTools.clear();
     m_emittedToolIds.clear();
@@ -19,41 +199,193 @@ void StreamParser::feed(const QByteArray &line)
     if (line.trimmed().isEmpty())
         return;
 
-    json j;
-    try {
-        j = json::parse(line.begin(), line.end());
-    } catch (const json::parse_error &) {
+    // Fast path: stream_event deltas are dispatched straight from the SAX
+    // captures without building a DOM.
+    if (m_sniffer->sniff(line)) {
+        handleInnerEvent(*m_sniffer);
         return;
     }
+    if (m_sniffer->malformed)
+        return;
+
+    // Slow path for rare events (system, result, assistant snapshots, ...)
+    auto dom = std::make_shared<json>(json::parse(line.constData(),
+                                                  line.constData() + line.size(),
+                                                  nullptr, false));
+    if (dom->is_discarded())
+        return;
 
-    // (debug logging removed)
+    const bool isTurnResult = dom->contains("type") && (*dom)["type"] == "result";
+    const bool isError = dom->contains("is_error") && (*dom)["is_error"].is_boolean()
+                         && (*dom)["is_error"].get<bool>();
 
-    StreamEvent event = parseEvent(j);
+    StreamEvent event = parseEvent(*dom);
+    // `line` may be a view into the caller's read buffer; rare events keep
+    // their own copy so the event can outlive it.
+    event.rawLine = QByteArray(line.constData(), line.size());
+    event.m_rawDom = std::move(dom);
 
     switch (event.type) {
     case StreamEvent::TextDelta:
         m_accumulatedText += event.text;
-        emit textDelta(event.text);
         break;
     case StreamEvent::ToolUse:
         qDebug() << "[stream] toolUse:" << event.toolName << "id=" << event.toolId;
-        emit toolUseStarted(event.toolName, event.toolId, event.toolInput);
         break;
     case StreamEvent::ToolResult:
         qDebug() << "[stream] toolResult len=" << event.toolResultContent.size();
-        emit toolResultReceived(event.toolResultContent);
         break;
     case StreamEvent::Result:
         qDebug() << "[stream] result  session=" << event.sessionId;
-        emit resultReady(event.sessionId, event.raw);
         break;
     case StreamEvent::Error:
         qWarning() << "[stream] error:" << event.text;
-        emit errorOccurred(event.text);
         break;
     default:
         break;
     }
+    if (event.type != StreamEvent::Unknown)
+        deliver(std::move(event));
+
+    if (isTurnResult) {
+        StreamEvent done;
+        done.type = StreamEvent::TurnCompleted;
+        done.isError = isError;
+        deliver(std::move(done));
+    }
+}
+
+QVector<StreamEvent> StreamParser::takeBatch()
+{
+    endDeltaRun();
+    QVector<StreamEvent> batch;
+    batch.swap(m_batch);
+    return batch;
+}
+
+void StreamParser::dispatch(const QVector<StreamEvent> &events)
+{
+    for (const StreamEvent &event : events) {
+        if (event.type == StreamEvent::TextDelta || event.type == StreamEvent::ThinkingDelta) {
+            m_stats.deltasIn += static_cast<quint64>(event.mergedDeltas);
+            ++m_stats.deltasOut;
+        }
+        emitEvent(event);
+    }
+}
+
+void StreamParser::setCoalescing(bool coalescing)
+{
+    if (!coalescing)
+        endDeltaRun();
+    m_coalescing = coalescing;
+}
+
+void StreamParser::flush()
+{
+    endDeltaRun();
+}
+
+void StreamParser::deliver(StreamEvent &&event)
+{
+    const bool isDelta = event.type == StreamEvent::TextDelta
+                         || event.type == StreamEvent::ThinkingDelta;
+    if (isDelta)
+        ++m_stats.deltasIn;
+
+    if (m_coalescing && isDelta) {
+        if (m_openDelta.type == event.type) {
+            m_openDelta.text += event.text;
+            ++m_openDelta.mergedDeltas;
+            if (m_openDelta.text.size() >= kCoalesceFlushChars)
+                endDeltaRun();
+            return;
+        }
+        endDeltaRun();
+        m_openDelta = std::move(event);
+        // Unbatched: close the run once control returns to the event loop
+        if (!m_batched && !m_flushQueued) {
+            m_flushQueued = true;
+            QMetaObject::invokeMethod(this, [this] {
+                m_flushQueued = false;
+                endDeltaRun();
+            }, Qt::QueuedConnection);
+        }
+        return;
+    }
+
+    endDeltaRun();
+    push(std::move(event));
+}
+
+void StreamParser::endDeltaRun()
+{
+    if (m_openDelta.type == StreamEvent::Unknown)
+        return;
+    StreamEvent run = std::move(m_openDelta);
+    m_openDelta = StreamEvent();
+    push(std::move(run));
+}
+
+void StreamParser::push(StreamEvent &&event)
+{
+    if (event.type == StreamEvent::TextDelta || event.type == StreamEvent::ThinkingDelta)
+        ++m_stats.deltasOut;
+    if (m_batched)
+        m_batch.append(std::move(event));
+    else
+        emitEvent(event);
+}
+
+void StreamParser::emitEvent(const StreamEvent &event)
+{
+    switch (event.type) {
+    case StreamEvent::TextDelta:
+        emit textDelta(event.text);
+        if (m_eventParsedConnected)
+            emit eventParsed(event);
+        break;
+    case StreamEvent::ToolUse:
+        emit toolUseStarted(event.toolName, event.toolId, event.toolInput);
+        if (m_eventParsedConnected)
+            emit eventParsed(event);
+        break;
+    case StreamEvent::ToolResult:
+        emit toolResultReceived(event.toolResultContent);
+        break;
+    case StreamEvent::Result:
+        emit resultReady(event.sessionId, event.raw());
+        break;
+    case StreamEvent::Error:
+        emit errorOccurred(event.text);
+        break;
+    case StreamEvent::ThinkingStarted:
+        emit thinkingStarted();
+        break;
+    case StreamEvent::ThinkingDelta:
+        emit thinkingDelta(event.text);
+        break;
+    case StreamEvent::ThinkingStopped:
+        emit thinkingStopped();
+        break;
+    case StreamEvent::EditStreamStarted:
+        emit editStreamStarted(event.toolName, event.text);
+        break;
+    case StreamEvent::EditContentDelta:
+        emit editContentDelta(event.blockIndex, event.text);
+        break;
+    case StreamEvent::EditStreamFinished:
+        emit editStreamFinished(event.blockIndex);
+        break;
+    case StreamEvent::Checkpoint:
+        emit checkpointReceived(event.text);
+        break;
+    case StreamEvent::TurnCompleted:
+        emit turnCompleted(event.isError);
+        break;
+    case StreamEvent::Unknown:
+        break;
+    }
 }
 
 static QString jstr(const json &j, const std::string &key)
@@ -70,81 +402,81 @@ static std::string jtype(const json &j)
     return {};
 }
 
-static int jint(const json &j, const std::string &key, int def = -1)
-{
-    if (j.contains(key) && j[key].is_number())
-        return j[key].get<int>();
-    return def;
-}
-
-void StreamParser::handleInnerEvent(const json &ev)
+void StreamParser::handleInnerEvent(const StreamLineSniffer &ev)
 {
-    std::string evType = jtype(ev);
+    const std::string &evType = ev.eventType;
 
     // --- Text streaming ---
     if (evType == "content_block_delta") {
-        if (ev.contains("delta")) {
-            std::string dt = jtype(ev["delta"]);
-            if (dt == "text_delta") {
-                StreamEvent event;
-                event.type = StreamEvent::TextDelta;
-                event.text = jstr(ev["delta"], "text");
-                m_accumulatedText += event.text;
-                emit textDelta(event.text);
-                emit eventParsed(event);
-                return;
-            }
-            if (dt == "input_json_delta") {
-                int idx = jint(ev, "index");
-                if (m_pendingTools.contains(idx)) {
-                    std::string partial;
-                    if (ev["delta"].contains("partial_json") && ev["delta"]["partial_json"].is_string())
-                        partial = ev["delta"]["partial_json"].get<std::string>();
-                    m_pendingTools[idx].accumulatedJson += partial;
-                    processPartialToolJson(idx, partial);
-                }
-                return;
-            }
-            if (dt == "thinking_delta") {
-                QString text = jstr(ev["delta"], "thinking");
-                if (!text.isEmpty())
-                    emit thinkingDelta(text);
-                return;
+        const std::string &dt = ev.deltaType;
+        if (dt == "text_delta") {
+            StreamEvent event;
+            event.type = StreamEvent::TextDelta;
+            event.text = QString::fromUtf8(ev.payload.data(),
+                                           static_cast<qsizetype>(ev.payload.size()));
+            m_accumulatedText += event.text;
+            deliver(std::move(event));
+            return;
+        }
+        if (dt == "input_json_delta") {
+            auto it = m_pendingTools.find(ev.index);
+            if (it != m_pendingTools.end()) {
+                it->accumulatedJson += ev.payload;
+                processPartialToolJson(ev.index, ev.payload);
             }
-            if (dt == "signature_delta") {
-                return;
+            return;
+        }
+        if (dt == "thinking_delta") {
+            if (!ev.payload.empty()) {
+                StreamEvent event;
+                event.type = StreamEvent::ThinkingDelta;
+                event.text = QString::fromUtf8(ev.payload.data(),
+                                               static_cast<qsizetype>(ev.payload.size()));
+                deliver(std::move(event));
             }
+            return;
         }
+        // signature_delta and unknown delta kinds need no action
         return;
     }
 
     if (evType == "content_block_start") {
-        if (ev.contains("content_block")) {
-            std::string bt = jtype(ev["content_block"]);
-            int idx = jint(ev, "index");
-            if (bt == "tool_use" && idx >= 0) {
-                PendingToolUse pending;
-                pending.name = jstr(ev["content_block"], "name");
-                pending.id = jstr(ev["content_block"], "id");
-                pending.blockIndex = idx;
-                m_pendingTools[idx] = pending;
-                qDebug() << "[stream] block_start tool_use:" << pending.name << "idx=" << idx;
-            } else if (bt == "thinking") {
-                m_activeThinkingBlockIdx = idx;
-                qDebug() << "[stream] block_start thinking idx=" << idx;
-                emit thinkingStarted();
+        endDeltaRun();
+        int idx = ev.index;
+        if (ev.blockType == "tool_use" && idx >= 0) {
+            PendingToolUse pending;
+            pending.name = QString::fromStdString(ev.blockName);
+            pending.id = QString::fromStdString(ev.blockId);
+            pending.blockIndex = idx;
+            if (pending.name == "Write") {
+                pending.isEdit = true;
+                pending.scanner.setWatchedFields({"path", "file_path", "content", "contents"});
+            } else if (pending.name == "Edit" || pending.name == "StrReplace") {
+                pending.isEdit = true;
+                pending.scanner.setWatchedFields({"path", "file_path", "new_string"});
             }
+            m_pendingTools[idx] = pending;
+            qDebug() << "[stream] block_start tool_use:" << pending.name << "idx=" << idx;
+        } else if (ev.blockType == "thinking") {
+            m_activeThinkingBlockIdx = idx;
+            qDebug() << "[stream] block_start thinking idx=" << idx;
+            StreamEvent event;
+            event.type = StreamEvent::ThinkingStarted;
+            deliver(std::move(event));
         }
         return;
     }
 
     if (evType == "content_block_stop") {
-        int idx = jint(ev, "index");
+        endDeltaRun();
+        int idx = ev.index;
         qDebug() << "[stream] block_stop idx=" << idx;
 
         if (idx == m_activeThinkingBlockIdx) {
             m_activeThinkingBlockIdx = -1;
-            emit thinkingStopped();
+            StreamEvent event;
+            event.type = StreamEvent::ThinkingStopped;
+            deliver(std::move(event));
             return;
         }
 
@@ -152,8 +484,12 @@ void StreamParser::handleInnerEvent(const json &ev)
             PendingToolUse &pending = m_pendingTools[idx];
 
             bool wasStreaming = pending.inNewString || pending.pathEmitted;
-            if (wasStreaming)
-                emit editStreamFinished(idx);
+            if (wasStreaming) {
+                StreamEvent event;
+                event.type = StreamEvent::EditStreamFinished;
+                event.blockIndex = idx;
+                deliver(std::move(event));
+            }
 
             if (!pending.id.isEmpty() && !m_emittedToolIds.contains(pending.id)
                 && !pending.accumulatedJson.empty()) {
@@ -169,9 +505,8 @@ void StreamParser::handleInnerEvent(const json &ev)
                 event.type = StreamEvent::ToolUse;
                 event.toolName = pending.name;
                 event.toolId = pending.id;
-                event.toolInput = toolInput;
-                emit toolUseStarted(pending.name, pending.id, toolInput);
-                emit eventParsed(event);
+                event.toolInput = std::move(toolInput);
+                deliver(std::move(event));
             }
 
             m_pendingTools.remove(idx);
@@ -185,7 +520,6 @@ void StreamParser::handleInnerEvent(const json &ev)
 StreamEvent StreamParser::parseEvent(const json &j)
 {
     StreamEvent event;
-    event.raw = j;
 
     std::string type = jtype(j);
 
@@ -215,12 +549,8 @@ StreamEvent StreamParser::parseEvent(const json &j)
         return event;
     }
 
-    // ---- "stream_event" wrapper ----
-    if (type == "stream_event" && j.contains("event")) {
-        handleInnerEvent(j["event"]);
-        event.type = StreamEvent::Unknown; // Already handled
-        return event;
-    }
+    // "stream_event" lines never reach here — feed() dispatches them from
+    // the SAX fast path.
 
     // ---- "user" message with checkpoint UUID (from --replay-user-messages) ----
     // Only the replayed user prompt (isReplay=true) carries the checkpoint UUID.
@@ -228,12 +558,29 @@ StreamEvent StreamParser::parseEvent(const json &j)
     if (type == "user") {
         bool isReplay = j.contains("isReplay") && j["isReplay"].is_boolean()
                         && j["isReplay"].get<bool>();
+        event.type = StreamEvent::Unknown;
         if (isReplay) {
-            QString uuid = jstr(j, "uuid");
-            if (!uuid.isEmpty())
-                emit checkpointReceived(uuid);
+            event.text = jstr(j, "uuid");
+            if (!event.text.isEmpty())
+                event.type = StreamEvent::Checkpoint;
+            return event;
+        }
+        // The CLI reports finished tool calls as user messages carrying
+        // tool_result blocks
+        if (j.contains("message") && j["message"].is_object()
+            && j["message"].contains("content") && j["message"]["content"].is_array()) {
+            for (const auto &block : j["message"]["content"]) {
+                if (jtype(block) != "tool_result")
+                    continue;
+                event.type = StreamEvent::ToolResult;
+                event.toolId = jstr(block, "tool_use_id");
+                if (block.contains("content"))
+                    event.toolResultContent = block["content"].is_string()
+                        ? QString::fromStdString(block["content"].get<std::string>())
+                        : QString::fromStdString(block["content"].dump());
+                break;
+            }
         }
-        event.type = StreamEvent::Unknown;
         return event;
     }
 
@@ -286,100 +633,51 @@ StreamEvent StreamParser::parseEvent(const json &j)
     return event;
 }
 
-static std::string unescapeJsonString(const std::string &s)
-{
-    std::string out;
-    out.reserve(s.size());
-    for (size_t i = 0; i < s.size(); ++i) {
-        if (s[i] == '\\' && i + 1 < s.size()) {
-            char c = s[i + 1];
-            if (c == '"')       { out += '"'; ++i; }
-            else if (c == '\\') { out += '\\'; ++i; }
-            else if (c == 'n')  { out += '\n'; ++i; }
-            else if (c == 't')  { out += '\t'; ++i; }
-            else if (c == 'r')  { out += '\r'; ++i; }
-            else if (c == '/')  { out += '/'; ++i; }
-            else                { out += s[i]; }
-        } else {
-            out += s[i];
-        }
-    }
-    return out;
-}
-
-static size_t findJsonFieldStart(const std::string &json, const std::string &field, size_t from)
-{
-    std::string needle = "\"" + field + "\":\"";
-    size_t pos = json.find(needle, from);
-    if (pos != std::string::npos)
-        return pos + needle.size();
-
-    needle = "\"" + field + "\": \"";
-    pos = json.find(needle, from);
-    if (pos != std::string::npos)
-        return pos + needle.size();
-
-    return std::string::npos;
-}
-
-static std::string extractFieldValue(const std::string &json, size_t fieldStart)
-{
-    std::string value;
-    for (size_t i = fieldStart; i < json.size(); ++i) {
-        if (json[i] == '\\' && i + 1 < json.size()) {
-            value += json[i];
-            value += json[i + 1];
-            ++i;
-        } else if (json[i] == '"') {
-            break;
-        } else {
-            value += json[i];
-        }
-    }
-    return value;
-}
-
-void StreamParser::processPartialToolJson(int idx, const std::string &)
+void StreamParser::processPartialToolJson(int idx, const std::string &partial)
 {
     PendingToolUse &p = m_pendingTools[idx];
-    bool isEdit = (p.name == "Edit" || p.name == "StrReplace" || p.name == "Write");
-    if (!isEdit)
+    if (!p.isEdit)
         return;
 
-    const std::string &json = p.accumulatedJson;
-
-    if (!p.pathEmitted) {
-        size_t pathStart = findJsonFieldStart(json, "path", 0);
-        if (pathStart == std::string::npos)
-            pathStart = findJsonFieldStart(json, "file_path", 0);
-        if (pathStart != std::string::npos) {
-            std::string rawVal = extractFieldValue(json, pathStart);
-            if (json.find('"', pathStart + rawVal.size()) != std::string::npos) {
-                p.extractedPath = unescapeJsonString(rawVal);
-                p.pathEmitted = true;
-                emit editStreamStarted(p.name, QString::fromStdString(p.extractedPath));
+    // Only the new bytes are scanned; the scanner carries string/escape state
+    // across deltas, so a large Write costs O(total) rather than O(total^2).
+    p.scanner.feed(partial, [this, &p, idx](const std::string &field,
+                                            std::string_view decoded, bool finished) {
+        if (field == "path" || field == "file_path") {
+            if (p.pathEmitted)
+                return;
+            p.extractedPath.append(decoded);
+            if (!finished)
+                return;
+            p.pathEmitted = true;
+            StreamEvent started;
+            started.type = StreamEvent::EditStreamStarted;
+            started.toolName = p.name;
+            started.text = QString::fromStdString(p.extractedPath);
+            deliver(std::move(started));
+            if (!p.earlyContent.empty()) {
+                p.inNewString = true;
+                StreamEvent delta;
+                delta.type = StreamEvent::EditContentDelta;
+                delta.blockIndex = idx;
+                delta.text = QString::fromStdString(p.earlyContent);
+                deliver(std::move(delta));
+                p.earlyContent.clear();
             }
+            return;
         }
-    }
 
-    if (p.pathEmitted && !p.inNewString) {
-        std::string fieldName = (p.name == "Write") ? "content" : "new_string";
-        size_t start = findJsonFieldStart(json, fieldName, 0);
-        if (start == std::string::npos && p.name == "Write")
-            start = findJsonFieldStart(json, "contents", 0);
-        if (start != std::string::npos) {
-            p.inNewString = true;
-            p.lastScanPos = start;
+        if (!p.pathEmitted) {
+            p.earlyContent.append(decoded);
+            return;
         }
-    }
-
-    if (p.inNewString) {
-        std::string rawVal = extractFieldValue(json, p.lastScanPos);
-        std::string decoded = unescapeJsonString(rawVal);
-        if (decoded.size() > p.newStringBuffer.size()) {
-            std::string delta = decoded.substr(p.newStringBuffer.size());
-            p.newStringBuffer = decoded;
-            emit editContentDelta(idx, QString::fromStdString(delta));
+        p.inNewString = true;
+        if (!decoded.empty()) {
+            StreamEvent delta;
+            delta.type = StreamEvent::EditContentDelta;
+            delta.blockIndex = idx;
+            delta.text = QString::fromUtf8(decoded.data(), static_cast<qsizetype>(decoded.size()));
+            deliver(std::move(delta));
         }
-    }
+    });
 }
@@ -4,7 +4,12 @@
 #include <QString>
 #include <QMap>
 #include <QSet>
+#include <QByteArray>
+#include <QVector>
+#include <QMetaType>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include "core/JsonFieldScanner.h"
 
 using json = nlohmann::json;
 
@@ -15,7 +20,17 @@ struct StreamEvent {
         ToolResult,
         Result,
         Error,
-        Unknown
+        Unknown,
+        // The remaining kinds mirror the other StreamParser signals so that a
+        // batch can be replayed in order with StreamParser::dispatch().
+        ThinkingStarted,
+        ThinkingDelta,
+        ThinkingStopped,
+        EditStreamStarted,   // toolName, text = file path
+        EditContentDelta,    // blockIndex, text
+        EditStreamFinished,  // blockIndex
+        Checkpoint,          // text = uuid
+        TurnCompleted        // isError
     };
 
     Type type = Unknown;
@@ -25,9 +40,22 @@ struct StreamEvent {
     json toolInput;
     QString toolResultContent;
     QString sessionId;
-    json raw;
+    int blockIndex = -1;
+    bool isError = false;
+    int mergedDeltas = 1; // source deltas folded into a coalesced Text/ThinkingDelta
+
+    // Source line. The DOM is only built the first time raw() is called, so
+    // consumers that never look pay nothing.
+    QByteArray rawLine;
+    const json &raw() const;
+
+private:
+    friend class StreamParser;
+    mutable std::shared_ptr<const json> m_rawDom;
 };
 
+Q_DECLARE_METATYPE(StreamEvent)
+
 struct PendingToolUse {
     QString name;
     QString id;
@@ -35,26 +63,60 @@ struct PendingToolUse {
     std::string accumulatedJson;
 
     // Streaming field extraction state (Feature 2)
+    bool isEdit = false;
     bool pathEmitted = false;
     bool inNewString = false;
     std::string extractedPath;
-    std::string newStringBuffer;
-    size_t lastScanPos = 0;
+    std::string earlyContent;  // new content decoded before the path completed
+    JsonFieldScanner scanner;  // resumes where the previous delta stopped
 };
 
+struct StreamLineSniffer;
+
 class StreamParser : public QObject {
     Q_OBJECT
 public:
     explicit StreamParser(QObject *parent = nullptr);
+    ~StreamParser();
 
     void feed(const QByteArray &line);
     void reset();
 
+    // In batched mode nothing is emitted from feed(); events collect until
+    // takeBatch(), and the receiving side re-emits them with dispatch().
+    // Used to parse on an I/O thread and hand whole frames to the GUI.
+    void setBatched(bool batched) { m_batched = batched; }
+    // Events batched so far, oldest first (an open delta run isn't included)
+    const QVector<StreamEvent> &pendingBatch() const { return m_batch; }
+    bool hasBatch() const { return !m_batch.isEmpty() || m_openDelta.type != StreamEvent::Unknown; }
+    QVector<StreamEvent> takeBatch();
+    void dispatch(const QVector<StreamEvent> &events);
+
+    // Coalescing folds consecutive text or thinking deltas into one event.
+    // A run ends at any other event, at a content block boundary, once it
+    // reaches kCoalesceFlushChars, at takeBatch(), or (unbatched) when
+    // control returns to the event loop. flush() ends it explicitly.
+    static constexpr int kCoalesceFlushChars = 4096;
+    void setCoalescing(bool coalescing);
+    bool isCoalescing() const { return m_coalescing; }
+    void flush();
+
+    // Deltas that reached this parser (fed, or replayed as part of a merged
+    // event) versus delta signals it emitted or queued
+    struct EmissionStats {
+        quint64 deltasIn = 0;
+        quint64 deltasOut = 0;
+        double reductionRatio() const { return deltasOut ? double(deltasIn) / double(deltasOut) : 1.0; }
+    };
+    EmissionStats emissionStats() const { return m_stats; }
+    void resetEmissionStats() { m_stats = {}; }
+
 signals:
     void textDelta(const QString &text);
     void toolUseStarted(const QString &toolName, const QString &toolId, const json &input);
     void toolResultReceived(const QString &content);
     void resultReady(const QString &sessionId, const json &result);
+    void turnCompleted(bool isError); // final "result" event of a turn
     void errorOccurred(const QString &message);
     void eventParsed(const StreamEvent &event);
     void checkpointReceived(const QString &uuid);
@@ -67,13 +129,29 @@ signals:
     void editContentDelta(int blockIndex, const QString &partialNewString);
     void editStreamFinished(int blockIndex);
 
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
 private:
     StreamEvent parseEvent(const json &j);
-    void handleInnerEvent(const json &ev);
+    void deliver(StreamEvent &&event);
+    void endDeltaRun();
+    void push(StreamEvent &&event);
+    void emitEvent(const StreamEvent &event);
+    void handleInnerEvent(const StreamLineSniffer &ev);
     void processPartialToolJson(int idx, const std::string &partial);
 
     QString m_accumulatedText;
     QMap<int, PendingToolUse> m_pendingTools; // block index -> pending tool
     QSet<QString> m_emittedToolIds;
     int m_activeThinkingBlockIdx = -1;
+    std::unique_ptr<StreamLineSniffer> m_sniffer;
+    bool m_batched = false;
+    QVector<StreamEvent> m_batch;
+    bool m_coalescing = false;
+    bool m_flushQueued = false;
+    StreamEvent m_openDelta;    // coalescing run in progress (Unknown = none)
+    EmissionStats m_stats;
+    bool m_eventParsedConnected = false; // skip the StreamEvent copy otherwise
 };
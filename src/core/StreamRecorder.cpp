@@ -0,0 +1,78 @@
+#include "core/StreamRecorder.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+
+static const char kCaptureHeader[] = "# cccpp stream capture v1\n";
+
+StreamRecorder::~StreamRecorder()
+{
+    close();
+}
+
+bool StreamRecorder::open(const QString &path)
+{
+    close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "[cccpp] Cannot open stream capture" << path << m_file.errorString();
+        return false;
+    }
+    m_file.write(kCaptureHeader);
+    m_clock.start();
+    qDebug() << "[cccpp] Recording stream to" << path;
+    return true;
+}
+
+void StreamRecorder::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+void StreamRecorder::record(const QByteArray &line)
+{
+    if (!m_file.isOpen())
+        return;
+    m_file.write(QByteArray::number(m_clock.nsecsElapsed() / 1000));
+    m_file.write("\t", 1);
+    m_file.write(line);
+    m_file.write("\n", 1);
+}
+
+QVector<StreamRecorder::Record> StreamRecorder::load(const QString &path, QString *error)
+{
+    QVector<Record> records;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = file.errorString();
+        return records;
+    }
+
+    const QByteArray data = file.readAll();
+    qsizetype pos = 0;
+    int lineNo = 0;
+    while (pos < data.size()) {
+        qsizetype end = data.indexOf('\n', pos);
+        if (end < 0)
+            end = data.size();
+        ++lineNo;
+        const QByteArray line = data.mid(pos, end - pos);
+        pos = end + 1;
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        qsizetype tab = line.indexOf('\t');
+        bool ok = false;
+        qint64 offset = tab > 0 ? line.left(tab).toLongLong(&ok) : 0;
+        if (!ok) {
+            if (error)
+                *error = QStringLiteral("%1:%2: malformed record").arg(path).arg(lineNo);
+            return {};
+        }
+        records.append({offset, line.mid(tab + 1)});
+    }
+    return records;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Tees raw claude stdout lines into a capture file so a session can be
+// replayed through StreamParser without a live CLI (see bench_stream).
+//
+// Capture format, one record per stdout line:
+//   <microseconds since recording started>\t<raw stream-json line>\n
+// Lines starting with '#' are comments. stream-json lines never contain a
+// raw newline, so no escaping is needed.
+class StreamRecorder {
+public:
+    struct Record {
+        qint64 offsetUs = 0;
+        QByteArray line;
+    };
+
+    ~StreamRecorder();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString path() const { return m_file.fileName(); }
+
+    void record(const QByteArray &line);
+
+    static QVector<Record> load(const QString &path, QString *error = nullptr);
+
+private:
+    QFile m_file;
+    QElapsedTimer m_clock;
+};
@@ -250,17 +250,18 @@ void TelegramDaemon::onInstanceData(QLocalSocket *socket)
         return;
     }
 
-    QByteArray newData = socket->readAll();
-    qDebug() << "[TelegramDaemon] onInstanceData: received" << newData.size() << "bytes from" << inst->name;
-    inst->readBuffer.append(newData);
+    qint64 received = inst->readFramer.readFrom(socket);
+    qDebug() << "[TelegramDaemon] onInstanceData: received" << received << "bytes from" << inst->name;
 
     // Process newline-delimited JSON messages
+    QByteArray line;
     while (true) {
-        int idx = inst->readBuffer.indexOf('\n');
-        if (idx < 0) break;
-
-        QByteArray line = inst->readBuffer.left(idx);
-        inst->readBuffer.remove(0, idx + 1);
+        LineFramer::Result r = inst->readFramer.next(line);
+        if (r == LineFramer::NoLine) break;
+        if (r == LineFramer::Overflow) {
+            qWarning() << "[TelegramDaemon] Dropped oversized IPC message from" << inst->name;
+            continue;
+        }
 
         if (line.isEmpty()) continue;
 
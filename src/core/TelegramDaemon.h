@@ -6,6 +6,7 @@
 #include <QTimer>
 #include <QMap>
 #include <QList>
+#include "core/LineFramer.h"
 
 class TelegramApi;
 struct TelegramMessage;
@@ -15,7 +16,7 @@ struct ConnectedInstance {
     QLocalSocket *socket = nullptr;
     QString workspace;
     QString name;
-    QByteArray readBuffer;
+    LineFramer readFramer{16 * 1024 * 1024};
 };
 
 struct DaemonUserState {
@@ -0,0 +1,144 @@
+#include "core/TurnMetrics.h"
+#include "core/StreamParser.h"
+#include <QElapsedTimer>
+#include <QtMath>
+#include <QStringList>
+
+int TurnMetrics::gapPercentileMs(double p) const
+{
+    int total = 0;
+    for (int n : gapHistogram)
+        total += n;
+    if (total == 0)
+        return -1;
+    const int rank = qMax(1, qCeil(p * total));
+    int seen = 0;
+    for (int i = 0; i < kGapBuckets - 1; ++i) {
+        seen += gapHistogram[i];
+        if (seen >= rank)
+            return kGapBucketLimitsMs[i];
+    }
+    return static_cast<int>(maxGapMs);
+}
+
+QString TurnMetrics::histogramToString() const
+{
+    QStringList parts;
+    for (int n : gapHistogram)
+        parts << QString::number(n);
+    return parts.join(',');
+}
+
+void TurnMetrics::histogramFromString(const QString &text)
+{
+    const QStringList parts = text.split(',', Qt::SkipEmptyParts);
+    for (int i = 0; i < kGapBuckets; ++i)
+        gapHistogram[i] = i < parts.size() ? parts[i].toInt() : 0;
+}
+
+static QString seconds(qint64 ms)
+{
+    return QString::number(ms / 1000.0, 'f', ms < 10000 ? 1 : 0) + "s";
+}
+
+QString TurnMetrics::summary() const
+{
+    if (!isValid())
+        return {};
+    QStringList parts;
+    if (spawnMs > 0)
+        parts << "spawn " + seconds(spawnMs);
+    if (ttftMs >= 0)
+        parts << "TTFT " + seconds(ttftMs);
+    const int p50 = gapPercentileMs(0.5);
+    if (p50 >= 0)
+        parts << QStringLiteral("p50 gap %1ms").arg(p50);
+    if (toolCount > 0)
+        parts << "tools " + seconds(toolMs);
+    parts << seconds(totalMs);
+    return parts.join(QString::fromUtf8(" \xc2\xb7 "));
+}
+
+qint64 TurnTimer::clockMs()
+{
+    // QElapsedTimer's reference is the same monotonic clock on every thread
+    QElapsedTimer t;
+    t.start();
+    return t.msecsSinceReference();
+}
+
+void TurnTimer::begin(qint64 sentAtMs, qint64 processStartedAtMs)
+{
+    m_metrics = TurnMetrics();
+    m_sentAtMs = sentAtMs;
+    m_lastDeltaMs = -1;
+    m_toolStartMs = -1;
+    m_toolEndMs = -1;
+    m_active = true;
+    if (processStartedAtMs > 0)
+        processStarted(processStartedAtMs);
+}
+
+void TurnTimer::processStarted(qint64 nowMs)
+{
+    if (m_active && m_metrics.spawnMs < 0)
+        m_metrics.spawnMs = qMax<qint64>(0, nowMs - m_sentAtMs);
+}
+
+void TurnTimer::stdoutReceived(qint64 nowMs)
+{
+    if (m_active && m_metrics.firstByteMs < 0)
+        m_metrics.firstByteMs = nowMs - m_sentAtMs;
+}
+
+void TurnTimer::deltaReceived(qint64 nowMs)
+{
+    if (!m_active)
+        return;
+    closeToolPhase();
+    ++m_metrics.deltaCount;
+    if (m_metrics.ttftMs < 0)
+        m_metrics.ttftMs = nowMs - m_sentAtMs;
+    if (m_lastDeltaMs >= 0) {
+        const qint64 gap = nowMs - m_lastDeltaMs;
+        int bucket = 0;
+        while (bucket < TurnMetrics::kGapBuckets - 1
+               && gap >= TurnMetrics::kGapBucketLimitsMs[bucket])
+            ++bucket;
+        ++m_metrics.gapHistogram[bucket];
+        m_metrics.maxGapMs = qMax(m_metrics.maxGapMs, gap);
+    }
+    m_lastDeltaMs = nowMs;
+}
+
+void TurnTimer::eventReceived(const StreamEvent &event, qint64 nowMs)
+{
+    if (!m_active)
+        return;
+    if (event.type == StreamEvent::ToolUse) {
+        ++m_metrics.toolCount;
+        if (m_toolStartMs < 0)
+            m_toolStartMs = nowMs;
+    } else if (event.type == StreamEvent::ToolResult && m_toolStartMs >= 0) {
+        // Parallel calls report one by one; the phase ends at the last
+        // result before the model speaks again
+        m_toolEndMs = nowMs;
+    }
+}
+
+void TurnTimer::closeToolPhase()
+{
+    if (m_toolStartMs >= 0 && m_toolEndMs >= 0)
+        m_metrics.toolMs += m_toolEndMs - m_toolStartMs;
+    if (m_toolEndMs >= 0)
+        m_toolStartMs = -1;
+    m_toolEndMs = -1;
+}
+
+TurnMetrics TurnTimer::finish(qint64 nowMs)
+{
+    closeToolPhase();
+    m_metrics.totalMs = nowMs - m_sentAtMs;
+    m_active = false;
+    return m_metrics;
+}
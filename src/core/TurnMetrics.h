@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QMetaType>
+#include <QString>
+
+struct StreamEvent;
+
+// Where one turn's wall time went. All durations are milliseconds from the
+// moment the message was handed to claude; -1 means it never happened.
+struct TurnMetrics {
+    // Inter-delta gap histogram: bucket i counts gaps below
+    // kGapBucketLimitsMs[i]; the last bucket is open-ended
+    static constexpr int kGapBuckets = 8;
+    static constexpr int kGapBucketLimitsMs[kGapBuckets - 1] = {10, 25, 50, 100, 250, 500, 1000};
+
+    qint64 spawnMs = -1;      // until the process was running (0 if it already was)
+    qint64 firstByteMs = -1;  // until the first stdout byte
+    qint64 ttftMs = -1;       // until the first text or thinking delta
+    qint64 toolMs = 0;        // from tool_use blocks until their results came back
+    qint64 totalMs = -1;      // until the result event, or process exit without one
+    int toolCount = 0;
+    int deltaCount = 0;
+    qint64 maxGapMs = 0;
+    int gapHistogram[kGapBuckets] = {};
+
+    bool isValid() const { return totalMs >= 0; }
+    // Upper bound of the bucket holding the p-th gap (0 < p <= 1), or -1
+    int gapPercentileMs(double p) const;
+
+    // Comma-separated bucket counts, as stored in the history database
+    QString histogramToString() const;
+    void histogramFromString(const QString &text);
+
+    // "spawn 0.1s · TTFT 1.2s · p50 gap 25ms · tools 3.4s · 8.0s"
+    QString summary() const;
+};
+
+Q_DECLARE_METATYPE(TurnMetrics)
+
+// Collects TurnMetrics for the turn in flight. Lives next to the parser on
+// the I/O thread, so timestamps are taken when a line is read rather than
+// when its (coalesced, frame-batched) events reach the GUI.
+class TurnTimer {
+public:
+    // Monotonic milliseconds, comparable across threads
+    static qint64 clockMs();
+
+    // processStartedAtMs <= 0 means the process is not running yet
+    void begin(qint64 sentAtMs, qint64 processStartedAtMs);
+    bool isActive() const { return m_active; }
+
+    void processStarted(qint64 nowMs);
+    void stdoutReceived(qint64 nowMs);
+    void deltaReceived(qint64 nowMs);
+    void eventReceived(const StreamEvent &event, qint64 nowMs); // tool use/result
+    TurnMetrics finish(qint64 nowMs);
+
+private:
+    void closeToolPhase();
+
+    TurnMetrics m_metrics;
+    qint64 m_sentAtMs = 0;
+    qint64 m_lastDeltaMs = -1;
+    qint64 m_toolStartMs = -1;  // first tool_use of the current tool phase
+    qint64 m_toolEndMs = -1;    // latest tool_result of that phase
+    bool m_active = false;
+};
@@ -0,0 +1,208 @@
+// Load scenario runner: drives many concurrent ClaudeProcess agents against
+// mock_claude and reports how much the main (UI) thread stalls and how much
+// memory each agent costs as concurrency grows.
+//
+// Usage: load_scenario [--agents 1,5,10,20,50] [--turns 3]
+//                      [--tokens-per-sec 60] [--mock /path/to/mock_claude]
+//
+// Stalls are measured with a 5 ms heartbeat timer on the main thread: any
+// gap beyond one 16 ms frame counts as stall time. Memory is sampled after
+// the last turn while the (persistent) agent processes are still alive.
+
+#include "core/ClaudeProcess.h"
+#include "core/StreamParser.h"
+#include "util/Config.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTimer>
+#include <QDebug>
+#include <memory>
+#include <vector>
+
+static constexpr qint64 kFrameNs = 16 * 1000 * 1000;
+
+static qint64 rssKb(qint64 pid)
+{
+    if (pid <= 0)
+        return 0;
+    QFile status(QStringLiteral("/proc/%1/status").arg(pid));
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            if (line.startsWith("VmRSS:"))
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+        }
+        return 0;
+    }
+    // No procfs (macOS)
+    QProcess ps;
+    ps.start(QStringLiteral("ps"), {QStringLiteral("-o"), QStringLiteral("rss="),
+                                    QStringLiteral("-p"), QString::number(pid)});
+    ps.waitForFinished(2000);
+    return ps.readAllStandardOutput().trimmed().toLongLong();
+}
+
+struct Agent {
+    std::unique_ptr<ClaudeProcess> process;
+    QString transcript;
+    int turnsDone = 0;
+    int deltas = 0;
+};
+
+struct LevelResult {
+    int agents = 0;
+    int turns = 0;
+    qint64 deltas = 0;
+    double wallSec = 0;
+    double stallMs = 0;
+    double maxGapMs = 0;
+    int longStalls = 0;
+    qint64 uiRssDeltaKb = 0;
+    qint64 childRssKb = 0;
+    bool timedOut = false;
+};
+
+static LevelResult runLevel(int agentCount, int turnsPerAgent)
+{
+    LevelResult res;
+    res.agents = agentCount;
+    const qint64 selfPid = QCoreApplication::applicationPid();
+    const qint64 rssBefore = rssKb(selfPid);
+
+    QEventLoop loop;
+    int agentsDone = 0;
+    std::vector<std::unique_ptr<Agent>> agents;
+    agents.reserve(static_cast<size_t>(agentCount));
+
+    QElapsedTimer wall;
+    wall.start();
+
+    for (int i = 0; i < agentCount; ++i) {
+        auto agent = std::make_unique<Agent>();
+        Agent *a = agent.get();
+        a->process = std::make_unique<ClaudeProcess>();
+        ClaudeProcess *proc = a->process.get();
+        proc->setPersistent(true);
+        proc->setWorkingDirectory(QDir::tempPath());
+        proc->setAgentName(QStringLiteral("load-%1").arg(i));
+
+        QObject::connect(proc->streamParser(), &StreamParser::textDelta, proc, [a](const QString &t) {
+            a->transcript += t;
+            ++a->deltas;
+        });
+        QObject::connect(proc, &ClaudeProcess::finished, proc, [a, proc, turnsPerAgent, &agentsDone, &loop, agentCount](int) {
+            if (++a->turnsDone < turnsPerAgent) {
+                QTimer::singleShot(0, proc, [proc, a] {
+                    proc->sendMessage(QStringLiteral("follow-up %1").arg(a->turnsDone));
+                });
+                return;
+            }
+            if (++agentsDone == agentCount)
+                loop.quit();
+        });
+        proc->sendMessage(QStringLiteral("Summarize module %1").arg(i));
+        agents.push_back(std::move(agent));
+    }
+
+    // Heartbeat on the main thread
+    QElapsedTimer beat;
+    beat.start();
+    qint64 lastNs = 0;
+    QTimer heartbeat;
+    heartbeat.setTimerType(Qt::PreciseTimer);
+    heartbeat.setInterval(5);
+    QObject::connect(&heartbeat, &QTimer::timeout, [&] {
+        qint64 now = beat.nsecsElapsed();
+        qint64 gap = now - lastNs;
+        lastNs = now;
+        res.maxGapMs = qMax(res.maxGapMs, gap / 1e6);
+        if (gap > kFrameNs) {
+            res.stallMs += (gap - kFrameNs) / 1e6;
+            if (gap > 50 * 1000 * 1000)
+                ++res.longStalls;
+        }
+    });
+    heartbeat.start();
+
+    QTimer::singleShot(10 * 60 * 1000, &loop, [&loop, &res] {
+        res.timedOut = true;
+        loop.quit();
+    });
+    if (agentsDone < agentCount)
+        loop.exec();
+    heartbeat.stop();
+    res.wallSec = wall.nsecsElapsed() / 1e9;
+
+    res.uiRssDeltaKb = rssKb(selfPid) - rssBefore;
+    for (const auto &a : agents) {
+        res.turns += a->turnsDone;
+        res.deltas += a->deltas;
+        res.childRssKb += rssKb(a->process->processId());
+    }
+    agents.clear(); // ~ClaudeProcess terminates the children
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> levels = {1, 5, 10, 20, 50};
+    int turns = 3;
+    QString tokensPerSec = QStringLiteral("60");
+    QString mock = QCoreApplication::applicationDirPath() + "/mock_claude";
+
+    const QStringList args = app.arguments();
+    for (int i = 1; i + 1 < args.size(); i += 2) {
+        const QString &flag = args[i];
+        const QString &value = args[i + 1];
+        if (flag == "--agents") {
+            levels.clear();
+            for (const QString &n : value.split(',', Qt::SkipEmptyParts))
+                levels << n.toInt();
+        } else if (flag == "--turns") {
+            turns = qMax(1, value.toInt());
+        } else if (flag == "--tokens-per-sec") {
+            tokensPerSec = value;
+        } else if (flag == "--mock") {
+            mock = value;
+        } else {
+            qWarning() << "Unknown option" << flag;
+            return 2;
+        }
+    }
+    if (!QFileInfo(mock).isExecutable()) {
+        qWarning().noquote() << "mock_claude not found at" << mock << "(use --mock)";
+        return 2;
+    }
+
+    // Keep the user's config file untouched; the launcher picks up the
+    // binary and the mock's environment on first use.
+    Config::instance().setSuppressAutoSave(true);
+    Config::instance().setClaudeBinary(mock);
+    Config::instance().setProcessPoolSize(0);
+    Config::instance().setStreamCaptureDir(QString());
+    qputenv("MOCK_CLAUDE_TOKENS_PER_SEC", tokensPerSec.toUtf8());
+
+    qDebug().noquote() << QStringLiteral("[load] mock=%1 turns/agent=%2 tokens/s=%3")
+                              .arg(mock).arg(turns).arg(tokensPerSec);
+    for (int n : levels) {
+        if (n <= 0)
+            continue;
+        LevelResult r = runLevel(n, turns);
+        qDebug().noquote() << QStringLiteral(
+            "[load] agents=%1 turns=%2/%3 deltas=%4 wall=%5s | stall %6 ms total, max gap %7 ms, %8 gaps >50ms"
+            " | UI rss +%9 KB/agent, agent rss %10 KB%11")
+            .arg(r.agents).arg(r.turns).arg(r.agents * turns).arg(r.deltas)
+            .arg(r.wallSec, 0, 'f', 1)
+            .arg(r.stallMs, 0, 'f', 1).arg(r.maxGapMs, 0, 'f', 1).arg(r.longStalls)
+            .arg(r.uiRssDeltaKb / qMax(1, r.agents))
+            .arg(r.childRssKb / qMax(1, r.agents))
+            .arg(r.timedOut ? QStringLiteral(" [TIMEOUT]") : QString());
+    }
+    return 0;
+}
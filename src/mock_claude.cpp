@@ -0,0 +1,419 @@
+// Offline stand-in for the claude CLI, for load tests and CI boxes without
+// network access. Point Config::claudeBinary ("claude_binary") at it.
+//
+// Honors the flags ClaudeProcess passes: -p, --input-format/--output-format
+// stream-json, --verbose, --include-partial-messages, --replay-user-messages,
+// --session-id, --resume, --model, and exits immediately for --rewind-files.
+// Every user envelope read from stdin produces one turn; the process keeps
+// serving turns until stdin is closed, so it works for one-shot and
+// persistent ClaudeProcess alike.
+//
+// Behaviour is set through environment variables:
+//   MOCK_CLAUDE_TOKENS_PER_SEC  output rate, 0 = as fast as possible (60)
+//   MOCK_CLAUDE_REPLY_TOKENS    text tokens per answer (300)
+//   MOCK_CLAUDE_TOOLS           tool_use blocks per turn (1)
+//   MOCK_CLAUDE_THINKING        emit a thinking block first, 0/1 (1)
+//   MOCK_CLAUDE_SCRIPT          capture file (StreamRecorder format) to replay
+//                               instead of synthetic output
+//   MOCK_CLAUDE_SPEED           speed-up applied to the recorded gaps (1.0)
+//   MOCK_CLAUDE_SEED            RNG seed (random)
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Options {
+    bool streamJsonOut = false;
+    bool partialMessages = false;
+    bool replayUserMessages = false;
+    bool rewind = false;
+    std::string sessionId;
+    std::string model = "claude-sonnet-4-6";
+    std::string cwd;
+
+    double tokensPerSec = 60.0;
+    int replyTokens = 300;
+    int toolsPerTurn = 1;
+    bool thinking = true;
+    std::string script;
+    double speed = 1.0;
+};
+
+std::mt19937_64 g_rng;
+
+std::string envString(const char *name, const std::string &fallback = {})
+{
+    const char *v = std::getenv(name);
+    return v && *v ? std::string(v) : fallback;
+}
+
+double envNumber(const char *name, double fallback)
+{
+    const char *v = std::getenv(name);
+    if (!v || !*v)
+        return fallback;
+    char *end = nullptr;
+    double d = std::strtod(v, &end);
+    return end != v ? d : fallback;
+}
+
+std::string makeUuid()
+{
+    static const char *hex = "0123456789abcdef";
+    std::string s = "xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx";
+    for (char &c : s) {
+        if (c == 'x')
+            c = hex[g_rng() & 0xf];
+        else if (c == 'y')
+            c = hex[8 + (g_rng() & 0x3)];
+    }
+    return s;
+}
+
+std::string makeId(const char *prefix)
+{
+    std::string id = prefix;
+    static const char *alnum = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    for (int i = 0; i < 22; ++i)
+        id += alnum[g_rng() % 62];
+    return id;
+}
+
+class Emitter {
+public:
+    explicit Emitter(const Options &opt) : m_opt(opt) {}
+
+    void line(const json &j)
+    {
+        std::string s = j.dump();
+        s += '\n';
+        std::fwrite(s.data(), 1, s.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    // Sleeps long enough to hold the configured token rate
+    void pace(int tokens = 1)
+    {
+        if (m_opt.tokensPerSec <= 0)
+            return;
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            static_cast<long long>(tokens * 1e6 / m_opt.tokensPerSec)));
+    }
+
+    void streamEvent(const json &event)
+    {
+        if (!m_opt.partialMessages)
+            return;
+        line({{"type", "stream_event"}, {"event", event}, {"session_id", m_opt.sessionId},
+              {"parent_tool_use_id", nullptr}, {"uuid", makeUuid()}});
+    }
+
+    void snapshot(const std::string &messageId, const json &content)
+    {
+        line({{"type", "assistant"},
+              {"message", {{"model", m_opt.model}, {"id", messageId}, {"type", "message"},
+                           {"role", "assistant"}, {"content", content},
+                           {"stop_reason", nullptr}, {"stop_sequence", nullptr}}},
+              {"parent_tool_use_id", nullptr}, {"session_id", m_opt.sessionId},
+              {"uuid", makeUuid()}});
+    }
+
+private:
+    const Options &m_opt;
+};
+
+const std::vector<std::string> &vocabulary()
+{
+    static const std::vector<std::string> words = {
+        "the", "parser", "returns", "a", "view", "into", "buffer", "so", "callers",
+        "must", "copy", "before", "next", "append", "**important**", "`feed()`",
+        "each", "line", "is", "framed", "once", "and", "dispatched", "without",
+        "building", "DOM", "which", "keeps", "allocations", "flat", "under", "load",
+    };
+    return words;
+}
+
+std::string nextToken(int i)
+{
+    const auto &words = vocabulary();
+    std::string t = words[g_rng() % words.size()];
+    if (i % 40 == 39)
+        return t + ".\n\n";
+    if (i % 12 == 11)
+        return t + ", ";
+    return t + " ";
+}
+
+std::string userText(const json &envelope)
+{
+    const json &content = envelope["message"]["content"];
+    if (content.is_string())
+        return content.get<std::string>();
+    std::string out;
+    if (content.is_array()) {
+        for (const auto &block : content)
+            if (block.value("type", "") == "text" && block.contains("text") && block["text"].is_string())
+                out += block["text"].get<std::string>();
+    }
+    return out;
+}
+
+void streamTextBlock(Emitter &out, const std::string &messageId,
+                     int index, const char *blockType, const char *deltaType, int tokens)
+{
+    const std::string field = blockType;
+    out.streamEvent({{"type", "content_block_start"}, {"index", index},
+                     {"content_block", {{"type", blockType}, {field, ""}}}});
+    std::string full;
+    for (int i = 0; i < tokens; ++i) {
+        std::string tok = nextToken(i);
+        full += tok;
+        out.pace();
+        out.streamEvent({{"type", "content_block_delta"}, {"index", index},
+                         {"delta", {{"type", deltaType}, {field, tok}}}});
+    }
+    if (field == "thinking") {
+        std::string signature = makeId("sig_") + makeId("") + makeId("");
+        out.streamEvent({{"type", "content_block_delta"}, {"index", index},
+                         {"delta", {{"type", "signature_delta"}, {"signature", signature}}}});
+        out.snapshot(messageId, json::array({{{"type", "thinking"}, {"thinking", full},
+                                              {"signature", signature}}}));
+    } else {
+        out.snapshot(messageId, json::array({{{"type", "text"}, {"text", full}}}));
+    }
+    out.streamEvent({{"type", "content_block_stop"}, {"index", index}});
+}
+
+json syntheticToolInput(int n, const Options &opt)
+{
+    const std::string root = opt.cwd.empty() ? std::string("/tmp/mock") : opt.cwd;
+    switch (n % 3) {
+    case 0:  return {{"file_path", root + "/src/module" + std::to_string(n) + ".cpp"}};
+    case 1:  return {{"pattern", "TODO|FIXME"}, {"path", root}, {"output_mode", "content"}};
+    default: return {{"pattern", "src/**/*.h"}};
+    }
+}
+
+const char *syntheticToolName(int n)
+{
+    static const char *names[] = {"Read", "Grep", "Glob"};
+    return names[n % 3];
+}
+
+void messageStart(Emitter &out, const Options &opt, const std::string &messageId)
+{
+    out.streamEvent({{"type", "message_start"},
+                     {"message", {{"model", opt.model}, {"id", messageId}, {"type", "message"},
+                                  {"role", "assistant"}, {"content", json::array()},
+                                  {"stop_reason", nullptr}, {"stop_sequence", nullptr},
+                                  {"usage", {{"input_tokens", 3}, {"output_tokens", 1}}}}}});
+}
+
+void messageEnd(Emitter &out, const char *stopReason, int outputTokens)
+{
+    out.streamEvent({{"type", "message_delta"},
+                     {"delta", {{"stop_reason", stopReason}, {"stop_sequence", nullptr}}},
+                     {"usage", {{"output_tokens", outputTokens}}}});
+    out.streamEvent({{"type", "message_stop"}});
+}
+
+// One synthetic turn: [thinking] -> tool_use blocks -> tool results -> answer
+int syntheticTurn(Emitter &out, const Options &opt)
+{
+    int apiTurns = 0;
+    if (opt.toolsPerTurn > 0) {
+        ++apiTurns;
+        std::string messageId = makeId("msg_01");
+        messageStart(out, opt, messageId);
+        int index = 0;
+        if (opt.thinking)
+            streamTextBlock(out, messageId, index++, "thinking", "thinking_delta", opt.replyTokens / 4 + 1);
+
+        std::vector<std::string> toolIds;
+        for (int t = 0; t < opt.toolsPerTurn; ++t, ++index) {
+            std::string toolId = makeId("toolu_01");
+            toolIds.push_back(toolId);
+            json input = syntheticToolInput(t, opt);
+            out.streamEvent({{"type", "content_block_start"}, {"index", index},
+                             {"content_block", {{"type", "tool_use"}, {"id", toolId},
+                                                {"name", syntheticToolName(t)},
+                                                {"input", json::object()}}}});
+            std::string raw = input.dump();
+            for (size_t pos = 0; pos < raw.size(); pos += 24) {
+                out.pace();
+                out.streamEvent({{"type", "content_block_delta"}, {"index", index},
+                                 {"delta", {{"type", "input_json_delta"},
+                                            {"partial_json", raw.substr(pos, 24)}}}});
+            }
+            out.snapshot(messageId, json::array({{{"type", "tool_use"}, {"id", toolId},
+                                                  {"name", syntheticToolName(t)}, {"input", input}}}));
+            out.streamEvent({{"type", "content_block_stop"}, {"index", index}});
+        }
+        messageEnd(out, "tool_use", 40 * opt.toolsPerTurn);
+
+        for (const auto &toolId : toolIds) {
+            out.pace(5);
+            out.line({{"type", "user"},
+                      {"message", {{"role", "user"},
+                                   {"content", json::array({{{"tool_use_id", toolId},
+                                                             {"type", "tool_result"},
+                                                             {"content", "mock tool output\nline 2\nline 3"}}})}}},
+                      {"parent_tool_use_id", nullptr}, {"session_id", opt.sessionId},
+                      {"uuid", makeUuid()}});
+        }
+    }
+
+    ++apiTurns;
+    std::string messageId = makeId("msg_01");
+    messageStart(out, opt, messageId);
+    int index = 0;
+    if (opt.thinking && opt.toolsPerTurn == 0)
+        streamTextBlock(out, messageId, index++, "thinking", "thinking_delta", opt.replyTokens / 4 + 1);
+    streamTextBlock(out, messageId, index, "text", "text_delta", opt.replyTokens);
+    messageEnd(out, "end_turn", opt.replyTokens);
+    return apiTurns;
+}
+
+// Replays a recorded capture, rewriting session ids and keeping the gaps
+void scriptedTurn(Emitter &out, const Options &opt)
+{
+    std::ifstream in(opt.script);
+    if (!in) {
+        std::cerr << "mock_claude: cannot open script " << opt.script << "\n";
+        return;
+    }
+    std::string rec;
+    long long prevUs = -1;
+    while (std::getline(in, rec)) {
+        if (rec.empty() || rec[0] == '#')
+            continue;
+        size_t tab = rec.find('\t');
+        if (tab == std::string::npos)
+            continue;
+        long long us = std::atoll(rec.substr(0, tab).c_str());
+        json j = json::parse(rec.substr(tab + 1), nullptr, false);
+        if (j.is_discarded())
+            continue;
+        std::string type = j.value("type", "");
+        // init/replay/result are produced by the mock itself
+        if (type == "system" || type == "result" || (type == "user" && j.value("isReplay", false)))
+            continue;
+        if (type == "stream_event" && !opt.partialMessages)
+            continue;
+        if (prevUs >= 0 && us > prevUs && opt.speed > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                static_cast<long long>((us - prevUs) / opt.speed)));
+        prevUs = us;
+        if (j.contains("session_id"))
+            j["session_id"] = opt.sessionId;
+        out.line(j);
+    }
+}
+
+Options parseOptions(int argc, char *argv[])
+{
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto value = [&]() -> std::string { return i + 1 < argc ? argv[++i] : std::string(); };
+        if (a == "--output-format")
+            opt.streamJsonOut = value() == "stream-json";
+        else if (a == "--input-format" || a == "--permission-mode" || a == "--allowedTools"
+                 || a == "--tools" || a == "--append-system-prompt" || a == "--max-turns")
+            value();
+        else if (a == "--include-partial-messages")
+            opt.partialMessages = true;
+        else if (a == "--replay-user-messages")
+            opt.replayUserMessages = true;
+        else if (a == "--session-id" || a == "--resume")
+            opt.sessionId = value();
+        else if (a == "--model")
+            opt.model = value();
+        else if (a == "--rewind-files") {
+            value();
+            opt.rewind = true;
+        }
+    }
+
+    opt.tokensPerSec = envNumber("MOCK_CLAUDE_TOKENS_PER_SEC", opt.tokensPerSec);
+    opt.replyTokens = static_cast<int>(envNumber("MOCK_CLAUDE_REPLY_TOKENS", opt.replyTokens));
+    opt.toolsPerTurn = static_cast<int>(envNumber("MOCK_CLAUDE_TOOLS", opt.toolsPerTurn));
+    opt.thinking = envNumber("MOCK_CLAUDE_THINKING", 1) != 0;
+    opt.script = envString("MOCK_CLAUDE_SCRIPT");
+    opt.speed = envNumber("MOCK_CLAUDE_SPEED", opt.speed);
+    std::error_code ec;
+    opt.cwd = std::filesystem::current_path(ec).string();
+    return opt;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options opt = parseOptions(argc, argv);
+    g_rng.seed(static_cast<unsigned long long>(envNumber("MOCK_CLAUDE_SEED", std::random_device{}())));
+
+    if (opt.rewind)
+        return 0;
+    if (!opt.streamJsonOut) {
+        std::cerr << "mock_claude: only --output-format stream-json is supported\n";
+        return 1;
+    }
+    if (opt.sessionId.empty())
+        opt.sessionId = makeUuid();
+
+    Emitter out(opt);
+    bool initSent = false;
+    std::string input;
+    while (std::getline(std::cin, input)) {
+        json envelope = json::parse(input, nullptr, false);
+        if (envelope.is_discarded() || envelope.value("type", "") != "user")
+            continue;
+
+        auto started = std::chrono::steady_clock::now();
+        if (!initSent) {
+            out.line({{"type", "system"}, {"subtype", "init"}, {"cwd", opt.cwd},
+                      {"session_id", opt.sessionId}, {"model", opt.model},
+                      {"tools", {"Bash", "Glob", "Grep", "Read", "Edit", "Write"}},
+                      {"permissionMode", "bypassPermissions"}, {"uuid", makeUuid()}});
+            initSent = true;
+        }
+        if (opt.replayUserMessages) {
+            json replay = envelope;
+            replay["session_id"] = opt.sessionId;
+            replay["parent_tool_use_id"] = nullptr;
+            replay["uuid"] = makeUuid();
+            replay["isReplay"] = true;
+            out.line(replay);
+        }
+
+        int apiTurns = 1;
+        if (!opt.script.empty())
+            scriptedTurn(out, opt);
+        else
+            apiTurns = syntheticTurn(out, opt);
+
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        std::string answer = "mock answer to: " + userText(envelope).substr(0, 80);
+        out.line({{"type", "result"}, {"subtype", "success"}, {"is_error", false},
+                  {"duration_ms", ms}, {"duration_api_ms", ms}, {"num_turns", apiTurns},
+                  {"result", answer}, {"session_id", opt.sessionId},
+                  {"total_cost_usd", 0.0},
+                  {"usage", {{"input_tokens", 3}, {"output_tokens", opt.replyTokens}}},
+                  {"uuid", makeUuid()}});
+    }
+    return 0;
+}
@@ -5,8 +5,38 @@
 #include "core/PersonalityProfile.h"
 #include "core/SessionManager.h"
 #include "core/PipelineEngine.h"
+#include "core/StreamParser.h"
+#include "core/TurnMetrics.h"
+#include "core/LineFramer.h"
+#include "core/ProcessLauncher.h"
+#include "core/Database.h"
+#include "util/MarkdownBlocks.h"
+#include "util/MarkdownRenderer.h"
+#include "util/TranscriptIndex.h"
+#include "util/RenderCache.h"
+#include "util/MarkdownRenderService.h"
+#include "util/CodeHighlighter.h"
+#include "util/LanguageMap.h"
+#include "ui/ThemePalette.h"
+#include "util/Config.h"
+#include <QBuffer>
 #include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QEventLoop>
 #include <QDebug>
+#include <functional>
+#include <memory>
+
+#ifndef CCCPP_MARKDOWN_GOLDEN
+#define CCCPP_MARKDOWN_GOLDEN "tests/markdown"
+#endif
 
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
@@ -130,6 +160,890 @@ int main(int argc, char *argv[]) {
     Q_ASSERT(engine.isNodeReady(exec, "tester"));
     qDebug() << "[PASS] After implementer completes: reviewer AND tester both ready (parallel)";
 
-    qDebug() << "\n=== ALL 19 TESTS PASSED ===";
+    // ─── Line Framing ───
+    // Views point into the framer's buffer; keep deep copies
+    auto nextLine = [](LineFramer &framer, QByteArray &out) {
+        QByteArray view;
+        const LineFramer::Result r = framer.next(view);
+        out = QByteArray(view.constData(), view.size());
+        return r;
+    };
+    QByteArray framed;
+    LineFramer splitFramer;
+    splitFramer.append("abc");
+    Q_ASSERT(nextLine(splitFramer, framed) == LineFramer::NoLine);
+    splitFramer.append("def\nghi\n");
+    Q_ASSERT(nextLine(splitFramer, framed) == LineFramer::Line && framed == "abcdef");
+    Q_ASSERT(nextLine(splitFramer, framed) == LineFramer::Line && framed == "ghi");
+    Q_ASSERT(nextLine(splitFramer, framed) == LineFramer::NoLine && splitFramer.bufferedBytes() == 0);
+
+    // An oversized partial line is dropped through its newline; a complete
+    // one is skipped whole
+    LineFramer cappedFramer(8);
+    cappedFramer.append("0123456789");
+    Q_ASSERT(nextLine(cappedFramer, framed) == LineFramer::Overflow);
+    cappedFramer.append("still the same line");
+    Q_ASSERT(nextLine(cappedFramer, framed) == LineFramer::NoLine);
+    cappedFramer.append(" tail\nok\n0123456789ab\nxy\n");
+    Q_ASSERT(nextLine(cappedFramer, framed) == LineFramer::Line && framed == "ok");
+    Q_ASSERT(nextLine(cappedFramer, framed) == LineFramer::Overflow);
+    Q_ASSERT(nextLine(cappedFramer, framed) == LineFramer::Line && framed == "xy");
+    Q_ASSERT(cappedFramer.overflowCount() == 2);
+
+    // Small chunks interleaved with reads go through every compaction path
+    QByteArray stream;
+    for (int i = 0; i < 1000; ++i)
+        stream += "line " + QByteArray::number(i) + QByteArray(i % 37, 'x') + "\n";
+    LineFramer chunkFramer;
+    QList<QByteArray> lines;
+    for (qsizetype pos = 0; pos < stream.size(); pos += 7) {
+        chunkFramer.append(stream.mid(pos, 7));
+        while (nextLine(chunkFramer, framed) == LineFramer::Line)
+            lines.append(framed);
+        Q_ASSERT(chunkFramer.bufferedBytes() < 64);
+    }
+    Q_ASSERT(lines.size() == 1000 && lines[999] == "line 999" + QByteArray(999 % 37, 'x'));
+    Q_ASSERT(lines.join('\n') + '\n' == stream);
+
+    QBuffer device;
+    device.setData("first\nunterminated");
+    device.open(QIODevice::ReadOnly);
+    LineFramer deviceFramer;
+    Q_ASSERT(deviceFramer.readFrom(&device) == 18);
+    Q_ASSERT(nextLine(deviceFramer, framed) == LineFramer::Line && framed == "first");
+    Q_ASSERT(nextLine(deviceFramer, framed) == LineFramer::NoLine);
+    const QByteArray remainder = deviceFramer.takeRemainder();
+    Q_ASSERT(remainder == "unterminated" && deviceFramer.bufferedBytes() == 0);
+    Q_ASSERT(nextLine(deviceFramer, framed) == LineFramer::NoLine);
+    cappedFramer.append("0123456789");
+    Q_ASSERT(nextLine(cappedFramer, framed) == LineFramer::Overflow);
+    Q_ASSERT(cappedFramer.takeRemainder().isEmpty());  // nothing of a dropped line
+    qDebug() << "[PASS] Line framer: split lines, overflow skip, compaction, remainder";
+
+    // ─── Process Pool ───
+    // "sh -c cat --session-id <uuid>": cat waits on stdin like the CLI does
+    Config::instance().setSuppressAutoSave(true);
+    Config::instance().setProcessPoolSize(2);
+    Config::instance().setClaudeBinary(QStringLiteral("/bin/sh"));
+    ProcessLauncher &launcher = ProcessLauncher::instance();
+    const ProcessLauncher::LaunchSpec catSpec{QDir::tempPath(), {"-c", "cat"}, {}};
+    auto waitFor = [](const std::function<bool()> &done) {
+        QElapsedTimer waited;
+        waited.start();
+        while (!done() && waited.elapsed() < 5000) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+            QThread::msleep(5);
+        }
+        return done();
+    };
+
+    launcher.prewarm(catSpec);
+    Q_ASSERT(launcher.parkedCount() == 2);
+    QProcess::ProcessState stateInSetup = QProcess::NotRunning;
+    QProcess *pooled = launcher.start(catSpec, {}, nullptr, [&](QProcess *proc) {
+        stateInSetup = proc->state();
+    });
+    Q_ASSERT(stateInSetup != QProcess::NotRunning);  // handed out, not spawned
+    Q_ASSERT(launcher.parkedCount() == 1);
+    const bool refilled = waitFor([&] { return launcher.parkedCount() == 2; });
+    Q_ASSERT(refilled);
+    pooled->write("ping\n");
+    const bool echoed = waitFor([&] { return pooled->canReadLine(); });
+    Q_ASSERT(echoed && pooled->readLine() == "ping\n");
+    pooled->closeWriteChannel();
+    const bool pooledExited = pooled->waitForFinished(5000);
+    Q_ASSERT(pooledExited);
+    delete pooled;
+
+    // A resumed session never gets a parked process; setup runs before start()
+    stateInSetup = QProcess::Running;
+    QProcess *resumed = launcher.start(catSpec, QStringLiteral("resume-me"), nullptr,
+                                       [&](QProcess *proc) { stateInSetup = proc->state(); });
+    Q_ASSERT(stateInSetup == QProcess::NotRunning && launcher.parkedCount() == 2);
+    resumed->closeWriteChannel();
+    const bool resumedExited = resumed->waitForFinished(5000);
+    Q_ASSERT(resumedExited);
+    delete resumed;
+
+    // Parked on another thread: started there, handed out without moving
+    QThread parkThread;
+    parkThread.start();
+    launcher.setPoolSize(0);
+    launcher.setPoolSize(1);
+    launcher.prewarm(catSpec, &parkThread);
+    Q_ASSERT(launcher.parkedCount() == 1);
+    QProcess *elsewhere = launcher.takeParked(catSpec);
+    Q_ASSERT(!elsewhere);  // not before its thread has started it
+    const bool parkedElsewhere = waitFor([&] {
+        elsewhere = launcher.takeParked(catSpec);
+        return elsewhere != nullptr;
+    });
+    Q_ASSERT(parkedElsewhere && elsewhere->thread() == &parkThread && !elsewhere->parent());
+    launcher.setPoolSize(0);  // no replacement
+    bool echoedElsewhere = false;
+    QMetaObject::invokeMethod(elsewhere, [&] {
+        elsewhere->write("ping\n");
+        echoedElsewhere = elsewhere->waitForReadyRead(5000) && elsewhere->readLine() == "ping\n";
+        elsewhere->closeWriteChannel();
+        elsewhere->waitForFinished(5000);
+        delete elsewhere;
+    }, Qt::BlockingQueuedConnection);
+    Q_ASSERT(echoedElsewhere);
+    QCoreApplication::processEvents();  // the refill finds the pool closed
+    parkThread.quit();
+    parkThread.wait();
+
+    // A binary change drops the pool; processes that die are unparked
+    Config::instance().setClaudeBinary(QStringLiteral("/nonexistent/claude"));
+    Q_ASSERT(launcher.parkedCount() == 0);
+    launcher.prewarm(catSpec);
+    const bool deadUnparked = waitFor([&] { return launcher.parkedCount() == 0; });
+    Q_ASSERT(deadUnparked);
+    Config::instance().setProcessPoolSize(0);
+    qDebug() << "[PASS] Process pool: parking, reuse, refill, other threads, invalidation";
+
+    // ─── Streaming Edit Extraction ───
+    StreamParser parser;
+    QString streamedPath;
+    QString streamedContent;
+    QObject::connect(&parser, &StreamParser::editStreamStarted,
+                     [&](const QString &, const QString &path) { streamedPath = path; });
+    QObject::connect(&parser, &StreamParser::editContentDelta,
+                     [&](int, const QString &text) { streamedContent += text; });
+
+    auto feedEvent = [&parser](const nlohmann::json &ev) {
+        parser.feed(QByteArray::fromStdString(
+            nlohmann::json{{"type", "stream_event"}, {"event", ev}}.dump()));
+    };
+    feedEvent({{"type", "content_block_start"}, {"index", 2},
+               {"content_block", {{"type", "tool_use"}, {"id", "toolu_1"}, {"name", "Write"}}}});
+    // Chunk boundaries split an escape, a \u sequence and a surrogate pair
+    const char *chunks[] = {
+        "{\"file_path\": \"/tmp/a\\\"b", "\"", ", \"content\": \"x\\", "n\\u00",
+        "e9 \\uD83D", "\\uDE00 ok\"}"
+    };
+    for (const char *chunk : chunks) {
+        feedEvent({{"type", "content_block_delta"}, {"index", 2},
+                   {"delta", {{"type", "input_json_delta"}, {"partial_json", chunk}}}});
+    }
+    Q_ASSERT(streamedPath == "/tmp/a\"b");
+    Q_ASSERT(streamedContent == QString::fromUtf8("x\n\xc3\xa9 \xf0\x9f\x98\x80 ok"));
+    qDebug() << "[PASS] Edit content streams across split escapes and surrogate pairs";
+
+    // ─── Delta Coalescing ───
+    StreamParser ioParser;
+    ioParser.setBatched(true);
+    ioParser.setCoalescing(true);
+    auto feedIo = [&ioParser](const nlohmann::json &ev) {
+        ioParser.feed(QByteArray::fromStdString(
+            nlohmann::json{{"type", "stream_event"}, {"event", ev}}.dump()));
+    };
+    for (int i = 0; i < 50; ++i)
+        feedIo({{"type", "content_block_delta"}, {"index", 0},
+                {"delta", {{"type", "text_delta"}, {"text", "ab"}}}});
+    feedIo({{"type", "content_block_stop"}, {"index", 0}});
+    feedIo({{"type", "content_block_start"}, {"index", 1},
+            {"content_block", {{"type", "thinking"}}}});
+    for (int i = 0; i < 3; ++i)
+        feedIo({{"type", "content_block_delta"}, {"index", 1},
+                {"delta", {{"type", "thinking_delta"}, {"thinking", "t"}}}});
+    feedIo({{"type", "content_block_stop"}, {"index", 1}});
+    feedIo({{"type", "content_block_delta"}, {"index", 2},
+            {"delta", {{"type", "text_delta"}, {"text", "z"}}}});
+    const QVector<StreamEvent> batch = ioParser.takeBatch();
+    Q_ASSERT(batch.size() == 5);
+    Q_ASSERT(batch[0].type == StreamEvent::TextDelta && batch[0].text.size() == 100);
+    Q_ASSERT(batch[0].mergedDeltas == 50);
+    Q_ASSERT(batch[1].type == StreamEvent::ThinkingStarted);
+    Q_ASSERT(batch[2].type == StreamEvent::ThinkingDelta && batch[2].text == "ttt");
+    Q_ASSERT(batch[3].type == StreamEvent::ThinkingStopped);
+    Q_ASSERT(batch[4].type == StreamEvent::TextDelta && batch[4].text == "z");
+
+    StreamParser guiParser;
+    int textSignals = 0;
+    QObject::connect(&guiParser, &StreamParser::textDelta, [&](const QString &) { ++textSignals; });
+    guiParser.dispatch(batch);
+    Q_ASSERT(textSignals == 2);
+    Q_ASSERT(guiParser.emissionStats().deltasIn == 54);
+    Q_ASSERT(guiParser.emissionStats().deltasOut == 3);
+    Q_ASSERT(ioParser.emissionStats().reductionRatio() == 18.0);
+    qDebug() << "[PASS] Consecutive deltas coalesce up to block boundaries (54 -> 3)";
+
+    // ─── Turn Latency Metrics ───
+    TurnTimer timer;
+    timer.begin(1000, 0);
+    timer.processStarted(1100);
+    timer.stdoutReceived(1500);
+    for (qint64 at : {2000, 2005, 2040, 2300})
+        timer.deltaReceived(at);
+    StreamEvent toolUse;
+    toolUse.type = StreamEvent::ToolUse;
+    timer.eventReceived(toolUse, 2400);
+    StreamEvent toolResult;
+    toolResult.type = StreamEvent::ToolResult;
+    timer.eventReceived(toolResult, 3400);
+    timer.deltaReceived(3500);
+    const TurnMetrics turn = timer.finish(4000);
+    Q_ASSERT(turn.spawnMs == 100 && turn.firstByteMs == 500 && turn.ttftMs == 1000);
+    Q_ASSERT(turn.totalMs == 3000 && turn.toolMs == 1000 && turn.toolCount == 1);
+    Q_ASSERT(turn.deltaCount == 5 && turn.maxGapMs == 1200);
+    Q_ASSERT(turn.histogramToString() == "1,0,1,0,0,1,0,1");
+    Q_ASSERT(turn.gapPercentileMs(0.5) == 50);
+    TurnMetrics restored;
+    restored.histogramFromString(turn.histogramToString());
+    Q_ASSERT(restored.gapPercentileMs(0.5) == 50);
+    qDebug() << "[PASS] Turn timer: spawn, TTFT, gap histogram, tool time";
+
+    // ─── Incremental Markdown Blocks ───
+    MarkdownBlockSplitter splitter;
+    QString md = "Intro line\n\n- one\n- two\n";
+    Q_ASSERT(splitter.update(md) == 1);
+    Q_ASSERT(md.mid(splitter.closedBlocks()[0].start,
+                    splitter.closedBlocks()[0].length) == "Intro line");
+    md += "\n\n```cpp\nint a;\n\nint b;\n";
+    Q_ASSERT(splitter.update(md) == 1);  // the list; the blank line is inside the fence
+    Q_ASSERT(splitter.inFence());
+    md += "```\n| a | b |\n|---|---|\n| 1 | 2";
+    Q_ASSERT(splitter.update(md) == 1);
+    const auto fence = splitter.closedBlocks()[2];
+    Q_ASSERT(md.mid(fence.start, fence.length) == "```cpp\nint a;\n\nint b;\n```");
+    Q_ASSERT(md.mid(splitter.openStart()).startsWith("| a | b |"));
+    Q_ASSERT(splitter.update(md) == 0);
+    qDebug() << "[PASS] Markdown splitter closes paragraphs, lists and fences; tables stay open";
+
+    // ─── Markdown Renderer ───
+    // The golden files were rendered with these colors
+    ThemePalette goldenPalette;
+    goldenPalette.text_primary = QColor("#c0c0c1");
+    goldenPalette.text_secondary = QColor("#c0c0c2");
+    goldenPalette.text_muted = QColor("#c0c0c3");
+    goldenPalette.text_faint = QColor("#c0c0c4");
+    goldenPalette.bg_raised = QColor("#c0c0c5");
+    goldenPalette.bg_surface = QColor("#c0c0c6");
+    goldenPalette.bg_base = QColor("#c0c0c7");
+    goldenPalette.bg_window = QColor("#c0c0c8");
+    goldenPalette.border_standard = QColor("#c0c0c9");
+    goldenPalette.green = QColor("#c0c0ca");
+    goldenPalette.red = QColor("#c0c0cb");
+    goldenPalette.blue = QColor("#c0c0cc");
+
+    const QDir goldenDir(QStringLiteral(CCCPP_MARKDOWN_GOLDEN));
+    const QStringList goldenCases = goldenDir.entryList({"*.md"}, QDir::Files, QDir::Name);
+    Q_ASSERT(goldenCases.size() >= 10);
+    MarkdownRenderer md(goldenPalette);
+    QString fencedCase;
+    for (const QString &name : goldenCases) {
+        QFile input(goldenDir.filePath(name));
+        QFile expected(goldenDir.filePath(name.chopped(3) + ".html"));
+        const bool opened = input.open(QIODevice::ReadOnly) && expected.open(QIODevice::ReadOnly);
+        Q_ASSERT(opened);
+        const QString source = QString::fromUtf8(input.readAll());
+        const bool same = md.toHtml(source) == QString::fromUtf8(expected.readAll());
+        if (!same)
+            qDebug() << "[FAIL] golden mismatch:" << name;
+        Q_ASSERT(same);
+        if (name.startsWith("04-"))
+            fencedCase = source;
+    }
+    qDebug() << "[PASS] Markdown golden corpus:" << goldenCases.size() << "cases";
+
+    const QString mainThreadHtml = md.toHtml(fencedCase);
+    const QList<CodeBlockInfo> fences = md.lastCodeBlocks();
+    Q_ASSERT(fences.size() == 3);
+    Q_ASSERT(fences[0].language == "bash" && fences[1].language == "cpp" && fences[2].language.isEmpty());
+    Q_ASSERT(fences[0].code == "mkdir build && cd build\ncmake .. && make -j8");
+    Q_ASSERT(fencedCase.mid(fences[2].startOffset, fences[2].endOffset - fences[2].startOffset)
+             == "```\nno language\n```");
+    QString workerHtml;
+    QThread *worker = QThread::create([&] {
+        MarkdownRenderer offThread(goldenPalette);
+        offThread.setCodeBlockIndexBase(5);
+        workerHtml = offThread.toHtml(fencedCase);
+    });
+    worker->start();
+    worker->wait();
+    delete worker;
+    Q_ASSERT(workerHtml.contains("cccpp://copy?block=5'") && workerHtml.contains("cccpp://copy?block=7'"));
+    workerHtml.replace("block=5'", "block=0'").replace("block=6'", "block=1'").replace("block=7'", "block=2'");
+    Q_ASSERT(workerHtml == mainThreadHtml);
+    qDebug() << "[PASS] Markdown code blocks, index base and off-thread rendering";
+
+    // ─── Transcript Index ───
+    TranscriptIndex rows;
+    for (int i = 0; i < 1000; ++i)
+        rows.append(10 + i % 7);
+    int expectedTop = 0;
+    for (int i = 0; i < 500; ++i)
+        expectedTop += 10 + i % 7;
+    Q_ASSERT(rows.offset(500) == expectedTop);
+    Q_ASSERT(rows.rowAt(expectedTop) == 500 && rows.rowAt(expectedTop - 1) == 499);
+    const int totalBefore = rows.totalHeight();
+    rows.setHeight(3, rows.height(3) + 40);  // a row measured taller than estimated
+    Q_ASSERT(rows.offset(500) == expectedTop + 40 && rows.totalHeight() == totalBefore + 40);
+    Q_ASSERT(rows.rowAt(-5) == 0 && rows.rowAt(totalBefore + 1000) == 999);
+    rows.truncate(500);
+    Q_ASSERT(rows.size() == 500 && rows.totalHeight() == expectedTop + 40);
+    rows.append(25);
+    Q_ASSERT(rows.rowAt(expectedTop + 40 + 24) == 500 && rows.totalHeight() == expectedTop + 65);
+    qDebug() << "[PASS] Transcript index offsets, lookups, height updates and truncation";
+
+    // ─── Render Cache ───
+    QTemporaryDir cacheDir;
+    Database cacheDb;
+    const bool cacheDbOpen = cacheDb.open(cacheDir.filePath("history.db"));
+    Q_ASSERT(cacheDbOpen);
+    auto &renderCache = RenderCache::instance();
+    renderCache.setDatabase(&cacheDb);
+    const qint64 missesBefore = renderCache.misses();
+    const RenderedMarkdown first = renderCache.render(md, fencedCase, 0);
+    const RenderedMarkdown again = renderCache.render(md, fencedCase, 0);
+    Q_ASSERT(first.html == mainThreadHtml && again.html == mainThreadHtml);
+    Q_ASSERT(renderCache.misses() == missesBefore + 1);
+    renderCache.flush();
+    cacheDb.flush();  // cache lookups never wait for the writer
+    renderCache.clearMemory();
+    const qint64 hitsBefore = renderCache.hits();
+    const RenderedMarkdown fromDisk = renderCache.render(md, fencedCase, 0);
+    Q_ASSERT(renderCache.hits() == hitsBefore + 1 && fromDisk.html == mainThreadHtml);
+    Q_ASSERT(fromDisk.codeBlocks.size() == 3 && fromDisk.codeBlocks[1].language == "cpp"
+             && fromDisk.codeBlocks[0].code == fences[0].code
+             && fromDisk.codeBlocks[2].endOffset == fences[2].endOffset);
+    // Numbering base and palette are part of the key
+    const QString keyBase0 = RenderCache::key(fencedCase, 0, md.styleKey());
+    Q_ASSERT(keyBase0 != RenderCache::key(fencedCase, 3, md.styleKey()));
+    ThemePalette otherPalette = goldenPalette;
+    otherPalette.text_primary = QColor("#123456");
+    Q_ASSERT(MarkdownRenderer(otherPalette).styleKey() != md.styleKey());
+    // Least recently used rows go once the table outgrows its limit
+    // Rows count their code block JSON too, which is about the fenced source
+    renderCache.setDiskLimit(qint64(mainThreadHtml.size() + fencedCase.size()) * 2 + 1000);
+    QThread::msleep(5);
+    const QString newer = fencedCase + "\n\nmore";
+    renderCache.render(md, newer, 0);
+    renderCache.flush();
+    cacheDb.flush();
+    renderCache.clearMemory();
+    RenderedMarkdown probe;
+    const bool oldKept = renderCache.lookup(keyBase0, probe);
+    const bool newKept = renderCache.lookup(RenderCache::key(newer, 0, md.styleKey()), probe);
+    Q_ASSERT(!oldKept && newKept);
+    renderCache.setDatabase(nullptr);
+    cacheDb.close();
+    {
+        // The running total the trim checks matches the rows
+        QSqlDatabase check = QSqlDatabase::addDatabase("QSQLITE", "render_cache_check");
+        check.setDatabaseName(cacheDir.filePath("history.db"));
+        check.open();
+        QSqlQuery q(check);
+        q.exec("SELECT (SELECT bytes FROM render_cache_size) = "
+               "(SELECT COALESCE(SUM(bytes), 0) FROM render_cache)");
+        const bool totalExact = q.next() && q.value(0).toBool();
+        Q_ASSERT(totalExact);
+        check.close();
+    }
+    QSqlDatabase::removeDatabase("render_cache_check");
+    qDebug() << "[PASS] Render cache memory/disk hits, keys and LRU trimming";
+
+    // ─── Markdown Render Service ───
+    auto &renderService = MarkdownRenderService::instance();
+    const quint64 slot = MarkdownRenderService::nextId();
+    const QString staleText = fencedCase + "\n\nsuperseded";
+    const QString liveText = "# Heading\n\nfirst paragraph\n\n" + fencedCase + "\n\ntail";
+    int staleDone = 0, liveDone = 0, cancelledDone = 0;
+    QObject receiver;
+    renderService.request(slot, staleText, goldenPalette, &receiver, [&] { ++staleDone; });
+    renderService.request(slot, liveText, goldenPalette, &receiver, [&] { ++liveDone; });
+    const quint64 dropped = MarkdownRenderService::nextId();
+    renderService.request(dropped, staleText + "!", goldenPalette, &receiver, [&] { ++cancelledDone; });
+    renderService.cancel(dropped);
+    QElapsedTimer serviceClock;
+    serviceClock.start();
+    while (renderService.pendingCount() > 0 && serviceClock.elapsed() < 5000) {
+        renderService.waitForDone();
+        QCoreApplication::processEvents();
+    }
+    Q_ASSERT(staleDone == 0 && liveDone == 1 && cancelledDone == 0);
+    // The service renders with code highlighting on, like the chat view
+    MarkdownRenderer served(goldenPalette);
+    served.setHighlightCode(true);
+    const bool liveCached = renderService.isCached(liveText, served.styleKey());
+    const bool grownCached = renderService.isCached(liveText + "\n\nnew tail", served.styleKey());
+    Q_ASSERT(liveCached && !grownCached);
+    // Blocks from the worker match what a GUI-thread render would produce
+    MarkdownBlockSplitter liveBlocks;
+    liveBlocks.update(liveText);
+    const QString liveTail = liveBlocks.openTail(liveText);
+    RenderedMarkdown workerTail;
+    const bool tailCached = renderCache.lookup(RenderCache::key(liveTail, 3, served.styleKey()), workerTail);
+    served.setCodeBlockIndexBase(3);
+    const QString guiTail = served.toHtml(liveTail);
+    Q_ASSERT(tailCached && workerTail.html == guiTail);
+    qDebug() << "[PASS] Markdown render service: async results, stale requests dropped";
+
+    // ─── Code Highlighting ───
+    HighlightColors syntax{"#000001", "#000002", "#000003", "#000004", "#000005", "#000006"};
+    const QString cppLine = CodeHighlighter::highlight(
+        SourceLanguage::Cpp, "int main() { return 0; } // done", syntax);
+    Q_ASSERT(cppLine == "<span style='color:#000002;'>int</span> main() { "
+                        "<span style='color:#000001;'>return</span> "
+                        "<span style='color:#000004;'>0</span>; } "
+                        "<span style='color:#000005;'>// done</span>");
+    // Open comments and strings carry over to the next line
+    const QString spanning = CodeHighlighter::highlight(
+        SourceLanguage::Cpp, "a /* b\nc */ \"x<y\"", syntax);
+    Q_ASSERT(spanning == "a <span style='color:#000005;'>/* b</span>\n"
+                         "<span style='color:#000005;'>c */</span> "
+                         "<span style='color:#000003;'>&quot;x&lt;y&quot;</span>");
+    const QString pyCode = "def f():\n    \"\"\"doc\n    more\"\"\"\n    return None  # x";
+    int lineState = 0;
+    QStringList pyLines;
+    for (const QString &line : pyCode.split('\n'))
+        pyLines << CodeHighlighter::highlightLine(SourceLanguage::Python, line, syntax, lineState);
+    Q_ASSERT(lineState == 0 && pyLines[2].startsWith("<span style='color:#000003;'>    more"));
+    Q_ASSERT(pyLines.join('\n') == CodeHighlighter::highlight(SourceLanguage::Python, pyCode, syntax));
+    // A growing block only tokenizes its new lines; a finished one is a single lookup
+    const CodeHighlighter::Stats beforeGrow = CodeHighlighter::stats();
+    CodeHighlighter::highlight(SourceLanguage::Python, pyCode + "\nx = 1", syntax, false);
+    const CodeHighlighter::Stats afterGrow = CodeHighlighter::stats();
+    Q_ASSERT(afterGrow.lineHits == beforeGrow.lineHits + 4 && afterGrow.lineMisses == beforeGrow.lineMisses + 1);
+    Q_ASSERT(afterGrow.blockHits == beforeGrow.blockHits && afterGrow.blockMisses == beforeGrow.blockMisses);
+    CodeHighlighter::highlight(SourceLanguage::Python, pyCode, syntax);
+    Q_ASSERT(CodeHighlighter::stats().blockHits == afterGrow.blockHits + 1);
+    Q_ASSERT(languageForFenceTag("c++") == SourceLanguage::Cpp
+             && languageForFenceTag("Python title=x.py") == SourceLanguage::Python
+             && languageForFenceTag("tsx") == SourceLanguage::JavaScript
+             && languageForFenceTag("text") == SourceLanguage::None
+             && languageForFile("src/CMakeLists.txt") == SourceLanguage::CMake);
+    // Chat rendering: colored fences, and an unclosed fence only while streaming
+    ThemePalette syntaxPalette = goldenPalette;
+    syntaxPalette.mauve = QColor("#c0c0cd");
+    MarkdownRenderer colored(syntaxPalette);
+    colored.setHighlightCode(true);
+    Q_ASSERT(colored.styleKey() != MarkdownRenderer(syntaxPalette).styleKey());
+    Q_ASSERT(colored.toHtml(fencedCase).contains("<span style='color:#c0c0cd;'>"));
+    const QString streaming = "Here:\n\n```python\nfor x in y:\n    pass";
+    Q_ASSERT(!colored.toHtml(streaming).contains("<table"));
+    colored.setRenderOpenFence(true);
+    const QString openHtml = colored.toHtml(streaming);
+    Q_ASSERT(openHtml.contains("<table") && colored.lastCodeBlocks().size() == 1
+             && colored.lastCodeBlocks()[0].code == "for x in y:\n    pass");
+    qDebug() << "[PASS] Code highlighting: tokens, carried state, line/block caches, fences";
+
+    // ─── History Writer ───
+    QTemporaryDir historyDir;
+    const QString historyPath = historyDir.filePath("history.db");
+    auto history = std::make_unique<Database>();
+    const bool historyOpen = history->open(historyPath);
+    Q_ASSERT(historyOpen);
+    SessionInfo batchSession;
+    batchSession.sessionId = "writer-session";
+    batchSession.title = "Writer";
+    history->saveSession(batchSession);
+    for (int i = 0; i < 1000; ++i) {
+        MessageRecord rec;
+        rec.sessionId = batchSession.sessionId;
+        rec.role = i % 2 ? "assistant" : "user";
+        rec.content = QString("message %1").arg(i);
+        rec.turnId = i / 2 + 1;
+        rec.timestamp = i;
+        history->saveMessage(rec);
+    }
+    // Reads wait for queued writes; the writes went out in a few batches
+    const bool batchWritten = history->flush();
+    Q_ASSERT(batchWritten);
+    const int writtenNow = history->loadMessages(batchSession.sessionId).size();
+    Q_ASSERT(writtenNow == 1000);
+    const qint64 writeTxns = history->writeTransactions();
+    Q_ASSERT(writeTxns > 0 && writeTxns < 100);
+    Q_ASSERT(QFile::exists(historyPath + "-wal"));
+    MessageRecord last;
+    last.sessionId = batchSession.sessionId;
+    last.role = "user";
+    last.content = "queued at close";
+    last.turnId = 501;
+    history->saveMessage(last);
+    history.reset();  // close drains the queue
+    Database reopened;
+    const bool reopenedOk = reopened.open(historyPath);
+    Q_ASSERT(reopenedOk);
+    const QList<MessageRecord> persisted = reopened.loadMessages(batchSession.sessionId);
+    Q_ASSERT(persisted.size() == 1001 && persisted.last().content == "queued at close");
+    Q_ASSERT(reopened.turnCountForSession(batchSession.sessionId) == 501);
+    reopened.close();
+    // A failing statement drops its own group, not the batch around it
+    {
+        DatabaseWriter writer(historyPath, "writer_atomic");
+        const bool writerStarted = writer.start();
+        Q_ASSERT(writerStarted);
+        writer.enqueue({{"INSERT INTO sessions (session_id, title) VALUES (?, ?)", {"atomic-a", "A"}},
+                        {"INSERT INTO no_such_table VALUES (1)", {}}});
+        writer.enqueue("INSERT INTO sessions (session_id, title) VALUES (?, ?)", {"atomic-b", "B"});
+        writer.flush();
+        Q_ASSERT(writer.failedGroups() == 1 && writer.statements() == 1);
+    }
+    Database atomic;
+    const bool atomicOpen = atomic.open(historyPath);
+    Q_ASSERT(atomicOpen);
+    Q_ASSERT(atomic.loadSession("atomic-a").sessionId.isEmpty()
+             && atomic.loadSession("atomic-b").title == "B");
+    atomic.close();
+    qDebug() << "[PASS] History writer: group commit, read-your-writes, flush on close";
+
+    // ─── History Schema ───
+    // A database from before versioning: no favorite column, no turn ids
+    const QString legacyPath = historyDir.filePath("legacy.db");
+    {
+        QSqlDatabase legacy = QSqlDatabase::addDatabase("QSQLITE", "legacy_setup");
+        legacy.setDatabaseName(legacyPath);
+        legacy.open();
+        QSqlQuery q(legacy);
+        q.exec("CREATE TABLE sessions (session_id TEXT PRIMARY KEY, title TEXT, workspace TEXT, "
+               "mode TEXT, created_at INTEGER, updated_at INTEGER)");
+        q.exec("CREATE TABLE messages (id INTEGER PRIMARY KEY AUTOINCREMENT, session_id TEXT, "
+               "role TEXT, content TEXT, tool_name TEXT, tool_input TEXT, turn_id INTEGER, "
+               "timestamp INTEGER)");
+        q.exec("INSERT INTO sessions VALUES ('old', 'Old', '/ws', 'agent', 7, 0)");
+        q.exec("INSERT INTO messages (session_id, role, content, timestamp) "
+               "VALUES ('old', 'user', 'hi', 42)");
+        legacy.close();
+    }
+    QSqlDatabase::removeDatabase("legacy_setup");
+    Database upgraded;
+    const bool upgradedOpen = upgraded.open(legacyPath);
+    Q_ASSERT(upgradedOpen);
+    const SessionInfo oldSession = upgraded.loadSession("old");
+    Q_ASSERT(oldSession.updatedAt == 42 && !oldSession.favorite);
+    Q_ASSERT(upgraded.loadSessions("/ws").size() == 1 && upgraded.loadSessions("/other").isEmpty());
+    Q_ASSERT(upgraded.loadMessages("old").first().turnId == 0);
+    upgraded.close();
+    {
+        QSqlDatabase check = QSqlDatabase::addDatabase("QSQLITE", "legacy_check");
+        check.setDatabaseName(legacyPath);
+        check.open();
+        QSqlQuery q(check);
+        q.exec("PRAGMA user_version");
+        const int version = q.next() ? q.value(0).toInt() : -1;
+        Q_ASSERT(version == upgraded.schemaVersion());
+        check.close();
+    }
+    QSqlDatabase::removeDatabase("legacy_check");
+    Database reupgraded;  // applied steps are not run again
+    const bool reupgradedOpen = reupgraded.open(legacyPath);
+    Q_ASSERT(reupgradedOpen && reupgraded.loadSessions("/ws").size() == 1);
+    // Hot queries must search an index, never scan the table
+    const auto usesIndex = [](Database &db, const QString &sql, const QVariantList &values,
+                              const char *index) {
+        const QStringList plan = db.queryPlan(sql, values);
+        bool found = false;
+        for (const auto &row : plan) {
+            if (row.startsWith("SCAN")) return false;
+            found = found || row.contains(index);
+        }
+        return found;
+    };
+    Q_ASSERT(usesIndex(reupgraded,
+                       "SELECT id, session_id, role, content, tool_name, tool_input, turn_id, "
+                       "timestamp FROM messages WHERE session_id = ? ORDER BY id ASC",
+                       {"old"}, "idx_messages_session"));
+    Q_ASSERT(usesIndex(reupgraded,
+                       "SELECT COALESCE(MAX(turn_id), 0) FROM messages WHERE session_id = ?",
+                       {"old"}, "COVERING INDEX idx_messages_session_turn"));
+    Q_ASSERT(usesIndex(reupgraded,
+                       "SELECT session_id FROM sessions WHERE workspace = ? ORDER BY updated_at DESC",
+                       {"/ws"}, "idx_sessions_workspace_updated"));
+    Q_ASSERT(usesIndex(reupgraded,
+                       "SELECT uuid FROM checkpoints WHERE session_id = ? AND turn_id = ?",
+                       {"old", 1}, "sqlite_autoindex_checkpoints"));
+    reupgraded.close();
+    qDebug() << "[PASS] History schema: versioned migrations, backfill, indexed query plans";
+
+    // ─── Session Stats ───
+    Database fleetDb;
+    const bool fleetOpen = fleetDb.open(historyDir.filePath("fleet.db"));
+    Q_ASSERT(fleetOpen);
+    for (int i = 0; i < 10000; ++i) {
+        SessionInfo info;
+        info.sessionId = QString("fleet-%1").arg(i);
+        info.workspace = i % 10 ? "/fleet" : "/elsewhere";
+        info.title = QString("Session %1").arg(i);
+        info.updatedAt = 1000 + i;
+        fleetDb.saveSession(info);
+    }
+    const auto fleetMessage = [&](const QString &role, const QString &tool, int turn) {
+        MessageRecord rec;
+        rec.sessionId = "fleet-9999";
+        rec.role = role;
+        rec.content = role + " " + tool;
+        rec.toolName = tool;
+        rec.turnId = turn;
+        rec.timestamp = 5000 + turn;
+        fleetDb.saveMessage(rec);
+    };
+    fleetMessage("user", {}, 1);
+    fleetMessage("tool", "Edit", 1);
+    fleetMessage("tool", "Read", 2);
+    fleetMessage("tool", "Write", 3);
+    fleetMessage("assistant", {}, 3);
+    TurnMetricsRecord fleetMetrics;
+    fleetMetrics.sessionId = "fleet-9999";
+    fleetMetrics.turnId = 3;
+    fleetMetrics.metrics.ttftMs = 420;
+    fleetMetrics.metrics.totalMs = 9000;
+    fleetDb.saveTurnMetrics(fleetMetrics);
+    fleetDb.addSessionUsage("fleet-9999", 0.25, 1000, 200);
+    fleetDb.addSessionUsage("fleet-9999", 0.5, 3000, 400);
+    fleetDb.flush();
+
+    QElapsedTimer fleetClock;
+    fleetClock.start();
+    const QList<SessionSummary> fleet = fleetDb.loadSessionSummaries("/fleet");
+    const qint64 fleetMs = fleetClock.elapsed();
+    Q_ASSERT(fleet.size() == 9000 && fleetDb.sessionCount("/fleet") == 9000);
+    // What a fleet refresh actually reads: one page of the newest sessions
+    fleetClock.restart();
+    const QList<SessionSummary> fleetPage = fleetDb.loadSessionSummaries("/fleet", 200);
+    const qint64 fleetPageMs = fleetClock.elapsed();
+    Q_ASSERT(fleetPage.size() == 200 && fleetPageMs < 10);
+    const SessionSummary &newest = fleet.first();
+    Q_ASSERT(newest.session.sessionId == "fleet-9999" && newest.session.title == "Session 9999");
+    Q_ASSERT(newest.turnCount == 3 && newest.editCount == 2 && newest.messageCount == 5);
+    Q_ASSERT(newest.lastActivity == "tool Write" && newest.lastMessageAt == 5003);
+    Q_ASSERT(newest.lastTtftMs == 420 && newest.lastTurnMs == 9000);
+    Q_ASSERT(qFuzzyCompare(newest.costUsd, 0.75) && newest.inputTokens == 4000
+             && newest.outputTokens == 600);
+    Q_ASSERT(fleet[1].turnCount == 0 && fleet[1].lastTtftMs == -1);
+    const QList<SessionSummary> page = fleetDb.loadSessionSummaries("/fleet", 50, 100);
+    Q_ASSERT(page.size() == 50 && page.first().session.sessionId == fleet[100].session.sessionId);
+    // A confirmed session id carries its stats along, into stats the id
+    // already has: counts and usage add up, the newer side's "last" fields
+    // win unless it has none. Deleting drops them.
+    MessageRecord resumedMessage;
+    resumedMessage.sessionId = "fleet-confirmed";
+    resumedMessage.role = "tool";
+    resumedMessage.content = "tool Write resumed";
+    resumedMessage.toolName = "Write";
+    resumedMessage.turnId = 4;
+    resumedMessage.timestamp = 6000;
+    fleetDb.saveMessage(resumedMessage);
+    fleetDb.addSessionUsage("fleet-confirmed", 1.0, 500, 50);
+    fleetDb.updateMessageSessionId("fleet-9999", "fleet-confirmed");
+    SessionInfo stale = newest.session;  // no stats are left under the old id
+    stale.updatedAt = 20000;
+    fleetDb.saveSession(stale);
+    const QList<SessionSummary> left = fleetDb.loadSessionSummaries("/fleet", 1);
+    Q_ASSERT(left.size() == 1 && left.first().session.sessionId == "fleet-9999"
+             && left.first().messageCount == 0 && left.first().turnCount == 0);
+    SessionInfo confirmed = newest.session;
+    confirmed.sessionId = "fleet-confirmed";
+    fleetDb.saveSession(confirmed);
+    fleetDb.deleteSession("fleet-9999");
+    const QList<SessionSummary> renamed = fleetDb.loadSessionSummaries("/fleet", 1);
+    Q_ASSERT(renamed.size() == 1 && renamed.first().session.sessionId == "fleet-confirmed");
+    const SessionSummary &merged = renamed.first();
+    Q_ASSERT(merged.turnCount == 4 && merged.editCount == 3 && merged.messageCount == 6);
+    Q_ASSERT(merged.lastActivity == "tool Write resumed" && merged.lastMessageAt == 6000);
+    Q_ASSERT(merged.lastTtftMs == 420 && merged.lastTurnMs == 9000);
+    Q_ASSERT(qFuzzyCompare(merged.costUsd, 1.75) && merged.inputTokens == 4500
+             && merged.outputTokens == 650);
+    Q_ASSERT(usesIndex(fleetDb,
+                       "SELECT s.title, st.turn_count FROM sessions s LEFT JOIN session_stats st "
+                       "ON st.session_id = s.session_id WHERE s.workspace = ? "
+                       "ORDER BY s.updated_at DESC LIMIT ? OFFSET ?",
+                       {"/fleet", -1, 0}, "idx_sessions_workspace_updated"));
+    fleetDb.close();
+    qDebug() << "[PASS] Session stats: maintained with writes, paged fleet query;"
+             << fleet.size() << "sessions in" << fleetMs << "ms, a page of 200 in"
+             << fleetPageMs << "ms";
+
+    // ─── Message Paging ───
+    Database pagingDb;
+    const bool pagingOpen = pagingDb.open(historyDir.filePath("paging.db"));
+    Q_ASSERT(pagingOpen);
+    for (int turn = 1; turn <= 10; ++turn) {
+        const QStringList roles{"user", "tool", "tool", "tool", "assistant"};
+        for (int i = 0; i < roles.size(); ++i) {
+            MessageRecord rec;
+            rec.sessionId = "paged";
+            rec.role = roles[i];
+            rec.content = QString("t%1 m%2").arg(turn).arg(i);
+            rec.toolName = roles[i] == "tool" ? "Read" : QString();
+            rec.turnId = turn;
+            rec.timestamp = 100 * turn + i;
+            pagingDb.saveMessage(rec);
+        }
+    }
+    const QList<MessageRecord> newestPage = pagingDb.loadMessagesBefore("paged", 0, 7);
+    Q_ASSERT(newestPage.size() == 7 && newestPage.last().content == "t10 m4"
+             && newestPage.first().content == "t9 m3");
+    const QList<MessageRecord> olderPage =
+        pagingDb.loadMessagesBefore("paged", newestPage.first().id, 5);
+    Q_ASSERT(olderPage.size() == 5 && olderPage.last().id == newestPage.first().id - 1
+             && olderPage.first().content == "t8 m3");
+    Q_ASSERT(pagingDb.loadMessagesBefore("paged", olderPage.first().id, 100).size() == 38);
+    const QList<MessageRecord> turns = pagingDb.loadTurnRange("paged", 3, 4);
+    Q_ASSERT(turns.size() == 10 && turns.first().content == "t3 m0"
+             && turns.last().content == "t4 m4");
+    const QMap<QString, int> byRole = pagingDb.countMessagesByRole("paged");
+    Q_ASSERT(byRole.value("user") == 10 && byRole.value("tool") == 30
+             && byRole.value("assistant") == 10);
+    int streamed = 0;
+    int lastStreamedId = 0;
+    bool streamOrdered = true;
+    MessageCursor toolCursor = pagingDb.streamMessages("paged", "tool");
+    for (MessageRecord rec; toolCursor.next(rec); ++streamed) {
+        streamOrdered = streamOrdered && rec.role == "tool" && rec.id > lastStreamedId;
+        lastStreamedId = rec.id;
+    }
+    Q_ASSERT(streamed == 30 && streamOrdered);
+    Q_ASSERT(pagingDb.lastMessage("paged", "assistant").content == "t10 m4");
+    Q_ASSERT(pagingDb.lastMessage("paged", "thinking").id == 0);
+    const QMap<int, qint64> starts = pagingDb.turnStartTimes("paged");
+    Q_ASSERT(starts.size() == 10 && starts.value(7) == 700);
+    const auto editMessage = [&pagingDb](int turn, const QString &tool, const QString &input) {
+        MessageRecord rec;
+        rec.sessionId = "paged";
+        rec.role = "tool";
+        rec.content = tool;
+        rec.toolName = tool;
+        rec.toolInput = input;
+        rec.turnId = turn;
+        pagingDb.saveMessage(rec);
+    };
+    editMessage(11, "Write", R"({"file_path":"a.txt","content":"x\ny\nz"})");
+    editMessage(11, "Edit", R"({"file_path":"a.txt","old_string":"x","new_string":"x\nq"})");
+    editMessage(12, "StrReplace", R"({"path":"/abs/b","old_string":"1\n2\n3","new_string":""})");
+    editMessage(12, "Write", "not json");
+    editMessage(12, "Write", R"({"path":"","file_path":"ignored"})");
+    editMessage(12, "Read", R"({"file_path":"a.txt"})");
+    const QList<FileEditRecord> edits = pagingDb.loadFileEdits("paged");
+    Q_ASSERT(edits.size() == 3);
+    Q_ASSERT(edits[0].turnId == 11 && edits[0].toolName == "Write"
+             && edits[0].filePath == "a.txt" && edits[0].linesAdded == 3
+             && edits[0].linesRemoved == 0);
+    Q_ASSERT(edits[1].toolName == "Edit" && edits[1].linesAdded == 1
+             && edits[1].linesRemoved == 0);
+    Q_ASSERT(edits[2].turnId == 12 && edits[2].filePath == "/abs/b"
+             && edits[2].linesAdded == 0 && edits[2].linesRemoved == 3);
+    Q_ASSERT(usesIndex(pagingDb,
+                       "SELECT id, session_id, role, content, tool_name, tool_input, turn_id, "
+                       "timestamp FROM messages WHERE session_id = ? AND id < ? "
+                       "ORDER BY id DESC LIMIT ?",
+                       {"paged", 40, 7}, "idx_messages_session"));
+    pagingDb.close();
+    qDebug() << "[PASS] Message paging: keyset pages, turn ranges, role counts, cursor,"
+             << "last message, file edits";
+
+    // ─── History Search ───
+    Database searchDb;
+    const bool searchOpen = searchDb.open(historyDir.filePath("search.db"));
+    Q_ASSERT(searchOpen && searchDb.hasSearch());
+    for (const QString &id : {QString("alpha"), QString("beta"), QString("gamma")}) {
+        SessionInfo info;
+        info.sessionId = id;
+        info.title = "Title " + id;
+        info.workspace = id == "gamma" ? "/elsewhere" : "/search";
+        searchDb.saveSession(info);
+    }
+    const auto searchMessage = [&searchDb](const QString &sessionId, int turn,
+                                           const QString &content,
+                                           const QString &toolInput = {}) {
+        MessageRecord rec;
+        rec.sessionId = sessionId;
+        rec.role = toolInput.isEmpty() ? "assistant" : "tool";
+        rec.content = content;
+        rec.toolName = toolInput.isEmpty() ? QString() : "Edit";
+        rec.toolInput = toolInput;
+        rec.turnId = turn;
+        rec.timestamp = 900 + turn;
+        searchDb.saveMessage(rec);
+    };
+    searchMessage("alpha", 1, "The Fenwick tree keeps row offsets");
+    searchMessage("alpha", 1, "fenwick fenwick fenwick prefix sums");
+    searchMessage("alpha", 2, "unrelated chatter");
+    searchMessage("beta", 4, "a long answer that mentions fenwick once among many other "
+                             "words about layout, scrolling and row heights");
+    searchMessage("beta", 5, "Edit", "{\"file_path\":\"src/util/TranscriptIndex.cpp\"}");
+    searchMessage("gamma", 1, "fenwick in another workspace");
+    searchDb.flush();  // search does not wait for the writer
+
+    // Best match first, one hit per turn, workspace respected
+    const QList<SearchHit> fenwick = searchDb.searchMessages("fenwick", "/search");
+    Q_ASSERT(fenwick.size() == 2);
+    Q_ASSERT(fenwick[0].sessionId == "alpha" && fenwick[0].turnId == 1
+             && fenwick[0].title == "Title alpha" && fenwick[0].timestamp == 901);
+    Q_ASSERT(fenwick[0].snippet.contains(QString(SearchHit::kMatchBegin) + "fenwick"
+                                         + SearchHit::kMatchEnd));
+    Q_ASSERT(fenwick[1].sessionId == "beta" && fenwick[1].turnId == 4);
+    Q_ASSERT(searchDb.searchMessages("fenw").size() == 3);  // typed prefix, all workspaces
+    Q_ASSERT(searchDb.searchMessages("fen").size() == 3);   // through the prefix index
+    Q_ASSERT(searchDb.searchMessages("fe").isEmpty());      // too short for a prefix
+    Q_ASSERT(searchDb.searchMessages("fenwick", {}, 1).size() == 1);
+    const QList<SearchHit> byTool = searchDb.searchMessages("TranscriptIndex", "/search");
+    Q_ASSERT(byTool.size() == 1 && byTool[0].turnId == 5);
+    // Query syntax in the input is searched for, not interpreted
+    Q_ASSERT(searchDb.searchMessages("fenwick NOT tree", "/search").isEmpty());
+    Q_ASSERT(searchDb.searchMessages("\"fenwick (").size() == 3);
+    Q_ASSERT(searchDb.searchMessages("   ").isEmpty());
+    // Deleted chats leave the index with their rows
+    searchDb.deleteSession("beta");
+    searchDb.flush();
+    Q_ASSERT(searchDb.searchMessages("TranscriptIndex").isEmpty());
+    Q_ASSERT(searchDb.searchMessages("fenwick", "/search").size() == 1);
+    // A turn whose matches outrank everything for pages of rows does not
+    // crowd out the other turns
+    searchMessage("alpha", 2, "crowded too, between a few other words");
+    searchMessage("gamma", 2, "crowded elsewhere, between a few other words");
+    for (int i = 0; i < 1100; ++i)
+        searchMessage("alpha", 3, "crowded");
+    searchDb.flush();
+    Q_ASSERT(searchDb.searchMessages("crowded").size() == 3);
+    Q_ASSERT(searchDb.searchMessages("crowded", {}, 2).size() == 2);
+    searchDb.close();
+    // Step 5 applied by a build without FTS5: the next open creates the index
+    {
+        QSqlDatabase noFts = QSqlDatabase::addDatabase("QSQLITE", "search_without_fts");
+        noFts.setDatabaseName(historyDir.filePath("search.db"));
+        noFts.open();
+        QSqlQuery q(noFts);
+        for (const char *drop : {"DROP TRIGGER messages_fts_insert", "DROP TRIGGER messages_fts_delete",
+                                 "DROP TRIGGER messages_fts_update", "DROP TABLE messages_fts"})
+            q.exec(drop);
+        noFts.close();
+    }
+    QSqlDatabase::removeDatabase("search_without_fts");
+    Database refts;
+    const bool reftsOpen = refts.open(historyDir.filePath("search.db"));
+    Q_ASSERT(reftsOpen && refts.hasSearch());
+    // The writer indexes the existing messages in the background; deleting
+    // some before it gets to them leaves the index consistent
+    refts.deleteSession("gamma");
+    while (refts.searchIndexing())
+        QThread::msleep(5);
+    Q_ASSERT(refts.searchMessages("fenwick", "/search").size() == 1);
+    Q_ASSERT(refts.searchMessages("crowded").size() == 2);
+    refts.close();
+    {
+        QSqlDatabase check = QSqlDatabase::addDatabase("QSQLITE", "search_integrity");
+        check.setDatabaseName(historyDir.filePath("search.db"));
+        check.open();
+        QSqlQuery q(check);
+        const bool consistent =
+            q.exec("INSERT INTO messages_fts (messages_fts) VALUES ('integrity-check')");
+        Q_ASSERT(consistent);
+        check.close();
+    }
+    QSqlDatabase::removeDatabase("search_integrity");
+    // Databases from before the index are indexed on upgrade
+    Database legacySearch;
+    const bool legacySearchOpen = legacySearch.open(legacyPath);
+    Q_ASSERT(legacySearchOpen);
+    while (legacySearch.searchIndexing())
+        QThread::msleep(5);
+    const QList<SearchHit> legacyHits = legacySearch.searchMessages("hi");
+    Q_ASSERT(legacyHits.size() == 1 && legacyHits[0].sessionId == "old");
+    legacySearch.close();
+    qDebug() << "[PASS] History search: ranked, one hit per turn, full pages, tool inputs, kept in sync";
+
+    qDebug() << "\n=== ALL 36 TESTS PASSED ===";
     return 0;
 }
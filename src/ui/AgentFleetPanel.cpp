@@ -42,6 +42,8 @@ void AgentCard::update(const AgentSummary &summary)
     m_isOrchestratorRoot = summary.isOrchestratorRoot;
     m_childCount = summary.childCount;
     m_costUsd = summary.costUsd;
+    m_lastTtftMs = summary.lastTtftMs;
+    m_lastTurnMs = summary.lastTurnMs;
     m_updatedAt = summary.updatedAt;
     m_profileIds = summary.profileIds;
     updatePulseAnimation();
@@ -316,8 +318,13 @@ void AgentCard::paintEvent(QPaintEvent *)
             dateStr = "Yesterday " + dt.toString("h:mm AP");
         else
             dateStr = dt.toString("MMM d");
+        if (m_lastTtftMs >= 0)
+            dateStr += QString::fromUtf8(" \xc2\xb7 TTFT %1s").arg(QString::number(m_lastTtftMs / 1000.0, 'f', 1));
+        if (m_lastTurnMs >= 0)
+            dateStr += QString::fromUtf8(" \xc2\xb7 %1s").arg(QString::number(m_lastTurnMs / 1000.0, 'f', 1));
 
-        p.drawText(textX, 42, dateStr);
+        QString elidedDate = p.fontMetrics().elidedText(dateStr, Qt::ElideRight, textRight - textX);
+        p.drawText(textX, 42, elidedDate);
     }
 
     // Unread dot
@@ -452,6 +459,12 @@ AgentFleetPanel::AgentFleetPanel(QWidget *parent)
     m_agentLayout = new QVBoxLayout(m_scrollContent);
     m_agentLayout->setContentsMargins(4, 2, 4, 4);
     m_agentLayout->setSpacing(2);
+
+    m_olderBtn = new QPushButton(m_scrollContent);
+    m_olderBtn->setCursor(Qt::PointingHandCursor);
+    m_olderBtn->hide();
+    connect(m_olderBtn, &QPushButton::clicked, this, &AgentFleetPanel::olderRequested);
+    m_agentLayout->addWidget(m_olderBtn);
     m_agentLayout->addStretch();
 
     m_scrollArea->setWidget(m_scrollContent);
@@ -612,7 +625,7 @@ void AgentFleetPanel::rebuild(const QList<AgentSummary> &agents, const QString &
                     : QStringLiteral("QLabel { color: %1; background: transparent; "
                         "border-top: 1px solid %2; }")
                         .arg(thm.hex("text_muted"), thm.hex("border_subtle")));
-                m_agentLayout->insertWidget(m_agentLayout->count() - 1, divider);
+                m_agentLayout->insertWidget(cardInsertIndex(), divider);
                 m_dividers.append(divider);
                 lastDateGroup = dateGroup;
             }
@@ -649,7 +662,7 @@ void AgentFleetPanel::rebuild(const QList<AgentSummary> &agents, const QString &
         connect(card, &AgentCard::doubleClicked, this, &AgentFleetPanel::exportAndDeleteRequested);
         connect(card, &AgentCard::renameRequested, this, &AgentFleetPanel::renameRequested);
         connect(card, &AgentCard::favoriteToggled, this, &AgentFleetPanel::favoriteToggled);
-        m_agentLayout->insertWidget(m_agentLayout->count() - 1, card);  // before stretch
+        m_agentLayout->insertWidget(cardInsertIndex(), card);
         m_cards[agent.sessionId] = card;
     }
 
@@ -727,6 +740,18 @@ void AgentFleetPanel::ensureVisible(const QString &sessionId)
     }
 }
 
+void AgentFleetPanel::setOlderCount(int count)
+{
+    m_olderBtn->setText(QStringLiteral("Show older chats (%1)").arg(count));
+    m_olderBtn->setVisible(count > 0);
+}
+
+int AgentFleetPanel::cardInsertIndex() const
+{
+    // Cards and dividers go above the "older chats" button and the stretch
+    return m_agentLayout->indexOf(m_olderBtn);
+}
+
 void AgentFleetPanel::clearCards()
 {
     for (auto *card : m_cards)
@@ -765,6 +790,12 @@ void AgentFleetPanel::applyThemeColors()
     m_menuBtn->setStyleSheet(btnStyle);
     m_menuBtn->setText("\u22EF");  // midline horizontal ellipsis
 
+    m_olderBtn->setStyleSheet(QStringLiteral(
+        "QPushButton { background: transparent; color: %1; border: none; "
+        "font-size: 11px; padding: 8px 0; }"
+        "QPushButton:hover { color: %2; }")
+        .arg(thm.hex("text_muted"), thm.hex("text_primary")));
+
     m_actionsMenu->setStyleSheet(QStringLiteral(
         "QMenu { background: %1; border: 1px solid %2; border-radius: 6px; padding: 4px 0; }"
         "QMenu::item { color: %3; padding: 6px 16px; font-size: 12px; }"
@@ -22,6 +22,8 @@ struct AgentSummary {
     int editCount = 0;
     int turnCount = 0;
     double costUsd = 0.0;
+    qint64 lastTtftMs = -1;   // latest turn's time to first token
+    qint64 lastTurnMs = -1;   // latest turn's wall time
     qint64 createdAt = 0;
     qint64 updatedAt = 0;
     QStringList profileIds;
@@ -92,6 +94,8 @@ private:
     bool m_childrenCollapsed = false;
     int m_childCount = 0;
     double m_costUsd = 0.0;
+    qint64 m_lastTtftMs = -1;
+    qint64 m_lastTurnMs = -1;
     qint64 m_updatedAt = 0;
     QStringList m_profileIds;
     QRect m_deleteRect;
@@ -116,6 +120,8 @@ public:
     void rebuild(const QList<AgentSummary> &agents, const QString &selectedId);
     void updateAgent(const AgentSummary &summary);
     void setSelectedAgent(const QString &sessionId);
+    // Stored chats left out of the last rebuild; shows a button to page them in
+    void setOlderCount(int count);
 
 signals:
     void agentSelected(const QString &sessionId);
@@ -127,12 +133,14 @@ signals:
     void deleteAllExceptTodayRequested();
     void renameRequested(const QString &sessionId);
     void favoriteToggled(const QString &sessionId, bool favorite);
+    void olderRequested();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
 
 private:
     void applyThemeColors();
+    int cardInsertIndex() const;
     void clearCards();
     void updateChildVisibility(const QString &rootId, bool visible);
     bool isDescendantOf(const QString &sessionId, const QString &ancestorId) const;
@@ -147,6 +155,7 @@ private:
     QScrollArea *m_scrollArea = nullptr;
     QWidget *m_scrollContent = nullptr;
     QVBoxLayout *m_agentLayout = nullptr;
+    QPushButton *m_olderBtn = nullptr;
 
     QMap<QString, AgentCard *> m_cards;
     QList<QWidget *> m_dividers;
@@ -1,19 +1,19 @@
 #include "ui/ChatMessageWidget.h"
 #include "ui/ThemeManager.h"
+#include "ui/MessageTextView.h"
 #include "util/MarkdownRenderer.h"
+#include "util/RenderCache.h"
 #include <QUrl>
 #include <QUrlQuery>
 #include <QDesktopServices>
 #include <QApplication>
 #include <QClipboard>
-#include <QRegularExpression>
-#include <QResizeEvent>
-#include <QTimer>
 #include <QPixmap>
+#include <QTextBrowser>
 #include <QTextCursor>
-#include <QScrollArea>
-#include <QScrollBar>
-#include <QtMath>
+#include <QTextBlockFormat>
+#include <QTextCharFormat>
+#include <QTextDocument>
 
 ChatMessageWidget::ChatMessageWidget(Role role, const QString &content, QWidget *parent)
     : QFrame(parent)
@@ -180,31 +180,14 @@ void ChatMessageWidget::setImages(const QList<QByteArray> &imageDataList)
     m_layout->insertWidget(0, m_imageContainer);
 }
 
-void ChatMessageWidget::setupAssistantContent(const QString &content)
+void ChatMessageWidget::setupAssistantContent(const QString &)
 {
-    m_contentBrowser = new QTextBrowser(this);
-    m_contentBrowser->setOpenExternalLinks(false);
-    m_contentBrowser->setOpenLinks(false);
-    m_contentBrowser->setFrameShape(QFrame::NoFrame);
-    m_contentBrowser->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_contentBrowser->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_contentBrowser->document()->setDocumentMargin(0);
-    m_contentBrowser->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
-    m_contentBrowser->setTextInteractionFlags(
-        Qt::TextSelectableByMouse | Qt::TextSelectableByKeyboard | Qt::LinksAccessibleByMouse);
-
-    connect(m_contentBrowser->document(), &QTextDocument::contentsChanged,
-            this, &ChatMessageWidget::resizeBrowser);
-
-    if (!content.isEmpty()) {
-        MarkdownRenderer renderer;
-        m_contentBrowser->setHtml(renderer.toHtml(content));
-    } else {
-        m_contentBrowser->setMaximumHeight(0);
-        m_contentBrowser->setMinimumHeight(0);
-    }
+    // Painted straight from its document; the height follows the width, so
+    // there is nothing to resize by hand. Initial content is rendered by
+    // applyThemeColors() from the constructor.
+    m_contentView = new MessageTextView(this);
 
-    connect(m_contentBrowser, &QTextBrowser::anchorClicked, this, [this](const QUrl &url) {
+    connect(m_contentView, &MessageTextView::anchorClicked, this, [this](const QUrl &url) {
         if (url.scheme() == "cccpp" && url.host() == "open") {
             QUrlQuery q(url);
             QString file = q.queryItemValue("file");
@@ -214,122 +197,157 @@ void ChatMessageWidget::setupAssistantContent(const QString &content)
         } else if (url.scheme() == "cccpp" && url.host() == "copy") {
             QUrlQuery q(url);
             int blockIdx = q.queryItemValue("block").toInt();
-            // Extract code from raw content for the given block index
-            QString raw = m_rawContent;
-            const auto &fenced = MarkdownRenderer::fencedCodeRegex();
-            auto it = fenced.globalMatch(raw);
-            int idx = 0;
-            while (it.hasNext()) {
-                auto match = it.next();
-                if (idx == blockIdx) {
-                    QApplication::clipboard()->setText(match.captured(2));
-                    break;
-                }
-                ++idx;
-            }
+            if (blockIdx >= 0 && blockIdx < m_codeBlocks.size())
+                QApplication::clipboard()->setText(m_codeBlocks[blockIdx].code);
         } else if (url.scheme() == "cccpp" && url.host() == "apply") {
             QUrlQuery q(url);
             int blockIdx = q.queryItemValue("block").toInt();
             QString lang = q.queryItemValue("lang");
-            QString raw = m_rawContent;
-            const auto &fenced = MarkdownRenderer::fencedCodeRegex();
-            auto it = fenced.globalMatch(raw);
-            int idx = 0;
-            while (it.hasNext()) {
-                auto match = it.next();
-                if (idx == blockIdx) {
-                    emit applyCodeRequested(match.captured(2), lang);
-                    break;
-                }
-                ++idx;
-            }
+            if (blockIdx >= 0 && blockIdx < m_codeBlocks.size())
+                emit applyCodeRequested(m_codeBlocks[blockIdx].code, lang);
         } else if (url.scheme() == "http" || url.scheme() == "https") {
             QDesktopServices::openUrl(url);
         }
     });
 
-    m_layout->addWidget(m_contentBrowser);
+    m_layout->addWidget(m_contentView);
 }
 
-bool ChatMessageWidget::isInViewport() const
+void ChatMessageWidget::insertDocumentHtml(QTextCursor &cursor, const QString &html)
 {
-    auto *sa = qobject_cast<QScrollArea *>(parentWidget()
-        ? parentWidget()->parentWidget() : nullptr);
-    if (!sa) {
-        // Walk up further — layout nesting may add extra layers
-        QWidget *p = parentWidget();
-        while (p) {
-            sa = qobject_cast<QScrollArea *>(p);
-            if (sa) break;
-            p = p->parentWidget();
+    // insertHtml() merges the fragment's first paragraph into the cursor's
+    // block, so every rendered block gets a fresh one
+    if (cursor.position() > 0)
+        cursor.insertBlock(QTextBlockFormat(), QTextCharFormat());
+    cursor.insertHtml(html);
+}
+
+void ChatMessageWidget::renderMarkdown()
+{
+    if (m_renderPending) {
+        // New text supersedes the worker's result; render it all here
+        MarkdownRenderService::instance().cancel(m_renderId);
+        m_renderPending = false;
+    }
+    m_markdownDirty = false;
+    m_blocks.update(m_rawContent);
+    const auto &closed = m_blocks.closedBlocks();
+
+    MarkdownRenderer renderer;
+    renderer.setHighlightCode(true);
+    QTextCursor cursor(m_contentView->document());
+    cursor.beginEditBlock();
+
+    // Drop the previous tail (and anything appendContentFast() put after it)
+    cursor.setPosition(m_tailDocPos);
+    cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+
+    // Code blocks of the old tail are re-collected below
+    m_codeBlocks.resize(m_closedCodeBlocks);
+    for (int i = m_docClosedBlocks; i < closed.size(); ++i) {
+        if (i == m_blockHtml.size()) {
+            const RenderedMarkdown block = RenderCache::instance().render(
+                renderer, m_rawContent.mid(closed[i].start, closed[i].length),
+                m_closedCodeBlocks);
+            m_blockHtml.append(block.html);
+            m_codeBlocks += block.codeBlocks;
+            m_closedCodeBlocks = m_codeBlocks.size();
         }
+        insertDocumentHtml(cursor, m_blockHtml[i]);
+    }
+    m_docClosedBlocks = closed.size();
+    m_tailDocPos = cursor.position();
+
+    const QString tail = m_blocks.openTail(m_rawContent);
+    QString html;
+    if (!tail.trimmed().isEmpty() && m_settled) {
+        // A finished message's tail won't change again, so it is cached too
+        const RenderedMarkdown rendered =
+            RenderCache::instance().render(renderer, tail, m_closedCodeBlocks);
+        html = rendered.html;
+        m_codeBlocks += rendered.codeBlocks;
+    } else if (!tail.trimmed().isEmpty()) {
+        // A code block being streamed shows as one, not as raw backticks
+        renderer.setRenderOpenFence(true);
+        renderer.setCodeBlockIndexBase(m_closedCodeBlocks);
+        html = renderer.toHtml(tail);
+        m_codeBlocks += renderer.lastCodeBlocks();
     }
-    if (!sa) return true; // no scroll area found — assume visible
-
-    int scrollTop = sa->verticalScrollBar()->value();
-    int scrollBottom = scrollTop + sa->viewport()->height();
-    // Widget position relative to the scroll content widget
-    QPoint pos = mapTo(sa->widget(), QPoint(0, 0));
-    int widgetTop = pos.y();
-    int widgetBottom = widgetTop + height();
-
-    // Include a generous buffer (one viewport height each direction)
-    int buffer = sa->viewport()->height();
-    return widgetBottom >= (scrollTop - buffer) && widgetTop <= (scrollBottom + buffer);
+    html += m_pendingHtmlBlocks.join("");
+    if (!html.isEmpty())
+        insertDocumentHtml(cursor, html);
+
+    cursor.endEditBlock();
 }
 
-void ChatMessageWidget::resizeBrowser()
+// Messages this long that aren't cached yet render on a worker thread
+static constexpr int kAsyncRenderChars = 4000;
+
+ChatMessageWidget::~ChatMessageWidget()
 {
-    if (!m_contentBrowser) return;
-    if (m_resizePending) return;
+    if (m_renderPending)
+        MarkdownRenderService::instance().cancel(m_renderId);
+}
 
-    // Skip expensive QTextDocument re-layout for off-screen widgets
-    if (!isInViewport()) {
-        m_needsResize = true;
+// Full render of the message. A finished one that is long and not in the
+// cache is converted by the render service while its plain text stands in.
+void ChatMessageWidget::renderDocument()
+{
+    auto &service = MarkdownRenderService::instance();
+    const ThemePalette &palette = ThemeManager::instance().palette();
+    MarkdownRenderer renderer(palette);
+    renderer.setHighlightCode(true);
+    if (m_settled && m_pendingHtmlBlocks.isEmpty() && m_rawContent.size() >= kAsyncRenderChars
+        && !service.isCached(m_rawContent, renderer.styleKey())) {
+        m_renderPending = true;
+        m_contentView->document()->setPlainText(m_rawContent);
+        m_docClosedBlocks = 0;
+        m_tailDocPos = 0;
+        service.request(m_renderId, m_rawContent, palette, this, [this] {
+            m_renderPending = false;
+            rebuildDocument();
+        });
         return;
     }
-
-    m_resizePending = true;
-    m_needsResize = false;
-    QTimer::singleShot(0, this, [this] {
-        m_resizePending = false;
-        if (!m_contentBrowser) return;
-        int vpWidth = m_contentBrowser->viewport()->width();
-        if (vpWidth <= 0)
-            vpWidth = m_contentBrowser->width() - 4;
-        if (vpWidth <= 0) {
-            QTimer::singleShot(50, this, [this] { resizeBrowser(); });
-            return;
-        }
-        m_contentBrowser->document()->setTextWidth(vpWidth);
-        int h = qCeil(m_contentBrowser->document()->size().height()) + 2;
-        m_contentBrowser->setMinimumHeight(qMax(h, 14));
-        m_contentBrowser->setMaximumHeight(qMax(h, 14));
-    });
+    if (m_renderPending) {
+        service.cancel(m_renderId);
+        m_renderPending = false;
+    }
+    rebuildDocument();
 }
 
-void ChatMessageWidget::resizeEvent(QResizeEvent *event)
+void ChatMessageWidget::rebuildDocument()
 {
-    QFrame::resizeEvent(event);
-    resizeBrowser();
+    m_contentView->document()->clear();
+    m_docClosedBlocks = 0;
+    m_tailDocPos = 0;
+    renderMarkdown();
 }
 
-void ChatMessageWidget::paintEvent(QPaintEvent *event)
+void ChatMessageWidget::setContent(const QString &content)
 {
-    if (m_needsResize)
-        resizeBrowser();
-    QFrame::paintEvent(event);
+    m_rawContent = content;
+    m_settled = true;
+    m_pendingHtmlBlocks.clear();
+    m_markdownDirty = false;
+    if (m_contentView) {
+        m_blocks.reset();
+        m_blockHtml.clear();
+        m_codeBlocks.clear();
+        m_closedCodeBlocks = 0;
+        renderDocument();
+    } else if (m_userLabel) {
+        m_userLabel->setText(content);
+    }
 }
 
 void ChatMessageWidget::appendContent(const QString &text)
 {
     m_rawContent += text;
-    if (m_contentBrowser) {
-        MarkdownRenderer renderer;
-        QString html = renderer.toHtml(m_rawContent);
-        if (!m_pendingHtmlBlocks.isEmpty())
-            html += m_pendingHtmlBlocks.join("");
-        m_contentBrowser->setHtml(html);
+    m_settled = false;
+    if (m_contentView) {
+        renderMarkdown();
     } else if (m_userLabel) {
         m_userLabel->setText(m_rawContent);
     }
@@ -338,14 +356,18 @@ void ChatMessageWidget::appendContent(const QString &text)
 void ChatMessageWidget::appendContentFast(const QString &text)
 {
     m_rawContent += text;
+    m_settled = false;
     m_markdownDirty = true;
 
-    if (m_contentBrowser) {
+    if (m_contentView) {
         QString escaped = text.toHtmlEscaped();
         escaped.replace('\n', "<br>");
 
-        QTextCursor cursor(m_contentBrowser->document());
+        QTextCursor cursor(m_contentView->document());
         cursor.movePosition(QTextCursor::End);
+        // Raw text lands in the tail; keep it off the last closed block's line
+        if (cursor.position() == m_tailDocPos && m_tailDocPos > 0)
+            cursor.insertBlock(QTextBlockFormat(), QTextCharFormat());
         cursor.insertHtml(escaped);
     } else if (m_userLabel) {
         m_userLabel->setText(m_rawContent);
@@ -354,14 +376,8 @@ void ChatMessageWidget::appendContentFast(const QString &text)
 
 void ChatMessageWidget::syncMarkdown()
 {
-    if (!m_markdownDirty || !m_contentBrowser) return;
-    m_markdownDirty = false;
-
-    MarkdownRenderer renderer;
-    QString html = renderer.toHtml(m_rawContent);
-    if (!m_pendingHtmlBlocks.isEmpty())
-        html += m_pendingHtmlBlocks.join("");
-    m_contentBrowser->setHtml(html);
+    if (!m_markdownDirty || !m_contentView) return;
+    renderMarkdown();
 }
 
 void ChatMessageWidget::finalizeContent()
@@ -373,22 +389,21 @@ void ChatMessageWidget::appendRawHtml(const QString &html, const QString &plainS
 {
     m_rawContent += plainSummary;
     m_pendingHtmlBlocks.append(html);
-    if (m_contentBrowser) {
-        MarkdownRenderer renderer;
-        QString rendered = renderer.toHtml(m_rawContent);
-        rendered += m_pendingHtmlBlocks.join("");
-        m_contentBrowser->setHtml(rendered);
-    }
+    if (m_contentView)
+        renderMarkdown();
 }
 
 void ChatMessageWidget::appendHtmlOnly(const QString &html, const QString &plainTextForStorage)
 {
     // Append plain text to rawContent (for DB storage) but render with extra HTML
     m_rawContent += plainTextForStorage;
-    if (m_contentBrowser) {
-        MarkdownRenderer renderer;
-        // Render the markdown portion, then append raw HTML
-        m_contentBrowser->setHtml(renderer.toHtml(m_rawContent) + html);
+    if (m_contentView) {
+        // Render the markdown portion, then append raw HTML to the tail (the
+        // next render replaces it, as before)
+        renderMarkdown();
+        QTextCursor cursor(m_contentView->document());
+        cursor.movePosition(QTextCursor::End);
+        insertDocumentHtml(cursor, html);
     }
 }
 
@@ -403,7 +418,7 @@ void ChatMessageWidget::setToolInfo(const QString &toolName, const QString &summ
 
 void ChatMessageWidget::setupToolWidget(const QString &, const QString &summary)
 {
-    if (m_contentBrowser) m_contentBrowser->setVisible(false);
+    if (m_contentView) m_contentView->setVisible(false);
     if (m_userLabel) m_userLabel->setVisible(false);
 
     auto *summaryLayout = new QHBoxLayout;
@@ -553,11 +568,11 @@ void ChatMessageWidget::applyThemeColors()
             .arg(tm.hex("bg_raised"), tm.hex("text_muted"),
                  tm.hex("hover_raised"), tm.hex("text_primary")));
 
-    if (m_contentBrowser && !m_rawContent.isEmpty()) {
-        MarkdownRenderer renderer;
-        QString html = renderer.toHtml(m_rawContent);
-        if (!m_pendingHtmlBlocks.isEmpty())
-            html += m_pendingHtmlBlocks.join("");
-        m_contentBrowser->setHtml(html);
+    if (m_contentView && !m_rawContent.isEmpty()) {
+        // Colors are baked into the HTML: re-render every block
+        m_blockHtml.clear();
+        m_codeBlocks.clear();
+        m_closedCodeBlocks = 0;
+        renderDocument();
     }
 }
@@ -2,12 +2,17 @@
 
 #include <QFrame>
 #include <QLabel>
-#include <QTextBrowser>
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QStringList>
 #include <QDateTime>
+#include "util/MarkdownBlocks.h"
+#include "util/MarkdownRenderer.h"
+#include "util/MarkdownRenderService.h"
+
+class QTextCursor;
+class MessageTextView;
 
 class ChatMessageWidget : public QFrame {
     Q_OBJECT
@@ -16,13 +21,14 @@ public:
 
     explicit ChatMessageWidget(Role role, const QString &content,
                                QWidget *parent = nullptr);
+    ~ChatMessageWidget() override;
 
+    // Replaces the text of a finished message; lets TranscriptView reuse widgets
+    void setContent(const QString &content);
     void appendContent(const QString &text);
     void appendContentFast(const QString &text);
     void syncMarkdown();
     void finalizeContent();
-    bool needsResize() const { return m_needsResize; }
-    void flushDeferredResize() { if (m_needsResize) resizeBrowser(); }
     void appendRawHtml(const QString &html, const QString &plainSummary);
     void appendHtmlOnly(const QString &html, const QString &plainTextForStorage);
     void setToolInfo(const QString &toolName, const QString &summary);
@@ -43,23 +49,21 @@ signals:
     void fileNavigationRequested(const QString &filePath, int line);
     void applyCodeRequested(const QString &code, const QString &language);
 
-protected:
-    void resizeEvent(QResizeEvent *event) override;
-    void paintEvent(QPaintEvent *event) override;
-
 private:
     void applyStyle();
     void applyThemeColors();
     void setupAssistantContent(const QString &content);
     void setupToolWidget(const QString &toolName, const QString &summary);
-    void resizeBrowser();
-    bool isInViewport() const;
+    void renderMarkdown();
+    void renderDocument();
+    void rebuildDocument();
+    void insertDocumentHtml(QTextCursor &cursor, const QString &html);
 
     Role m_role;
     int m_turnId = 0;
     QLabel *m_roleLabel = nullptr;
     QLabel *m_userLabel = nullptr;
-    QTextBrowser *m_contentBrowser = nullptr;
+    MessageTextView *m_contentView = nullptr;
     QWidget *m_headerWidget = nullptr;
     QWidget *m_toolDetailWidget = nullptr;
     QPushButton *m_revertBtn = nullptr;
@@ -71,8 +75,17 @@ private:
     QLabel *m_timestampLabel = nullptr;
     QString m_rawContent;
     QStringList m_pendingHtmlBlocks;
+    // Incremental rendering: closed blocks are rendered once and appended to
+    // the document; only the open tail after m_tailDocPos is ever replaced
+    MarkdownBlockSplitter m_blocks;
+    QStringList m_blockHtml;        // cached HTML per closed block
+    QList<CodeBlockInfo> m_codeBlocks; // Copy/Apply targets: closed blocks, then the tail's
+    int m_closedCodeBlocks = 0;     // fenced blocks inside m_blockHtml
+    int m_docClosedBlocks = 0;      // closed blocks present in the document
+    int m_tailDocPos = 0;           // document position where the tail starts
+    bool m_settled = false;         // set by setContent(); tail HTML is cacheable
+    bool m_renderPending = false;   // placeholder shown, render service working
+    quint64 m_renderId = MarkdownRenderService::nextId();
     bool m_isCollapsed = true;
-    bool m_resizePending = false;
     bool m_markdownDirty = false;
-    bool m_needsResize = false;
 };
@@ -11,6 +11,9 @@
 #include "ui/ThinkingBlockWidget.h"
 #include "ui/QuestionWidget.h"
 #include "ui/SuggestionChips.h"
+#include "ui/TranscriptView.h"
+#include "ui/FrameScheduler.h"
+#include "ui/HistorySearchWidget.h"
 #include "ui/ThemeManager.h"
 #include "ui/CodeViewer.h"
 #include "core/ClaudeProcess.h"
@@ -19,6 +22,7 @@
 #include "core/DiffEngine.h"
 #include "core/Database.h"
 #include "util/JsonUtils.h"
+#include "util/Config.h"
 #include <algorithm>
 #include <QLabel>
 #include <QScrollBar>
@@ -172,6 +176,13 @@ ChatPanel::ChatPanel(QWidget *parent)
     m_scrollDebounce->setSingleShot(true);
     m_scrollDebounce->setInterval(100);
 
+    // Streaming output of every tab is applied from one display-paced frame
+    m_frames = new FrameScheduler(this, this);
+    connect(m_frames, &FrameScheduler::frame, this, &ChatPanel::runUiFrame);
+    m_markdownDue = new QTimer(this);
+    m_markdownDue->setSingleShot(true);
+    connect(m_markdownDue, &QTimer::timeout, m_frames, &FrameScheduler::requestFrame);
+
     m_tabWidget = new QTabWidget(this);
     m_tabWidget->setTabsClosable(true);
     m_tabWidget->setDocumentMode(true);
@@ -273,8 +284,16 @@ ChatPanel::ChatPanel(QWidget *parent)
         dlg.exec();
     });
     connect(m_tabWidget, &QTabWidget::currentChanged, this, [this](int idx) {
+        // Only the shown tab renders its stream; the others just record it
+        for (auto it = m_tabs.begin(); it != m_tabs.end(); ++it) {
+            if (it.key() == idx)
+                leaveBackground(it.value());
+            else if (it->processing)
+                enterBackground(it.value());
+        }
         refreshInputBarForCurrentTab();
         updateStatsLabel();
+        m_frames->requestFrame();
         if (m_tabs.contains(idx)) {
             m_tabs[idx].unread = false;
             emit activeSessionChanged(m_tabs[idx].sessionId);
@@ -288,6 +307,8 @@ ChatPanel::ChatPanel(QWidget *parent)
     });
     connect(m_tabWidget, &QTabWidget::tabCloseRequested, this, [this](int idx) {
         if (m_tabs.size() <= 1) return;
+        if (m_tabs[idx].process)
+            m_tabs[idx].process->stopPersistentProcess();
         m_tabs.remove(idx);
         m_tabWidget->removeTab(idx);
         QMap<int, ChatTab> reindexed;
@@ -379,19 +400,12 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             t->currentToolGroup = nullptr;
         }
 
-        if (!t->currentAssistantMsg) {
-            t->currentAssistantMsg = new ChatMessageWidget(ChatMessageWidget::Assistant, "");
-            t->currentAssistantMsg->setTurnId(t->turnId);
-            t->currentAssistantMsg->setTimestamp(QDateTime::currentDateTime());
-            if (!t->hasFirstAssistantMsg)
-                t->hasFirstAssistantMsg = true;
-            else
-                t->currentAssistantMsg->setHeaderVisible(false);
-            addMessageToTab(*t, t->currentAssistantMsg);
-        }
         t->pendingText += text;
         t->accumulatedRawContent += text;
-        // appendContent is batched by textFlushTimer; no direct call here
+        if (t->background) return;
+        ensureAssistantMessage(*t);
+        // Applied by the next UI frame; no direct appendContent here
+        m_frames->requestFrame();
     });
 
     connect(proc->streamParser(), &StreamParser::thinkingStarted, this,
@@ -399,6 +413,7 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
         auto *t = tabForProcess(proc);
         if (!t) return;
         flushPendingText(*t);
+        flushPendingThinking(*t);
         saveCurrentTextSegment(*t);
         if (t->currentAssistantMsg)
             t->currentAssistantMsg->finalizeContent();
@@ -407,9 +422,10 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             t->currentToolGroup->finalize();
             t->currentToolGroup = nullptr;
         }
+        t->thinkingOpen = true;
+        if (t->background) return;
         t->currentThinkingBlock = new ThinkingBlockWidget;
-        if (t->messagesLayout)
-            t->messagesLayout->insertWidget(insertPosForTab(*t), t->currentThinkingBlock);
+        insertTurnWidget(*t, t->currentThinkingBlock);
         scrollTabToBottom(*t);
     });
 
@@ -417,28 +433,16 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             [this, proc](const QString &text) {
         auto *t = tabForProcess(proc);
         if (!t) return;
-        if (t->currentThinkingBlock)
-            t->currentThinkingBlock->appendContent(text);
-        scrollTabToBottom(*t);
+        t->pendingThinking += text;
+        if (!t->background)
+            m_frames->requestFrame();
     });
 
     connect(proc->streamParser(), &StreamParser::thinkingStopped, this,
             [this, proc] {
         auto *t = tabForProcess(proc);
         if (!t) return;
-        if (t->currentThinkingBlock) {
-            t->currentThinkingBlock->finalize();
-            if (m_database) {
-                MessageRecord rec;
-                rec.sessionId = t->sessionId;
-                rec.role = "thinking";
-                rec.content = t->currentThinkingBlock->rawContent();
-                rec.turnId = t->turnId;
-                rec.timestamp = QDateTime::currentSecsSinceEpoch();
-                m_database->saveMessage(rec);
-            }
-            t->currentThinkingBlock = nullptr;
-        }
+        finishThinkingBlock(*t);
     });
 
     connect(proc->streamParser(), &StreamParser::editStreamStarted, this,
@@ -543,13 +547,14 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
         }
 
         if (name == "AskUserQuestion") {
+            // Needs an answer, so a hidden tab renders again right away
+            leaveBackground(*t);
             if (t->currentToolGroup) {
                 t->currentToolGroup->finalize();
                 t->currentToolGroup = nullptr;
             }
             auto *questionWidget = new QuestionWidget(input);
-            if (t->messagesLayout)
-                t->messagesLayout->insertWidget(insertPosForTab(*t), questionWidget);
+            insertTurnWidget(*t, questionWidget);
             t->hasPendingQuestion = true;
             refreshInputBarForCurrentTab();
             connect(questionWidget, &QuestionWidget::answered, this,
@@ -588,6 +593,8 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
                 }
             });
             scrollTabToBottom(*t);
+        } else if (t->background) {
+            // Recorded below and rendered when the tab is shown
         } else if (isEditTool) {
             if (t->currentToolGroup) {
                 t->currentToolGroup->finalize();
@@ -595,8 +602,7 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             }
             auto *editGroup = new ToolCallGroupWidget;
             connect(editGroup, &ToolCallGroupWidget::fileClicked, this, &ChatPanel::onToolFileClicked);
-            if (t->messagesLayout)
-                t->messagesLayout->insertWidget(insertPosForTab(*t), editGroup);
+            insertTurnWidget(*t, editGroup);
             editGroup->addToolCall(info);
             editGroup->finalize();
             editGroup->setExpandedByDefault();
@@ -604,24 +610,21 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             if (!t->currentToolGroup) {
                 t->currentToolGroup = new ToolCallGroupWidget;
                 connect(t->currentToolGroup, &ToolCallGroupWidget::fileClicked, this, &ChatPanel::onToolFileClicked);
-                if (t->messagesLayout)
-                    t->messagesLayout->insertWidget(insertPosForTab(*t), t->currentToolGroup);
+                insertTurnWidget(*t, t->currentToolGroup);
             }
             t->currentToolGroup->addToolCall(info);
         }
         scrollTabToBottom(*t);
 
-        if (m_database) {
-            MessageRecord rec;
-            rec.sessionId = t->sessionId;
-            rec.role = "tool";
-            rec.content = info.summary;
-            rec.toolName = name;
-            rec.toolInput = QString::fromStdString(input.dump());
-            rec.turnId = t->turnId;
-            rec.timestamp = QDateTime::currentSecsSinceEpoch();
-            m_database->saveMessage(rec);
-        }
+        MessageRecord rec;
+        rec.sessionId = t->sessionId;
+        rec.role = "tool";
+        rec.content = info.summary;
+        rec.toolName = name;
+        rec.toolInput = QString::fromStdString(input.dump());
+        rec.turnId = t->turnId;
+        rec.timestamp = QDateTime::currentSecsSinceEpoch();
+        recordMessage(*t, rec);
     });
 
     // Forward MCP orchestrator tool calls to the Orchestrator
@@ -664,19 +667,49 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             emit sessionListChanged();
         }
         // Extract context usage from result event
+        double costUsd = 0.0;
+        qint64 inputTokens = 0, outputTokens = 0;
         if (raw.contains("usage") && raw["usage"].is_object()) {
             auto &u = raw["usage"];
-            t->totalInputTokens += u.value("input_tokens", 0);
-            t->totalOutputTokens += u.value("output_tokens", 0);
+            inputTokens = u.value("input_tokens", 0);
+            outputTokens = u.value("output_tokens", 0);
+            t->totalInputTokens += inputTokens;
+            t->totalOutputTokens += outputTokens;
             t->totalCacheReadTokens += u.value("cache_read_input_tokens", 0);
         }
-        if (raw.contains("total_cost_usd") && raw["total_cost_usd"].is_number())
-            t->totalCostUsd += raw["total_cost_usd"].get<double>();
+        if (raw.contains("total_cost_usd") && raw["total_cost_usd"].is_number()) {
+            costUsd = raw["total_cost_usd"].get<double>();
+            t->totalCostUsd += costUsd;
+        }
+        if (m_database)
+            m_database->addSessionUsage(t->sessionId, costUsd, inputTokens, outputTokens);
+        updateStatsLabel();
+    });
+
+    connect(proc, &ClaudeProcess::turnMetricsReady, this,
+            [this, proc](const TurnMetrics &metrics) {
+        auto *t = tabForProcess(proc);
+        if (!t) return;
+        t->lastTurnMetrics = metrics;
+        if (metrics.ttftMs >= 0) {
+            t->ttftSumMs += metrics.ttftMs;
+            ++t->ttftTurns;
+        }
+        if (m_database) {
+            TurnMetricsRecord rec;
+            rec.sessionId = t->sessionId;
+            rec.turnId = t->turnId;
+            rec.model = proc->model();
+            rec.mode = proc->mode();
+            rec.metrics = metrics;
+            rec.timestamp = QDateTime::currentSecsSinceEpoch();
+            m_database->saveTurnMetrics(rec);
+        }
         updateStatsLabel();
     });
 
     connect(proc, &ClaudeProcess::finished, this, [this, proc](int exitCode) {
-        qDebug() << "[cccpp] ChatPanel received finished(" << exitCode << ")";
+        qCDebug(lcProcess) << "[cccpp] ChatPanel received finished(" << exitCode << ")";
         auto *t = tabForProcess(proc);
         if (!t) {
             qWarning() << "[cccpp] finished: tabForProcess returned null! Processing state will NOT be cleared.";
@@ -687,11 +720,8 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
                              || exitCode == 143 || exitCode == 137);
 
         flushPendingText(*t);
-
-        if (t->currentThinkingBlock) {
-            t->currentThinkingBlock->finalize();
-            t->currentThinkingBlock = nullptr;
-        }
+        if (t->currentThinkingBlock || t->thinkingOpen)
+            finishThinkingBlock(*t);
 
         if (t->currentToolGroup) {
             t->currentToolGroup->finalize();
@@ -699,38 +729,21 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
         }
 
         if (wasCancelled) {
-            if (!t->currentAssistantMsg) {
-                t->currentAssistantMsg = new ChatMessageWidget(ChatMessageWidget::Assistant, "");
-                t->currentAssistantMsg->setTurnId(t->turnId);
-                t->currentAssistantMsg->setTimestamp(QDateTime::currentDateTime());
-                if (!t->hasFirstAssistantMsg)
-                    t->hasFirstAssistantMsg = true;
-                else
-                    t->currentAssistantMsg->setHeaderVisible(false);
-                addMessageToTab(*t, t->currentAssistantMsg);
-            }
-            t->currentAssistantMsg->appendContent("\n\n*\\[Stopped by user\\]*");
+            appendAssistantText(*t, "\n\n*\\[Stopped by user\\]*");
             t->accumulatedRawContent += "\n\n*[Stopped by user]*";
         } else if (t->accumulatedRawContent.isEmpty() && exitCode != 0) {
-            if (!t->currentAssistantMsg) {
-                t->currentAssistantMsg = new ChatMessageWidget(ChatMessageWidget::Assistant, "");
-                t->currentAssistantMsg->setTurnId(t->turnId);
-                t->currentAssistantMsg->setTimestamp(QDateTime::currentDateTime());
-                if (!t->hasFirstAssistantMsg)
-                    t->hasFirstAssistantMsg = true;
-                else
-                    t->currentAssistantMsg->setHeaderVisible(false);
-                addMessageToTab(*t, t->currentAssistantMsg);
-            }
-            t->currentAssistantMsg->appendContent(
+            appendAssistantText(*t,
                 QStringLiteral("*(Process exited with code %1)*").arg(exitCode));
             t->accumulatedRawContent += QStringLiteral("*(Process exited with code %1)*").arg(exitCode);
         }
 
         saveCurrentTextSegment(*t);
 
-        showSuggestionChips(*t, t->accumulatedRawContent);
-        showAcceptAllButton(*t);
+        // Transient hints are only worth building for a tab on screen
+        if (!t->background) {
+            showSuggestionChips(*t, t->accumulatedRawContent);
+            showAcceptAllButton(*t);
+        }
         if (t->currentAssistantMsg)
             t->currentAssistantMsg->finalizeContent();
         t->currentAssistantMsg = nullptr;
@@ -746,8 +759,11 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
                     break;
                 }
             }
+            if (t->transcript)
+                t->transcript->addCheckpointTurn(t->turnId);
         }
         setTabProcessingState(*t, false);
+        archiveSettledTurns(*t);
         scrollTabToBottom(*t);
     });
 
@@ -758,9 +774,8 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
             qWarning() << "[cccpp] errorOccurred: tabForProcess returned null!";
             return;
         }
-        if (t->currentAssistantMsg)
-            t->currentAssistantMsg->appendContent(
-                QStringLiteral("\n\n**Error:** %1").arg(err));
+        if (t->currentAssistantMsg || (t->background && !t->pendingText.isEmpty()))
+            appendAssistantText(*t, QStringLiteral("\n\n**Error:** %1").arg(err));
         setTabProcessingState(*t, false);
     });
 
@@ -769,32 +784,9 @@ void ChatPanel::wireProcessSignals(ChatTab &tab)
         qWarning() << "[cccpp] StreamParser errorOccurred:" << err;
         auto *t = tabForProcess(proc);
         if (!t) return;
-        if (t->currentAssistantMsg)
-            t->currentAssistantMsg->appendContent(
-                QStringLiteral("\n\n**Stream error:** %1").arg(err));
+        if (t->currentAssistantMsg || (t->background && !t->pendingText.isEmpty()))
+            appendAssistantText(*t, QStringLiteral("\n\n**Stream error:** %1").arg(err));
     });
-
-    // Throttled text flusher: batches appendContent calls to ~30fps so
-    // the main thread stays responsive for splitter drag events.
-    auto *flushTimer = new QTimer(this);
-    flushTimer->setInterval(33);
-    flushTimer->setSingleShot(false);
-    connect(flushTimer, &QTimer::timeout, this, [this, proc] {
-        auto *t = tabForProcess(proc);
-        if (t) flushPendingText(*t);
-    });
-    tab.textFlushTimer = flushTimer;
-
-    // Slow-tier markdown sync: full re-render every 500ms for proper formatting
-    auto *syncTimer = new QTimer(this);
-    syncTimer->setInterval(500);
-    syncTimer->setSingleShot(false);
-    connect(syncTimer, &QTimer::timeout, this, [this, proc] {
-        auto *t = tabForProcess(proc);
-        if (t && t->currentAssistantMsg)
-            t->currentAssistantMsg->syncMarkdown();
-    });
-    tab.markdownSyncTimer = syncTimer;
 }
 
 QString ChatPanel::newChat()
@@ -810,9 +802,19 @@ QString ChatPanel::newChat()
     tab.container = createChatContent();
     tab.scrollArea = tab.container->findChild<QScrollArea *>();
     tab.messagesLayout = tab.scrollArea->widget()->findChild<QVBoxLayout *>("messagesLayout");
+    tab.transcript = tab.scrollArea->widget()->findChild<TranscriptView *>();
 
     tab.process = new ClaudeProcess(this);
+    tab.process->setPersistent(Config::instance().persistentSessions());
     tab.process->setWorkingDirectory(m_workingDir);
+    if (!m_workingDir.isEmpty()) {
+        // Park a process with the settings the first message will use
+        tab.process->setMode(m_modeSelector->currentMode());
+        tab.process->setModel(m_modelSelector->currentModelId());
+        tab.process->setSystemPrompt(ProfileManager::instance().buildSystemPrompt(
+            m_workingDir, tab.profileIds));
+        tab.process->prewarm();
+    }
 
     auto *scrollContent = tab.scrollArea->widget();
 
@@ -841,18 +843,7 @@ QString ChatPanel::newChat()
         if (!m_tabs.contains(idx)) return;
         auto &t = m_tabs[idx];
         if (!t.messagesLayout || !t.scrollArea) return;
-        int viewportTop = t.scrollArea->verticalScrollBar()->value();
-        int threshold = t.scrollArea->viewport()->height() / 3;
-        int bestTurnId = -1;
-        for (int i = 0; i < t.messagesLayout->count(); ++i) {
-            auto *item = t.messagesLayout->itemAt(i);
-            if (!item || !item->widget()) continue;
-            auto *chatMsg = qobject_cast<ChatMessageWidget *>(item->widget());
-            if (!chatMsg || chatMsg->turnId() <= 0) continue;
-            int widgetTop = chatMsg->mapTo(t.scrollArea->widget(), QPoint(0, 0)).y();
-            if (widgetTop <= viewportTop + threshold)
-                bestTurnId = chatMsg->turnId();
-        }
+        int bestTurnId = visibleTurnForTab(t);
         if (bestTurnId > 0)
             emit visibleTurnChanged(t.sessionId, bestTurnId);
     });
@@ -868,6 +859,8 @@ void ChatPanel::closeAllTabs()
     for (auto it = m_tabs.begin(); it != m_tabs.end(); ++it) {
         if (it->process && it->process->isRunning())
             it->process->cancel();
+        if (it->process)
+            it->process->stopPersistentProcess();
     }
 
     // Remove all tabs
@@ -878,160 +871,92 @@ void ChatPanel::closeAllTabs()
 }
 
 // ---------------------------------------------------------------------------
-// renderMessageRange — create widgets for allMessages[startIndex..endIndex)
-// Returns the layout insert position after the last widget added.
+// archiveSettledTurns — hand all but the newest turns to the transcript view
+// so long live sessions don't keep a widget per message
 // ---------------------------------------------------------------------------
-int ChatPanel::renderMessageRange(ChatTab &tab, int startIndex, int endIndex, int insertPos)
+void ChatPanel::archiveSettledTurns(ChatTab &tab)
 {
-    ToolCallGroupWidget *pendingGroup = nullptr;
-    bool firstAssistantInTurn = true;
-    int currentTurn = -1;
-    int pos = insertPos;
-
-    auto flushGroup = [&] {
-        if (pendingGroup) {
-            pendingGroup->finalize();
-            pendingGroup = nullptr;
-        }
-    };
+    static constexpr int kLiveTurnCount = 3;
+    if (!tab.transcript || !tab.messagesLayout) return;
+    if (tab.processing || tab.hasPendingQuestion) return;
 
-    for (int mi = startIndex; mi < endIndex; ++mi) {
-        const auto &msg = tab.allMessages[mi];
-        int turnId = msg.turnId;
-
-        if (turnId != currentTurn) {
-            flushGroup();
-            firstAssistantInTurn = true;
-            currentTurn = turnId;
-        }
-
-        if (msg.role == "user" && !msg.content.trimmed().isEmpty()) {
-            flushGroup();
-            auto *w = new ChatMessageWidget(ChatMessageWidget::User, msg.content);
-            w->setTurnId(turnId);
-            if (msg.timestamp > 0)
-                w->setTimestamp(QDateTime::fromSecsSinceEpoch(msg.timestamp));
-            w->showRevertButton(tab.checkpointTurnIds.contains(turnId));
-            tab.messagesLayout->insertWidget(pos++, w);
-            connect(w, &ChatMessageWidget::revertRequested, this, &ChatPanel::onRevertRequested);
-
-        } else if (msg.role == "thinking" && !msg.content.trimmed().isEmpty()) {
-            flushGroup();
-            auto *tb = new ThinkingBlockWidget;
-            tb->appendContent(msg.content);
-            tb->finalize();
-            tab.messagesLayout->insertWidget(pos++, tb);
-
-        } else if (msg.role == "assistant" && !msg.content.trimmed().isEmpty()) {
-            flushGroup();
-            auto *w = new ChatMessageWidget(ChatMessageWidget::Assistant, msg.content);
-            w->setTurnId(turnId);
-            if (msg.timestamp > 0)
-                w->setTimestamp(QDateTime::fromSecsSinceEpoch(msg.timestamp));
-            if (!firstAssistantInTurn)
-                w->setHeaderVisible(false);
-            firstAssistantInTurn = false;
-            tab.messagesLayout->insertWidget(pos++, w);
-            connect(w, &ChatMessageWidget::fileNavigationRequested,
-                    this, [this](const QString &fp, int line) { emit navigateToFile(fp, line); });
-            connect(w, &ChatMessageWidget::applyCodeRequested,
-                    this, [this](const QString &code, const QString &lang) {
-                emit applyCodeRequested(code, lang, "");
-            });
+    QList<int> turns;
+    for (const auto &rec : tab.liveRecords) {
+        if (turns.isEmpty() || turns.last() != rec.turnId)
+            turns.append(rec.turnId);
+    }
+    if (turns.size() <= kLiveTurnCount) return;
+    const int keepFrom = turns[turns.size() - kLiveTurnCount];
 
-        } else if (msg.role == "tool") {
-            ToolCallInfo info;
-            info.toolName = msg.toolName;
-            info.summary = msg.content;
-
-            if (!msg.toolInput.isEmpty()) {
-                auto parsed = nlohmann::json::parse(
-                    msg.toolInput.toStdString(), nullptr, false);
-                if (!parsed.is_discarded()) {
-                    if (parsed.contains("path"))
-                        info.filePath = JsonUtils::getString(parsed, "path");
-                    else if (parsed.contains("file_path"))
-                        info.filePath = JsonUtils::getString(parsed, "file_path");
-
-                    if ((msg.toolName == "Edit" || msg.toolName == "StrReplace")
-                        && parsed.contains("old_string")) {
-                        info.isEdit = true;
-                        info.oldString = JsonUtils::getString(parsed, "old_string");
-                        info.newString = JsonUtils::getString(parsed, "new_string");
-                    } else if (msg.toolName == "Write") {
-                        info.isEdit = true;
-                        info.newString = JsonUtils::getString(parsed, "content",
-                                         JsonUtils::getString(parsed, "contents"));
-                    }
-                }
-            }
+    int split = 0;
+    while (split < tab.liveRecords.size() && tab.liveRecords[split].turnId < keepFrom)
+        ++split;
+    tab.transcript->appendMessages(tab.liveRecords.mid(0, split));
+    tab.liveRecords.remove(0, split);
 
-            if (info.isEdit) {
-                flushGroup();
-                auto *editGroup = new ToolCallGroupWidget;
-                connect(editGroup, &ToolCallGroupWidget::fileClicked, this, &ChatPanel::onToolFileClicked);
-                editGroup->addToolCall(info);
-                editGroup->finalize();
-                editGroup->setExpandedByDefault();
-                tab.messagesLayout->insertWidget(pos++, editGroup);
-            } else {
-                if (!pendingGroup) {
-                    pendingGroup = new ToolCallGroupWidget;
-                    connect(pendingGroup, &ToolCallGroupWidget::fileClicked, this, &ChatPanel::onToolFileClicked);
-                    tab.messagesLayout->insertWidget(pos++, pendingGroup);
-                }
-                pendingGroup->addToolCall(info);
-            }
+    // Chips and buttons of those turns go with them, as in a restored session
+    for (int i = tab.messagesLayout->count() - 1; i >= 0; --i) {
+        QWidget *w = tab.messagesLayout->itemAt(i)->widget();
+        if (!w) continue;
+        const QVariant turn = w->property("turnId");
+        if (turn.isValid() && turn.toInt() < keepFrom) {
+            if (w == tab.suggestionChips)
+                tab.suggestionChips = nullptr;
+            tab.messagesLayout->removeWidget(w);
+            w->deleteLater();
         }
     }
-    flushGroup();
-    return pos;
 }
 
 // ---------------------------------------------------------------------------
-// loadOlderMessages — prepend a batch of older messages, preserving scroll pos
+// visibleTurnForTab — turn of the last message starting above the upper third
+// of the viewport
 // ---------------------------------------------------------------------------
-void ChatPanel::loadOlderMessages(ChatTab &tab, int count)
+int ChatPanel::visibleTurnForTab(const ChatTab &t) const
 {
-    if (tab.lazyRenderIndex <= 0) return;
-    if (tab.lazyLoadingInProgress) return;
-    tab.lazyLoadingInProgress = true;
-
-    int endIndex = tab.lazyRenderIndex;
-    int startIndex = qMax(0, endIndex - count);
-
-    // Align backward to a turn boundary so we don't split a turn
-    if (startIndex > 0) {
-        int turnAtStart = tab.allMessages[startIndex].turnId;
-        while (startIndex > 0 && tab.allMessages[startIndex - 1].turnId == turnAtStart)
-            --startIndex;
+    int viewportTop = t.scrollArea->verticalScrollBar()->value();
+    int viewportBottom = viewportTop + t.scrollArea->viewport()->height();
+    int threshold = t.scrollArea->viewport()->height() / 3;
+    int bestTurnId = -1;
+    if (t.transcript && t.transcript->rowCount() > 0
+        && viewportTop + threshold >= t.transcript->y())
+        bestTurnId = t.transcript->turnAt(viewportTop + threshold - t.transcript->y());
+    for (int i = 0; i < t.messagesLayout->count(); ++i) {
+        auto *item = t.messagesLayout->itemAt(i);
+        if (!item || !item->widget()) continue;
+        auto *chatMsg = qobject_cast<ChatMessageWidget *>(item->widget());
+        if (!chatMsg || chatMsg->turnId() <= 0) continue;
+        int widgetTop = chatMsg->mapTo(t.scrollArea->widget(), QPoint(0, 0)).y();
+        if (widgetTop <= viewportTop + threshold)
+            bestTurnId = chatMsg->turnId();
+        else if (widgetTop > viewportBottom)
+            break;
     }
+    return bestTurnId;
+}
 
-    // Record scroll state before inserting
-    QScrollBar *sb = tab.scrollArea->verticalScrollBar();
-    int oldScrollValue = sb->value();
-    QWidget *scrollContent = tab.scrollArea->widget();
-    int oldContentHeight = scrollContent->sizeHint().height();
-
-    // Render the batch at position 0 (top of layout)
-    renderMessageRange(tab, startIndex, endIndex, 0);
-    tab.lazyRenderIndex = startIndex;
-
-    // Restore scroll position so viewport does not jump
-    QTimer::singleShot(0, this, [sb, oldScrollValue, oldContentHeight, scrollContent] {
-        int newContentHeight = scrollContent->sizeHint().height();
-        int heightDelta = newContentHeight - oldContentHeight;
-        sb->setValue(oldScrollValue + heightDelta);
-    });
-
-    tab.lazyLoadingInProgress = false;
+// About a viewport of rows; restoring and scrolling up load this many
+// messages at a time
+static constexpr int kHistoryPage = 40;
 
-    // Free stored messages when fully rendered
-    if (tab.lazyRenderIndex == 0) {
-        tab.allMessages.clear();
-        tab.allMessages.squeeze();
-        tab.checkpointTurnIds.clear();
-    }
+// The newest whole turns among the kHistoryPage messages before beforeId
+// (0: the end of the session). `complete` is set once nothing older is left.
+static QList<MessageRecord> historyPage(Database *db, const QString &sessionId, int beforeId,
+                                        bool &complete)
+{
+    QList<MessageRecord> page = db->loadMessagesBefore(sessionId, beforeId, kHistoryPage);
+    complete = page.size() < kHistoryPage;
+    if (complete)
+        return page;
+    // The oldest turn may go back further; it comes whole with the next page
+    const int partialTurn = page.first().turnId;
+    int keep = 0;
+    while (keep < page.size() && page[keep].turnId == partialTurn)
+        ++keep;
+    if (keep < page.size())
+        return page.mid(keep);
+    // A single turn longer than a page
+    return db->loadTurnRange(sessionId, partialTurn, partialTurn);
 }
 
 void ChatPanel::restoreSession(const QString &sessionId)
@@ -1040,74 +965,70 @@ void ChatPanel::restoreSession(const QString &sessionId)
 
     ChatTab tab;
     tab.sessionId = sessionId;
-    auto sessionInfo = m_database->loadSession(sessionId);
-    tab.updatedAt = sessionInfo.updatedAt;
-    tab.favorite = sessionInfo.favorite;
+    // Fleet aggregates stand in for a pass over the whole history
+    const SessionSummary summary = m_database->loadSessionSummary(sessionId);
+    tab.updatedAt = summary.session.updatedAt;
+    tab.favorite = summary.session.favorite;
+    tab.turnId = summary.turnCount;
+    tab.editCount = summary.editCount;
+    tab.lastActivity = summary.lastActivity;
     if (tab.updatedAt == 0)
         tab.updatedAt = QDateTime::currentSecsSinceEpoch();
     tab.container = createChatContent();
     tab.scrollArea = tab.container->findChild<QScrollArea *>();
     tab.messagesLayout = tab.scrollArea->widget()->findChild<QVBoxLayout *>("messagesLayout");
+    tab.transcript = tab.scrollArea->widget()->findChild<TranscriptView *>();
 
     tab.process = new ClaudeProcess(this);
+    tab.process->setPersistent(Config::instance().persistentSessions());
     tab.process->setWorkingDirectory(m_workingDir);
     tab.process->setSessionId(sessionId);
     tab.sessionConfirmed = true;
 
-    // Load ALL messages (needed for effects panel, editCount, title)
-    tab.allMessages = m_database->loadMessages(sessionId);
-
-    // Batch-load all checkpoints (store for lazy widget creation)
+    // Batch-load all checkpoints (revert buttons of the transcript rows)
+    QSet<int> checkpointTurnIds;
     auto checkpoints = m_database->loadCheckpoints(sessionId);
     for (const auto &cp : checkpoints) {
         if (!cp.uuid.isEmpty())
-            tab.checkpointTurnIds.insert(cp.turnId);
-    }
-
-    // Compute metadata from full history (lightweight, no widget creation)
-    int maxTurn = 0;
-    for (const auto &msg : tab.allMessages) {
-        if (msg.turnId > maxTurn) maxTurn = msg.turnId;
-        if (msg.role == "tool") {
-            tab.lastActivity = msg.content;
-            if (msg.toolName == "Edit" || msg.toolName == "StrReplace"
-                || msg.toolName == "Write" || msg.toolName == "MultiEdit") {
-                tab.editCount++;
-            }
-        }
+            checkpointTurnIds.insert(cp.turnId);
     }
-    tab.turnId = maxTurn;
-
-    // Determine initial render range: only the last N messages
-    static constexpr int kInitialRenderCount = 40;
-    int totalCount = tab.allMessages.size();
-    int startIndex = qMax(0, totalCount - kInitialRenderCount);
 
-    // Align startIndex backward to a turn boundary
-    if (startIndex > 0) {
-        int turnAtStart = tab.allMessages[startIndex].turnId;
-        while (startIndex > 0 && tab.allMessages[startIndex - 1].turnId == turnAtStart)
-            --startIndex;
+    const auto turnMetrics = m_database->loadTurnMetrics(sessionId);
+    for (const auto &rec : turnMetrics) {
+        if (rec.metrics.ttftMs >= 0) {
+            tab.ttftSumMs += rec.metrics.ttftMs;
+            ++tab.ttftTurns;
+        }
     }
-    tab.lazyRenderIndex = startIndex;
+    if (!turnMetrics.isEmpty())
+        tab.lastTurnMetrics = turnMetrics.last().metrics;
 
-    // Render only the visible tail
-    int insertAt = tab.messagesLayout->count() - 1; // before stretch spacer
-    renderMessageRange(tab, startIndex, totalCount, insertAt);
+    // Only the newest page goes to the transcript; scrolling up (or jumping
+    // to an older turn) pages in the rest
+    tab.transcript->setCheckpointTurns(checkpointTurnIds);
+    const QList<MessageRecord> messages = historyPage(m_database, sessionId, 0,
+                                                      tab.historyComplete);
+    if (!messages.isEmpty()) {
+        tab.historyCursor = messages.first().id;
+        tab.historyTurn = messages.first().turnId;
+    }
+    tab.transcript->appendMessages(messages);
 
     auto *scrollContent = tab.scrollArea->widget();
     auto *indicator = new ThinkingIndicator(scrollContent);
     tab.messagesLayout->insertWidget(tab.messagesLayout->count() - 1, indicator);
     tab.thinkingIndicator = indicator;
 
-    // Title derivation (iterates allMessages, lightweight)
+    // Title derivation (iterates messages, lightweight)
     SessionInfo info = m_sessionMgr ? m_sessionMgr->sessionInfo(sessionId) : SessionInfo();
     QString title;
     if (!info.title.isEmpty()) {
         title = info.title;
     } else {
-        for (const auto &msg : tab.allMessages) {
-            if (msg.role == "user" && !msg.content.trimmed().isEmpty()) {
+        MessageCursor cursor = m_database->streamMessages(sessionId, QStringLiteral("user"));
+        MessageRecord msg;
+        while (cursor.next(msg)) {
+            if (!msg.content.trimmed().isEmpty()) {
                 QString simplified = msg.content.simplified();
                 if (simplified.length() <= 30) {
                     title = simplified;
@@ -1130,30 +1051,17 @@ void ChatPanel::restoreSession(const QString &sessionId)
 
     wireProcessSignals(m_tabs[idx]);
 
-    // Scroll monitoring: lazy load trigger + visible turn detection
+    // Scroll monitoring: visible turn detection (the transcript windows itself)
     auto *scrollBar = m_tabs[idx].scrollArea->verticalScrollBar();
     connect(scrollBar, &QScrollBar::valueChanged, this, [this, idx]() {
         if (!m_tabs.contains(idx)) return;
         auto &t = m_tabs[idx];
         if (!t.messagesLayout || !t.scrollArea) return;
 
-        // Lazy load trigger: render older messages when near top
-        if (t.lazyRenderIndex > 0 && !t.lazyLoadingInProgress) {
-            int scrollValue = t.scrollArea->verticalScrollBar()->value();
-            int viewportHeight = t.scrollArea->viewport()->height();
-            if (scrollValue < viewportHeight * 1.5) {
-                loadOlderMessages(t, 30);
-            }
-        }
-
-        // Flush deferred resizes for widgets now in viewport
-        for (int i = 0; i < t.messagesLayout->count(); ++i) {
-            auto *item = t.messagesLayout->itemAt(i);
-            if (!item || !item->widget()) continue;
-            auto *chatMsg = qobject_cast<ChatMessageWidget *>(item->widget());
-            if (chatMsg && chatMsg->needsResize())
-                chatMsg->flushDeferredResize();
-        }
+        // Page in older history before the user reaches the top
+        if (!t.historyComplete
+            && t.scrollArea->verticalScrollBar()->value() < t.scrollArea->viewport()->height())
+            loadOlderMessages(t);
 
         // Debounced visible turn detection
         m_scrollDebounce->disconnect();
@@ -1161,21 +1069,7 @@ void ChatPanel::restoreSession(const QString &sessionId)
             if (!m_tabs.contains(idx)) return;
             auto &t = m_tabs[idx];
             if (!t.messagesLayout || !t.scrollArea) return;
-            int viewportTop = t.scrollArea->verticalScrollBar()->value();
-            int viewportBottom = viewportTop + t.scrollArea->viewport()->height();
-            int threshold = t.scrollArea->viewport()->height() / 3;
-            int bestTurnId = -1;
-            for (int i = 0; i < t.messagesLayout->count(); ++i) {
-                auto *item = t.messagesLayout->itemAt(i);
-                if (!item || !item->widget()) continue;
-                auto *chatMsg = qobject_cast<ChatMessageWidget *>(item->widget());
-                if (!chatMsg || chatMsg->turnId() <= 0) continue;
-                int widgetTop = chatMsg->mapTo(t.scrollArea->widget(), QPoint(0, 0)).y();
-                if (widgetTop <= viewportTop + threshold)
-                    bestTurnId = chatMsg->turnId();
-                else if (widgetTop > viewportBottom)
-                    break;
-            }
+            int bestTurnId = visibleTurnForTab(t);
             if (bestTurnId > 0)
                 emit visibleTurnChanged(t.sessionId, bestTurnId);
         });
@@ -1188,22 +1082,14 @@ void ChatPanel::restoreSession(const QString &sessionId)
     emit activeSessionChanged(sessionId);
     emit sessionListChanged();
 
-    // Populate effects panel with complete history (uses stored allMessages)
-    auto &storedTab = m_tabs[idx];
-    auto historicalChanges = extractFileChangesFromHistory(sessionId, storedTab.allMessages);
+    // Populate effects panel with complete history
+    auto historicalChanges = extractFileChangesFromHistory(sessionId);
     if (!historicalChanges.isEmpty())
         emit historicalEffectsReady(sessionId, historicalChanges);
 
-    auto timestamps = turnTimestampsForSession(storedTab.allMessages);
+    auto timestamps = turnTimestampsForSession(sessionId);
     if (!timestamps.isEmpty())
         emit turnTimestampsReady(sessionId, timestamps);
-
-    // Free stored messages if everything was rendered (short session)
-    if (storedTab.lazyRenderIndex == 0) {
-        storedTab.allMessages.clear();
-        storedTab.allMessages.squeeze();
-        storedTab.checkpointTurnIds.clear();
-    }
 }
 
 void ChatPanel::sendMessage(const QString &text)
@@ -1243,6 +1129,7 @@ void ChatPanel::onSendRequested(const QString &text)
         newChat();
 
     auto &tab = currentTab();
+    tab.process->markTurnRequested();
 
     // Hide previous suggestion chips
     if (tab.suggestionChips) {
@@ -1289,15 +1176,13 @@ void ChatPanel::onSendRequested(const QString &text)
         emit sessionListChanged();
     }
 
-    if (m_database) {
-        MessageRecord rec;
-        rec.sessionId = tab.sessionId;
-        rec.role = "user";
-        rec.content = text;
-        rec.turnId = tab.turnId;
-        rec.timestamp = QDateTime::currentSecsSinceEpoch();
-        m_database->saveMessage(rec);
-    }
+    MessageRecord rec;
+    rec.sessionId = tab.sessionId;
+    rec.role = "user";
+    rec.content = text;
+    rec.turnId = tab.turnId;
+    rec.timestamp = QDateTime::currentSecsSinceEpoch();
+    recordMessage(tab, rec);
 
     // Build enriched message with context
     QString enrichedMessage = buildContextPreamble(text);
@@ -1496,7 +1381,7 @@ void ChatPanel::removeMessagesAfterTurn(int turnId)
         if (!item || !item->widget()) continue;
         QWidget *w = item->widget();
 
-        if (w == tab.thinkingIndicator || w == tab.welcomeWidget)
+        if (w == tab.thinkingIndicator || w == tab.welcomeWidget || w == tab.transcript)
             continue;
 
         auto *chatMsg = qobject_cast<ChatMessageWidget *>(w);
@@ -1532,13 +1417,12 @@ void ChatPanel::removeMessagesAfterTurn(int turnId)
     tab.currentToolGroup = nullptr;
     tab.suggestionChips = nullptr;
 
-    // Truncate lazy message state
-    if (!tab.allMessages.isEmpty()) {
-        auto it = std::remove_if(tab.allMessages.begin(), tab.allMessages.end(),
-            [turnId](const MessageRecord &m) { return m.turnId >= turnId; });
-        tab.allMessages.erase(it, tab.allMessages.end());
-        tab.lazyRenderIndex = qMin(tab.lazyRenderIndex, tab.allMessages.size());
-    }
+    // Reverted turns may already have been handed to the transcript
+    if (tab.transcript)
+        tab.transcript->removeTurnsFrom(turnId);
+    auto it = std::remove_if(tab.liveRecords.begin(), tab.liveRecords.end(),
+        [turnId](const MessageRecord &m) { return m.turnId >= turnId; });
+    tab.liveRecords.erase(it, tab.liveRecords.end());
 }
 
 QString ChatPanel::buildContextPreamble(const QString &userText)
@@ -1645,7 +1529,7 @@ void ChatPanel::hideTabBar()
         corner->hide();
 }
 
-QList<AgentSummary> ChatPanel::agentSummaries() const
+QList<AgentSummary> ChatPanel::agentSummaries(int historyLimit) const
 {
     QList<AgentSummary> result;
     QSet<QString> openIds;
@@ -1666,6 +1550,8 @@ QList<AgentSummary> ChatPanel::agentSummaries() const
         s.turnCount = it->turnId;
         s.costUsd = it->totalCostUsd;
         s.profileIds = it->profileIds;
+        s.lastTtftMs = it->lastTurnMetrics.ttftMs;
+        s.lastTurnMs = it->lastTurnMetrics.totalMs;
         s.updatedAt = it->updatedAt;
         s.favorite = it->favorite;
         // Hierarchy fields
@@ -1681,32 +1567,26 @@ QList<AgentSummary> ChatPanel::agentSummaries() const
         openIds.insert(it->sessionId);
     }
 
-    // Second: old sessions from database (not currently open)
+    // Second: old sessions from database (not currently open), one indexed
+    // query over sessions and their session_stats rows
     if (m_database) {
-        auto sessions = m_database->loadSessions();
-
-        // Collect IDs of closed sessions that need turn counts
-        QStringList closedSessionIds;
-        for (const auto &session : sessions) {
-            if (session.workspace != m_workingDir) continue;
-            if (openIds.contains(session.sessionId)) continue;
-            closedSessionIds.append(session.sessionId);
-        }
-
-        // Single batch query for all turn counts
-        auto turnCounts = m_database->turnCountsForSessions(closedSessionIds);
-
-        for (const auto &session : sessions) {
-            if (session.workspace != m_workingDir) continue;
+        const auto summaries = m_database->loadSessionSummaries(m_workingDir, historyLimit);
+        for (const auto &summary : summaries) {
+            const SessionInfo &session = summary.session;
             if (openIds.contains(session.sessionId)) continue;
             AgentSummary s;
             s.sessionId = session.sessionId;
             s.title = session.title.isEmpty()
                           ? session.sessionId.left(8) + "..."
                           : session.title;
+            s.activity = summary.lastActivity;
             s.createdAt = session.createdAt;
             s.updatedAt = session.updatedAt;
-            s.turnCount = turnCounts.value(session.sessionId, 0);
+            s.turnCount = summary.turnCount;
+            s.editCount = summary.editCount;
+            s.costUsd = summary.costUsd;
+            s.lastTtftMs = summary.lastTtftMs;
+            s.lastTurnMs = summary.lastTurnMs;
             s.favorite = session.favorite;
             s.parentSessionId = session.parentSessionId;
             s.delegationTask = session.delegationTask;
@@ -1718,6 +1598,11 @@ QList<AgentSummary> ChatPanel::agentSummaries() const
     return result;
 }
 
+int ChatPanel::historySessionCount() const
+{
+    return m_database ? m_database->sessionCount(m_workingDir) : 0;
+}
+
 AgentSummary ChatPanel::agentSummaryForSession(const QString &sessionId) const
 {
     for (auto it = m_tabs.constBegin(); it != m_tabs.constEnd(); ++it) {
@@ -1736,6 +1621,8 @@ AgentSummary ChatPanel::agentSummaryForSession(const QString &sessionId) const
             s.turnCount = it->turnId;
             s.costUsd = it->totalCostUsd;
             s.profileIds = it->profileIds;
+            s.lastTtftMs = it->lastTurnMetrics.ttftMs;
+            s.lastTurnMs = it->lastTurnMetrics.totalMs;
             s.updatedAt = it->updatedAt;
             s.favorite = it->favorite;
             // Hierarchy fields from SessionManager
@@ -1769,67 +1656,29 @@ void ChatPanel::selectSession(const QString &sessionId)
 QList<FileChange> ChatPanel::extractFileChangesFromHistory(const QString &sessionId)
 {
     if (!m_database) return {};
-    auto messages = m_database->loadMessages(sessionId);
-    return extractFileChangesFromHistory(sessionId, messages);
-}
-
-QList<FileChange> ChatPanel::extractFileChangesFromHistory(
-    const QString &sessionId, const QList<MessageRecord> &messages)
-{
     QMap<QPair<int, QString>, FileChange> turnFileMap;
 
-    for (const auto &msg : messages) {
-        if (msg.role != "tool") continue;
-        if (msg.toolName != "Edit" && msg.toolName != "StrReplace"
-            && msg.toolName != "Write" && msg.toolName != "MultiEdit") continue;
-
-        auto input = nlohmann::json::parse(msg.toolInput.toStdString(), nullptr, false);
-        if (input.is_discarded()) continue;
-
-        QString filePath;
-        if (input.contains("path"))
-            filePath = QString::fromStdString(input["path"].get<std::string>());
-        else if (input.contains("file_path"))
-            filePath = QString::fromStdString(input["file_path"].get<std::string>());
-
-        if (filePath.isEmpty()) continue;
-
+    for (const FileEditRecord &edit : m_database->loadFileEdits(sessionId)) {
+        QString filePath = edit.filePath;
         if (!QFileInfo(filePath).isAbsolute())
             filePath = m_workingDir + "/" + filePath;
 
-        int turnId = msg.turnId;
-        auto key = qMakePair(turnId, filePath);
+        auto key = qMakePair(edit.turnId, filePath);
+        auto it = turnFileMap.find(key);
+        if (it != turnFileMap.end()) {
+            it->linesAdded += edit.linesAdded;
+            it->linesRemoved += edit.linesRemoved;
+            continue;
+        }
 
         FileChange change;
         change.filePath = filePath;
         change.sessionId = sessionId;
-        change.turnId = turnId;
-        change.type = FileChange::Modified;
-
-        if (msg.toolName == "Write" && !turnFileMap.contains(key))
-            change.type = FileChange::Created;
-
-        if (input.contains("old_string") && input.contains("new_string")) {
-            QString oldStr = QString::fromStdString(input["old_string"].get<std::string>());
-            QString newStr = QString::fromStdString(input["new_string"].get<std::string>());
-            int oldLines = oldStr.count('\n') + (oldStr.isEmpty() ? 0 : 1);
-            int newLines = newStr.count('\n') + (newStr.isEmpty() ? 0 : 1);
-            change.linesAdded = qMax(0, newLines - oldLines);
-            change.linesRemoved = qMax(0, oldLines - newLines);
-        } else if (input.contains("content")) {
-            QString content = QString::fromStdString(input["content"].get<std::string>());
-            change.linesAdded = content.count('\n') + 1;
-        } else if (input.contains("contents")) {
-            QString content = QString::fromStdString(input["contents"].get<std::string>());
-            change.linesAdded = content.count('\n') + 1;
-        }
-
-        if (turnFileMap.contains(key)) {
-            turnFileMap[key].linesAdded += change.linesAdded;
-            turnFileMap[key].linesRemoved += change.linesRemoved;
-        } else {
-            turnFileMap[key] = change;
-        }
+        change.turnId = edit.turnId;
+        change.type = edit.toolName == "Write" ? FileChange::Created : FileChange::Modified;
+        change.linesAdded = edit.linesAdded;
+        change.linesRemoved = edit.linesRemoved;
+        turnFileMap.insert(key, change);
     }
 
     return turnFileMap.values();
@@ -1838,19 +1687,7 @@ QList<FileChange> ChatPanel::extractFileChangesFromHistory(
 QMap<int, qint64> ChatPanel::turnTimestampsForSession(const QString &sessionId) const
 {
     if (!m_database) return {};
-    auto messages = m_database->loadMessages(sessionId);
-    return turnTimestampsForSession(messages);
-}
-
-QMap<int, qint64> ChatPanel::turnTimestampsForSession(
-    const QList<MessageRecord> &messages) const
-{
-    QMap<int, qint64> timestamps;
-    for (const auto &msg : messages) {
-        if (msg.turnId > 0 && msg.timestamp > 0 && !timestamps.contains(msg.turnId))
-            timestamps[msg.turnId] = msg.timestamp;
-    }
-    return timestamps;
+    return m_database->turnStartTimes(sessionId);
 }
 
 void ChatPanel::scrollToTurn(int turnId)
@@ -1859,8 +1696,35 @@ void ChatPanel::scrollToTurn(int turnId)
     if (!m_tabs.contains(idx)) return;
     auto &tab = m_tabs[idx];
     if (!tab.messagesLayout || !tab.scrollArea) return;
+    // A jump wins over the bottom pin of a tab that was just restored
+    tab.scrollFrames = 0;
+
+    // Restored turns not paged in yet: load them and everything after, then
+    // jump once the scroll range has grown
+    if (tab.transcript && !tab.historyComplete && turnId < tab.historyTurn && m_database) {
+        const QList<MessageRecord> older =
+            m_database->loadTurnRange(tab.sessionId, turnId, tab.historyTurn - 1);
+        if (!older.isEmpty()) {
+            tab.historyCursor = older.first().id;
+            tab.historyTurn = older.first().turnId;
+            tab.transcript->prependMessages(older);
+            auto *sb = tab.scrollArea->verticalScrollBar();
+            const int y = tab.transcript->y() + tab.transcript->turnOffset(turnId);
+            QTimer::singleShot(0, sb, [sb, y] { sb->setValue(qMax(y - 20, 0)); });
+            return;
+        }
+    }
 
-    // Find the first widget with matching turnId
+    // Settled turns: jump to the row; it is bound and measured on arrival
+    if (tab.transcript && tab.transcript->containsTurn(turnId)) {
+        if (QLayout *layout = tab.scrollArea->widget()->layout())
+            layout->activate();
+        int y = tab.transcript->y() + tab.transcript->turnOffset(turnId);
+        tab.scrollArea->verticalScrollBar()->setValue(qMax(y - 20, 0));
+        return;
+    }
+
+    // Live turns: find the first widget with matching turnId
     for (int i = 0; i < tab.messagesLayout->count(); ++i) {
         auto *item = tab.messagesLayout->itemAt(i);
         if (!item || !item->widget()) continue;
@@ -1870,17 +1734,6 @@ void ChatPanel::scrollToTurn(int turnId)
             return;
         }
     }
-
-    // Target turn not found — force-render older messages up to it
-    if (tab.lazyRenderIndex > 0 && !tab.allMessages.isEmpty()) {
-        for (int mi = 0; mi < tab.lazyRenderIndex; ++mi) {
-            if (tab.allMessages[mi].turnId >= turnId) {
-                loadOlderMessages(tab, tab.lazyRenderIndex - mi);
-                QTimer::singleShot(20, this, [this, turnId] { scrollToTurn(turnId); });
-                return;
-            }
-        }
-    }
 }
 
 void ChatPanel::showSuggestionChips(ChatTab &tab, const QString &responseText)
@@ -1910,8 +1763,7 @@ void ChatPanel::showSuggestionChips(ChatTab &tab, const QString &responseText)
         sendMessage(text);
     });
 
-    if (tab.messagesLayout)
-        tab.messagesLayout->insertWidget(insertPosForTab(tab), chips);
+    insertTurnWidget(tab, chips);
     tab.suggestionChips = chips;
     scrollTabToBottom(tab);
 }
@@ -1943,7 +1795,7 @@ void ChatPanel::showAcceptAllButton(ChatTab &tab)
         btn->deleteLater();
     });
 
-    tab.messagesLayout->insertWidget(insertPosForTab(tab), btn);
+    insertTurnWidget(tab, btn);
     scrollTabToBottom(tab);
 }
 
@@ -1978,6 +1830,27 @@ QWidget *ChatPanel::createChatContent()
     messagesLayout->setObjectName("messagesLayout");
     messagesLayout->setContentsMargins(20, 16, 20, 16);
     messagesLayout->setSpacing(6);
+
+    // Settled history sits above the live widgets of the current turns
+    auto *transcript = new TranscriptView(scrollArea, scrollContent);
+    connect(transcript, &TranscriptView::revertRequested, this, &ChatPanel::onRevertRequested);
+    connect(transcript, &TranscriptView::fileNavigationRequested,
+            this, [this](const QString &filePath, int line) { emit navigateToFile(filePath, line); });
+    connect(transcript, &TranscriptView::applyCodeRequested,
+            this, [this](const QString &code, const QString &language) {
+        emit applyCodeRequested(code, language, "");
+    });
+    connect(transcript, &TranscriptView::toolFileClicked, this, &ChatPanel::onToolFileClicked);
+    connect(transcript, &TranscriptView::rowsPending, m_frames, &FrameScheduler::requestFrame);
+    connect(transcript, &TranscriptView::prependSettled, this, [this, transcript] {
+        for (auto &tab : m_tabs) {
+            if (tab.transcript == transcript) {
+                tab.pageInFlight = false;
+                break;
+            }
+        }
+    });
+    messagesLayout->addWidget(transcript);
     messagesLayout->addStretch();
 
     scrollArea->setWidget(scrollContent);
@@ -1998,8 +1871,14 @@ int ChatPanel::insertPosForTab(const ChatTab &tab) const
 
 void ChatPanel::saveCurrentTextSegment(ChatTab &tab)
 {
-    if (!tab.currentAssistantMsg || !m_database) return;
-    QString content = tab.currentAssistantMsg->rawContent().trimmed();
+    QString content;
+    if (tab.currentAssistantMsg) {
+        content = tab.currentAssistantMsg->rawContent().trimmed();
+    } else if (tab.background) {
+        // Never rendered: the segment is still the raw pending text
+        content = tab.pendingText.trimmed();
+        tab.pendingText.clear();
+    }
     if (content.isEmpty()) return;
     MessageRecord rec;
     rec.sessionId = tab.sessionId;
@@ -2007,7 +1886,40 @@ void ChatPanel::saveCurrentTextSegment(ChatTab &tab)
     rec.content = content;
     rec.turnId = tab.turnId;
     rec.timestamp = QDateTime::currentSecsSinceEpoch();
-    m_database->saveMessage(rec);
+    recordMessage(tab, rec);
+    tab.hasFirstAssistantMsg = true;  // later segments of the turn go headerless
+}
+
+void ChatPanel::recordMessage(ChatTab &tab, const MessageRecord &rec)
+{
+    if (m_database)
+        m_database->saveMessage(rec);
+    tab.liveRecords.append(rec);
+}
+
+void ChatPanel::loadOlderMessages(ChatTab &tab)
+{
+    // Until the last page's scroll fix-up runs the bar still reads near
+    // the top, and every valueChanged would fetch another page
+    if (tab.historyComplete || tab.pageInFlight || !m_database || !tab.transcript) return;
+    const QList<MessageRecord> page = historyPage(m_database, tab.sessionId, tab.historyCursor,
+                                                  tab.historyComplete);
+    if (page.isEmpty()) {
+        tab.historyComplete = true;
+        return;
+    }
+    tab.historyCursor = page.first().id;
+    tab.historyTurn = page.first().turnId;
+    tab.pageInFlight = true;
+    tab.transcript->prependMessages(page);
+}
+
+void ChatPanel::insertTurnWidget(ChatTab &tab, QWidget *widget)
+{
+    if (!tab.messagesLayout) return;
+    // Tagged so archiveSettledTurns() knows which turn a widget belongs to
+    widget->setProperty("turnId", tab.turnId);
+    tab.messagesLayout->insertWidget(insertPosForTab(tab), widget);
 }
 
 void ChatPanel::addMessageToTab(ChatTab &tab, ChatMessageWidget *msg)
@@ -2017,7 +1929,7 @@ void ChatPanel::addMessageToTab(ChatTab &tab, ChatMessageWidget *msg)
     if (tab.welcomeWidget && tab.welcomeWidget->isVisible())
         tab.welcomeWidget->hide();
 
-    tab.messagesLayout->insertWidget(insertPosForTab(tab), msg);
+    insertTurnWidget(tab, msg);
 
     connect(msg, &ChatMessageWidget::revertRequested,
             this, &ChatPanel::onRevertRequested);
@@ -2033,28 +1945,224 @@ void ChatPanel::addMessageToTab(ChatTab &tab, ChatMessageWidget *msg)
 
 void ChatPanel::flushPendingText(ChatTab &tab)
 {
-    if (tab.pendingText.isEmpty()) return;
+    if (tab.pendingText.isEmpty() || tab.background) return;
     if (!tab.currentAssistantMsg) {
         tab.pendingText.clear();
         return;
     }
     tab.currentAssistantMsg->appendContentFast(tab.pendingText);
     tab.pendingText.clear();
+    tab.markdownDirty = true;
+    scrollTabToBottom(tab);
+}
+
+void ChatPanel::flushPendingThinking(ChatTab &tab)
+{
+    if (tab.pendingThinking.isEmpty() || tab.background) return;
+    if (tab.currentThinkingBlock)
+        tab.currentThinkingBlock->appendContent(tab.pendingThinking);
+    tab.pendingThinking.clear();
+    scrollTabToBottom(tab);
+}
+
+// Closes the open thinking block and records it
+void ChatPanel::finishThinkingBlock(ChatTab &tab)
+{
+    flushPendingThinking(tab);
+    QString content;
+    if (tab.currentThinkingBlock) {
+        tab.currentThinkingBlock->finalize();
+        content = tab.currentThinkingBlock->rawContent();
+        tab.currentThinkingBlock = nullptr;
+    } else if (tab.background && tab.thinkingOpen) {
+        content = tab.pendingThinking;
+        tab.pendingThinking.clear();
+    } else {
+        tab.thinkingOpen = false;
+        return;
+    }
+    tab.thinkingOpen = false;
+
+    MessageRecord rec;
+    rec.sessionId = tab.sessionId;
+    rec.role = "thinking";
+    rec.content = content;
+    rec.turnId = tab.turnId;
+    rec.timestamp = QDateTime::currentSecsSinceEpoch();
+    recordMessage(tab, rec);
+}
+
+ChatMessageWidget *ChatPanel::ensureAssistantMessage(ChatTab &tab)
+{
+    if (!tab.currentAssistantMsg) {
+        tab.currentAssistantMsg = new ChatMessageWidget(ChatMessageWidget::Assistant, "");
+        tab.currentAssistantMsg->setTurnId(tab.turnId);
+        tab.currentAssistantMsg->setTimestamp(QDateTime::currentDateTime());
+        if (tab.hasFirstAssistantMsg)
+            tab.currentAssistantMsg->setHeaderVisible(false);
+        addMessageToTab(tab, tab.currentAssistantMsg);
+    }
+    return tab.currentAssistantMsg;
+}
+
+// Text that has to show up now rather than on the next frame
+void ChatPanel::appendAssistantText(ChatTab &tab, const QString &text)
+{
+    if (tab.background)
+        tab.pendingText += text;
+    else
+        ensureAssistantMessage(tab)->appendContent(text);
+}
+
+// ---------------------------------------------------------------------------
+// enterBackground / leaveBackground — a streaming tab that isn't shown does
+// no widget work: its live turns move into the transcript, the open segment
+// becomes raw text again, and further events are only recorded. Showing the
+// tab appends what was recorded to the transcript (which binds only the rows
+// in view) and renders the open segment once.
+// ---------------------------------------------------------------------------
+void ChatPanel::enterBackground(ChatTab &tab)
+{
+    if (tab.background || tab.hasPendingQuestion) return;
+    if (!tab.transcript || !tab.messagesLayout) return;
+    tab.background = true;
+
+    if (tab.currentAssistantMsg)
+        tab.pendingText.prepend(tab.currentAssistantMsg->rawContent());
+    if (tab.currentThinkingBlock)
+        tab.pendingThinking.prepend(tab.currentThinkingBlock->rawContent());
+    tab.currentAssistantMsg = nullptr;
+    tab.currentThinkingBlock = nullptr;
+    tab.currentToolGroup = nullptr;
+    tab.markdownDirty = false;
+    tab.scrollFrames = 0;
+
+    tab.transcript->appendMessages(tab.liveRecords);
+    tab.liveRecords.clear();
+    for (int i = tab.messagesLayout->count() - 1; i >= 0; --i) {
+        QWidget *w = tab.messagesLayout->itemAt(i)->widget();
+        if (!w || !w->property("turnId").isValid()) continue;
+        if (w == tab.suggestionChips)
+            tab.suggestionChips = nullptr;
+        tab.messagesLayout->removeWidget(w);
+        w->deleteLater();
+    }
+}
+
+void ChatPanel::leaveBackground(ChatTab &tab)
+{
+    if (!tab.background) return;
+    tab.background = false;
+
+    tab.transcript->appendMessages(tab.liveRecords);
+    tab.liveRecords.clear();
+
+    if (tab.thinkingOpen) {
+        tab.currentThinkingBlock = new ThinkingBlockWidget;
+        insertTurnWidget(tab, tab.currentThinkingBlock);
+    }
+    flushPendingThinking(tab);
+    if (!tab.pendingText.isEmpty()) {
+        // One full render instead of the deltas it was streamed in
+        ensureAssistantMessage(tab)->appendContent(tab.pendingText);
+        tab.pendingText.clear();
+        tab.markdownClock.restart();
+    }
     scrollTabToBottom(tab);
 }
 
 void ChatPanel::scrollTabToBottom(ChatTab &tab)
 {
-    if (!tab.scrollArea) return;
-    QTimer::singleShot(10, this, [sa = tab.scrollArea] {
-        auto *sb = sa->verticalScrollBar();
+    if (!tab.scrollArea || tab.background) return;
+    // Coalesced into the next frame, and the one after it so resizes that
+    // were deferred to the event loop are included
+    tab.scrollFrames = 2;
+    m_frames->requestFrame();
+}
+
+// ---------------------------------------------------------------------------
+// runUiFrame — apply buffered stream output of visible tabs and bind their
+// queued transcript rows, current tab first, until the frame budget is
+// spent. Hidden tabs keep their backlog until shown; markdown re-renders at
+// most every kMarkdownSyncMs.
+// ---------------------------------------------------------------------------
+static constexpr qint64 kMarkdownSyncMs = 500;
+
+void ChatPanel::runUiFrame(const QDeadlineTimer &deadline)
+{
+    bool more = false;
+    qint64 nextSync = -1;
+    auto drain = [&](ChatTab &tab) {
+        if (!tab.container || !tab.container->isVisible()) return;
+        if (deadline.hasExpired()) {
+            more |= tab.scrollFrames > 0 || !tab.pendingText.isEmpty()
+                    || !tab.pendingThinking.isEmpty()
+                    || (tab.transcript && tab.transcript->hasPendingRows());
+            return;
+        }
+        more |= drainTab(tab, deadline);
+        if (tab.markdownDirty) {
+            qint64 wait = qMax<qint64>(0, kMarkdownSyncMs - tab.markdownClock.elapsed());
+            nextSync = nextSync < 0 ? wait : qMin(nextSync, wait);
+        }
+    };
+
+    const int current = m_tabWidget->currentIndex();
+    if (m_tabs.contains(current))
+        drain(m_tabs[current]);
+    for (auto it = m_tabs.begin(); it != m_tabs.end(); ++it) {
+        if (it.key() != current)
+            drain(it.value());
+    }
+
+    if (more)
+        m_frames->requestFrame();
+    else if (nextSync >= 0)
+        m_markdownDue->start(int(nextSync));
+}
+
+// Returns true while the tab still needs frames
+bool ChatPanel::drainTab(ChatTab &tab, const QDeadlineTimer &deadline)
+{
+    flushPendingThinking(tab);
+    flushPendingText(tab);
+
+    if (!tab.markdownClock.isValid())
+        tab.markdownClock.start();
+    if (tab.markdownDirty && tab.markdownClock.elapsed() >= kMarkdownSyncMs) {
+        if (tab.currentAssistantMsg)
+            tab.currentAssistantMsg->syncMarkdown();
+        tab.markdownDirty = false;
+        tab.markdownClock.restart();
+    }
+
+    // History rows of a restored session fill in a slice per frame, before
+    // the bottom pin so it sees their measured heights
+    bool rowsLeft = false;
+    if (tab.transcript && tab.transcript->hasPendingRows())
+        rowsLeft = tab.transcript->materialize(deadline);
+
+    if (tab.scrollFrames > 0) {
+        --tab.scrollFrames;
+        // Settle pending geometry first so maximum() covers the new content
+        if (QLayout *layout = tab.scrollArea->widget()->layout())
+            layout->activate();
+        auto *sb = tab.scrollArea->verticalScrollBar();
         sb->setValue(sb->maximum());
-    });
+    }
+
+    // A restored page too short to scroll never reaches the scroll handler's
+    // paging; keep loading until it fills the viewport
+    if (!rowsLeft && tab.scrollFrames == 0 && !tab.historyComplete
+        && tab.scrollArea->verticalScrollBar()->maximum() == 0)
+        loadOlderMessages(tab);
+    return rowsLeft || tab.scrollFrames > 0 || !tab.pendingText.isEmpty()
+        || !tab.pendingThinking.isEmpty();
 }
 
 void ChatPanel::setTabProcessingState(ChatTab &tab, bool processing)
 {
-    qDebug() << "[cccpp] setTabProcessingState" << (processing ? "ON" : "OFF")
+    qCDebug(lcProcess) << "[cccpp] setTabProcessingState" << (processing ? "ON" : "OFF")
              << "tab=" << tab.tabIndex << "session=" << tab.sessionId;
 
     tab.processing = processing;
@@ -2073,21 +2181,13 @@ void ChatPanel::setTabProcessingState(ChatTab &tab, bool processing)
             tab.thinkingIndicator->stopAnimation();
     }
 
-    if (tab.textFlushTimer) {
-        if (processing) {
-            tab.textFlushTimer->start();
-        } else {
-            tab.textFlushTimer->stop();
-            flushPendingText(tab);
-        }
-    }
-
-    if (tab.markdownSyncTimer) {
-        if (processing) {
-            tab.markdownSyncTimer->start();
-        } else {
-            tab.markdownSyncTimer->stop();
-        }
+    if (processing) {
+        tab.markdownClock.start();
+        if (tab.tabIndex != m_tabWidget->currentIndex())
+            enterBackground(tab);
+    } else {
+        flushPendingText(tab);
+        tab.markdownDirty = false;  // finalizeContent() renders the rest
     }
 
     if (tab.tabIndex == m_tabWidget->currentIndex())
@@ -2260,7 +2360,6 @@ void ChatPanel::exportChatHistory(const QString &sessionId)
     if (!m_database) return;
 
     SessionInfo info = m_sessionMgr ? m_sessionMgr->sessionInfo(sessionId) : SessionInfo();
-    auto messages = m_database->loadMessages(sessionId);
 
     nlohmann::json root;
     root["session_id"] = sessionId.toStdString();
@@ -2271,7 +2370,9 @@ void ChatPanel::exportChatHistory(const QString &sessionId)
     root["updated_at"] = info.updatedAt;
 
     nlohmann::json msgs = nlohmann::json::array();
-    for (const auto &m : messages) {
+    MessageCursor cursor = m_database->streamMessages(sessionId);
+    MessageRecord m;
+    while (cursor.next(m)) {
         nlohmann::json obj;
         obj["id"] = m.id;
         obj["role"] = m.role.toStdString();
@@ -2329,6 +2430,8 @@ void ChatPanel::deleteSessionNoConfirm(const QString &sessionId)
         if (it->sessionId == sessionId) {
             if (it->process && it->process->isRunning())
                 it->process->cancel();
+            if (it->process)
+                it->process->stopPersistentProcess();
             int idx = it->tabIndex;
             m_tabs.erase(it);
             m_tabWidget->removeTab(idx);
@@ -2380,6 +2483,22 @@ void ChatPanel::showHistoryMenu()
     QMenu menu(this);
     auto &thm = ThemeManager::instance();
 
+    // Searches every saved chat of the workspace, open ones included
+    auto *search = new HistorySearchWidget(m_database, &menu);
+    search->setWorkspace(m_workingDir);
+    auto *searchAction = new QWidgetAction(&menu);
+    searchAction->setDefaultWidget(search);
+    menu.addAction(searchAction);
+    menu.addSeparator();
+    connect(search, &HistorySearchWidget::resultActivated, this,
+            [this, &menu](const QString &sid, int turnId) {
+        menu.close();
+        selectSession(sid);
+        // After the restored tab has laid out its first page
+        QTimer::singleShot(0, this, [this, turnId] { scrollToTurn(turnId); });
+    });
+    QTimer::singleShot(0, search, &HistorySearchWidget::focusInput);
+
     QSet<QString> openIds;
     for (auto it = m_tabs.begin(); it != m_tabs.end(); ++it)
         openIds.insert(it->sessionId);
@@ -2537,8 +2656,10 @@ QString ChatPanel::delegateToChild(const QString &parentSessionId,
     tab.container = createChatContent();
     tab.scrollArea = tab.container->findChild<QScrollArea *>();
     tab.messagesLayout = tab.scrollArea->widget()->findChild<QVBoxLayout *>("messagesLayout");
+    tab.transcript = tab.scrollArea->widget()->findChild<TranscriptView *>();
 
     tab.process = new ClaudeProcess(this);
+    tab.process->setPersistent(Config::instance().persistentSessions());
     tab.process->setWorkingDirectory(m_workingDir);
     tab.process->setMode(mode);
 
@@ -2612,15 +2733,13 @@ QString ChatPanel::delegateToChild(const QString &parentSessionId,
     addMessageToTab(m_tabs[idx], userMsg);
 
     // Save to DB
-    if (m_database) {
-        MessageRecord rec;
-        rec.sessionId = childId;
-        rec.role = "user";
-        rec.content = message;
-        rec.turnId = tab.turnId;
-        rec.timestamp = QDateTime::currentSecsSinceEpoch();
-        m_database->saveMessage(rec);
-    }
+    MessageRecord rec;
+    rec.sessionId = childId;
+    rec.role = "user";
+    rec.content = message;
+    rec.turnId = tab.turnId;
+    rec.timestamp = QDateTime::currentSecsSinceEpoch();
+    recordMessage(m_tabs[idx], rec);
 
     // Configure and send
     QString systemPrompt = ProfileManager::instance().buildSystemPrompt(m_workingDir, profileIds);
@@ -2643,6 +2762,12 @@ QString ChatPanel::delegateToChild(const QString &parentSessionId,
     m_tabs[idx].process->setProfileIds(profileIds);
     m_tabs[idx].process->setModel(m_modelSelector->currentModelId());
 
+    // Children of one specialist share a launch spec, so park processes for
+    // the ones that follow. A peer identity is baked into the environment
+    // and makes every team member's spec unique; nothing would match those.
+    if (agentName.isEmpty())
+        m_tabs[idx].process->prewarm();
+
     m_sessionMgr->setDelegationStatus(childId, SessionInfo::Running);
     setTabProcessingState(m_tabs[idx], true);
     m_tabs[idx].process->sendMessage(message);
@@ -2665,21 +2790,22 @@ void ChatPanel::sendMessageToSession(const QString &sessionId, const QString &te
         tab.currentAssistantMsg = nullptr;
         tab.currentToolGroup = nullptr;
 
-        auto *userMsg = new ChatMessageWidget(ChatMessageWidget::User, text);
-        userMsg->setTurnId(tab.turnId);
-        userMsg->setTimestamp(QDateTime::currentDateTime());
-        addMessageToTab(tab, userMsg);
-
-        if (m_database) {
-            MessageRecord rec;
-            rec.sessionId = tab.sessionId;
-            rec.role = "user";
-            rec.content = text;
-            rec.turnId = tab.turnId;
-            rec.timestamp = QDateTime::currentSecsSinceEpoch();
-            m_database->saveMessage(rec);
+        // A background tab picks the message up from its records when shown
+        if (!tab.background) {
+            auto *userMsg = new ChatMessageWidget(ChatMessageWidget::User, text);
+            userMsg->setTurnId(tab.turnId);
+            userMsg->setTimestamp(QDateTime::currentDateTime());
+            addMessageToTab(tab, userMsg);
         }
 
+        MessageRecord rec;
+        rec.sessionId = tab.sessionId;
+        rec.role = "user";
+        rec.content = text;
+        rec.turnId = tab.turnId;
+        rec.timestamp = QDateTime::currentSecsSinceEpoch();
+        recordMessage(tab, rec);
+
         // Apply process configuration (mode, model, profiles, system prompt)
         if (!tab.overrideMode.isEmpty())
             tab.process->setMode(tab.overrideMode);
@@ -2708,6 +2834,16 @@ void ChatPanel::configureSession(const QString &sessionId,
         if (it->sessionId != sessionId) continue;
         it->overrideMode = mode;
         it->profileIds = profileIds;
+        // What newChat() parked was for the UI's mode; the first message
+        // will go out with this configuration instead
+        if (!m_workingDir.isEmpty()) {
+            it->process->setMode(mode);
+            it->process->setModel(m_modelSelector->currentModelId());
+            it->process->setSystemPrompt(ProfileManager::instance().buildSystemPrompt(
+                m_workingDir, profileIds));
+            it->process->setProfileIds(profileIds);
+            it->process->prewarm();
+        }
         return;
     }
 }
@@ -2715,12 +2851,8 @@ void ChatPanel::configureSession(const QString &sessionId,
 QString ChatPanel::sessionFinalOutput(const QString &sessionId) const
 {
     if (!m_database) return {};
-    auto messages = m_database->loadMessages(sessionId);
-    QString lastAssistantContent;
-    for (const auto &msg : messages) {
-        if (msg.role == "assistant")
-            lastAssistantContent = msg.content;
-    }
+    QString lastAssistantContent =
+        m_database->lastMessage(sessionId, QStringLiteral("assistant")).content;
     if (lastAssistantContent.length() > 4000)
         lastAssistantContent = lastAssistantContent.left(4000) + "\n\n[... truncated ...]";
     return lastAssistantContent;
@@ -2735,7 +2867,8 @@ void ChatPanel::updateStatsLabel()
     }
     const auto &tab = m_tabs[idx];
     int totalIn = tab.totalInputTokens + tab.totalCacheReadTokens;
-    if (totalIn == 0 && tab.totalOutputTokens == 0) {
+    const TurnMetrics &m = tab.lastTurnMetrics;
+    if (totalIn == 0 && tab.totalOutputTokens == 0 && !m.isValid()) {
         m_statsLabel->hide();
         return;
     }
@@ -2746,6 +2879,31 @@ void ChatPanel::updateStatsLabel()
         text += QString("  cache %1").arg(formatTokenCount(tab.totalCacheReadTokens));
     if (tab.totalCostUsd > 0.0)
         text += QString("  $%1").arg(QString::number(tab.totalCostUsd, 'f', 4));
+
+    QStringList lines;
+    if (m.isValid()) {
+        if (m.ttftMs >= 0) {
+            text += QString("  TTFT %1s").arg(QString::number(m.ttftMs / 1000.0, 'f', 1));
+            if (tab.ttftTurns > 1)
+                text += QString(" (avg %1s)").arg(
+                    QString::number(tab.ttftSumMs / 1000.0 / tab.ttftTurns, 'f', 1));
+        }
+        text += QString("  turn %1s").arg(QString::number(m.totalMs / 1000.0, 'f', 1));
+
+        lines << QString("Last turn: %1").arg(m.summary());
+        lines << QString("Spawn %1 ms, first byte %2 ms, first token %3 ms")
+                     .arg(m.spawnMs).arg(m.firstByteMs).arg(m.ttftMs);
+        lines << QString("%1 deltas, gap p50 %2 ms, p95 %3 ms, max %4 ms")
+                     .arg(m.deltaCount).arg(m.gapPercentileMs(0.5))
+                     .arg(m.gapPercentileMs(0.95)).arg(m.maxGapMs);
+        if (m.toolCount > 0)
+            lines << QString("%1 tool calls, %2 ms waiting on tools").arg(m.toolCount).arg(m.toolMs);
+    }
+    if (m_frames->frameCount() > 0)
+        lines << QString("UI: %1 frames, %2 dropped, %3 over the %4 ms budget")
+                     .arg(m_frames->frameCount()).arg(m_frames->droppedFrames())
+                     .arg(m_frames->overBudgetFrames()).arg(m_frames->budgetMs());
     m_statsLabel->setText(text);
+    m_statsLabel->setToolTip(lines.join('\n'));
     m_statsLabel->show();
 }
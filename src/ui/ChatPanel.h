@@ -7,6 +7,7 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QIcon>
 #include <QMap>
 #include <nlohmann/json.hpp>
@@ -15,6 +16,7 @@
 #include "ui/EffectsPanel.h"     // for FileChange
 
 #include "core/Database.h"  // for MessageRecord
+#include "core/TurnMetrics.h"
 class InputBar;
 class ModeSelector;
 class ModelSelector;
@@ -23,6 +25,9 @@ class ChatMessageWidget;
 class ToolCallGroupWidget;
 class ThinkingIndicator;
 class ThinkingBlockWidget;
+class TranscriptView;
+class FrameScheduler;
+class QDeadlineTimer;
 class SuggestionChips;
 class ClaudeProcess;
 class SessionManager;
@@ -34,6 +39,7 @@ struct ChatTab {
     QWidget *container = nullptr;
     QScrollArea *scrollArea = nullptr;
     QVBoxLayout *messagesLayout = nullptr;
+    TranscriptView *transcript = nullptr;  // settled turns, virtualized
     ClaudeProcess *process = nullptr;
     ChatMessageWidget *currentAssistantMsg = nullptr;
     ToolCallGroupWidget *currentToolGroup = nullptr;
@@ -44,9 +50,17 @@ struct ChatTab {
     QString sessionId;
     QString pendingEditFile;
     QString accumulatedRawContent;
+    // Streaming output waiting for the next UI frame (see runUiFrame)
     QString pendingText;
-    QTimer *textFlushTimer = nullptr;
-    QTimer *markdownSyncTimer = nullptr;
+    QString pendingThinking;
+    QElapsedTimer markdownClock;    // since the last full markdown sync
+    bool markdownDirty = false;
+    int scrollFrames = 0;           // frames left that pin the view to the bottom
+    // Hidden while streaming: events are only recorded (liveRecords) and the
+    // open text/thinking segment stays raw in pendingText/pendingThinking
+    // until the tab is shown again (see enterBackground)
+    bool background = false;
+    bool thinkingOpen = false;
     int turnId = 0;
     int tabIndex = -1;
     bool processing = false;
@@ -61,6 +75,11 @@ struct ChatTab {
     int totalCacheReadTokens = 0;
     double totalCostUsd = 0.0;
 
+    // Turn latency tracking
+    TurnMetrics lastTurnMetrics;
+    qint64 ttftSumMs = 0;
+    int ttftTurns = 0;
+
     // Agent fleet tracking
     int editCount = 0;
     QString lastActivity;
@@ -69,11 +88,17 @@ struct ChatTab {
     qint64 updatedAt = 0;
     bool favorite = false;
 
-    // Lazy message rendering
-    QList<MessageRecord> allMessages;
-    QSet<int> checkpointTurnIds;
-    int lazyRenderIndex = 0;        // messages [0, lazyRenderIndex) are NOT yet rendered
-    bool lazyLoadingInProgress = false;
+    // Messages of the turns still shown as live widgets; handed to the
+    // transcript once the turns settle
+    QList<MessageRecord> liveRecords;
+
+    // Restored history is paged in newest first; the transcript holds the
+    // turns from historyTurn on
+    int historyCursor = 0;  // id of the oldest message loaded
+    int historyTurn = 0;
+    bool historyComplete = true;
+    // A page was prepended and its scroll fix-up hasn't run yet
+    bool pageInFlight = false;
 };
 
 class ChatPanel : public QWidget {
@@ -103,13 +128,13 @@ public:
 
     // Agent Fleet API
     void hideTabBar();
-    QList<AgentSummary> agentSummaries() const;
+    // Open tabs plus the newest `historyLimit` stored sessions of the
+    // workspace (-1: all of them)
+    QList<AgentSummary> agentSummaries(int historyLimit = -1) const;
+    int historySessionCount() const;
     void selectSession(const QString &sessionId);
     QList<FileChange> extractFileChangesFromHistory(const QString &sessionId);
-    QList<FileChange> extractFileChangesFromHistory(const QString &sessionId,
-                                                     const QList<MessageRecord> &messages);
     QMap<int, qint64> turnTimestampsForSession(const QString &sessionId) const;
-    QMap<int, qint64> turnTimestampsForSession(const QList<MessageRecord> &messages) const;
     AgentSummary agentSummaryForSession(const QString &sessionId) const;
     void scrollToTurn(int turnId);
     void exportChatHistory(const QString &sessionId);
@@ -182,6 +207,14 @@ private:
     void addMessageToTab(ChatTab &tab, ChatMessageWidget *msg);
     void scrollTabToBottom(ChatTab &tab);
     void flushPendingText(ChatTab &tab);
+    void flushPendingThinking(ChatTab &tab);
+    void finishThinkingBlock(ChatTab &tab);
+    ChatMessageWidget *ensureAssistantMessage(ChatTab &tab);
+    void appendAssistantText(ChatTab &tab, const QString &text);
+    void enterBackground(ChatTab &tab);
+    void leaveBackground(ChatTab &tab);
+    void runUiFrame(const QDeadlineTimer &deadline);
+    bool drainTab(ChatTab &tab, const QDeadlineTimer &deadline);
     void setTabProcessingState(ChatTab &tab, bool processing);
     void refreshInputBarForCurrentTab();
     void showHistoryMenu();
@@ -193,8 +226,11 @@ private:
     void showAcceptAllButton(ChatTab &tab);
     void saveCurrentTextSegment(ChatTab &tab);
     int insertPosForTab(const ChatTab &tab) const;
-    int renderMessageRange(ChatTab &tab, int startIndex, int endIndex, int insertPos);
-    void loadOlderMessages(ChatTab &tab, int count = 30);
+    void insertTurnWidget(ChatTab &tab, QWidget *widget);
+    void recordMessage(ChatTab &tab, const MessageRecord &rec);
+    void loadOlderMessages(ChatTab &tab);
+    void archiveSettledTurns(ChatTab &tab);
+    int visibleTurnForTab(const ChatTab &tab) const;
     void removeMessagesAfterTurn(int turnId);
     void showPlansMenu();
     void updateStatsLabel();
@@ -221,4 +257,6 @@ private:
     int m_pendingRevertTurnId = 0;
     int m_previousTabIndex = -1;
     QTimer *m_scrollDebounce = nullptr;
+    FrameScheduler *m_frames = nullptr;
+    QTimer *m_markdownDue = nullptr;  // wakes the scheduler for the next markdown sync
 };
@@ -7,6 +7,7 @@
 #include "ui/InlineEditBar.h"
 #include "ui/ThemeManager.h"
 #include "util/MarkdownRenderer.h"
+#include "util/LanguageMap.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QDir>
@@ -1225,131 +1226,36 @@ void CodeViewer::paste()
 #ifndef NO_QSCINTILLA
 void CodeViewer::setLexerForFile(const QString &filePath, QsciScintilla *editor)
 {
-    QFileInfo fi(filePath);
-    QString ext = fi.suffix().toLower();
-    QString name = fi.fileName().toLower();
     QsciLexer *lexer = nullptr;
-
-    // --- By filename first (for extensionless files) ---
-    if (name == "makefile" || name == "gnumakefile") {
-        lexer = new QsciLexerMakefile(editor);
-    } else if (name == "cmakelists.txt") {
-        lexer = new QsciLexerCMake(editor);
-    } else if (name == "dockerfile" || name.startsWith("dockerfile.")) {
-        lexer = new QsciLexerBash(editor);
-    } else if (name == "gemfile" || name == "rakefile" || name == "vagrantfile") {
-        lexer = new QsciLexerRuby(editor);
-    } else if (name == ".bashrc" || name == ".bash_profile" || name == ".zshrc" ||
-               name == ".profile" || name == ".zprofile") {
-        lexer = new QsciLexerBash(editor);
-    }
-
-    // --- By extension ---
-    if (!lexer) {
-        if (ext == "cpp" || ext == "cxx" || ext == "cc" || ext == "c" ||
-            ext == "h" || ext == "hpp" || ext == "hxx" || ext == "m" || ext == "mm" ||
-            ext == "ino" || ext == "pde") {
-            lexer = new QsciLexerCPP(editor);
-
-        } else if (ext == "java") {
-            lexer = new QsciLexerJava(editor);
-
-        } else if (ext == "cs") {
-            lexer = new QsciLexerCSharp(editor);
-
-        } else if (ext == "js" || ext == "ts" || ext == "jsx" || ext == "tsx" ||
-                   ext == "mjs" || ext == "cjs") {
-        lexer = new QsciLexerJavaScript(editor);
-
-        } else if (ext == "py" || ext == "pyw" || ext == "pyi" || ext == "pyx") {
-            lexer = new QsciLexerPython(editor);
-
-        } else if (ext == "rb" || ext == "rake" || ext == "gemspec") {
-            lexer = new QsciLexerRuby(editor);
-
-        } else if (ext == "rs" || ext == "go" || ext == "swift" || ext == "kt" ||
-                   ext == "kts" || ext == "dart" || ext == "scala" || ext == "groovy" ||
-                   ext == "gradle" || ext == "proto" || ext == "thrift") {
-            // C-family syntax — CPP lexer is a reasonable approximation
-            lexer = new QsciLexerCPP(editor);
-
-        } else if (ext == "html" || ext == "htm" || ext == "vue" || ext == "svelte" ||
-                   ext == "astro" || ext == "erb" || ext == "ejs" || ext == "hbs" ||
-                   ext == "twig" || ext == "njk" || ext == "blade" ||
-                   ext == "php" || ext == "phtml") {
-            lexer = new QsciLexerHTML(editor);
-
-        } else if (ext == "css" || ext == "scss" || ext == "sass" || ext == "less") {
-            lexer = new QsciLexerCSS(editor);
-
-        } else if (ext == "xml" || ext == "xsl" || ext == "xslt" || ext == "xsd" ||
-                   ext == "svg" || ext == "plist" || ext == "csproj" || ext == "fsproj" ||
-                   ext == "vcxproj" || ext == "sln" || ext == "xaml" || ext == "wsdl" ||
-                   ext == "rss" || ext == "atom" || ext == "ui") {
-            lexer = new QsciLexerXML(editor);
-
-        } else if (ext == "json" || ext == "jsonc" || ext == "geojson" ||
-                   ext == "jsonl" || ext == "json5") {
-            lexer = new QsciLexerJSON(editor);
-
-        } else if (ext == "yml" || ext == "yaml") {
-            lexer = new QsciLexerYAML(editor);
-
-        } else if (ext == "sql" || ext == "ddl" || ext == "dml" || ext == "pgsql" ||
-                   ext == "plsql" || ext == "mysql") {
-            lexer = new QsciLexerSQL(editor);
-
-        } else if (ext == "sh" || ext == "bash" || ext == "zsh" || ext == "fish" ||
-                   ext == "ksh" || ext == "csh" || ext == "tcsh") {
-            lexer = new QsciLexerBash(editor);
-
-        } else if (ext == "lua") {
-            lexer = new QsciLexerLua(editor);
-
-        } else if (ext == "pl" || ext == "pm" || ext == "pod" || ext == "t") {
-            lexer = new QsciLexerPerl(editor);
-
-        } else if (ext == "mk") {
-            lexer = new QsciLexerMakefile(editor);
-
-        } else if (ext == "cmake") {
-            lexer = new QsciLexerCMake(editor);
-
-        } else if (ext == "md" || ext == "markdown" || ext == "mdx" || ext == "rst") {
-            lexer = new QsciLexerMarkdown(editor);
-
-        } else if (ext == "diff" || ext == "patch") {
-            lexer = new QsciLexerDiff(editor);
-
-        } else if (ext == "bat" || ext == "cmd") {
-            lexer = new QsciLexerBatch(editor);
-
-        } else if (ext == "ini" || ext == "cfg" || ext == "conf" || ext == "properties" ||
-                   ext == "env" || ext == "toml" || ext == "editorconfig" || ext == "gitconfig") {
-            lexer = new QsciLexerProperties(editor);
-
-        } else if (ext == "tex" || ext == "latex" || ext == "sty" || ext == "cls" || ext == "bib") {
-            lexer = new QsciLexerTeX(editor);
-
-        } else if (ext == "d") {
-            lexer = new QsciLexerD(editor);
-
-        } else if (ext == "pas" || ext == "pp" || ext == "dpr" || ext == "lpr") {
-            lexer = new QsciLexerPascal(editor);
-
-        } else if (ext == "f" || ext == "for" || ext == "f90" || ext == "f95" || ext == "f03") {
-            lexer = new QsciLexerFortran(editor);
-
-        } else if (ext == "tcl" || ext == "tk") {
-            lexer = new QsciLexerTCL(editor);
-
-        } else if (ext == "coffee" || ext == "litcoffee") {
-            lexer = new QsciLexerCoffeeScript(editor);
-
-        } else if (ext == "r" || ext == "rmd") {
-            // No dedicated R lexer in QScintilla; Python is a reasonable fallback
-            lexer = new QsciLexerPython(editor);
-        }
+    switch (languageForFile(filePath)) {
+    case SourceLanguage::Cpp:          lexer = new QsciLexerCPP(editor); break;
+    case SourceLanguage::Java:         lexer = new QsciLexerJava(editor); break;
+    case SourceLanguage::CSharp:       lexer = new QsciLexerCSharp(editor); break;
+    case SourceLanguage::JavaScript:   lexer = new QsciLexerJavaScript(editor); break;
+    case SourceLanguage::Python:       lexer = new QsciLexerPython(editor); break;
+    case SourceLanguage::Ruby:         lexer = new QsciLexerRuby(editor); break;
+    case SourceLanguage::Html:         lexer = new QsciLexerHTML(editor); break;
+    case SourceLanguage::Css:          lexer = new QsciLexerCSS(editor); break;
+    case SourceLanguage::Xml:          lexer = new QsciLexerXML(editor); break;
+    case SourceLanguage::Json:         lexer = new QsciLexerJSON(editor); break;
+    case SourceLanguage::Yaml:         lexer = new QsciLexerYAML(editor); break;
+    case SourceLanguage::Sql:          lexer = new QsciLexerSQL(editor); break;
+    case SourceLanguage::Bash:         lexer = new QsciLexerBash(editor); break;
+    case SourceLanguage::Lua:          lexer = new QsciLexerLua(editor); break;
+    case SourceLanguage::Perl:         lexer = new QsciLexerPerl(editor); break;
+    case SourceLanguage::Makefile:     lexer = new QsciLexerMakefile(editor); break;
+    case SourceLanguage::CMake:        lexer = new QsciLexerCMake(editor); break;
+    case SourceLanguage::Markdown:     lexer = new QsciLexerMarkdown(editor); break;
+    case SourceLanguage::Diff:         lexer = new QsciLexerDiff(editor); break;
+    case SourceLanguage::Batch:        lexer = new QsciLexerBatch(editor); break;
+    case SourceLanguage::Properties:   lexer = new QsciLexerProperties(editor); break;
+    case SourceLanguage::TeX:          lexer = new QsciLexerTeX(editor); break;
+    case SourceLanguage::D:            lexer = new QsciLexerD(editor); break;
+    case SourceLanguage::Pascal:       lexer = new QsciLexerPascal(editor); break;
+    case SourceLanguage::Fortran:      lexer = new QsciLexerFortran(editor); break;
+    case SourceLanguage::Tcl:          lexer = new QsciLexerTCL(editor); break;
+    case SourceLanguage::CoffeeScript: lexer = new QsciLexerCoffeeScript(editor); break;
+    case SourceLanguage::None:         break;
     }
 
     if (lexer) {
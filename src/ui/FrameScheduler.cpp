@@ -0,0 +1,72 @@
+#include "ui/FrameScheduler.h"
+#include <QWidget>
+#include <QWindow>
+#include <QScreen>
+#include <QEvent>
+#include <QtMath>
+
+FrameScheduler::FrameScheduler(QWidget *host, QObject *parent)
+    : QObject(parent)
+    , m_host(host)
+{
+    m_fallback.setSingleShot(true);
+    connect(&m_fallback, &QTimer::timeout, this, &FrameScheduler::runFrame);
+}
+
+int FrameScheduler::frameIntervalMs() const
+{
+    QScreen *screen = m_host->screen();
+    const qreal rate = screen ? screen->refreshRate() : 60.0;
+    return qMax(1, qRound(1000.0 / (rate > 0 ? rate : 60.0)));
+}
+
+void FrameScheduler::requestFrame()
+{
+    if (m_requested) return;
+    m_requested = true;
+    m_requestedAt.start();
+
+    QWindow *window = m_host->window()->windowHandle();
+    if (window != m_window) {
+        if (m_window)
+            m_window->removeEventFilter(this);
+        m_window = window;
+        if (m_window)
+            m_window->installEventFilter(this);
+    }
+    if (m_window && m_window->isExposed())
+        m_window->requestUpdate();
+    // Backstop in case the update request is swallowed (window minimized or
+    // unexposed in between); a timely UpdateRequest stops it
+    m_fallback.start(m_window && m_window->isExposed() ? 2 * frameIntervalMs()
+                                                       : frameIntervalMs());
+}
+
+bool FrameScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    // Observe only: the window still paints on this update request
+    if (watched == m_window && event->type() == QEvent::UpdateRequest && m_requested)
+        runFrame();
+    return QObject::eventFilter(watched, event);
+}
+
+void FrameScheduler::runFrame()
+{
+    if (!m_requested) return;
+    m_requested = false;
+    m_fallback.stop();
+
+    // Served within a refresh interval (plus slack for timer jitter) is on
+    // time; every further interval it waited is a frame that never happened
+    const int interval = frameIntervalMs();
+    const qint64 late = m_requestedAt.elapsed() - interval / 2;
+    if (late >= interval)
+        m_dropped += late / interval;
+
+    QElapsedTimer work;
+    work.start();
+    emit frame(QDeadlineTimer(m_budgetMs));
+    ++m_frames;
+    if (work.elapsed() > m_budgetMs)
+        ++m_overBudget;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QObject>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+
+class QWidget;
+class QWindow;
+
+// One frame callback for all pending UI work. requestFrame() asks the host's
+// window for an update (QWindow::requestUpdate(), which the platform paces to
+// the display refresh) and frame() fires when it arrives, with a deadline the
+// handler should stop at. Nothing runs while no frame is requested.
+//
+// A request that is served more than one refresh interval late counts the
+// missed intervals as dropped frames; a handler running past the budget is
+// counted separately.
+class FrameScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit FrameScheduler(QWidget *host, QObject *parent = nullptr);
+
+    void requestFrame();
+
+    void setBudgetMs(int ms) { m_budgetMs = ms; }
+    int budgetMs() const { return m_budgetMs; }
+    int frameIntervalMs() const;
+
+    qint64 frameCount() const { return m_frames; }
+    qint64 droppedFrames() const { return m_dropped; }
+    qint64 overBudgetFrames() const { return m_overBudget; }
+
+signals:
+    void frame(const QDeadlineTimer &deadline);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void runFrame();
+
+    QWidget *m_host;
+    QPointer<QWindow> m_window;
+    QTimer m_fallback;          // hidden/unexposed windows get no update requests
+    QElapsedTimer m_requestedAt;
+    bool m_requested = false;
+    int m_budgetMs = 8;
+
+    qint64 m_frames = 0;
+    qint64 m_dropped = 0;
+    qint64 m_overBudget = 0;
+};
@@ -0,0 +1,170 @@
+#include "ui/HistorySearchWidget.h"
+#include "core/Database.h"
+#include "ui/ThemeManager.h"
+#include <QDateTime>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+static constexpr int kSessionRole = Qt::UserRole;
+static constexpr int kTurnRole = Qt::UserRole + 1;
+
+HistorySearchWidget::HistorySearchWidget(Database *db, QWidget *parent)
+    : QWidget(parent)
+    , m_db(db)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 4, 8, 4);
+    layout->setSpacing(4);
+
+    m_input = new QLineEdit(this);
+    m_input->setPlaceholderText(QStringLiteral("Search chat history..."));
+    m_input->setClearButtonEnabled(true);
+    layout->addWidget(m_input);
+
+    m_results = new QListWidget(this);
+    m_results->setFocusPolicy(Qt::NoFocus);
+    m_results->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_results->setFixedHeight(260);
+    m_results->hide();
+    layout->addWidget(m_results);
+
+    m_status = new QLabel(this);
+    m_status->hide();
+    layout->addWidget(m_status);
+
+    setMinimumWidth(420);
+
+    m_debounce = new QTimer(this);
+    m_debounce->setSingleShot(true);
+    m_debounce->setInterval(kDebounceMs);
+    connect(m_debounce, &QTimer::timeout, this, &HistorySearchWidget::runSearch);
+    connect(m_input, &QLineEdit::textChanged, m_debounce, qOverload<>(&QTimer::start));
+    connect(m_input, &QLineEdit::returnPressed, this, [this] {
+        // Enter opens the first hit, searching first if the debounce is pending
+        if (m_debounce->isActive()) {
+            m_debounce->stop();
+            runSearch();
+        }
+        if (auto *item = m_results->currentItem() ? m_results->currentItem() : m_results->item(0))
+            onItemActivated(item);
+    });
+    connect(m_results, &QListWidget::itemClicked, this, &HistorySearchWidget::onItemActivated);
+
+    m_input->installEventFilter(this);
+    applyThemeColors();
+    connect(&ThemeManager::instance(), &ThemeManager::themeChanged,
+            this, &HistorySearchWidget::applyThemeColors);
+
+    if (!m_db || !m_db->hasSearch()) {
+        m_input->setEnabled(false);
+        m_input->setPlaceholderText(QStringLiteral("History search unavailable"));
+    }
+}
+
+void HistorySearchWidget::setWorkspace(const QString &workspace)
+{
+    m_workspace = workspace;
+}
+
+void HistorySearchWidget::focusInput()
+{
+    m_input->setFocus(Qt::PopupFocusReason);
+}
+
+bool HistorySearchWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    // Arrow keys move through the results while typing continues in the input
+    if (watched == m_input && event->type() == QEvent::KeyPress && m_results->count() > 0) {
+        const int key = static_cast<QKeyEvent *>(event)->key();
+        if (key == Qt::Key_Down || key == Qt::Key_Up) {
+            const int step = key == Qt::Key_Down ? 1 : -1;
+            const int row = qBound(0, m_results->currentRow() + step, m_results->count() - 1);
+            m_results->setCurrentRow(row);
+            return true;
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+void HistorySearchWidget::runSearch()
+{
+    m_results->clear();
+    const QString text = m_input->text().trimmed();
+    if (text.isEmpty() || !m_db) {
+        m_results->hide();
+        m_status->hide();
+        return;
+    }
+
+    const QList<SearchHit> hits = m_db->searchMessages(text, m_workspace, kMaxResults);
+    const auto &thm = ThemeManager::instance();
+    // The list may not be laid out yet on the first search
+    const int rowWidth = qMax(m_results->viewport()->width(), minimumWidth() - 24);
+    for (const auto &hit : hits) {
+        // Snippets are plain text; escape them before marking the matches
+        QString snippet = hit.snippet.toHtmlEscaped();
+        snippet.replace(SearchHit::kMatchBegin,
+                        QStringLiteral("<b style=\"color:%1\">").arg(thm.hex("teal")));
+        snippet.replace(SearchHit::kMatchEnd, QStringLiteral("</b>"));
+        snippet.replace(QLatin1Char('\n'), QLatin1Char(' '));
+
+        QString title = hit.title.isEmpty() ? hit.sessionId.left(8) + "..." : hit.title;
+        const QString when = QDateTime::fromSecsSinceEpoch(hit.timestamp).toString("MMM d, hh:mm");
+
+        // One arg() pass: a title or snippet containing "%4" stays literal
+        auto *label = new QLabel(QStringLiteral(
+            "<div style=\"color:%1\">%2 <span style=\"color:%3\">&middot; turn %4 &middot; %5</span></div>"
+            "<div style=\"color:%3\">%6</div>")
+            .arg(thm.hex("text_primary"), title.toHtmlEscaped(), thm.hex("text_muted"),
+                 QString::number(hit.turnId), when, snippet));
+        label->setTextFormat(Qt::RichText);
+        label->setWordWrap(true);
+        label->setContentsMargins(6, 4, 6, 4);
+        label->setAttribute(Qt::WA_TransparentForMouseEvents);
+
+        auto *item = new QListWidgetItem(m_results);
+        item->setData(kSessionRole, hit.sessionId);
+        item->setData(kTurnRole, hit.turnId);
+        item->setSizeHint(QSize(0, label->heightForWidth(rowWidth) + 2));
+        m_results->setItemWidget(item, label);
+    }
+
+    m_results->setVisible(!hits.isEmpty());
+    m_status->setVisible(hits.isEmpty());
+    m_status->setText(QStringLiteral("No matches"));
+    if (!hits.isEmpty())
+        m_results->setCurrentRow(0);
+}
+
+void HistorySearchWidget::onItemActivated(QListWidgetItem *item)
+{
+    if (!item) return;
+    emit resultActivated(item->data(kSessionRole).toString(), item->data(kTurnRole).toInt());
+}
+
+void HistorySearchWidget::applyThemeColors()
+{
+    const auto &p = ThemeManager::instance().palette();
+
+    m_input->setStyleSheet(QStringLiteral(
+        "QLineEdit { background: %1; color: %2; border: 1px solid %3; "
+        "border-radius: 4px; padding: 3px 6px; font-size: 12px; }"
+        "QLineEdit:focus { border-color: %4; }")
+        .arg(p.bg_surface.name(), p.text_primary.name(),
+             p.border_standard.name(), p.border_focus.name()));
+
+    m_results->setStyleSheet(QStringLiteral(
+        "QListWidget { background: %1; border: 1px solid %2; border-radius: 4px; "
+        "font-size: 12px; }"
+        "QListWidget::item { border-bottom: 1px solid %3; }"
+        "QListWidget::item:selected { background: %4; }")
+        .arg(p.bg_base.name(), p.border_standard.name(),
+             p.border_subtle.name(), p.hover_raised.name()));
+
+    m_status->setStyleSheet(QStringLiteral("QLabel { color: %1; font-size: 11px; padding: 2px 4px; }")
+        .arg(p.text_muted.name()));
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QWidget>
+
+class Database;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+class QTimer;
+
+// Full-text search over saved chats, for the top of the history menu.
+// Searches as you type (debounced) and lists one row per matching turn:
+// session title, time and the snippet around the match.
+class HistorySearchWidget : public QWidget {
+    Q_OBJECT
+public:
+    explicit HistorySearchWidget(Database *db, QWidget *parent = nullptr);
+
+    // Restricts results to one workspace; empty searches all of them
+    void setWorkspace(const QString &workspace);
+    void focusInput();
+
+signals:
+    void resultActivated(const QString &sessionId, int turnId);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    static constexpr int kDebounceMs = 150;
+    static constexpr int kMaxResults = 30;
+
+    void runSearch();
+    void onItemActivated(QListWidgetItem *item);
+    void applyThemeColors();
+
+    Database *m_db = nullptr;
+    QString m_workspace;
+    QLineEdit *m_input = nullptr;
+    QListWidget *m_results = nullptr;
+    QLabel *m_status = nullptr;
+    QTimer *m_debounce = nullptr;
+};
@@ -27,6 +27,7 @@
 #include "util/Config.h"
 #include "util/MacUtils.h"
 #include "util/JsonUtils.h"
+#include "util/RenderCache.h"
 #include <QMenuBar>
 #include <QFileDialog>
 #include <QFileInfo>
@@ -49,6 +50,7 @@ static constexpr int    kTreePanelWidth     = 250;
 static constexpr double kEditorFraction     = 0.40;
 static constexpr double kChatFraction       = 0.35;
 static constexpr double kEditorFractionGit  = 0.50;
+static constexpr int    kFleetHistoryPage   = 200;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -60,6 +62,7 @@ MainWindow::MainWindow(QWidget *parent)
     m_database = new Database(this);
     m_database->open();
     m_database->deleteStalePendingSessions();
+    RenderCache::instance().setDatabase(m_database);
     m_gitManager = new GitManager(this);
 
     ThemeManager::instance().initialize();
@@ -165,6 +168,7 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    RenderCache::instance().setDatabase(nullptr);  // flushes
     if (m_daemonClient)
         m_daemonClient->unregisterWorkspace();
     if (m_telegramApi)
@@ -448,6 +452,10 @@ void MainWindow::setupUI()
         m_chatPanel->selectSession(sid);
     });
     connect(m_agentFleet, &AgentFleetPanel::newAgentRequested, this, &MainWindow::onNewChat);
+    connect(m_agentFleet, &AgentFleetPanel::olderRequested, this, [this]() {
+        m_fleetHistoryLimit += kFleetHistoryPage;
+        rebuildFleetPanel();
+    });
     connect(m_agentFleet, &AgentFleetPanel::deleteRequested, this, [this](const QString &sid) {
         m_chatPanel->deleteSession(sid);
         rebuildFleetPanel();
@@ -1190,9 +1198,14 @@ void MainWindow::dismissInlineFilePreview()
 
 void MainWindow::rebuildFleetPanel()
 {
-    auto agents = m_chatPanel->agentSummaries();
+    // One card per chat: page the workspace's history in rather than build
+    // thousands of widgets on every refresh
+    if (m_fleetHistoryLimit <= 0)
+        m_fleetHistoryLimit = kFleetHistoryPage;
+    auto agents = m_chatPanel->agentSummaries(m_fleetHistoryLimit);
     QString selectedId = m_chatPanel->currentSessionId();
     m_agentFleet->rebuild(agents, selectedId);
+    m_agentFleet->setOlderCount(qMax(0, m_chatPanel->historySessionCount() - m_fleetHistoryLimit));
 }
 
 void MainWindow::wireEffectsPanel()
@@ -1395,6 +1408,7 @@ void MainWindow::openWorkspace(const QString &rawPath)
         m_chatPanel->closeAllTabs();
 
     m_workspacePath = path;
+    m_fleetHistoryLimit = kFleetHistoryPage;
     m_workspaceTree->setRootPath(path);
     m_searchPanel->setRootPath(path);
     m_chatPanel->setWorkingDirectory(path);
@@ -1622,11 +1636,9 @@ void MainWindow::onGitRefresh()
 
 void MainWindow::restoreSessions()
 {
-    auto sessions = m_database->loadSessions();
-    for (const auto &session : sessions) {
-        if (session.workspace == m_workspacePath)
-            m_sessionMgr->registerSession(session.sessionId, session);
-    }
+    const auto sessions = m_database->loadSessions(m_workspacePath);
+    for (const auto &session : sessions)
+        m_sessionMgr->registerSession(session.sessionId, session);
 }
 
 void MainWindow::setupTelegram()
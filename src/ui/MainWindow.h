@@ -104,6 +104,8 @@ private:
 
     // Mission Control panels
     AgentFleetPanel *m_agentFleet = nullptr;
+    // Stored sessions shown in the fleet; "Show older chats" raises it
+    int m_fleetHistoryLimit = 0;
     EffectsPanel *m_effectsPanel = nullptr;
 
     SessionManager *m_sessionMgr;
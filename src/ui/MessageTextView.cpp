@@ -0,0 +1,223 @@
+#include "ui/MessageTextView.h"
+#include "ui/ThemeManager.h"
+#include <QAbstractTextDocumentLayout>
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QTextDocument>
+#include <QtMath>
+
+MessageTextView::MessageTextView(QWidget *parent)
+    : QWidget(parent)
+    , m_doc(new QTextDocument(this))
+{
+    m_doc->setDocumentMargin(0);
+    // Edited in place while streaming; an undo stack would only keep every
+    // replaced tail alive
+    m_doc->setUndoRedoEnabled(false);
+    // Matches the chat's QTextBrowser style for text outside rendered HTML
+    QFont font = m_doc->defaultFont();
+    font.setPixelSize(13);
+    m_doc->setDefaultFont(font);
+    m_selection = QTextCursor(m_doc);
+
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    setMouseTracking(true);
+    setFocusPolicy(Qt::ClickFocus);
+
+    connect(m_doc, &QTextDocument::contentsChanged, this, &MessageTextView::onContentsChanged);
+}
+
+int MessageTextView::bucketOf(int width)
+{
+    return qMax(kWidthBucket, width - width % kWidthBucket);
+}
+
+void MessageTextView::layoutAt(int bucket) const
+{
+    if (bucket == m_layoutBucket) return;
+    m_doc->setTextWidth(bucket);
+    m_layoutBucket = bucket;
+}
+
+int MessageTextView::heightForWidth(int width) const
+{
+    if (m_doc->isEmpty())
+        return 0;
+    const int bucket = bucketOf(width);
+    auto it = m_heights.constFind(bucket);
+    if (it != m_heights.cend())
+        return it.value();
+    layoutAt(bucket);
+    const int h = qCeil(m_doc->size().height());
+    m_heights.insert(bucket, h);
+    return h;
+}
+
+QSize MessageTextView::sizeHint() const
+{
+    const int w = width() > 0 ? width() : 400;
+    return QSize(w, heightForWidth(w));
+}
+
+void MessageTextView::onContentsChanged()
+{
+    // The document re-lays out the edited blocks itself; only the cached
+    // heights are stale
+    m_heights.clear();
+    updateGeometry();
+    update();
+}
+
+QString MessageTextView::selectedText() const
+{
+    return m_selection.hasSelection() ? m_selection.selection().toPlainText() : QString();
+}
+
+void MessageTextView::clearSelection()
+{
+    if (!m_selection.hasSelection()) return;
+    m_selection.clearSelection();
+    update();
+}
+
+// ---------------------------------------------------------------------------
+// Painting
+// ---------------------------------------------------------------------------
+
+void MessageTextView::paintEvent(QPaintEvent *event)
+{
+    if (m_doc->isEmpty()) return;
+    layoutAt(bucketOf(width()));
+
+    const auto &pal = ThemeManager::instance().palette();
+    QPainter p(this);
+    QAbstractTextDocumentLayout::PaintContext ctx;
+    ctx.clip = event->rect();
+    ctx.palette.setColor(QPalette::Text, pal.text_primary);
+    if (m_selection.hasSelection()) {
+        QAbstractTextDocumentLayout::Selection sel;
+        sel.cursor = m_selection;
+        sel.format.setBackground(pal.hover_raised);
+        sel.format.setForeground(pal.text_primary);
+        ctx.selections.append(sel);
+    }
+    p.setClipRect(event->rect());
+    m_doc->documentLayout()->draw(&p, ctx);
+}
+
+// ---------------------------------------------------------------------------
+// Hit-testing and interaction
+// ---------------------------------------------------------------------------
+
+int MessageTextView::hitTest(const QPoint &pos) const
+{
+    layoutAt(bucketOf(width()));
+    const int hit = m_doc->documentLayout()->hitTest(pos, Qt::FuzzyHit);
+    return hit < 0 ? 0 : hit;
+}
+
+QString MessageTextView::anchorAt(const QPoint &pos) const
+{
+    layoutAt(bucketOf(width()));
+    return m_doc->documentLayout()->anchorAt(pos);
+}
+
+void MessageTextView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    const QPoint pos = event->position().toPoint();
+    m_pressPos = pos;
+    m_pressedAnchor = anchorAt(pos);
+    m_selecting = true;
+    // Shift-click extends the current selection
+    const bool extend = event->modifiers() & Qt::ShiftModifier;
+    m_selection.setPosition(hitTest(pos), extend ? QTextCursor::KeepAnchor
+                                                 : QTextCursor::MoveAnchor);
+    update();
+}
+
+void MessageTextView::mouseMoveEvent(QMouseEvent *event)
+{
+    const QPoint pos = event->position().toPoint();
+    if (m_selecting && (event->buttons() & Qt::LeftButton)) {
+        if ((pos - m_pressPos).manhattanLength() >= QApplication::startDragDistance())
+            m_pressedAnchor.clear();
+        m_selection.setPosition(hitTest(pos), QTextCursor::KeepAnchor);
+        update();
+        return;
+    }
+    setCursor(anchorAt(pos).isEmpty() ? Qt::IBeamCursor : Qt::PointingHandCursor);
+}
+
+void MessageTextView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+    m_selecting = false;
+    const QString anchor = m_pressedAnchor;
+    m_pressedAnchor.clear();
+    if (!anchor.isEmpty() && anchor == anchorAt(event->position().toPoint())) {
+        // A click on a link is not a selection
+        clearSelection();
+        emit anchorClicked(QUrl(anchor));
+        return;
+    }
+    if (m_selection.hasSelection() && QApplication::clipboard()->supportsSelection())
+        QApplication::clipboard()->setText(selectedText(), QClipboard::Selection);
+}
+
+void MessageTextView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) return;
+    m_selection.setPosition(hitTest(event->position().toPoint()));
+    m_selection.select(QTextCursor::WordUnderCursor);
+    m_pressedAnchor.clear();
+    update();
+}
+
+void MessageTextView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy) && m_selection.hasSelection()) {
+        QApplication::clipboard()->setText(selectedText());
+        return;
+    }
+    if (event->matches(QKeySequence::SelectAll)) {
+        m_selection.select(QTextCursor::Document);
+        update();
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
+
+void MessageTextView::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu menu(this);
+    QAction *copy = menu.addAction(QStringLiteral("Copy"));
+    copy->setEnabled(m_selection.hasSelection());
+    connect(copy, &QAction::triggered, this, [this] {
+        QApplication::clipboard()->setText(selectedText());
+    });
+    const QString anchor = anchorAt(event->pos());
+    if (anchor.startsWith(QLatin1String("http"))) {
+        connect(menu.addAction(QStringLiteral("Copy Link")), &QAction::triggered, this, [anchor] {
+            QApplication::clipboard()->setText(anchor);
+        });
+    }
+    menu.addSeparator();
+    connect(menu.addAction(QStringLiteral("Select All")), &QAction::triggered, this, [this] {
+        m_selection.select(QTextCursor::Document);
+        update();
+    });
+    menu.exec(event->globalPos());
+}
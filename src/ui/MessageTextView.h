@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QWidget>
+#include <QHash>
+#include <QTextCursor>
+#include <QUrl>
+
+class QTextDocument;
+
+// Rich text of a chat message without a QTextBrowser: the widget owns a
+// QTextDocument and paints it through its layout. No scroll area, viewport
+// or scroll bars; the height follows the width (heightForWidth), and heights
+// are cached per width bucket so a column resize only lays out a document
+// again when the width crosses into a bucket it has not seen. The document is
+// laid out at the bucket width, leaving at most kWidthBucket - 1 px unused.
+//
+// Interaction is hit-tested against the layout: links (anchors) show a
+// pointing cursor and emit anchorClicked(), and text can be selected with
+// the mouse (double-click for a word) and copied.
+class MessageTextView : public QWidget {
+    Q_OBJECT
+public:
+    explicit MessageTextView(QWidget *parent = nullptr);
+
+    // Edit through the document; the view follows its contentsChanged()
+    QTextDocument *document() const { return m_doc; }
+
+    QString selectedText() const;
+    void clearSelection();
+
+    bool hasHeightForWidth() const override { return true; }
+    int heightForWidth(int width) const override;
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override { return QSize(0, 0); }
+
+    static constexpr int kWidthBucket = 8;
+
+signals:
+    void anchorClicked(const QUrl &url);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private:
+    static int bucketOf(int width);
+    void layoutAt(int bucket) const;
+    int hitTest(const QPoint &pos) const;
+    QString anchorAt(const QPoint &pos) const;
+    void onContentsChanged();
+
+    QTextDocument *m_doc;
+    mutable QHash<int, int> m_heights;  // width bucket -> document height
+    mutable int m_layoutBucket = -1;    // bucket the document is laid out at
+
+    QTextCursor m_selection;
+    QString m_pressedAnchor;
+    QPoint m_pressPos;
+    bool m_selecting = false;
+};
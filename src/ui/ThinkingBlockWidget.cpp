@@ -94,6 +94,17 @@ void ThinkingBlockWidget::finalize()
     setCollapsed(true);
 }
 
+void ThinkingBlockWidget::reset()
+{
+    m_rawContent.clear();
+    m_contentBrowser->clear();
+    m_finalized = false;
+    m_titleLabel->setText("Thinking");
+    m_timer.restart();
+    m_dotAnim->start();
+    setCollapsed(false);
+}
+
 void ThinkingBlockWidget::setCollapsed(bool collapsed)
 {
     m_collapsed = collapsed;
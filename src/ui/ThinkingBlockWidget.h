@@ -17,6 +17,8 @@ public:
 
     void appendContent(const QString &text);
     void finalize();
+    // Back to an empty, running block (for widgets reused by TranscriptView)
+    void reset();
     void setCollapsed(bool collapsed);
     bool isCollapsed() const { return m_collapsed; }
     QString rawContent() const { return m_rawContent; }
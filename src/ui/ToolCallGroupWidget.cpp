@@ -124,6 +124,18 @@ void ToolCallGroupWidget::setExpandedByDefault()
     m_detailContainer->setMaximumHeight(16777215);
 }
 
+void ToolCallGroupWidget::clear()
+{
+    m_expandAnim->stop();
+    m_expanded = false;
+    m_expandBtn->setText(QStringLiteral("\u25B6"));
+    clearDetailView();
+    m_detailContainer->setMaximumHeight(0);
+    m_calls.clear();
+    m_toolCounts.clear();
+    updateSummaryLabel();
+}
+
 void ToolCallGroupWidget::applyThemeColors()
 {
     auto &tm = ThemeManager::instance();
@@ -175,14 +187,18 @@ void ToolCallGroupWidget::updateSummaryLabel()
             .arg(tm.hex("text_muted")));
 }
 
-void ToolCallGroupWidget::rebuildDetailView()
+void ToolCallGroupWidget::clearDetailView()
 {
-    // Clear old detail widgets
     QLayoutItem *item;
     while ((item = m_detailLayout->takeAt(0)) != nullptr) {
         delete item->widget();
         delete item;
     }
+}
+
+void ToolCallGroupWidget::rebuildDetailView()
+{
+    clearDetailView();
 
     auto &tm = ThemeManager::instance();
     for (const auto &call : m_calls) {
@@ -27,6 +27,8 @@ public:
     void addToolCall(const ToolCallInfo &info);
     void finalize();
     void setExpandedByDefault();
+    // Drops all calls and collapses, so the widget can show another group
+    void clear();
     int toolCount() const { return m_calls.size(); }
 
 signals:
@@ -35,6 +37,7 @@ signals:
 private:
     void updateSummaryLabel();
     void rebuildDetailView();
+    void clearDetailView();
     void applyThemeColors();
     QWidget *createDiffView(const QString &oldStr, const QString &newStr);
 
@@ -0,0 +1,571 @@
+#include "ui/TranscriptView.h"
+#include "ui/ChatMessageWidget.h"
+#include "ui/ToolCallGroupWidget.h"
+#include "ui/ThinkingBlockWidget.h"
+#include "ui/ThemeManager.h"
+#include "util/JsonUtils.h"
+#include <nlohmann/json.hpp>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QTimer>
+#include <algorithm>
+#include <utility>
+#include <limits>
+
+static constexpr int kRowSpacing = 6;      // matches the chat layout's spacing
+static constexpr int kMinOverscan = 200;   // px materialized beyond each viewport edge
+static constexpr int kPoolPerKind = 8;     // idle widgets kept for reuse
+
+static int wrappedLines(const QString &text, int charsPerLine)
+{
+    int lines = 1;
+    int column = 0;
+    for (QChar c : text) {
+        if (c == '\n' || ++column > charsPerLine) {
+            ++lines;
+            column = 0;
+        }
+    }
+    return lines;
+}
+
+TranscriptView::TranscriptView(QScrollArea *area, QWidget *parent)
+    : QWidget(parent)
+    , m_area(area)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setVisible(false);
+    m_area->viewport()->installEventFilter(this);
+    connect(m_area->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &TranscriptView::updateWindow);
+}
+
+ToolCallInfo TranscriptView::toolCallInfo(const MessageRecord &record)
+{
+    ToolCallInfo info;
+    info.toolName = record.toolName;
+    info.summary = record.content;
+    if (record.toolInput.isEmpty())
+        return info;
+
+    auto parsed = nlohmann::json::parse(record.toolInput.toStdString(), nullptr, false);
+    if (parsed.is_discarded())
+        return info;
+    if (parsed.contains("path"))
+        info.filePath = JsonUtils::getString(parsed, "path");
+    else if (parsed.contains("file_path"))
+        info.filePath = JsonUtils::getString(parsed, "file_path");
+
+    if ((record.toolName == "Edit" || record.toolName == "StrReplace")
+        && parsed.contains("old_string")) {
+        info.isEdit = true;
+        info.oldString = JsonUtils::getString(parsed, "old_string");
+        info.newString = JsonUtils::getString(parsed, "new_string");
+    } else if (record.toolName == "Write") {
+        info.isEdit = true;
+        info.newString = JsonUtils::getString(parsed, "content",
+                         JsonUtils::getString(parsed, "contents"));
+    }
+    return info;
+}
+
+void TranscriptView::appendMessages(const QList<MessageRecord> &messages)
+{
+    const int extendedRow = m_openGroupRow;
+    const int from = m_records.size();
+    m_records.append(messages);
+    groupRecords(from);
+
+    // A group that was already on screen may have picked up more calls
+    if (QWidget *w = m_live.value(extendedRow))
+        bind(w, m_rows[extendedRow]);
+
+    setVisible(!m_rows.isEmpty());
+    updateGeometry();
+    updateWindow();
+}
+
+void TranscriptView::prependMessages(const QList<MessageRecord> &messages)
+{
+    if (messages.isEmpty()) return;
+    if (m_records.isEmpty()) {
+        appendMessages(messages);
+        emit prependSettled();
+        return;
+    }
+
+    // Group the older turns on their own, then put the existing rows back
+    // after them with their measured heights and bound widgets
+    const QList<MessageRecord> newer = std::exchange(m_records, messages);
+    const QList<Row> newerRows = std::exchange(m_rows, {});
+    QVector<int> newerHeights;
+    newerHeights.reserve(newerRows.size());
+    for (int row = 0; row < newerRows.size(); ++row)
+        newerHeights.append(m_index.height(row));
+    const int openGroupRow = m_openGroupRow;
+    const int lastTurn = m_lastTurn;
+    const bool turnHasAssistant = m_turnHasAssistant;
+
+    m_index.clear();
+    m_openGroupRow = -1;
+    m_lastTurn = -1;
+    m_turnHasAssistant = false;
+    groupRecords(0);
+    const int addedRows = m_rows.size();
+    const int addedHeight = m_index.totalHeight();
+
+    const int shift = m_records.size();
+    m_records.append(newer);
+    for (Row row : newerRows) {
+        row.first += shift;
+        m_rows.append(row);
+    }
+    for (int height : std::as_const(newerHeights))
+        m_index.append(height);
+    m_openGroupRow = openGroupRow < 0 ? -1 : openGroupRow + addedRows;
+    m_lastTurn = lastTurn;
+    m_turnHasAssistant = turnHasAssistant;
+
+    QMap<int, QWidget *> live;
+    for (auto it = m_live.cbegin(); it != m_live.cend(); ++it)
+        live.insert(it.key() + addedRows, it.value());
+    m_live = live;
+    m_wanted.clear();
+    placeWidgets();
+    updateGeometry();
+
+    // Keep what the user is reading in place once the content has grown
+    QTimer::singleShot(0, this, [this, addedHeight] {
+        auto *sb = m_area->verticalScrollBar();
+        sb->setValue(sb->value() + addedHeight);
+        updateWindow();
+        emit prependSettled();
+    });
+}
+
+void TranscriptView::groupRecords(int from)
+{
+    for (int index = from; index < m_records.size(); ++index) {
+        const MessageRecord &msg = m_records[index];
+
+        if (msg.turnId != m_lastTurn) {
+            m_openGroupRow = -1;
+            m_turnHasAssistant = false;
+            m_lastTurn = msg.turnId;
+        }
+
+        Row row;
+        row.turnId = msg.turnId;
+        row.first = index;
+
+        if (msg.role == "user" && !msg.content.trimmed().isEmpty()) {
+            row.kind = UserRow;
+        } else if (msg.role == "thinking" && !msg.content.trimmed().isEmpty()) {
+            row.kind = ThinkingRow;
+        } else if (msg.role == "assistant" && !msg.content.trimmed().isEmpty()) {
+            row.kind = AssistantRow;
+            row.header = !m_turnHasAssistant;
+            m_turnHasAssistant = true;
+        } else if (msg.role == "tool") {
+            const bool editCandidate = msg.toolName == "Edit" || msg.toolName == "StrReplace"
+                                       || msg.toolName == "Write";
+            if (editCandidate && toolCallInfo(msg).isEdit) {
+                row.kind = EditRow;
+            } else if (m_openGroupRow >= 0) {
+                // Read-only calls of one stretch share a group
+                m_rows[m_openGroupRow].count = index - m_rows[m_openGroupRow].first + 1;
+                continue;
+            } else {
+                row.kind = ToolsRow;
+                addRow(row);
+                m_openGroupRow = m_rows.size() - 1;
+                continue;
+            }
+        } else {
+            continue;
+        }
+        m_openGroupRow = -1;
+        addRow(row);
+    }
+}
+
+void TranscriptView::addRow(const Row &row)
+{
+    m_rows.append(row);
+    m_index.append(estimateHeight(row) + kRowSpacing);
+}
+
+void TranscriptView::removeTurnsFrom(int turnId)
+{
+    int row = firstRowOfTurn(turnId);
+    if (row < 0)
+        row = m_rows.size();
+    for (auto it = m_live.begin(); it != m_live.end();) {
+        if (it.key() >= row) {
+            release(it.key(), it.value());
+            it = m_live.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    int record = m_records.size();
+    while (record > 0 && m_records[record - 1].turnId >= turnId)
+        --record;
+    m_records.resize(record);
+    m_rows.resize(row);
+    m_index.truncate(row);
+
+    m_openGroupRow = -1;
+    m_lastTurn = -1;
+    setVisible(!m_rows.isEmpty());
+    updateGeometry();
+    updateWindow();
+}
+
+void TranscriptView::clear()
+{
+    removeTurnsFrom(std::numeric_limits<int>::min());
+}
+
+void TranscriptView::setCheckpointTurns(const QSet<int> &turnIds)
+{
+    m_checkpointTurns = turnIds;
+    for (auto it = m_live.cbegin(); it != m_live.cend(); ++it) {
+        const Row &row = m_rows[it.key()];
+        if (row.kind == UserRow)
+            static_cast<ChatMessageWidget *>(it.value())->showRevertButton(
+                m_checkpointTurns.contains(row.turnId));
+    }
+}
+
+void TranscriptView::addCheckpointTurn(int turnId)
+{
+    auto turns = m_checkpointTurns;
+    turns.insert(turnId);
+    setCheckpointTurns(turns);
+}
+
+int TranscriptView::firstRowOfTurn(int turnId) const
+{
+    // Turn ids never decrease along the transcript
+    auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), turnId,
+                               [](const Row &row, int id) { return row.turnId < id; });
+    return it == m_rows.cend() ? -1 : int(it - m_rows.cbegin());
+}
+
+bool TranscriptView::containsTurn(int turnId) const
+{
+    int row = firstRowOfTurn(turnId);
+    return row >= 0 && m_rows[row].turnId == turnId;
+}
+
+int TranscriptView::turnOffset(int turnId) const
+{
+    return containsTurn(turnId) ? m_index.offset(firstRowOfTurn(turnId)) : -1;
+}
+
+int TranscriptView::turnAt(int y) const
+{
+    return m_rows.isEmpty() ? -1 : m_rows[m_index.rowAt(y)].turnId;
+}
+
+QSize TranscriptView::sizeHint() const
+{
+    return QSize(0, qMax(m_index.totalHeight() - kRowSpacing, 0));
+}
+
+int TranscriptView::estimateHeight(const Row &row) const
+{
+    const int w = width() > 0 ? width() : 600;
+    const int charsPerLine = qMax(20, (w - 32) / 7);
+    const QString &content = m_records[row.first].content;
+
+    switch (row.kind) {
+    case UserRow:
+        return 44 + 18 * wrappedLines(content, charsPerLine);
+    case AssistantRow:
+        return 28 + (row.header ? 22 : 0) + 20 * wrappedLines(content, charsPerLine);
+    case ThinkingRow:
+        return 30;
+    case ToolsRow:
+        return 36;
+    case EditRow: {
+        const ToolCallInfo info = toolCallInfo(m_records[row.first]);
+        const int diffLines = (info.oldString.isEmpty() ? 0 : int(info.oldString.count('\n')) + 1)
+                            + (info.newString.isEmpty() ? 0 : int(info.newString.count('\n')) + 1);
+        return 60 + qMin(diffLines * 16, 200);
+    }
+    }
+    return 36;
+}
+
+int TranscriptView::visibleTop() const
+{
+    return mapFrom(m_area->viewport(), QPoint(0, 0)).y();
+}
+
+// ---------------------------------------------------------------------------
+// Windowing
+// ---------------------------------------------------------------------------
+
+void TranscriptView::updateWindow()
+{
+    m_wanted.clear();
+    if (m_rows.isEmpty() || !isVisible()) return;
+
+    const int viewportHeight = m_area->viewport()->height();
+    const int overscan = qMax(viewportHeight / 2, kMinOverscan);
+    const int top = visibleTop() - overscan;
+    const int bottom = visibleTop() + viewportHeight + overscan;
+
+    int first = 0;
+    int last = -1;
+    if (bottom > 0 && top < m_index.totalHeight()) {
+        first = m_index.rowAt(top);
+        last = m_index.rowAt(bottom);
+    }
+
+    for (auto it = m_live.begin(); it != m_live.end();) {
+        if (it.key() < first || it.key() > last) {
+            release(it.key(), it.value());
+            it = m_live.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // What is on screen first, then the overscan outward from it
+    const int viewFirst = qBound(first, m_index.rowAt(visibleTop()), last + 1);
+    const int viewLast = qBound(viewFirst - 1, m_index.rowAt(visibleTop() + viewportHeight), last);
+    auto want = [this](int row) {
+        if (!m_live.contains(row))
+            m_wanted.append(row);
+    };
+    for (int row = viewFirst; row <= viewLast; ++row)
+        want(row);
+    for (int below = viewLast + 1, above = viewFirst - 1; below <= last || above >= first;
+         ++below, --above) {
+        if (below <= last) want(below);
+        if (above >= first) want(above);
+    }
+
+    syncHeights();
+    if (!m_wanted.isEmpty()) {
+        update();
+        emit rowsPending();
+    }
+}
+
+bool TranscriptView::materialize(const QDeadlineTimer &deadline)
+{
+    bool bound = false;
+    while (!m_wanted.isEmpty() && !(bound && deadline.hasExpired())) {
+        const int row = m_wanted.takeFirst();
+        if (row >= m_rows.size() || m_live.contains(row)) continue;
+        m_live.insert(row, acquire(row));
+        bound = true;
+    }
+    if (bound) {
+        syncHeights();
+        update();
+    }
+    return !m_wanted.isEmpty();
+}
+
+void TranscriptView::syncHeights()
+{
+    if (m_syncing || width() <= 0) return;
+    m_syncing = true;
+
+    // Rows above the one at the viewport top move the content; scroll by
+    // the same amount so what the user is reading stays put
+    const int anchor = m_index.rowAt(visibleTop());
+    int shift = 0;
+    bool changed = false;
+    for (auto it = m_live.cbegin(); it != m_live.cend(); ++it) {
+        const int delta = measure(it.value()) + kRowSpacing - m_index.height(it.key());
+        if (delta == 0) continue;
+        m_index.setHeight(it.key(), m_index.height(it.key()) + delta);
+        if (it.key() < anchor)
+            shift += delta;
+        changed = true;
+    }
+    placeWidgets();
+
+    if (changed)
+        updateGeometry();
+    if (shift != 0) {
+        // Apply once the scroll content has been resized
+        QTimer::singleShot(0, this, [this, shift] {
+            auto *sb = m_area->verticalScrollBar();
+            sb->setValue(sb->value() + shift);
+        });
+    }
+    m_syncing = false;
+}
+
+void TranscriptView::placeWidgets()
+{
+    for (auto it = m_live.cbegin(); it != m_live.cend(); ++it)
+        it.value()->setGeometry(0, m_index.offset(it.key()), width(),
+                                m_index.height(it.key()) - kRowSpacing);
+}
+
+int TranscriptView::measure(QWidget *w) const
+{
+    if (w->hasHeightForWidth())
+        return w->heightForWidth(width());
+    return w->sizeHint().height();
+}
+
+QWidget *TranscriptView::acquire(int row)
+{
+    auto &pool = m_pool[poolKey(m_rows[row].kind)];
+    QWidget *w = pool.isEmpty() ? create(m_rows[row].kind) : pool.takeLast();
+    bind(w, m_rows[row]);
+    w->show();
+    return w;
+}
+
+void TranscriptView::release(int row, QWidget *w)
+{
+    w->hide();
+    auto &pool = m_pool[poolKey(m_rows[row].kind)];
+    if (pool.size() < kPoolPerKind)
+        pool.append(w);
+    else
+        w->deleteLater();
+}
+
+QWidget *TranscriptView::create(Kind kind)
+{
+    switch (kind) {
+    case UserRow:
+    case AssistantRow: {
+        auto *msg = new ChatMessageWidget(kind == UserRow ? ChatMessageWidget::User
+                                                          : ChatMessageWidget::Assistant,
+                                          QString(), this);
+        connect(msg, &ChatMessageWidget::revertRequested, this, &TranscriptView::revertRequested);
+        connect(msg, &ChatMessageWidget::fileNavigationRequested,
+                this, &TranscriptView::fileNavigationRequested);
+        connect(msg, &ChatMessageWidget::applyCodeRequested,
+                this, &TranscriptView::applyCodeRequested);
+        return msg;
+    }
+    case ThinkingRow:
+        return new ThinkingBlockWidget(this);
+    case ToolsRow:
+    case EditRow: {
+        auto *group = new ToolCallGroupWidget(this);
+        connect(group, &ToolCallGroupWidget::fileClicked, this, &TranscriptView::toolFileClicked);
+        return group;
+    }
+    }
+    return nullptr;
+}
+
+void TranscriptView::bind(QWidget *w, const Row &row)
+{
+    const MessageRecord &msg = m_records[row.first];
+    switch (row.kind) {
+    case UserRow:
+    case AssistantRow: {
+        auto *chatMsg = static_cast<ChatMessageWidget *>(w);
+        chatMsg->setContent(msg.content);
+        chatMsg->setTurnId(row.turnId);
+        chatMsg->setTimestamp(msg.timestamp > 0 ? QDateTime::fromSecsSinceEpoch(msg.timestamp)
+                                                : QDateTime());
+        if (row.kind == UserRow)
+            chatMsg->showRevertButton(m_checkpointTurns.contains(row.turnId));
+        else
+            chatMsg->setHeaderVisible(row.header);
+        break;
+    }
+    case ThinkingRow: {
+        auto *block = static_cast<ThinkingBlockWidget *>(w);
+        block->reset();
+        block->appendContent(msg.content);
+        block->finalize();
+        break;
+    }
+    case ToolsRow:
+    case EditRow: {
+        auto *group = static_cast<ToolCallGroupWidget *>(w);
+        group->clear();
+        for (int i = row.first; i < row.first + row.count; ++i) {
+            if (m_records[i].role == "tool")
+                group->addToolCall(toolCallInfo(m_records[i]));
+        }
+        group->finalize();
+        if (row.kind == EditRow)
+            group->setExpandedByDefault();
+        break;
+    }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Events
+// ---------------------------------------------------------------------------
+
+bool TranscriptView::event(QEvent *event)
+{
+    // Posted by bound widgets whose size hint changed (documents laid out,
+    // groups expanded, theme switched)
+    if (event->type() == QEvent::LayoutRequest)
+        syncHeights();
+    return QWidget::event(event);
+}
+
+bool TranscriptView::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_area->viewport() && event->type() == QEvent::Resize)
+        updateWindow();
+    return QWidget::eventFilter(watched, event);
+}
+
+void TranscriptView::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    if (event->size().width() != m_lastWidth) {
+        m_lastWidth = event->size().width();
+        syncHeights();
+    }
+    updateWindow();
+}
+
+void TranscriptView::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    updateWindow();
+}
+
+void TranscriptView::paintEvent(QPaintEvent *event)
+{
+    if (m_wanted.isEmpty()) return;
+
+    // Skeletons for queued rows: a few text-line bars at the row's estimated
+    // height, so the layout is final before the content arrives
+    const auto &pal = ThemeManager::instance().palette();
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(Qt::NoPen);
+    p.setBrush(pal.bg_surface);
+    for (int row : std::as_const(m_wanted)) {
+        const QRect rect(0, m_index.offset(row), width(), m_index.height(row) - kRowSpacing);
+        if (!rect.intersects(event->rect())) continue;
+        const int bars = qBound(1, (rect.height() - 12) / 20, 4);
+        for (int i = 0; i < bars; ++i) {
+            const int barWidth = (i == bars - 1 && bars > 1) ? rect.width() * 3 / 5
+                                                             : rect.width() - 32;
+            p.drawRoundedRect(QRect(16, rect.top() + 10 + i * 20, barWidth, 10), 4, 4);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <QWidget>
+#include <QList>
+#include <QMap>
+#include <QHash>
+#include <QSet>
+#include "core/Database.h"  // for MessageRecord
+#include "util/TranscriptIndex.h"
+
+class QScrollArea;
+class QDeadlineTimer;
+struct ToolCallInfo;
+
+// Settled chat history as a virtualized list. Messages are grouped into rows
+// the way the live chat shows them (one card per user/assistant/thinking
+// message, read-only tool calls merged into groups, edits on their own), and
+// only rows inside the scroll area's viewport plus some overscan get a widget.
+// Rows start at an estimated height and switch to the measured one once shown;
+// scrolling hands widgets that leave the window to a per-kind pool and binds
+// them to the rows coming in.
+//
+// Binding is time-sliced: rows entering the window are queued (viewport rows
+// first, then the overscan nearest to it) and painted as skeletons until the
+// owner's frame calls materialize() with its remaining budget.
+class TranscriptView : public QWidget {
+    Q_OBJECT
+public:
+    explicit TranscriptView(QScrollArea *area, QWidget *parent = nullptr);
+
+    // Appends whole turns, oldest first
+    void appendMessages(const QList<MessageRecord> &messages);
+    // Inserts whole turns older than the first one shown, oldest first; the
+    // rows on screen keep their place
+    void prependMessages(const QList<MessageRecord> &messages);
+    // Drops turnId and every later turn
+    void removeTurnsFrom(int turnId);
+    void clear();
+
+    void setCheckpointTurns(const QSet<int> &turnIds);
+    void addCheckpointTurn(int turnId);
+
+    int rowCount() const { return m_rows.size(); }
+    bool containsTurn(int turnId) const;
+    // Top of the first row of turnId, in view coordinates (-1 if absent)
+    int turnOffset(int turnId) const;
+    // Turn of the row at y, in view coordinates (-1 when empty)
+    int turnAt(int y) const;
+
+    // Binds queued rows until the deadline, at least one per call. Returns
+    // true while rows are still waiting.
+    bool materialize(const QDeadlineTimer &deadline);
+    bool hasPendingRows() const { return !m_wanted.isEmpty(); }
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override { return sizeHint(); }
+
+signals:
+    void revertRequested(int turnId);
+    void fileNavigationRequested(const QString &filePath, int line);
+    void applyCodeRequested(const QString &code, const QString &language);
+    void toolFileClicked(const QString &filePath, const QString &searchText);
+    // Rows were queued for binding; call materialize() on the next frame
+    void rowsPending();
+    // A prependMessages() page is laid out and the scroll position restored
+    void prependSettled();
+
+protected:
+    bool event(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    enum Kind { UserRow, AssistantRow, ThinkingRow, ToolsRow, EditRow };
+
+    struct Row {
+        Kind kind = UserRow;
+        int turnId = 0;
+        int first = 0;  // index into m_records
+        int count = 1;  // records covered (tool groups span several)
+        bool header = true;
+    };
+
+    static ToolCallInfo toolCallInfo(const MessageRecord &record);
+    static int poolKey(Kind kind) { return kind == EditRow ? ToolsRow : kind; }
+
+    // Rows for m_records[from...], continuing the grouping state
+    void groupRecords(int from);
+    void addRow(const Row &row);
+    int firstRowOfTurn(int turnId) const;
+    int estimateHeight(const Row &row) const;
+    int visibleTop() const;
+
+    void updateWindow();
+    void syncHeights();
+    void placeWidgets();
+    QWidget *acquire(int row);
+    void release(int row, QWidget *w);
+    void bind(QWidget *w, const Row &row);
+    QWidget *create(Kind kind);
+    int measure(QWidget *w) const;
+
+    QScrollArea *m_area;
+    QList<MessageRecord> m_records;
+    QList<Row> m_rows;
+    TranscriptIndex m_index;  // row heights including the gap below
+    QSet<int> m_checkpointTurns;
+
+    QMap<int, QWidget *> m_live;  // row -> bound widget
+    QList<int> m_wanted;          // rows in the window awaiting a widget, by priority
+    QHash<int, QList<QWidget *>> m_pool;
+
+    // Grouping state carried between appendMessages() calls
+    int m_openGroupRow = -1;
+    int m_lastTurn = -1;
+    bool m_turnHasAssistant = false;
+
+    int m_lastWidth = -1;
+    bool m_syncing = false;
+};
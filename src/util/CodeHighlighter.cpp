@@ -0,0 +1,642 @@
+#include "util/CodeHighlighter.h"
+#include <QCache>
+#include <QCryptographicHash>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStringList>
+
+// ---------------------------------------------------------------------------
+// Rule tables — one per language family, built on first use
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Rules {
+    QSet<QString> keywords;
+    QSet<QString> types;         // builtin types and literals
+    QStringList lineComments;
+    QString blockOpen, blockClose;
+    QString quotes;              // single-line string delimiters
+    bool tripleQuotes = false;   // """ / ''' strings may span lines
+    bool backticks = false;      // `template` strings may span lines
+    bool preprocessor = false;   // '#' directive lines
+    bool decorators = false;     // @name
+    bool variables = false;      // $name, ${...}, $(...)
+    bool markup = false;         // <tag ...>, quotes only inside tags
+    bool commands = false;       // \command
+    bool caseInsensitive = false;
+};
+
+enum LineState { Plain = 0, InBlockComment, InTripleDouble, InTripleSingle, InBacktick };
+
+QSet<QString> words(const char *list)
+{
+    QSet<QString> set;
+    for (const QString &w : QString::fromLatin1(list).split(' ', Qt::SkipEmptyParts))
+        set.insert(w);
+    return set;
+}
+
+const QHash<int, Rules> &ruleTable()
+{
+    static const QHash<int, Rules> table = [] {
+        using L = SourceLanguage;
+        QHash<int, Rules> t;
+
+        Rules cFamily;
+        cFamily.keywords = words(
+            "alignas alignof auto break case catch class const consteval constexpr constinit "
+            "continue co_await co_return co_yield concept decltype default delete do else enum "
+            "explicit export extern final for friend goto if inline mutable namespace new "
+            "noexcept operator override private protected public requires return sizeof static "
+            "static_assert static_cast dynamic_cast reinterpret_cast const_cast struct switch "
+            "template this throw try typedef typename union using virtual volatile while "
+            // Rust, Go, Swift, Kotlin, Dart... share the family
+            "fn let mut impl trait pub use mod match loop where crate move async await dyn "
+            "func var val package import type defer go chan select range interface fun when "
+            "object companion data sealed guard extension protocol init deinit");
+        cFamily.types = words(
+            "bool char char8_t char16_t char32_t double float int long short signed unsigned "
+            "void wchar_t size_t ssize_t ptrdiff_t int8_t int16_t int32_t int64_t uint8_t "
+            "uint16_t uint32_t uint64_t true false nullptr NULL i8 i16 i32 i64 u8 u16 u32 u64 "
+            "usize isize f32 f64 str String Vec Option Result Some None Ok Err Self self nil "
+            "string error byte rune");
+        cFamily.lineComments = {"//"};
+        cFamily.blockOpen = "/*";
+        cFamily.blockClose = "*/";
+        cFamily.quotes = "\"'";
+        cFamily.preprocessor = true;
+        cFamily.decorators = true;  // Swift/Kotlin attributes and annotations
+        t.insert(int(L::Cpp), cFamily);
+
+        Rules d = cFamily;
+        d.keywords += words("module import alias immutable scope shared pure nothrow unittest");
+        t.insert(int(L::D), d);
+
+        Rules java;
+        java.keywords = words(
+            "abstract assert break case catch class continue default do else enum extends final "
+            "finally for if implements import instanceof interface native new package private "
+            "protected public return static strictfp super switch synchronized this throw throws "
+            "transient try volatile while var record yield sealed permits");
+        java.types = words("boolean byte char double float int long short void true false null "
+                           "String Object Integer Long Boolean");
+        java.lineComments = {"//"};
+        java.blockOpen = "/*";
+        java.blockClose = "*/";
+        java.quotes = "\"'";
+        java.decorators = true;
+        t.insert(int(L::Java), java);
+
+        Rules cs = java;
+        cs.keywords = words(
+            "abstract as async await base break case catch checked class const continue default "
+            "delegate do else enum event explicit extern finally fixed for foreach goto if "
+            "implicit in interface internal is lock namespace new operator out override params "
+            "private protected public readonly ref return sealed sizeof stackalloc static struct "
+            "switch this throw try typeof unchecked unsafe using var virtual volatile while yield "
+            "record init get set");
+        cs.types = words("bool byte char decimal double float int long object sbyte short "
+                         "string uint ulong ushort void true false null dynamic");
+        cs.preprocessor = true;
+        cs.decorators = false;
+        t.insert(int(L::CSharp), cs);
+
+        Rules js;
+        js.keywords = words(
+            "async await break case catch class const continue debugger default delete do else "
+            "export extends finally for from function if import in instanceof let new of return "
+            "static super switch this throw try typeof var void while with yield as interface "
+            "type enum implements private protected public readonly declare namespace abstract "
+            "keyof get set");
+        js.types = words("true false null undefined NaN Infinity number string boolean any "
+                         "unknown never object symbol bigint");
+        js.lineComments = {"//"};
+        js.blockOpen = "/*";
+        js.blockClose = "*/";
+        js.quotes = "\"'";
+        js.backticks = true;
+        js.decorators = true;
+        t.insert(int(L::JavaScript), js);
+
+        Rules coffee = js;
+        coffee.lineComments = {"#"};
+        coffee.blockOpen = "###";
+        coffee.blockClose = "###";
+        coffee.keywords += words("then unless until loop by when and or is isnt not yes no on off");
+        t.insert(int(L::CoffeeScript), coffee);
+
+        Rules py;
+        py.keywords = words(
+            "and as assert async await break class continue def del elif else except finally for "
+            "from global if import in is lambda nonlocal not or pass raise return try while with "
+            "yield match case");
+        py.types = words("True False None self cls int float str bool list dict set tuple bytes "
+                         "object");
+        py.lineComments = {"#"};
+        py.quotes = "\"'";
+        py.tripleQuotes = true;
+        py.decorators = true;
+        t.insert(int(L::Python), py);
+
+        Rules ruby;
+        ruby.keywords = words(
+            "alias and begin break case class def do else elsif end ensure for if in module next "
+            "not or redo rescue retry return super then undef unless until when while yield "
+            "require require_relative attr_accessor attr_reader attr_writer include extend");
+        ruby.types = words("true false nil self");
+        ruby.lineComments = {"#"};
+        ruby.quotes = "\"'";
+        ruby.decorators = true;  // @ivar
+        t.insert(int(L::Ruby), ruby);
+
+        Rules sh;
+        sh.keywords = words(
+            "if then else elif fi case esac for while until do done in function return local "
+            "export readonly declare unset shift exit break continue source alias set select");
+        sh.types = words("echo printf cd ls grep sed awk cat mkdir rm cp mv test true false "
+                         "sudo git make cmake npm pip curl chmod");
+        sh.lineComments = {"#"};
+        sh.quotes = "\"'";
+        sh.variables = true;
+        t.insert(int(L::Bash), sh);
+
+        Rules sql;
+        sql.keywords = words(
+            "select from where insert into values update set delete create table index view "
+            "drop alter add column primary key foreign references join inner left right outer "
+            "full cross on group by order having limit offset union all distinct as and or not "
+            "null is in exists between like glob case when then else end begin commit rollback "
+            "transaction if default unique constraint check with recursive returning explain "
+            "query plan pragma trigger virtual using asc desc");
+        sql.types = words("integer int text real blob varchar char boolean date timestamp "
+                          "numeric bigint serial true false");
+        sql.lineComments = {"--"};
+        sql.blockOpen = "/*";
+        sql.blockClose = "*/";
+        sql.quotes = "'\"";
+        sql.caseInsensitive = true;
+        t.insert(int(L::Sql), sql);
+
+        Rules lua;
+        lua.keywords = words("and break do else elseif end for function goto if in local not or "
+                             "repeat return then until while");
+        lua.types = words("nil true false self");
+        lua.lineComments = {"--"};
+        lua.quotes = "\"'";
+        t.insert(int(L::Lua), lua);
+
+        Rules perl;
+        perl.keywords = words("my our local sub if elsif else unless while until for foreach do "
+                              "last next redo return use require package print");
+        perl.lineComments = {"#"};
+        perl.quotes = "\"'";
+        perl.variables = true;
+        t.insert(int(L::Perl), perl);
+
+        Rules tcl;
+        tcl.keywords = words("proc set if else elseif for foreach while return puts expr "
+                             "namespace variable global");
+        tcl.lineComments = {"#"};
+        tcl.quotes = "\"";
+        tcl.variables = true;
+        t.insert(int(L::Tcl), tcl);
+
+        Rules make;
+        make.keywords = words("ifeq ifneq ifdef ifndef else endif include define endef export "
+                              "override .PHONY");
+        make.lineComments = {"#"};
+        make.variables = true;
+        t.insert(int(L::Makefile), make);
+
+        Rules cmake;
+        cmake.keywords = words(
+            "if elseif else endif foreach endforeach while endwhile function endfunction macro "
+            "endmacro return set unset option project add_executable add_library "
+            "target_link_libraries target_include_directories target_compile_definitions "
+            "target_sources find_package include message install add_subdirectory list string "
+            "cmake_minimum_required");
+        cmake.lineComments = {"#"};
+        cmake.quotes = "\"";
+        cmake.variables = true;
+        cmake.caseInsensitive = true;
+        t.insert(int(L::CMake), cmake);
+
+        Rules css;
+        css.blockOpen = "/*";
+        css.blockClose = "*/";
+        css.quotes = "\"'";
+        css.decorators = true;  // @media, @import
+        css.types = words("important inherit initial none auto");
+        t.insert(int(L::Css), css);
+
+        Rules json;
+        json.quotes = "\"";
+        json.types = words("true false null");
+        t.insert(int(L::Json), json);
+
+        Rules yaml;
+        yaml.lineComments = {"#"};
+        yaml.quotes = "\"'";
+        yaml.types = words("true false null yes no on off");
+        t.insert(int(L::Yaml), yaml);
+
+        Rules props;
+        props.lineComments = {"#", ";"};
+        props.quotes = "\"'";
+        props.types = words("true false");
+        t.insert(int(L::Properties), props);
+
+        Rules batch;
+        batch.keywords = words("if else for in do goto call set echo exit not exist defined "
+                               "errorlevel setlocal endlocal");
+        batch.lineComments = {"rem ", "REM ", "::"};
+        batch.quotes = "\"";
+        batch.caseInsensitive = true;
+        t.insert(int(L::Batch), batch);
+
+        Rules pascal;
+        pascal.keywords = words(
+            "begin end program procedure function var const type if then else for to downto do "
+            "while repeat until case of record array uses unit interface implementation class "
+            "and or not div mod");
+        pascal.types = words("integer real boolean char string true false nil");
+        pascal.lineComments = {"//"};
+        pascal.blockOpen = "{";
+        pascal.blockClose = "}";
+        pascal.quotes = "'";
+        pascal.caseInsensitive = true;
+        t.insert(int(L::Pascal), pascal);
+
+        Rules fortran;
+        fortran.keywords = words("program end subroutine function module use implicit none if "
+                                 "then else do call return contains allocate deallocate");
+        fortran.types = words("integer real character logical complex double precision");
+        fortran.lineComments = {"!"};
+        fortran.quotes = "\"'";
+        fortran.caseInsensitive = true;
+        t.insert(int(L::Fortran), fortran);
+
+        Rules tex;
+        tex.lineComments = {"%"};
+        tex.commands = true;
+        t.insert(int(L::TeX), tex);
+
+        Rules markup;
+        markup.blockOpen = "<!--";
+        markup.blockClose = "-->";
+        markup.quotes = "\"'";
+        markup.markup = true;
+        t.insert(int(L::Html), markup);
+        t.insert(int(L::Xml), markup);
+
+        return t;
+    }();
+    return table;
+}
+
+const Rules *rulesFor(SourceLanguage language)
+{
+    const auto &table = ruleTable();
+    auto it = table.constFind(int(language));
+    return it == table.cend() ? nullptr : &it.value();
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+// ---------------------------------------------------------------------------
+
+bool isWordStart(QChar c) { return c.isLetter() || c == '_'; }
+bool isWordChar(QChar c) { return c.isLetterOrNumber() || c == '_'; }
+
+bool matchesAt(const QString &text, int pos, const QString &token)
+{
+    return !token.isEmpty() && QStringView(text).mid(pos).startsWith(token);
+}
+
+void appendEscaped(QString &out, const QString &text, int from, int to)
+{
+    for (int i = from; i < to; ++i) {
+        const QChar c = text[i];
+        switch (c.unicode()) {
+        case '&': out += QLatin1String("&amp;"); break;
+        case '<': out += QLatin1String("&lt;"); break;
+        case '>': out += QLatin1String("&gt;"); break;
+        case '"': out += QLatin1String("&quot;"); break;
+        default:  out += c; break;
+        }
+    }
+}
+
+// Index of `close` at or after `from`, skipping backslash escapes
+int findClose(const QString &line, int from, const QString &close, bool escapes)
+{
+    for (int i = from; i < line.size(); ++i) {
+        if (escapes && line[i] == '\\') {
+            ++i;
+            continue;
+        }
+        if (matchesAt(line, i, close))
+            return i;
+    }
+    return -1;
+}
+
+QString tokenize(const Rules &r, const QString &line, const HighlightColors &c, int &state)
+{
+    const int n = line.size();
+    QString out;
+    out.reserve(n * 2);
+    int i = 0;
+
+    auto span = [&](const QString &color, int from, int to) {
+        if (to <= from) return;
+        out += QLatin1String("<span style='color:") + color + QLatin1String(";'>");
+        appendEscaped(out, line, from, to);
+        out += QLatin1String("</span>");
+    };
+    // Continue a comment or string that began on an earlier line
+    auto resume = [&](const QString &close, const QString &color, bool escapes) {
+        const int end = findClose(line, 0, close, escapes);
+        if (end < 0) {
+            span(color, 0, n);
+            i = n;
+            return;
+        }
+        i = end + close.size();
+        span(color, 0, i);
+        state = Plain;
+    };
+    switch (state) {
+    case InBlockComment: resume(r.blockClose, c.comment, false); break;
+    case InTripleDouble: resume(QStringLiteral("\"\"\""), c.string, true); break;
+    case InTripleSingle: resume(QStringLiteral("'''"), c.string, true); break;
+    case InBacktick:     resume(QStringLiteral("`"), c.string, true); break;
+    default: break;
+    }
+
+    int firstText = 0;
+    while (firstText < n && line[firstText].isSpace())
+        ++firstText;
+    bool inTag = false;
+
+    while (i < n) {
+        const QChar ch = line[i];
+
+        if (r.preprocessor && ch == '#' && i == firstText) {
+            span(c.preprocessor, i, n);
+            break;
+        }
+        bool lineComment = false;
+        for (const QString &prefix : r.lineComments) {
+            if (matchesAt(line, i, prefix)) {
+                lineComment = true;
+                break;
+            }
+        }
+        if (lineComment) {
+            span(c.comment, i, n);
+            break;
+        }
+        if (matchesAt(line, i, r.blockOpen)) {
+            const int end = line.indexOf(r.blockClose, i + r.blockOpen.size());
+            if (end < 0) {
+                span(c.comment, i, n);
+                state = InBlockComment;
+                break;
+            }
+            span(c.comment, i, end + r.blockClose.size());
+            i = end + r.blockClose.size();
+            continue;
+        }
+        if (r.tripleQuotes && (matchesAt(line, i, QStringLiteral("\"\"\""))
+                               || matchesAt(line, i, QStringLiteral("'''")))) {
+            const QString delim = line.mid(i, 3);
+            const int end = findClose(line, i + 3, delim, true);
+            if (end < 0) {
+                span(c.string, i, n);
+                state = delim[0] == '"' ? InTripleDouble : InTripleSingle;
+                break;
+            }
+            span(c.string, i, end + 3);
+            i = end + 3;
+            continue;
+        }
+        if (r.backticks && ch == '`') {
+            const int end = findClose(line, i + 1, QStringLiteral("`"), true);
+            if (end < 0) {
+                span(c.string, i, n);
+                state = InBacktick;
+                break;
+            }
+            span(c.string, i, end + 1);
+            i = end + 1;
+            continue;
+        }
+        if (r.quotes.contains(ch) && (!r.markup || inTag)) {
+            const int end = findClose(line, i + 1, QString(ch), true);
+            // A lone apostrophe (Rust lifetime, prose) is not a string
+            if (end >= 0 || ch != '\'') {
+                const int stop = end < 0 ? n : end + 1;
+                span(c.string, i, stop);
+                i = stop;
+                continue;
+            }
+        }
+        if (ch.isDigit() && (i == 0 || !isWordChar(line[i - 1]))) {
+            int j = i + 1;
+            while (j < n && (line[j].isLetterOrNumber() || line[j] == '.' || line[j] == '_'))
+                ++j;
+            span(c.number, i, j);
+            i = j;
+            continue;
+        }
+        if (isWordStart(ch)) {
+            int j = i + 1;
+            while (j < n && isWordChar(line[j]))
+                ++j;
+            const QString word = line.mid(i, j - i);
+            const QString probe = r.caseInsensitive ? word.toLower() : word;
+            if (r.keywords.contains(probe))
+                span(c.keyword, i, j);
+            else if (r.types.contains(probe))
+                span(c.type, i, j);
+            else
+                appendEscaped(out, line, i, j);
+            i = j;
+            continue;
+        }
+        if (r.decorators && ch == '@' && i + 1 < n && isWordStart(line[i + 1])) {
+            int j = i + 2;
+            while (j < n && (isWordChar(line[j]) || line[j] == '.'))
+                ++j;
+            span(c.preprocessor, i, j);
+            i = j;
+            continue;
+        }
+        if (r.variables && ch == '$' && i + 1 < n) {
+            int j = i + 1;
+            const QChar open = line[j];
+            if (open == '{' || open == '(') {
+                const int close = line.indexOf(open == '{' ? '}' : ')', j + 1);
+                j = close < 0 ? n : close + 1;
+            } else {
+                // $1, $@, $? and friends are one character
+                if (QStringLiteral("@#?*!").contains(open))
+                    ++j;
+                else
+                    while (j < n && isWordChar(line[j]))
+                        ++j;
+            }
+            if (j > i + 1) {
+                span(c.preprocessor, i, j);
+                i = j;
+                continue;
+            }
+        }
+        if (r.markup && ch == '<') {
+            int j = i + 1;
+            if (j < n && (line[j] == '/' || line[j] == '!' || line[j] == '?'))
+                ++j;
+            while (j < n && (isWordChar(line[j]) || line[j] == '-' || line[j] == ':' || line[j] == '.'))
+                ++j;
+            if (j > i + 1) {
+                span(c.keyword, i, j);
+                inTag = true;
+                i = j;
+                continue;
+            }
+        }
+        if (r.markup && inTag && (ch == '>' || matchesAt(line, i, QStringLiteral("/>")))) {
+            const int len = ch == '>' ? 1 : 2;
+            span(c.keyword, i, i + len);
+            inTag = false;
+            i += len;
+            continue;
+        }
+        if (r.commands && ch == '\\' && i + 1 < n && line[i + 1].isLetter()) {
+            int j = i + 1;
+            while (j < n && line[j].isLetter())
+                ++j;
+            span(c.keyword, i, j);
+            i = j;
+            continue;
+        }
+
+        appendEscaped(out, line, i, i + 1);
+        ++i;
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Caches
+// ---------------------------------------------------------------------------
+
+struct LineEntry {
+    QString html;
+    int state = Plain;
+};
+
+constexpr qsizetype kBlockCacheBytes = 8 * 1024 * 1024;
+constexpr qsizetype kLineCacheBytes = 4 * 1024 * 1024;
+
+QMutex g_cacheMutex;
+QCache<QString, QString> g_blocks(kBlockCacheBytes);
+QCache<QString, LineEntry> g_lines(kLineCacheBytes);
+CodeHighlighter::Stats g_stats;
+
+QString cachePrefix(SourceLanguage language, const HighlightColors &colors)
+{
+    return QString::number(int(language)) + ':' + colors.key() + ':';
+}
+
+} // namespace
+
+bool CodeHighlighter::hasRules(SourceLanguage language)
+{
+    return rulesFor(language) != nullptr;
+}
+
+QString CodeHighlighter::highlightLine(SourceLanguage language, const QString &line,
+                                       const HighlightColors &colors, int &state)
+{
+    const Rules *rules = rulesFor(language);
+    if (!rules) {
+        QString out;
+        appendEscaped(out, line, 0, line.size());
+        return out;
+    }
+
+    const QString key = cachePrefix(language, colors) + QString::number(state) + ':' + line;
+    {
+        QMutexLocker lock(&g_cacheMutex);
+        if (const LineEntry *hit = g_lines.object(key)) {
+            ++g_stats.lineHits;
+            state = hit->state;
+            return hit->html;
+        }
+        ++g_stats.lineMisses;
+    }
+
+    auto *entry = new LineEntry;
+    int endState = state;
+    entry->html = tokenize(*rules, line, colors, endState);
+    entry->state = endState;
+    const QString html = entry->html;
+    state = endState;
+
+    QMutexLocker lock(&g_cacheMutex);
+    g_lines.insert(key, entry, (key.size() + html.size()) * 2);
+    return html;
+}
+
+QString CodeHighlighter::highlight(SourceLanguage language, const QString &code,
+                                   const HighlightColors &colors, bool complete)
+{
+    QString blockKey;
+    if (complete) {
+        blockKey = cachePrefix(language, colors) + QString::fromLatin1(
+            QCryptographicHash::hash(code.toUtf8(), QCryptographicHash::Sha1).toHex());
+        QMutexLocker lock(&g_cacheMutex);
+        if (const QString *hit = g_blocks.object(blockKey)) {
+            ++g_stats.blockHits;
+            return *hit;
+        }
+        ++g_stats.blockMisses;
+    }
+
+    QString html;
+    html.reserve(code.size() * 2);
+    int state = Plain;
+    int lineStart = 0;
+    while (true) {
+        const int nl = code.indexOf('\n', lineStart);
+        const QString line = code.mid(lineStart, nl < 0 ? -1 : nl - lineStart);
+        html += highlightLine(language, line, colors, state);
+        if (nl < 0) break;
+        html += '\n';
+        lineStart = nl + 1;
+    }
+
+    if (complete) {
+        QMutexLocker lock(&g_cacheMutex);
+        g_blocks.insert(blockKey, new QString(html), html.size() * 2);
+    }
+    return html;
+}
+
+CodeHighlighter::Stats CodeHighlighter::stats()
+{
+    QMutexLocker lock(&g_cacheMutex);
+    return g_stats;
+}
+
+void CodeHighlighter::clearCaches()
+{
+    QMutexLocker lock(&g_cacheMutex);
+    g_blocks.clear();
+    g_lines.clear();
+}
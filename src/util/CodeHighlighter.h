@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QString>
+#include "util/LanguageMap.h"
+
+// Colors of the token classes, as "#rrggbb"
+struct HighlightColors {
+    QString keyword, type, string, number, comment, preprocessor;
+
+    QString key() const
+    {
+        return keyword + type + string + number + comment + preprocessor;
+    }
+};
+
+// Syntax highlighting for code blocks in chat. Each language family has a
+// rule table (keywords, builtin types, comment and string delimiters) built
+// once; the tokenizer runs line by line with the open comment/string state
+// carried over, which is all it needs to resume mid-block.
+//
+// Two caches make repeats free: whole blocks by (language, colors, code
+// hash), and single lines by (language, colors, incoming state, text). A
+// block that is still streaming in re-highlights only its new lines.
+// Thread-safe; the markdown render workers share the caches with the GUI.
+class CodeHighlighter {
+public:
+    // Escaped HTML with colored spans, lines separated by '\n'. Pass
+    // complete = false while the block is still growing so the partial text
+    // is not stored as a whole block.
+    static QString highlight(SourceLanguage language, const QString &code,
+                             const HighlightColors &colors, bool complete = true);
+
+    // Returns the escaped line with spans; `state` is the state at the start
+    // of the line on entry and at its end on return (0 = none open)
+    static QString highlightLine(SourceLanguage language, const QString &line,
+                                 const HighlightColors &colors, int &state);
+
+    static bool hasRules(SourceLanguage language);
+
+    struct Stats {
+        qint64 blockHits = 0, blockMisses = 0;
+        qint64 lineHits = 0, lineMisses = 0;
+    };
+    static Stats stats();
+    static void clearCaches();
+};
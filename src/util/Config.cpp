@@ -49,6 +49,7 @@ void Config::setSuppressAutoSave(bool suppress)
 
 void Config::autoSave()
 {
+    emit changed();
     if (!m_suppressSave)
         save();
 }
@@ -92,6 +93,45 @@ void Config::setLastWorkspace(const QString &path)
     autoSave();
 }
 
+bool Config::persistentSessions() const
+{
+    if (m_data.contains("persistent_sessions") && m_data["persistent_sessions"].is_boolean())
+        return m_data["persistent_sessions"].get<bool>();
+    return true;
+}
+
+void Config::setPersistentSessions(bool enabled)
+{
+    m_data["persistent_sessions"] = enabled;
+    autoSave();
+}
+
+int Config::processPoolSize() const
+{
+    if (m_data.contains("process_pool_size") && m_data["process_pool_size"].is_number_integer())
+        return m_data["process_pool_size"].get<int>();
+    return 2;
+}
+
+void Config::setProcessPoolSize(int size)
+{
+    m_data["process_pool_size"] = size;
+    autoSave();
+}
+
+QString Config::streamCaptureDir() const
+{
+    if (m_data.contains("stream_capture_dir") && m_data["stream_capture_dir"].is_string())
+        return QString::fromStdString(m_data["stream_capture_dir"].get<std::string>());
+    return {};
+}
+
+void Config::setStreamCaptureDir(const QString &dir)
+{
+    m_data["stream_capture_dir"] = dir.toStdString();
+    autoSave();
+}
+
 bool Config::telegramEnabled() const
 {
     if (m_data.contains("telegram_enabled") && m_data["telegram_enabled"].is_boolean())
@@ -21,6 +21,16 @@ public:
     QString lastWorkspace() const;
     void setLastWorkspace(const QString &path);
 
+    // Keep one claude process alive per chat tab across turns
+    bool persistentSessions() const;
+    void setPersistentSessions(bool enabled);
+    // Number of claude processes kept started ahead of time for new sessions
+    int processPoolSize() const;
+    void setProcessPoolSize(int size);
+    // When set, raw claude stdout is recorded here for bench_stream replay
+    QString streamCaptureDir() const;
+    void setStreamCaptureDir(const QString &dir);
+
     bool telegramEnabled() const;
     void setTelegramEnabled(bool enabled);
     QString telegramBotToken() const;
@@ -31,6 +41,9 @@ public:
     nlohmann::json &rawData() { return m_data; }
     const nlohmann::json &rawData() const { return m_data; }
 
+signals:
+    void changed();
+
 private:
     Config();
     void autoSave();
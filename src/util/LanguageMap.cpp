@@ -0,0 +1,99 @@
+#include "util/LanguageMap.h"
+#include <QFileInfo>
+#include <QHash>
+#include <initializer_list>
+
+SourceLanguage languageForFile(const QString &filePath)
+{
+    using L = SourceLanguage;
+    const QFileInfo fi(filePath);
+    const QString ext = fi.suffix().toLower();
+    const QString name = fi.fileName().toLower();
+
+    // --- By filename first (for extensionless files) ---
+    if (name == "makefile" || name == "gnumakefile")
+        return L::Makefile;
+    if (name == "cmakelists.txt")
+        return L::CMake;
+    if (name == "dockerfile" || name.startsWith("dockerfile."))
+        return L::Bash;
+    if (name == "gemfile" || name == "rakefile" || name == "vagrantfile")
+        return L::Ruby;
+    if (name == ".bashrc" || name == ".bash_profile" || name == ".zshrc" ||
+        name == ".profile" || name == ".zprofile")
+        return L::Bash;
+
+    // --- By extension ---
+    static const QHash<QString, SourceLanguage> byExtension = [] {
+        QHash<QString, SourceLanguage> map;
+        auto add = [&map](SourceLanguage lang, std::initializer_list<const char *> exts) {
+            for (const char *e : exts)
+                map.insert(QString::fromLatin1(e), lang);
+        };
+        add(L::Cpp, {"cpp", "cxx", "cc", "c", "h", "hpp", "hxx", "m", "mm", "ino", "pde"});
+        add(L::Java, {"java"});
+        add(L::CSharp, {"cs"});
+        add(L::JavaScript, {"js", "ts", "jsx", "tsx", "mjs", "cjs"});
+        add(L::Python, {"py", "pyw", "pyi", "pyx"});
+        add(L::Ruby, {"rb", "rake", "gemspec"});
+        // C-family syntax — the C++ rules are a reasonable approximation
+        add(L::Cpp, {"rs", "go", "swift", "kt", "kts", "dart", "scala", "groovy",
+                     "gradle", "proto", "thrift"});
+        add(L::Html, {"html", "htm", "vue", "svelte", "astro", "erb", "ejs", "hbs",
+                      "twig", "njk", "blade", "php", "phtml"});
+        add(L::Css, {"css", "scss", "sass", "less"});
+        add(L::Xml, {"xml", "xsl", "xslt", "xsd", "svg", "plist", "csproj", "fsproj",
+                     "vcxproj", "sln", "xaml", "wsdl", "rss", "atom", "ui"});
+        add(L::Json, {"json", "jsonc", "geojson", "jsonl", "json5"});
+        add(L::Yaml, {"yml", "yaml"});
+        add(L::Sql, {"sql", "ddl", "dml", "pgsql", "plsql", "mysql"});
+        add(L::Bash, {"sh", "bash", "zsh", "fish", "ksh", "csh", "tcsh"});
+        add(L::Lua, {"lua"});
+        add(L::Perl, {"pl", "pm", "pod", "t"});
+        add(L::Makefile, {"mk"});
+        add(L::CMake, {"cmake"});
+        add(L::Markdown, {"md", "markdown", "mdx", "rst"});
+        add(L::Diff, {"diff", "patch"});
+        add(L::Batch, {"bat", "cmd"});
+        add(L::Properties, {"ini", "cfg", "conf", "properties", "env", "toml",
+                            "editorconfig", "gitconfig"});
+        add(L::TeX, {"tex", "latex", "sty", "cls", "bib"});
+        add(L::D, {"d"});
+        add(L::Pascal, {"pas", "pp", "dpr", "lpr"});
+        add(L::Fortran, {"f", "for", "f90", "f95", "f03"});
+        add(L::Tcl, {"tcl", "tk"});
+        add(L::CoffeeScript, {"coffee", "litcoffee"});
+        // No dedicated R lexer in QScintilla; Python is a reasonable fallback
+        add(L::Python, {"r", "rmd"});
+        return map;
+    }();
+    return byExtension.value(ext, L::None);
+}
+
+SourceLanguage languageForFenceTag(const QString &tag)
+{
+    using L = SourceLanguage;
+    // "```python title=x.py" — only the first word names the language
+    const QString word = tag.section(' ', 0, 0).trimmed().toLower();
+    if (word.isEmpty())
+        return L::None;
+
+    static const QHash<QString, SourceLanguage> byName = {
+        {"c++", L::Cpp}, {"objective-c", L::Cpp}, {"objc", L::Cpp},
+        {"rust", L::Cpp}, {"golang", L::Cpp}, {"kotlin", L::Cpp},
+        {"c#", L::CSharp}, {"csharp", L::CSharp},
+        {"javascript", L::JavaScript}, {"typescript", L::JavaScript},
+        {"node", L::JavaScript},
+        {"python", L::Python}, {"python3", L::Python}, {"ruby", L::Ruby},
+        {"shell", L::Bash}, {"console", L::Bash}, {"shellsession", L::Bash},
+        {"dockerfile", L::Bash},
+        {"makefile", L::Makefile}, {"make", L::Makefile},
+        {"perl", L::Perl}, {"latex", L::TeX}, {"pascal", L::Pascal},
+        {"fortran", L::Fortran}, {"coffeescript", L::CoffeeScript},
+        {"batch", L::Batch}, {"text", L::None}, {"plaintext", L::None},
+    };
+    auto it = byName.constFind(word);
+    if (it != byName.cend())
+        return it.value();
+    return languageForFile(QStringLiteral("file.") + word);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QString>
+
+// Syntax families the editor has a lexer for. Languages without their own
+// family use the nearest one (Rust, Go, Swift, Kotlin... are C-like, R reads
+// well enough as Python).
+enum class SourceLanguage {
+    None,
+    Cpp, Java, CSharp, JavaScript, Python, Ruby,
+    Html, Css, Xml, Json, Yaml, Sql, Bash, Lua, Perl,
+    Makefile, CMake, Markdown, Diff, Batch, Properties,
+    TeX, D, Pascal, Fortran, Tcl, CoffeeScript
+};
+
+// By file name first (Makefile, Dockerfile, dotfiles), then by extension
+SourceLanguage languageForFile(const QString &filePath);
+
+// Info string of a fenced code block: common names ("python", "c++",
+// "shell"...) and anything that works as a file extension ("py", "tsx")
+SourceLanguage languageForFenceTag(const QString &tag);
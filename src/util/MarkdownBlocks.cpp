@@ -0,0 +1,80 @@
+#include "util/MarkdownBlocks.h"
+
+static bool isFenceLine(const QString &text, int start, int end)
+{
+    int i = start;
+    while (i < end && (text[i] == ' ' || text[i] == '\t'))
+        ++i;
+    return end - i >= 3 && text[i] == '`' && text[i + 1] == '`' && text[i + 2] == '`';
+}
+
+static bool isBlankLine(const QString &text, int start, int end)
+{
+    for (int i = start; i < end; ++i) {
+        if (!text[i].isSpace())
+            return false;
+    }
+    return true;
+}
+
+void MarkdownBlockSplitter::reset()
+{
+    m_closed.clear();
+    m_scanPos = 0;
+    m_blockStart = 0;
+    m_inFence = false;
+    m_blockHasText = false;
+}
+
+QString MarkdownBlockSplitter::openTail(const QString &text) const
+{
+    QString tail = text.mid(m_blockStart);
+    while (tail.endsWith('\n'))
+        tail.chop(1);
+    return tail;
+}
+
+void MarkdownBlockSplitter::close(int end, int next)
+{
+    // `end` points at the newline that terminates the block
+    m_closed.append({m_blockStart, end - m_blockStart});
+    m_blockStart = next;
+    m_blockHasText = false;
+}
+
+int MarkdownBlockSplitter::update(const QString &text)
+{
+    const int before = m_closed.size();
+
+    // Only complete lines: an unterminated last line may still become a
+    // fence marker or turn blank-looking whitespace into text
+    while (true) {
+        const int newline = text.indexOf('\n', m_scanPos);
+        if (newline < 0)
+            break;
+        const int lineStart = m_scanPos;
+        m_scanPos = newline + 1;
+
+        if (m_inFence) {
+            if (isFenceLine(text, lineStart, newline)) {
+                m_inFence = false;
+                close(newline, m_scanPos);
+            }
+        } else if (isFenceLine(text, lineStart, newline)) {
+            // A fence starts its own block so the code renders as one unit
+            if (m_blockHasText)
+                close(lineStart - 1, lineStart);
+            m_inFence = true;
+            m_blockHasText = true;
+        } else if (isBlankLine(text, lineStart, newline)) {
+            if (m_blockHasText)
+                close(lineStart - 1, m_scanPos);
+            else
+                m_blockStart = m_scanPos; // drop leading blank lines
+        } else {
+            m_blockHasText = true;
+        }
+    }
+
+    return m_closed.size() - before;
+}
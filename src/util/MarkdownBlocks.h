@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+// Splits streaming markdown into top-level blocks that render independently.
+// A block is closed once later text can no longer change it: a blank line
+// outside a code fence ends a paragraph, list or table, and a closing ```
+// ends a fenced block. Everything after the last closed block is the open
+// tail. update() only scans text it has not seen, so following a growing
+// string costs time proportional to what was appended.
+class MarkdownBlockSplitter {
+public:
+    struct Block {
+        int start = 0;
+        int length = 0; // excludes the terminating newline
+    };
+
+    void reset();
+    // Scans the complete lines appended to `text` since the last call and
+    // returns how many blocks closed. `text` may only grow between resets.
+    int update(const QString &text);
+
+    const QVector<Block> &closedBlocks() const { return m_closed; }
+    // Offset of the open tail in `text` (== its length when nothing is open)
+    int openStart() const { return m_blockStart; }
+    // The open tail of `text` without trailing newlines, as it is rendered
+    QString openTail(const QString &text) const;
+    bool inFence() const { return m_inFence; }
+
+private:
+    void close(int end, int next);
+
+    QVector<Block> m_closed;
+    int m_scanPos = 0;
+    int m_blockStart = 0;
+    bool m_inFence = false;
+    bool m_blockHasText = false;
+};
@@ -0,0 +1,99 @@
+#include "util/MarkdownRenderService.h"
+#include "util/MarkdownBlocks.h"
+#include "util/MarkdownRenderer.h"
+#include "util/RenderCache.h"
+#include "ui/ThemePalette.h"
+#include <QPointer>
+#include <QThread>
+
+MarkdownRenderService &MarkdownRenderService::instance()
+{
+    static MarkdownRenderService service;
+    return service;
+}
+
+quint64 MarkdownRenderService::nextId()
+{
+    static quint64 next = 0;
+    return ++next;
+}
+
+MarkdownRenderService::MarkdownRenderService(QObject *parent)
+    : QObject(parent)
+{
+    // Leave a core for the GUI thread; more than a few workers only queue
+    // up behind each other on one long transcript
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 3));
+}
+
+bool MarkdownRenderService::isCached(const QString &markdown, const QString &styleKey) const
+{
+    auto &cache = RenderCache::instance();
+    MarkdownBlockSplitter blocks;
+    blocks.update(markdown);
+
+    int base = 0;
+    for (const auto &block : blocks.closedBlocks()) {
+        const RenderedMarkdown *hit = cache.peek(
+            RenderCache::key(markdown.mid(block.start, block.length), base, styleKey));
+        if (!hit) return false;
+        base += hit->codeBlocks.size();
+    }
+    const QString tail = blocks.openTail(markdown);
+    return tail.trimmed().isEmpty()
+        || cache.peek(RenderCache::key(tail, base, styleKey)) != nullptr;
+}
+
+void MarkdownRenderService::request(quint64 id, const QString &markdown,
+                                    const ThemePalette &palette, QObject *context,
+                                    std::function<void()> done)
+{
+    cancel(id);
+    auto stale = std::make_shared<std::atomic_bool>(false);
+    m_live.insert(id, stale);
+
+    QPointer<QObject> guard(context);
+    m_pool.start([this, id, markdown, palette, stale, guard, done = std::move(done)] {
+        if (*stale) return;
+
+        MarkdownRenderer renderer(palette);
+        renderer.setHighlightCode(true);
+        const QString styleKey = renderer.styleKey();
+        MarkdownBlockSplitter blocks;
+        blocks.update(markdown);
+
+        QList<QPair<QString, RenderedMarkdown>> results;
+        int base = 0;
+        auto render = [&](const QString &text) {
+            renderer.setCodeBlockIndexBase(base);
+            RenderedMarkdown out;
+            out.html = renderer.toHtml(text);
+            out.codeBlocks = renderer.lastCodeBlocks();
+            results.append({RenderCache::key(text, base, styleKey), out});
+            base += out.codeBlocks.size();
+        };
+        for (const auto &block : blocks.closedBlocks()) {
+            if (*stale) return;
+            render(markdown.mid(block.start, block.length));
+        }
+        const QString tail = blocks.openTail(markdown);
+        if (!tail.trimmed().isEmpty())
+            render(tail);
+
+        QMetaObject::invokeMethod(this, [this, id, stale, guard, done, results] {
+            if (*stale) return;
+            m_live.remove(id);
+            auto &cache = RenderCache::instance();
+            for (const auto &r : results)
+                cache.insert(r.first, r.second);
+            if (guard && done)
+                done();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MarkdownRenderService::cancel(quint64 id)
+{
+    if (StaleFlag stale = m_live.take(id))
+        *stale = true;
+}
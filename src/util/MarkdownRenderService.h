@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+struct ThemePalette;
+
+// Markdown conversion off the GUI thread. A request names the slot it is for
+// (a widget's render id), the text and a palette snapshot. A pool worker
+// splits the text into blocks the way ChatMessageWidget does and renders them
+// with its own MarkdownRenderer. Back on the GUI thread the blocks go into
+// RenderCache and `done` runs, so the caller's next render is all cache hits.
+//
+// A newer request or cancel() for the same id makes the older one stale: a
+// worker that has not started it skips it, one that has stops between blocks,
+// and a result that still arrives is dropped.
+class MarkdownRenderService : public QObject {
+    Q_OBJECT
+public:
+    static MarkdownRenderService &instance();
+    static quint64 nextId();
+
+    // True when every block of `markdown` is in RenderCache already
+    bool isCached(const QString &markdown, const QString &styleKey) const;
+
+    void request(quint64 id, const QString &markdown, const ThemePalette &palette,
+                 QObject *context, std::function<void()> done);
+    void cancel(quint64 id);
+
+    int pendingCount() const { return m_live.size(); }
+    // Blocks until queued work is done; results are still delivered through
+    // the event loop
+    void waitForDone() { m_pool.waitForDone(); }
+
+private:
+    explicit MarkdownRenderService(QObject *parent = nullptr);
+
+    using StaleFlag = std::shared_ptr<std::atomic_bool>;
+
+    QThreadPool m_pool;
+    QHash<quint64, StaleFlag> m_live;  // id -> flag of its current request
+};
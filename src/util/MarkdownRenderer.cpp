@@ -1,256 +1,353 @@
 #include "util/MarkdownRenderer.h"
 #include "ui/ThemeManager.h"
-#include <QRegularExpression>
-#include <QFileInfo>
+#include <QCryptographicHash>
 
 // ---------------------------------------------------------------------------
-// Placeholder helpers — control characters that never appear in markdown.
-// Format:  \x01\x02{index}\x02\x01
-// These are inert to every inline-formatting regex (no |, *, #, -, etc.).
+// Atoms — rendered code and tables stand in the working text as
+//   U+FFFC {index} U+FFFC
+// until the final pass. U+FFFC is stripped from the input, and the token is
+// inert to every line and inline rule (no |, *, #, -, digits at line start).
 // ---------------------------------------------------------------------------
 
-QString MarkdownRenderer::placeholder(int index)
+static const QChar kAtom(0xFFFC);
+
+static QString atomToken(int index)
+{
+    return kAtom + QString::number(index) + kAtom;
+}
+
+static void appendAtom(QString &work, QVector<QString> &atoms, const QString &html)
+{
+    work += atomToken(atoms.size());
+    atoms.append(html);
+}
+
+// Replaces every atom token in `text` with its HTML
+static QString expandAtoms(const QString &text, const QVector<QString> &atoms)
+{
+    int open = text.indexOf(kAtom);
+    if (open < 0)
+        return text;
+
+    QString out;
+    out.reserve(text.size() * 2);
+    int copied = 0;
+    while (open >= 0) {
+        const int close = text.indexOf(kAtom, open + 1);
+        if (close < 0)
+            break;
+        out += text.mid(copied, open - copied);
+        out += atoms[text.mid(open + 1, close - open - 1).toInt()];
+        copied = close + 1;
+        open = text.indexOf(kAtom, copied);
+    }
+    out += text.mid(copied);
+    return out;
+}
+
+static bool matchesAt(const QString &text, int pos, QLatin1String what)
+{
+    if (pos < 0 || pos + int(what.size()) > text.size())
+        return false;
+    for (int i = 0; i < int(what.size()); ++i) {
+        if (text[pos + i] != QLatin1Char(what[i]))
+            return false;
+    }
+    return true;
+}
+
+static QString escapeHtml(const QString &text)
 {
-    return QStringLiteral("\x01\x02%1\x02\x01").arg(index);
+    QString escaped;
+    escaped.reserve(text.size() + text.size() / 8);
+    for (QChar c : text) {
+        switch (c.unicode()) {
+        case '&': escaped += QLatin1String("&amp;"); break;
+        case '<': escaped += QLatin1String("&lt;"); break;
+        case '>': escaped += QLatin1String("&gt;"); break;
+        case '"': escaped += QLatin1String("&quot;"); break;
+        default:  escaped += c; break;
+        }
+    }
+    return escaped;
 }
 
-MarkdownRenderer::MarkdownRenderer(QObject *parent)
-    : QObject(parent)
+MarkdownRenderer::MarkdownRenderer()
+    : MarkdownRenderer(ThemeManager::instance().palette())
 {
 }
 
-const QRegularExpression &MarkdownRenderer::fencedCodeRegex()
+MarkdownRenderer::MarkdownRenderer(const ThemePalette &palette)
 {
-    // [^\n`]*  — any language tag incl. hyphens/plus (objective-c, c++, etc.)
-    // [ \t]*   — allows indented closing backticks (horizontal ws only, not \s)
-    static QRegularExpression re("```([^\\n`]*)\\n([\\s\\S]*?)\\n[ \\t]*```");
-    return re;
+    m_colors.textPrimary    = palette.text_primary.name();
+    m_colors.textSecondary  = palette.text_secondary.name();
+    m_colors.textMuted      = palette.text_muted.name();
+    m_colors.textFaint      = palette.text_faint.name();
+    m_colors.bgBase         = palette.bg_base.name();
+    m_colors.bgSurface      = palette.bg_surface.name();
+    m_colors.bgWindow       = palette.bg_window.name();
+    m_colors.bgRaised       = palette.bg_raised.name();
+    m_colors.borderStandard = palette.border_standard.name();
+    m_colors.green          = palette.green.name();
+    m_colors.red            = palette.red.name();
+    m_colors.blue           = palette.blue.name();
+
+    // Same token colors as the editor lexers
+    m_syntax.keyword        = palette.mauve.name();
+    m_syntax.type           = palette.yellow.name();
+    m_syntax.string         = palette.green.name();
+    m_syntax.number         = palette.peach.name();
+    m_syntax.comment        = palette.overlay0.name();
+    m_syntax.preprocessor   = palette.blue.name();
+}
+
+QString MarkdownRenderer::styleKey() const
+{
+    const QString colors = QStringList{
+        m_colors.textPrimary, m_colors.textSecondary, m_colors.textMuted,
+        m_colors.textFaint, m_colors.bgBase, m_colors.bgSurface,
+        m_colors.bgWindow, m_colors.bgRaised, m_colors.borderStandard,
+        m_colors.green, m_colors.red, m_colors.blue}.join(',');
+    const QString syntax = m_highlightCode ? m_syntax.key() : QString();
+    const QByteArray digest = QCryptographicHash::hash((colors + syntax).toLatin1(),
+                                                       QCryptographicHash::Md5);
+    const QString options = QLatin1String(m_highlightCode ? "h" : "")
+        + QLatin1String(m_renderOpenFence ? "o" : "");
+    return QStringLiteral("v%1%2-%3").arg(kVersion).arg(options)
+        .arg(QString::fromLatin1(digest.toHex().left(12)));
 }
 
 // ---------------------------------------------------------------------------
 // Main entry point
 //
-// Pipeline (placeholder-based protection):
-//   1. Extract fenced code blocks  → placeholders
-//   2. Extract inline code (`...`) → placeholders
-//   3. Convert markdown tables     → HTML → placeholders
-//   4. Inline formatting (only raw markdown text remains — safe)
-//   5. Newline → <br> conversion
-//   6. Reinsert all placeholders
+//   1. Fenced code, then inline code in the gaps       → atoms
+//   2. Lines: tables → atoms; headers, lists, rules and quotes wrap the line
+//      after its inline spans (bold, italic, links) are resolved
+//   3. Newline runs → <br>; <br>s between adjacent block divs dropped
+//   4. Atoms expanded
+// Every step is a forward scan, so the cost is linear in the input.
 // ---------------------------------------------------------------------------
 
 QString MarkdownRenderer::toHtml(const QString &markdown) const
 {
     m_lastCodeBlocks.clear();
 
-    QStringList blocks;        // rendered HTML keyed by placeholder index
-    QString result = markdown;
-
-    // Phase 1 — fenced code blocks first so inline-code regex can't reach
-    //           inside them.
-    result = extractFencedBlocks(result, blocks);
-
-    // Phase 2 — inline code next so | inside `code` won't break table
-    //           cell splitting.
-    result = extractInlineCode(result, blocks);
-
-    // Phase 3 — markdown tables → <table> HTML → placeholders.
-    result = processTables(result, blocks);
-
-    // Phase 4 — inline formatting runs on pure markdown text (safe).
-    result = processInlineFormatting(result);
-
-    // Phase 5 — newline conversion (placeholders are opaque tokens).
-    // A single <br> per paragraph break; block-level divs already have margins.
-    result.replace("\n\n", "<br>");
-    result.replace("\n", "<br>");
-
-    // Collapse <br> between adjacent block-level <div> elements.
-    static QRegularExpression divGap("</div>((?:<br>|\\s)+)<div");
-    result.replace(divGap, "</div><div");
-
-    // Phase 6 — reinsert all protected blocks.
-    // Blocks are ordered: fenced code (low) → inline code → tables (high).
-    // Table cell content may reference inline-code placeholders, so we must
-    // insert tables first (high → low) so that nested placeholders are already
-    // in `result` by the time their own index is processed.
-    for (int i = blocks.size() - 1; i >= 0; --i)
-        result.replace(placeholder(i), blocks[i]);
-
-    return QStringLiteral(
-        "<div style='font-family:\"Inter\";"
-        "font-size:13px;line-height:1.6;color:%2;'>"
-        "%1</div>")
-        .arg(result, ThemeManager::instance().hex("text_primary"));
-}
+    QString text = markdown;
+    if (text.contains(kAtom))
+        text.remove(kAtom);
 
-// ---------------------------------------------------------------------------
-// Helpers
-// ---------------------------------------------------------------------------
+    QVector<QString> atoms;
+    QString work;
+    scanCode(text, work, atoms);
 
-QString MarkdownRenderer::escapeHtml(const QString &text) const
-{
-    QString escaped = text;
-    escaped.replace("&", "&amp;");
-    escaped.replace("<", "&lt;");
-    escaped.replace(">", "&gt;");
-    escaped.replace("\"", "&quot;");
-    return escaped;
+    QString body = expandAtoms(renderLines(work, atoms), atoms);
+
+    return QLatin1String("<div style='font-family:\"Inter\";"
+                         "font-size:13px;line-height:1.6;color:")
+        + m_colors.textPrimary + QLatin1String(";'>") + body + QLatin1String("</div>");
 }
 
 // ---------------------------------------------------------------------------
-// Phase 1 — Fenced code blocks
+// Phase 1 — Code
+//
+// A fence is ```lang\n body \n[ \t]*``` with no backtick in `lang`, found
+// anywhere (not only at line start), with the shortest body. Inline code is
+// `x` on one line. Both follow leftmost-first matching.
 // ---------------------------------------------------------------------------
 
-QString MarkdownRenderer::extractFencedBlocks(const QString &text, QStringList &blocks) const
+void MarkdownRenderer::scanCode(const QString &text, QString &work,
+                                QVector<QString> &atoms) const
 {
-    QString result = text;
-    const QRegularExpression &fenced = fencedCodeRegex();
-    auto it = fenced.globalMatch(result);
-
-    QList<std::pair<int, int>> ranges;
-    QList<QString> replacements;
+    const int n = text.size();
+    work.reserve(n);
+    int blockIndex = m_codeBlockBase;
+    int pos = 0;
+
+    int tick = text.indexOf(QLatin1String("```"));
+    while (tick >= 0) {
+        int langEnd = tick + 3;
+        while (langEnd < n && text[langEnd] != '\n' && text[langEnd] != '`')
+            ++langEnd;
+        if (langEnd >= n || text[langEnd] != '\n') {
+            tick = text.indexOf(QLatin1String("```"), tick + 1);
+            continue;
+        }
 
-    int blockIndex = 0;
-    while (it.hasNext()) {
-        auto match = it.next();
-        ranges.append({match.capturedStart(), match.capturedLength()});
+        // Shortest body: the first "\n[ \t]*```" after the language line
+        int close = -1;
+        int end = 0;
+        for (int nl = text.indexOf('\n', langEnd + 1); nl >= 0; nl = text.indexOf('\n', nl + 1)) {
+            int j = nl + 1;
+            while (j < n && (text[j] == ' ' || text[j] == '\t'))
+                ++j;
+            if (matchesAt(text, j, QLatin1String("```"))) {
+                close = nl;
+                end = j + 3;
+                break;
+            }
+        }
+        // No closing fence after this one means none after any later one;
+        // while streaming, the open fence runs to the end of the text
+        const bool open = close < 0;
+        if (open) {
+            if (!m_renderOpenFence)
+                break;
+            close = n;
+            end = n;
+        }
 
-        QString lang = match.captured(1).trimmed();
-        QString code = match.captured(2);
-        QString escapedCode = escapeHtml(code);
+        scanInlineCode(text, pos, tick, work, atoms);
 
-        // Store code block info for Copy / Apply
         CodeBlockInfo info;
-        info.language = lang;
-        info.code = code;
-        info.startOffset = match.capturedStart();
-        info.endOffset = match.capturedEnd();
+        info.language = text.mid(tick + 3, langEnd - tick - 3).trimmed();
+        info.code = text.mid(langEnd + 1, close - langEnd - 1);
+        info.startOffset = tick;
+        info.endOffset = end;
         m_lastCodeBlocks.append(info);
 
-        auto &tm = ThemeManager::instance();
-
-        // --- Diff highlighting ---
-        QString cardTitle;
-        QString diffFilePath;
-        bool isDiff = (lang == "diff");
-        if (isDiff) {
-            QRegularExpression diffFile("^\\+{3}\\s+(?:b/)?(.+?)(?:\\t.*)?$",
-                                        QRegularExpression::MultilineOption);
-            auto dm = diffFile.match(code);
-            if (dm.hasMatch()) {
-                diffFilePath = dm.captured(1).trimmed();
-                QString fname = QFileInfo(diffFilePath).fileName();
-                cardTitle = fname.isEmpty() ? diffFilePath : fname;
-            }
+        appendAtom(work, atoms, renderFence(info.language, info.code, blockIndex++, open));
 
-            QStringList lines = escapedCode.split('\n');
-            QStringList highlighted;
-            for (const QString &line : lines) {
-                if ((line.startsWith("---") || line.startsWith("+++")) && !cardTitle.isEmpty())
-                    continue;
-
-                QString color;
-                if (line.startsWith('+'))
-                    color = tm.hex("green");
-                else if (line.startsWith('-'))
-                    color = tm.hex("red");
-                else if (line.startsWith("@@"))
-                    color = tm.hex("blue");
-
-                if (!color.isEmpty())
-                    highlighted << "<span style='color:" + color + ";'>" + line + "</span>";
-                else
-                    highlighted << line;
-            }
-            escapedCode = highlighted.join('\n');
+        pos = end;
+        tick = text.indexOf(QLatin1String("```"), pos);
+    }
+
+    scanInlineCode(text, pos, n, work, atoms);
+}
+
+void MarkdownRenderer::scanInlineCode(const QString &text, int from, int to,
+                                      QString &work, QVector<QString> &atoms) const
+{
+    int copied = from;
+    int p = text.indexOf('`', from);
+    while (p >= 0 && p < to) {
+        int q = p + 1;
+        while (q < to && text[q] != '`' && text[q] != '\n')
+            ++q;
+        if (q < to && text[q] == '`' && q > p + 1) {
+            work += text.mid(copied, p - copied);
+            appendAtom(work, atoms, renderInlineCode(text.mid(p + 1, q - p - 1)));
+            copied = q + 1;
+            p = text.indexOf('`', copied);
+        } else {
+            // "``" retries from the second tick; a newline skips ahead
+            p = text.indexOf('`', q < to && text[q] == '`' ? q : q + 1);
         }
+    }
+    work += text.mid(copied, to - copied);
+}
 
-        // --- Card header ---
-        QString titleLabel;
-        if (isDiff && !cardTitle.isEmpty()) {
-            titleLabel = "<a href='cccpp://open?file=" + escapeHtml(diffFilePath)
-                + "&amp;line=0' style='color:" + tm.hex("blue")
-                + ";text-decoration:none;font-family:\"JetBrains Mono\";font-size:12px;'>"
-                + escapeHtml(cardTitle) + "</a>";
-        } else if (!lang.isEmpty()) {
-            titleLabel = "<span style='color:" + tm.hex("text_muted")
-                + ";font-family:\"JetBrains Mono\";font-size:11px;'>" + lang + "</span>";
+QString MarkdownRenderer::renderFence(const QString &lang, const QString &code,
+                                      int blockIndex, bool open) const
+{
+    const Colors &c = m_colors;
+    QString escapedCode = escapeHtml(code);
+
+    // --- Diff highlighting ---
+    QString cardTitle;
+    QString diffFilePath;
+    const bool isDiff = (lang == QLatin1String("diff"));
+    if (isDiff) {
+        // First "+++ [b/]path[\tdate]" line names the file
+        const QStringList rawLines = code.split('\n');
+        for (const QString &line : rawLines) {
+            if (!line.startsWith(QLatin1String("+++")))
+                continue;
+            int i = 3;
+            while (i < line.size() && line[i].isSpace())
+                ++i;
+            if (i == 3)
+                continue;
+            QString path = line.mid(i);
+            if (path.isEmpty())
+                continue;
+            if (path.startsWith(QLatin1String("b/")) && path.size() > 2)
+                path = path.mid(2);
+            const int tab = path.indexOf('\t', 1);
+            if (tab > 0)
+                path.truncate(tab);
+            diffFilePath = path.trimmed();
+            const QString fname = diffFilePath.mid(diffFilePath.lastIndexOf('/') + 1);
+            cardTitle = fname.isEmpty() ? diffFilePath : fname;
+            break;
         }
 
-        QString copyApply =
-            " <a href='cccpp://copy?block=" + QString::number(blockIndex)
-            + "' style='color:" + tm.hex("text_muted")
-            + ";text-decoration:none;font-size:11px;'>Copy</a>";
-
-        QString codeAsHtml = escapedCode;
-        codeAsHtml.replace("\n", "<br>");
-
-        QString border = tm.hex("border_standard");
-        QString html =
-            "<table cellspacing='0' cellpadding='0' style='width:100%;margin:6px 0;'>"
-            "<tr><td style='background:" + tm.hex("bg_surface") + ";padding:6px 12px;"
-            "border:1px solid " + border + ";'>"
-            + titleLabel + copyApply +
-            "</td></tr>"
-            "<tr><td style='background:" + tm.hex("bg_base") + ";padding:8px 14px;"
-            "border:1px solid " + border + ";border-top:none;"
-            "font-family:\"JetBrains Mono\";font-size:12px;color:" + tm.hex("text_primary") + ";'>"
-            + codeAsHtml +
-            "</td></tr></table>";
-
-        int phIdx = blocks.size();
-        blocks.append(html);
-        replacements.append(placeholder(phIdx));
-        ++blockIndex;
+        const QStringList lines = escapedCode.split('\n');
+        QString highlighted;
+        highlighted.reserve(escapedCode.size() * 2);
+        bool first = true;
+        for (const QString &line : lines) {
+            if ((line.startsWith(QLatin1String("---")) || line.startsWith(QLatin1String("+++")))
+                && !cardTitle.isEmpty())
+                continue;
+
+            QString color;
+            if (line.startsWith('+'))
+                color = c.green;
+            else if (line.startsWith('-'))
+                color = c.red;
+            else if (line.startsWith(QLatin1String("@@")))
+                color = c.blue;
+
+            if (!first)
+                highlighted += '\n';
+            first = false;
+            if (!color.isEmpty())
+                highlighted += QLatin1String("<span style='color:") + color
+                    + QLatin1String(";'>") + line + QLatin1String("</span>");
+            else
+                highlighted += line;
+        }
+        escapedCode = highlighted;
+    } else if (m_highlightCode) {
+        // A still-open block changes with every chunk; only its finished
+        // lines are worth caching
+        const SourceLanguage language = languageForFenceTag(lang);
+        if (CodeHighlighter::hasRules(language))
+            escapedCode = CodeHighlighter::highlight(language, code, m_syntax, !open);
     }
 
-    for (int i = ranges.size() - 1; i >= 0; --i)
-        result.replace(ranges[i].first, ranges[i].second, replacements[i]);
+    // --- Card header ---
+    QString titleLabel;
+    if (isDiff && !cardTitle.isEmpty()) {
+        titleLabel = QLatin1String("<a href='cccpp://open?file=") + escapeHtml(diffFilePath)
+            + QLatin1String("&amp;line=0' style='color:") + c.blue
+            + QLatin1String(";text-decoration:none;font-family:\"JetBrains Mono\";font-size:12px;'>")
+            + escapeHtml(cardTitle) + QLatin1String("</a>");
+    } else if (!lang.isEmpty()) {
+        titleLabel = QLatin1String("<span style='color:") + c.textMuted
+            + QLatin1String(";font-family:\"JetBrains Mono\";font-size:11px;'>")
+            + lang + QLatin1String("</span>");
+    }
 
-    return result;
+    const QString copyLink =
+        QLatin1String(" <a href='cccpp://copy?block=") + QString::number(blockIndex)
+        + QLatin1String("' style='color:") + c.textMuted
+        + QLatin1String(";text-decoration:none;font-size:11px;'>Copy</a>");
+
+    escapedCode.replace('\n', QLatin1String("<br>"));
+
+    return QLatin1String("<table cellspacing='0' cellpadding='0' style='width:100%;margin:6px 0;'>"
+                         "<tr><td style='background:") + c.bgSurface
+        + QLatin1String(";padding:6px 12px;border:1px solid ") + c.borderStandard
+        + QLatin1String(";'>") + titleLabel + copyLink
+        + QLatin1String("</td></tr><tr><td style='background:") + c.bgBase
+        + QLatin1String(";padding:8px 14px;border:1px solid ") + c.borderStandard
+        + QLatin1String(";border-top:none;font-family:\"JetBrains Mono\";font-size:12px;color:")
+        + c.textPrimary + QLatin1String(";'>") + escapedCode
+        + QLatin1String("</td></tr></table>");
 }
 
-// ---------------------------------------------------------------------------
-// Phase 2 — Inline code
-// ---------------------------------------------------------------------------
-
-QString MarkdownRenderer::extractInlineCode(const QString &text, QStringList &blocks) const
+QString MarkdownRenderer::renderInlineCode(const QString &code) const
 {
-    QString result = text;
-
-    // [^`\n]+ — don't match across newlines; prevents swallowing failed
-    //           fenced blocks that the fenced regex didn't recognise.
-    static QRegularExpression inlineCode("`([^`\\n]+)`");
-
-    auto it = inlineCode.globalMatch(result);
-    QList<std::pair<int, int>> ranges;
-    QList<QString> replacements;
-
-    auto &tm = ThemeManager::instance();
-    while (it.hasNext()) {
-        auto match = it.next();
-        ranges.append({match.capturedStart(), match.capturedLength()});
-
-        QString html = QStringLiteral(
-            "<code style='background:%1;color:%2;padding:2px 6px;"
-            "border-radius:4px;font-family:\"JetBrains Mono\";font-size:12px;'>%3</code>")
-            .arg(tm.hex("bg_raised"), tm.hex("text_secondary"),
-                 escapeHtml(match.captured(1)));
-
-        int phIdx = blocks.size();
-        blocks.append(html);
-        replacements.append(placeholder(phIdx));
-    }
-
-    for (int i = ranges.size() - 1; i >= 0; --i)
-        result.replace(ranges[i].first, ranges[i].second, replacements[i]);
-
-    return result;
+    return QLatin1String("<code style='background:") + m_colors.bgRaised
+        + QLatin1String(";color:") + m_colors.textSecondary
+        + QLatin1String(";padding:2px 6px;border-radius:4px;"
+                        "font-family:\"JetBrains Mono\";font-size:12px;'>")
+        + escapeHtml(code) + QLatin1String("</code>");
 }
 
 // ---------------------------------------------------------------------------
-// Phase 3 — Tables
+// Phase 2 — Lines
 // ---------------------------------------------------------------------------
 
 static QStringList splitTableRow(const QString &row)
@@ -261,177 +358,328 @@ static QStringList splitTableRow(const QString &row)
     return trimmed.split('|');
 }
 
-static bool isTableSeparator(const QString &line)
+// \s*:?-{3,}:?\s*
+static bool isSeparatorCell(const QString &cell)
 {
-    QString trimmed = line.trimmed();
-    if (!trimmed.contains('-') || !trimmed.contains('|'))
+    const QString c = cell.trimmed();
+    int i = 0;
+    int end = c.size();
+    if (i < end && c[i] == ':') ++i;
+    if (end > i && c[end - 1] == ':') --end;
+    if (end - i < 3)
         return false;
+    for (; i < end; ++i) {
+        if (c[i] != '-')
+            return false;
+    }
+    return true;
+}
 
-    QStringList cells = splitTableRow(trimmed);
-    if (cells.isEmpty())
+static bool isTableSeparator(const QString &line)
+{
+    const QString trimmed = line.trimmed();
+    if (!trimmed.contains('-') || !trimmed.contains('|'))
         return false;
 
-    static QRegularExpression cellPat("^\\s*:?-{3,}:?\\s*$");
+    const QStringList cells = splitTableRow(trimmed);
     for (const QString &cell : cells) {
-        if (!cellPat.match(cell).hasMatch())
+        if (!isSeparatorCell(cell))
             return false;
     }
-    return true;
+    return !cells.isEmpty();
 }
 
 static QStringList parseAlignments(const QString &separator)
 {
-    QStringList cells = splitTableRow(separator);
     QStringList aligns;
-    for (const QString &cell : cells) {
-        QString c = cell.trimmed();
-        bool l = c.startsWith(':');
-        bool r = c.endsWith(':');
-        if (l && r)        aligns << "center";
-        else if (r)         aligns << "right";
-        else                aligns << "left";
+    for (const QString &cell : splitTableRow(separator)) {
+        const QString c = cell.trimmed();
+        const bool l = c.startsWith(':');
+        const bool r = c.endsWith(':');
+        if (l && r)        aligns << QStringLiteral("center");
+        else if (r)        aligns << QStringLiteral("right");
+        else               aligns << QStringLiteral("left");
     }
     return aligns;
 }
 
-QString MarkdownRenderer::processTables(const QString &text, QStringList &blocks) const
+static bool isTableHeader(const QString &line)
 {
-    // At this point the text contains only raw markdown + placeholders.
-    // Placeholders don't contain '|', so splitTableRow is safe.
+    const QString trimmed = line.trimmed();
+    return trimmed.count('|') >= 2;
+}
 
-    QStringList lines = text.split('\n');
-    QStringList output;
-    int i = 0;
+QString MarkdownRenderer::renderLines(const QString &work, QVector<QString> &atoms) const
+{
+    const QStringList lines = work.split('\n');
+    QString body;
+    body.reserve(work.size() * 2);
+
+    // A run of k newlines becomes ceil(k/2) <br>: a blank line is one break
+    int newlines = 0;
+    auto emitLine = [&](const QString &html) {
+        for (int b = 0; b < (newlines + 1) / 2; ++b)
+            body += QLatin1String("<br>");
+        newlines = 0;
+        body += html;
+    };
 
+    int i = 0;
     while (i < lines.size()) {
-        QString line = lines[i].trimmed();
-
-        if (i + 1 < lines.size()
-            && line.contains('|') && line.count('|') >= 2
-            && isTableSeparator(lines[i + 1])) {
-
-            auto headerCells = splitTableRow(line);
-            auto aligns = parseAlignments(lines[i + 1].trimmed());
-
-            auto &tm = ThemeManager::instance();
-            QString borderColor = tm.hex("text_faint");
-            QString table = QStringLiteral(
-                "<table cellspacing='0' cellpadding='6' "
-                "style='border-collapse:collapse;margin:6px 0;border:1px solid %1;'>")
-                .arg(borderColor);
-
-            table += QStringLiteral("<tr>");
-            for (int c = 0; c < headerCells.size(); ++c) {
-                QString a = c < aligns.size() ? aligns[c] : QStringLiteral("left");
-                table += QStringLiteral(
-                    "<td style='border:1px solid %3;padding:4px 10px;"
-                    "text-align:%1;font-weight:bold;background:%4;'>%2</td>")
-                    .arg(a, headerCells[c].trimmed(), borderColor, tm.hex("bg_window"));
-            }
-            table += QStringLiteral("</tr>");
-
-            i += 2;
-            bool even = false;
-            while (i < lines.size()) {
-                QString dataLine = lines[i].trimmed();
-                if (dataLine.isEmpty() || !dataLine.contains('|'))
-                    break;
-
-                auto cells = splitTableRow(dataLine);
-                QString bg = even ? tm.hex("bg_surface") : QStringLiteral("transparent");
-                table += QStringLiteral("<tr>");
-                for (int c = 0; c < cells.size(); ++c) {
-                    QString a = c < aligns.size() ? aligns[c] : QStringLiteral("left");
-                    table += QStringLiteral(
-                        "<td style='border:1px solid %3;padding:4px 10px;"
-                        "text-align:%1;background:%2;'>%4</td>")
-                        .arg(a, bg, borderColor, cells[c].trimmed());
-                }
-                table += QStringLiteral("</tr>");
-                even = !even;
-                ++i;
-            }
-
-            table += QStringLiteral("</table>");
-
-            int phIdx = blocks.size();
-            blocks.append(table);
-            output << placeholder(phIdx);
+        if (i > 0)
+            ++newlines;
+        const QString &line = lines[i];
+        if (line.isEmpty()) {
+            ++i;
+            continue;
+        }
+        if (i + 1 < lines.size() && isTableHeader(line) && isTableSeparator(lines[i + 1])) {
+            QString table;
+            const int next = renderTable(lines, i, table, atoms);
+            QString token;
+            appendAtom(token, atoms, table);
+            emitLine(token);
+            // The table's own rows are not line breaks
+            i = next;
             continue;
         }
+        emitLine(renderInline(line));
+        ++i;
+    }
+    for (int b = 0; b < (newlines + 1) / 2; ++b)
+        body += QLatin1String("<br>");
+
+    // </div>(<br>|\s)+<div → </div><div: block divs carry their own margins
+    static const QLatin1String divClose("</div>");
+    int p = body.indexOf(divClose);
+    if (p < 0)
+        return body;
+    QString out;
+    out.reserve(body.size());
+    int copied = 0;
+    while (p >= 0) {
+        const int gapStart = p + int(divClose.size());
+        int g = gapStart;
+        while (g < body.size()) {
+            if (body[g].isSpace())
+                ++g;
+            else if (matchesAt(body, g, QLatin1String("<br>")))
+                g += 4;
+            else
+                break;
+        }
+        if (g > gapStart && matchesAt(body, g, QLatin1String("<div"))) {
+            out += body.mid(copied, gapStart - copied);
+            copied = g;
+        }
+        p = body.indexOf(divClose, g);
+    }
+    out += body.mid(copied);
+    return out;
+}
 
-        output << lines[i];
+int MarkdownRenderer::renderTable(const QStringList &lines, int first, QString &html,
+                                  const QVector<QString> &atoms) const
+{
+    const QStringList headerCells = splitTableRow(lines[first]);
+    const QStringList aligns = parseAlignments(lines[first + 1].trimmed());
+    const QString &borderColor = m_colors.textFaint;
+    auto align = [&](int col) {
+        return col < aligns.size() ? aligns[col] : QStringLiteral("left");
+    };
+
+    html = QLatin1String("<table cellspacing='0' cellpadding='6' "
+                         "style='border-collapse:collapse;margin:6px 0;border:1px solid ")
+        + borderColor + QLatin1String(";'><tr>");
+    for (int col = 0; col < headerCells.size(); ++col) {
+        html += QLatin1String("<td style='border:1px solid ") + borderColor
+            + QLatin1String(";padding:4px 10px;text-align:") + align(col)
+            + QLatin1String(";font-weight:bold;background:") + m_colors.bgWindow
+            + QLatin1String(";'>") + expandAtoms(headerCells[col].trimmed(), atoms)
+            + QLatin1String("</td>");
+    }
+    html += QLatin1String("</tr>");
+
+    int i = first + 2;
+    bool even = false;
+    while (i < lines.size()) {
+        const QString dataLine = lines[i].trimmed();
+        if (dataLine.isEmpty() || !dataLine.contains('|'))
+            break;
+
+        const QStringList cells = splitTableRow(dataLine);
+        const QString bg = even ? m_colors.bgSurface : QStringLiteral("transparent");
+        html += QLatin1String("<tr>");
+        for (int col = 0; col < cells.size(); ++col) {
+            html += QLatin1String("<td style='border:1px solid ") + borderColor
+                + QLatin1String(";padding:4px 10px;text-align:") + align(col)
+                + QLatin1String(";background:") + bg + QLatin1String(";'>")
+                + expandAtoms(cells[col].trimmed(), atoms) + QLatin1String("</td>");
+        }
+        html += QLatin1String("</tr>");
+        even = !even;
         ++i;
     }
 
-    return output.join('\n');
+    html += QLatin1String("</table>");
+    return i;
 }
 
 // ---------------------------------------------------------------------------
-// Phase 4 — Inline formatting
-//
-// Only raw markdown text + inert placeholders reach this point.
-// No HTML to corrupt.
+// Phase 2b — Inline spans and line prefixes
 // ---------------------------------------------------------------------------
 
-QString MarkdownRenderer::processInlineFormatting(const QString &text) const
+// mark(.+?)mark — leftmost pair around non-empty content
+static QString replacePaired(const QString &line, QLatin1String mark,
+                             QLatin1String open, QLatin1String close)
+{
+    const int len = int(mark.size());
+    int p = line.indexOf(mark);
+    if (p < 0)
+        return line;
+    QString out;
+    int copied = 0;
+    while (p >= 0) {
+        const int q = line.indexOf(mark, p + len + 1);
+        if (q < 0)
+            break;
+        out += line.mid(copied, p - copied) + open
+            + line.mid(p + len, q - p - len) + close;
+        copied = q + len;
+        p = line.indexOf(mark, copied);
+    }
+    if (copied == 0)
+        return line;
+    out += line.mid(copied);
+    return out;
+}
+
+// (?<!\*)\*([^*]+)\*(?!\*)
+static QString replaceItalic(const QString &line)
 {
-    QString result = text;
-    auto &tm = ThemeManager::instance();
-
-    QRegularExpression bold("\\*\\*(.+?)\\*\\*");
-    result.replace(bold, "<b>\\1</b>");
-
-    QRegularExpression boldUnderscore("__(.+?)__");
-    result.replace(boldUnderscore, "<b>\\1</b>");
-
-    QRegularExpression italic("(?<!\\*)\\*([^*]+)\\*(?!\\*)");
-    result.replace(italic, "<i>\\1</i>");
-
-    QString headingColor = tm.hex("text_primary");
-    QRegularExpression h1("^# (.+)$", QRegularExpression::MultilineOption);
-    result.replace(h1,
-        QStringLiteral("<div style='color:%1;margin:16px 0 6px;font-size:18px;font-weight:600;letter-spacing:-0.2px;'>\\1</div>")
-        .arg(headingColor));
-
-    QRegularExpression h2("^## (.+)$", QRegularExpression::MultilineOption);
-    result.replace(h2,
-        QStringLiteral("<div style='color:%1;margin:14px 0 4px;font-size:16px;font-weight:600;letter-spacing:-0.2px;'>\\1</div>")
-        .arg(headingColor));
-
-    QRegularExpression h3("^### (.+)$", QRegularExpression::MultilineOption);
-    result.replace(h3,
-        QStringLiteral("<div style='color:%1;margin:12px 0 4px;font-size:14px;font-weight:600;'>\\1</div>")
-        .arg(headingColor));
-
-    QString faintHex = tm.hex("text_faint");
-    QRegularExpression bullet("^[\\-\\*] (.+)$", QRegularExpression::MultilineOption);
-    result.replace(bullet,
-        QStringLiteral("<div style='padding-left:20px;margin:2px 0;'>"
-        "<span style='color:%1;'>&#x2022;</span> \\1</div>")
-        .arg(faintHex));
-
-    QRegularExpression numbered("^(\\d+)\\. (.+)$", QRegularExpression::MultilineOption);
-    result.replace(numbered,
-        QStringLiteral("<div style='padding-left:20px;margin:2px 0;'>"
-        "<span style='color:%1;'>\\1.</span> \\2</div>")
-        .arg(faintHex));
-
-    QRegularExpression link("\\[([^\\]]+)\\]\\(([^)]+)\\)");
-    result.replace(link,
-        QStringLiteral("<a href='\\2' style='color:%1;text-decoration:underline;'>\\1</a>")
-        .arg(tm.hex("blue")));
-
-    QRegularExpression hr("^(---+|\\*\\*\\*+)$", QRegularExpression::MultilineOption);
-    result.replace(hr,
-        QStringLiteral("<hr style='border:none;border-top:1px solid %1;margin:8px 0;'>")
-        .arg(tm.hex("border_standard")));
-
-    QRegularExpression blockquote("^> (.+)$", QRegularExpression::MultilineOption);
-    result.replace(blockquote,
-        QStringLiteral("<div style='border-left:3px solid %1;padding-left:16px;margin:8px 0;"
-        "color:%2;font-style:italic;'>\\1</div>")
-        .arg(tm.hex("border_standard"), tm.hex("text_muted")));
-
-    return result;
+    int p = line.indexOf('*');
+    if (p < 0)
+        return line;
+    QString out;
+    int copied = 0;
+    while (p >= 0) {
+        const int q = line.indexOf('*', p + 1);
+        if (q < 0)
+            break;
+        const bool free = p == 0 || line[p - 1] != '*';
+        if (free && q > p + 1 && (q + 1 >= line.size() || line[q + 1] != '*')) {
+            out += line.mid(copied, p - copied) + QLatin1String("<i>")
+                + line.mid(p + 1, q - p - 1) + QLatin1String("</i>");
+            copied = q + 1;
+            p = line.indexOf('*', copied);
+        } else {
+            p = q;
+        }
+    }
+    if (copied == 0)
+        return line;
+    out += line.mid(copied);
+    return out;
+}
+
+// \[([^\]]+)\]\(([^)]+)\)
+static QString replaceLinks(const QString &line, const QString &color)
+{
+    int p = line.indexOf('[');
+    if (p < 0)
+        return line;
+    QString out;
+    int copied = 0;
+    while (p >= 0) {
+        const int textEnd = line.indexOf(']', p + 1);
+        if (textEnd < 0)
+            break;
+        if (textEnd > p + 1 && textEnd + 1 < line.size() && line[textEnd + 1] == '(') {
+            const int urlEnd = line.indexOf(')', textEnd + 2);
+            if (urlEnd < 0)
+                break;
+            if (urlEnd > textEnd + 2) {
+                out += line.mid(copied, p - copied) + QLatin1String("<a href='")
+                    + line.mid(textEnd + 2, urlEnd - textEnd - 2)
+                    + QLatin1String("' style='color:") + color
+                    + QLatin1String(";text-decoration:underline;'>")
+                    + line.mid(p + 1, textEnd - p - 1) + QLatin1String("</a>");
+                copied = urlEnd + 1;
+                p = line.indexOf('[', copied);
+                continue;
+            }
+        }
+        // Every '[' before textEnd would stop at the same ']'
+        p = line.indexOf('[', p + 1);
+        if (p >= 0 && p < textEnd)
+            p = line.indexOf('[', textEnd);
+    }
+    if (copied == 0)
+        return line;
+    out += line.mid(copied);
+    return out;
+}
+
+// ^(---+|\*\*\*+)$
+static bool isHorizontalRule(const QString &line)
+{
+    if (line.size() < 3 || (line[0] != '-' && line[0] != '*'))
+        return false;
+    for (QChar c : line) {
+        if (c != line[0])
+            return false;
+    }
+    return true;
+}
+
+QString MarkdownRenderer::renderInline(const QString &source) const
+{
+    const Colors &c = m_colors;
+
+    QString line = replacePaired(source, QLatin1String("**"),
+                                 QLatin1String("<b>"), QLatin1String("</b>"));
+    line = replacePaired(line, QLatin1String("__"), QLatin1String("<b>"), QLatin1String("</b>"));
+    line = replaceItalic(line);
+
+    // Line prefixes, tried in the order they used to run; at most one applies
+    if (line.startsWith(QLatin1String("# ")) && line.size() > 2) {
+        line = QLatin1String("<div style='color:") + c.textPrimary
+            + QLatin1String(";margin:16px 0 6px;font-size:18px;font-weight:600;letter-spacing:-0.2px;'>")
+            + line.mid(2) + QLatin1String("</div>");
+    } else if (line.startsWith(QLatin1String("## ")) && line.size() > 3) {
+        line = QLatin1String("<div style='color:") + c.textPrimary
+            + QLatin1String(";margin:14px 0 4px;font-size:16px;font-weight:600;letter-spacing:-0.2px;'>")
+            + line.mid(3) + QLatin1String("</div>");
+    } else if (line.startsWith(QLatin1String("### ")) && line.size() > 4) {
+        line = QLatin1String("<div style='color:") + c.textPrimary
+            + QLatin1String(";margin:12px 0 4px;font-size:14px;font-weight:600;'>")
+            + line.mid(4) + QLatin1String("</div>");
+    } else if (line.size() > 2 && (line[0] == '-' || line[0] == '*') && line[1] == ' ') {
+        line = QLatin1String("<div style='padding-left:20px;margin:2px 0;'><span style='color:")
+            + c.textFaint + QLatin1String(";'>&#x2022;</span> ") + line.mid(2)
+            + QLatin1String("</div>");
+    } else {
+        int digits = 0;
+        while (digits < line.size() && line[digits].isDigit())
+            ++digits;
+        if (digits > 0 && matchesAt(line, digits, QLatin1String(". "))
+            && line.size() > digits + 2) {
+            line = QLatin1String("<div style='padding-left:20px;margin:2px 0;'><span style='color:")
+                + c.textFaint + QLatin1String(";'>") + line.left(digits)
+                + QLatin1String(".</span> ") + line.mid(digits + 2) + QLatin1String("</div>");
+        }
+    }
+
+    line = replaceLinks(line, c.blue);
+
+    if (isHorizontalRule(line)) {
+        line = QLatin1String("<hr style='border:none;border-top:1px solid ")
+            + c.borderStandard + QLatin1String(";margin:8px 0;'>");
+    } else if (line.startsWith(QLatin1String("> ")) && line.size() > 2) {
+        line = QLatin1String("<div style='border-left:3px solid ") + c.borderStandard
+            + QLatin1String(";padding-left:16px;margin:8px 0;color:") + c.textMuted
+            + QLatin1String(";font-style:italic;'>") + line.mid(2) + QLatin1String("</div>");
+    }
+
+    return line;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
-#include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QList>
-#include <QRegularExpression>
+#include <QVector>
+#include "util/CodeHighlighter.h"
+
+struct ThemePalette;
 
 struct CodeBlockInfo {
     QString language;
@@ -12,27 +15,63 @@ struct CodeBlockInfo {
     int endOffset = 0;
 };
 
-class MarkdownRenderer : public QObject {
-    Q_OBJECT
+// Markdown -> QTextDocument HTML in linear time. One forward scan pulls out
+// fenced and inline code, a line pass builds tables and block prefixes
+// (headers, lists, quotes, rules) and inline spans are resolved per line.
+// Colors are copied out of a palette at construction and toHtml() touches
+// no shared state, so a renderer can be built and used on any thread.
+class MarkdownRenderer {
 public:
-    explicit MarkdownRenderer(QObject *parent = nullptr);
+    // Snapshot of the current theme; GUI thread only
+    MarkdownRenderer();
+    explicit MarkdownRenderer(const ThemePalette &palette);
 
     QString toHtml(const QString &markdown) const;
 
-    // Returns info about code blocks found during last toHtml() call
-    QList<CodeBlockInfo> lastCodeBlocks() const { return m_lastCodeBlocks; }
+    // Bump whenever toHtml() output changes for the same input; part of
+    // styleKey() so cached HTML from older builds is never reused
+    static constexpr int kVersion = 1;
+
+    // Renderer version plus a digest of the palette colors and options: two
+    // renderers with the same key produce identical HTML for identical input
+    QString styleKey() const;
+
+    // Number the Copy links of fenced blocks from `base`, for callers that
+    // render one message in several pieces
+    void setCodeBlockIndexBase(int base) { m_codeBlockBase = base; }
 
-    /// Regex for fenced code blocks — shared with ChatMessageWidget for Copy/Apply.
-    static const QRegularExpression &fencedCodeRegex();
+    // Color fenced code by its language tag (diffs are always colored)
+    void setHighlightCode(bool on) { m_highlightCode = on; }
+
+    // Render a fence without its closing ``` as a code block running to the
+    // end of the text, for the tail of a message that is still streaming
+    void setRenderOpenFence(bool on) { m_renderOpenFence = on; }
+
+    // Fenced code blocks seen by the last toHtml() call, in order
+    QList<CodeBlockInfo> lastCodeBlocks() const { return m_lastCodeBlocks; }
 
 private:
-    QString escapeHtml(const QString &text) const;
-    QString extractFencedBlocks(const QString &text, QStringList &blocks) const;
-    QString extractInlineCode(const QString &text, QStringList &blocks) const;
-    QString processTables(const QString &text, QStringList &blocks) const;
-    QString processInlineFormatting(const QString &text) const;
+    struct Colors {
+        QString textPrimary, textSecondary, textMuted, textFaint;
+        QString bgBase, bgSurface, bgWindow, bgRaised;
+        QString borderStandard, green, red, blue;
+    };
 
-    static QString placeholder(int index);
+    void scanCode(const QString &text, QString &work, QVector<QString> &atoms) const;
+    void scanInlineCode(const QString &text, int from, int to,
+                        QString &work, QVector<QString> &atoms) const;
+    QString renderFence(const QString &lang, const QString &code, int blockIndex,
+                        bool open) const;
+    QString renderInlineCode(const QString &code) const;
+    QString renderLines(const QString &work, QVector<QString> &atoms) const;
+    int renderTable(const QStringList &lines, int first, QString &html,
+                    const QVector<QString> &atoms) const;
+    QString renderInline(const QString &line) const;
 
+    Colors m_colors;
+    HighlightColors m_syntax;
+    int m_codeBlockBase = 0;
+    bool m_highlightCode = false;
+    bool m_renderOpenFence = false;
     mutable QList<CodeBlockInfo> m_lastCodeBlocks;
 };
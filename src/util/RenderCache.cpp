@@ -0,0 +1,185 @@
+#include "util/RenderCache.h"
+#include "core/Database.h"
+#include "ui/ThemeManager.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <nlohmann/json.hpp>
+
+static constexpr qint64 kDefaultMemoryBytes = 16ll * 1024 * 1024;
+static constexpr int kFlushDelayMs = 2000;
+
+static qint64 costOf(const RenderedMarkdown &value)
+{
+    qint64 bytes = value.html.size();
+    for (const auto &block : value.codeBlocks)
+        bytes += block.code.size() + block.language.size();
+    return qMax<qint64>(1, bytes * 2);
+}
+
+RenderCache &RenderCache::instance()
+{
+    static RenderCache cache;
+    return cache;
+}
+
+RenderCache::RenderCache(QObject *parent)
+    : QObject(parent)
+{
+    m_memory.setMaxCost(kDefaultMemoryBytes);
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(kFlushDelayMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &RenderCache::flush);
+    connect(&ThemeManager::instance(), &ThemeManager::themeChanged,
+            this, &RenderCache::clearMemory);
+    if (auto *app = QCoreApplication::instance())
+        connect(app, &QCoreApplication::aboutToQuit, this, &RenderCache::flush);
+}
+
+void RenderCache::setDatabase(Database *db)
+{
+    if (db == m_db) return;
+    flush();
+    m_db = db;
+}
+
+QString RenderCache::key(const QString &markdown, int codeBlockBase, const QString &styleKey)
+{
+    const QByteArray digest = QCryptographicHash::hash(markdown.toUtf8(),
+                                                       QCryptographicHash::Sha1);
+    return QStringLiteral("%1:%2:%3").arg(QString::fromLatin1(digest.toHex()))
+        .arg(codeBlockBase).arg(styleKey);
+}
+
+const RenderedMarkdown *RenderCache::peek(const QString &key)
+{
+    if (const RenderedMarkdown *cached = m_memory.object(key))
+        return cached;
+    // Too big for the memory tier but not written yet
+    auto unsaved = m_unsaved.constFind(key);
+    if (unsaved != m_unsaved.cend())
+        return &unsaved.value();
+
+    RenderCacheRecord rec;
+    if (!m_db || !m_db->loadRenderCache(key, rec))
+        return nullptr;
+    auto loaded = std::make_unique<RenderedMarkdown>(
+        RenderedMarkdown{rec.html, decodeCodeBlocks(rec.codeBlocks)});
+    const qint64 cost = costOf(*loaded);
+    if (cost > m_memory.maxCost()) {
+        m_oversized = std::move(loaded);
+        return m_oversized.get();
+    }
+    RenderedMarkdown *entry = loaded.release();
+    m_memory.insert(key, entry, cost);
+    return entry;
+}
+
+bool RenderCache::lookup(const QString &key, RenderedMarkdown &out)
+{
+    const RenderedMarkdown *cached = peek(key);
+    if (!cached) {
+        ++m_misses;
+        return false;
+    }
+    out = *cached;
+    ++m_hits;
+    if (m_db && !m_unsaved.contains(key)) {
+        m_touched.insert(key);
+        scheduleFlush();
+    }
+    return true;
+}
+
+void RenderCache::insert(const QString &key, const RenderedMarkdown &value)
+{
+    m_memory.insert(key, new RenderedMarkdown(value), costOf(value));
+    if (m_db) {
+        m_unsaved.insert(key, value);
+        m_touched.remove(key);
+        scheduleFlush();
+    }
+}
+
+RenderedMarkdown RenderCache::render(MarkdownRenderer &renderer, const QString &markdown,
+                                     int codeBlockBase)
+{
+    const QString k = key(markdown, codeBlockBase, renderer.styleKey());
+    RenderedMarkdown result;
+    if (lookup(k, result))
+        return result;
+
+    renderer.setCodeBlockIndexBase(codeBlockBase);
+    result.html = renderer.toHtml(markdown);
+    result.codeBlocks = renderer.lastCodeBlocks();
+    insert(k, result);
+    return result;
+}
+
+void RenderCache::clearMemory()
+{
+    m_memory.clear();
+}
+
+void RenderCache::scheduleFlush()
+{
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void RenderCache::flush()
+{
+    m_flushTimer.stop();
+    if (!m_db) {
+        m_unsaved.clear();
+        m_touched.clear();
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<RenderCacheRecord> records;
+    records.reserve(m_unsaved.size());
+    for (auto it = m_unsaved.cbegin(); it != m_unsaved.cend(); ++it) {
+        RenderCacheRecord rec;
+        rec.key = it.key();
+        rec.html = it->html;
+        rec.codeBlocks = encodeCodeBlocks(it->codeBlocks);
+        rec.lastUsed = now;
+        records.append(rec);
+    }
+    m_db->saveRenderCache(records, QStringList(m_touched.cbegin(), m_touched.cend()),
+                          now, m_diskLimit);
+    m_unsaved.clear();
+    m_touched.clear();
+}
+
+QString RenderCache::encodeCodeBlocks(const QList<CodeBlockInfo> &blocks)
+{
+    if (blocks.isEmpty()) return {};
+    nlohmann::json arr = nlohmann::json::array();
+    for (const auto &b : blocks) {
+        arr.push_back({{"language", b.language.toStdString()},
+                       {"code", b.code.toStdString()},
+                       {"start", b.startOffset},
+                       {"end", b.endOffset}});
+    }
+    return QString::fromStdString(arr.dump());
+}
+
+QList<CodeBlockInfo> RenderCache::decodeCodeBlocks(const QString &json)
+{
+    QList<CodeBlockInfo> blocks;
+    if (json.isEmpty()) return blocks;
+    auto arr = nlohmann::json::parse(json.toStdString(), nullptr, false);
+    if (!arr.is_array()) return blocks;
+    for (const auto &obj : arr) {
+        if (!obj.is_object()) continue;
+        CodeBlockInfo b;
+        b.language = QString::fromStdString(obj.value("language", std::string()));
+        b.code = QString::fromStdString(obj.value("code", std::string()));
+        b.startOffset = obj.value("start", 0);
+        b.endOffset = obj.value("end", 0);
+        blocks.append(b);
+    }
+    return blocks;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <memory>
+#include "util/MarkdownRenderer.h"
+
+class Database;
+
+struct RenderedMarkdown {
+    QString html;
+    QList<CodeBlockInfo> codeBlocks;
+};
+
+// Rendered markdown keyed by content: SHA-1 of the source, the Copy-link
+// numbering base and the renderer's styleKey() (version + palette). A
+// byte-bounded LRU in memory sits in front of the history DB's render_cache
+// table, so reopening a session finds its HTML without converting anything.
+//
+// A theme change needs no explicit invalidation: the new palette yields new
+// keys, the memory tier is dropped, and stale rows age out of the table.
+// New entries and access times are written in batches a little later.
+// GUI thread only; workers compute keys with the static key().
+class RenderCache : public QObject {
+    Q_OBJECT
+public:
+    static RenderCache &instance();
+
+    void setDatabase(Database *db);
+    void setMemoryLimit(qint64 bytes) { m_memory.setMaxCost(bytes); }
+    void setDiskLimit(qint64 bytes) { m_diskLimit = bytes; }
+
+    static QString key(const QString &markdown, int codeBlockBase, const QString &styleKey);
+
+    bool lookup(const QString &key, RenderedMarkdown &out);
+    // Like lookup() but uncounted; the pointer lives until the next peek or insert
+    const RenderedMarkdown *peek(const QString &key);
+    void insert(const QString &key, const RenderedMarkdown &value);
+    // Renders through the cache
+    RenderedMarkdown render(MarkdownRenderer &renderer, const QString &markdown,
+                            int codeBlockBase);
+
+    void clearMemory();
+    void flush();
+
+    qint64 hits() const { return m_hits; }
+    qint64 misses() const { return m_misses; }
+
+    static QString encodeCodeBlocks(const QList<CodeBlockInfo> &blocks);
+    static QList<CodeBlockInfo> decodeCodeBlocks(const QString &json);
+
+private:
+    explicit RenderCache(QObject *parent = nullptr);
+    void scheduleFlush();
+
+    Database *m_db = nullptr;
+    QCache<QString, RenderedMarkdown> m_memory;
+    QHash<QString, RenderedMarkdown> m_unsaved;
+    QSet<QString> m_touched;  // served from the table, last_used to refresh
+    std::unique_ptr<RenderedMarkdown> m_oversized;  // last row too big for memory
+    qint64 m_diskLimit = 64ll * 1024 * 1024;
+    QTimer m_flushTimer;
+
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+};
@@ -0,0 +1,63 @@
+#include "util/TranscriptIndex.h"
+
+void TranscriptIndex::clear()
+{
+    m_heights.clear();
+    m_tree.clear();
+}
+
+void TranscriptIndex::append(int height)
+{
+    height = qMax(height, 1);
+    m_heights.append(height);
+    if (m_tree.isEmpty())
+        m_tree.append(0);
+    // Node i covers rows (i - lowbit(i), i]: the new row plus whole nodes below it
+    const int i = m_heights.size();
+    m_tree.append(height + offset(i - 1) - offset(i - (i & -i)));
+}
+
+void TranscriptIndex::truncate(int rows)
+{
+    if (rows >= m_heights.size()) return;
+    // Fenwick nodes never look right of their index, so the prefix stays valid
+    m_heights.resize(qMax(rows, 0));
+    m_tree.resize(m_heights.size() + 1);
+}
+
+void TranscriptIndex::setHeight(int row, int height)
+{
+    height = qMax(height, 1);
+    const int delta = height - m_heights[row];
+    if (delta == 0) return;
+    m_heights[row] = height;
+    for (int i = row + 1; i < m_tree.size(); i += i & -i)
+        m_tree[i] += delta;
+}
+
+int TranscriptIndex::offset(int row) const
+{
+    int sum = 0;
+    for (int i = row; i > 0; i -= i & -i)
+        sum += m_tree[i];
+    return sum;
+}
+
+int TranscriptIndex::rowAt(int y) const
+{
+    const int n = m_heights.size();
+    if (n == 0 || y <= 0) return 0;
+
+    // Descend to the largest prefix whose sum is still <= y
+    int step = 1;
+    while (step * 2 <= n)
+        step *= 2;
+    int pos = 0;
+    for (; step > 0; step /= 2) {
+        if (pos + step <= n && m_tree[pos + step] <= y) {
+            pos += step;
+            y -= m_tree[pos];
+        }
+    }
+    return qMin(pos, n - 1);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QVector>
+
+// Row heights of a virtualized list, kept in a Fenwick tree so the offset of
+// any row, the row at a given y and a height change all cost O(log n).
+// Heights start as estimates and are replaced as rows get measured; rows
+// must be at least 1px tall.
+class TranscriptIndex {
+public:
+    void clear();
+    int size() const { return m_heights.size(); }
+
+    void append(int height);
+    // Drops rows [rows, size())
+    void truncate(int rows);
+
+    int height(int row) const { return m_heights[row]; }
+    void setHeight(int row, int height);
+
+    // Top of `row`; offset(size()) is the total height
+    int offset(int row) const;
+    int totalHeight() const { return offset(m_heights.size()); }
+    // Row whose [offset, offset + height) contains y, clamped to the ends
+    int rowAt(int y) const;
+
+private:
+    QVector<int> m_heights;
+    QVector<int> m_tree; // 1-based Fenwick tree over m_heights
+};